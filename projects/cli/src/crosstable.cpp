@@ -0,0 +1,692 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "crosstable.h"
+#include <algorithm>
+#include <QtMath>
+#include <QFile>
+#include <QTextStream>
+#include <QVariant>
+#include <jsonserializer.h>
+
+namespace {
+
+int fieldWidth(qreal largest, int extra, int minimum)
+{
+	if (largest <= 0)
+		return minimum;
+	return qMax(qFloor(qLn(largest) * M_LOG10E) + extra, minimum);
+}
+
+QString jsonValue(const QVariant& value)
+{
+	return JsonSerializer(value).toFragment(0);
+}
+
+} // anonymous namespace
+
+CrossTable::Encounter::Encounter()
+	: winsAsWhite(0),
+	  winsAsBlack(0),
+	  lossAsWhite(0),
+	  lossAsBlack(0),
+	  drawsAsWhite(0),
+	  drawsAsBlack(0),
+	  jsonDirty(true)
+{
+}
+
+CrossTable::Row::Row()
+	: rating(0),
+	  strikes(0),
+	  disqualified(false),
+	  score(0),
+	  neustadtlScore(0),
+	  gamesAsWhite(0),
+	  gamesAsBlack(0),
+	  winsAsWhite(0),
+	  winsAsBlack(0),
+	  lossAsWhite(0),
+	  lossAsBlack(0),
+	  totalGames(0),
+	  performance(0),
+	  elo(0),
+	  resultsDirty(true),
+	  textDirty(true)
+{
+}
+
+bool CrossTable::Row::hasSameStanding(const Row& other) const
+{
+	return rating == other.rating
+	    && strikes == other.strikes
+	    && disqualified == other.disqualified
+	    && score == other.score
+	    && neustadtlScore == other.neustadtlScore
+	    && gamesAsWhite == other.gamesAsWhite
+	    && gamesAsBlack == other.gamesAsBlack
+	    && totalGames == other.totalGames
+	    && performance == other.performance
+	    && elo == other.elo;
+}
+
+CrossTable::CrossTable()
+	: m_eloKfactor(32.0),
+	  m_dirty(false)
+{
+}
+
+void CrossTable::clear()
+{
+	m_rows.clear();
+	m_encounters.clear();
+	m_index.clear();
+	m_byName.clear();
+	m_order.clear();
+	m_textLayout.clear();
+	m_dirty = false;
+}
+
+void CrossTable::setEloKfactor(qreal kfactor)
+{
+	if (kfactor == m_eloKfactor)
+		return;
+
+	m_eloKfactor = kfactor;
+	m_dirty = true;
+}
+
+CrossTable::Encounter& CrossTable::encounter(int player, int opponent)
+{
+	return m_encounters[player * m_rows.size() + opponent];
+}
+
+const CrossTable::Encounter& CrossTable::encounter(int player, int opponent) const
+{
+	return m_encounters.at(player * m_rows.size() + opponent);
+}
+
+void CrossTable::setPlayer(int index,
+			   const QString& name,
+			   int rating,
+			   int strikes,
+			   bool disqualified)
+{
+	Q_ASSERT(index >= 0 && index <= m_rows.size());
+
+	if (index < m_rows.size())
+	{
+		Row& row = m_rows[index];
+		if (row.rating == rating
+		&&  row.strikes == strikes
+		&&  row.disqualified == disqualified)
+			return;
+
+		// Disqualification nullifies scores against every opponent
+		if (row.disqualified != disqualified)
+		{
+			for (Row& other : m_rows)
+				other.textDirty = true;
+		}
+
+		row.rating = rating;
+		row.strikes = strikes;
+		row.disqualified = disqualified;
+		m_dirty = true;
+		return;
+	}
+
+	Row row;
+	row.name = name;
+	row.rating = rating;
+	row.strikes = strikes;
+	row.disqualified = disqualified;
+
+	int n = 1;
+	QString abbrev;
+	abbrev.append(name.at(0).toUpper()).append(name.length() > n ? name.at(n++).toLower() : ' ');
+	bool unique = false;
+	while (!unique)
+	{
+		unique = true;
+		for (const Row& other : qAsConst(m_rows))
+		{
+			if (other.abbrev == abbrev)
+			{
+				abbrev[1] = name.length() > n ? name.at(n++).toLower() : ' ';
+				unique = false;
+				break;
+			}
+		}
+	}
+	row.abbrev = abbrev;
+
+	const int oldCount = m_rows.size();
+	const int count = oldCount + 1;
+	QVector<Encounter> encounters(count * count);
+	for (int i = 0; i < oldCount; i++)
+	{
+		for (int j = 0; j < oldCount; j++)
+			encounters[i * count + j] = m_encounters.at(i * oldCount + j);
+	}
+	m_encounters = encounters;
+
+	// Every row gets a new member in its "Results" object
+	for (Row& other : m_rows)
+		other.resultsDirty = true;
+
+	m_rows.append(row);
+	m_index.insert(name, index);
+
+	m_byName.append(index);
+	std::sort(m_byName.begin(), m_byName.end(), [this](int a, int b)
+	{
+		return m_rows.at(a).name < m_rows.at(b).name;
+	});
+
+	m_dirty = true;
+}
+
+void CrossTable::addResult(int gameNumber,
+			   const QString& white,
+			   const QString& black,
+			   const QString& result)
+{
+	const int iWhite = m_index.value(white, -1);
+	const int iBlack = m_index.value(black, -1);
+	if (iWhite == -1 || iBlack == -1 || iWhite == iBlack)
+		return;
+
+	Slot whiteSlot;
+	Slot blackSlot;
+	whiteSlot.gameNumber = blackSlot.gameNumber = gameNumber;
+	whiteSlot.color = 0;
+	blackSlot.color = 1;
+
+	Encounter& whiteData = encounter(iWhite, iBlack);
+	Encounter& blackData = encounter(iBlack, iWhite);
+
+	if (result == "1-0")
+	{
+		whiteSlot.winner = blackSlot.winner = WinnerWhite;
+		whiteSlot.result = 1.0;
+		blackSlot.result = 0.0;
+		whiteData.winsAsWhite++;
+		blackData.lossAsBlack++;
+	}
+	else if (result == "0-1")
+	{
+		whiteSlot.winner = blackSlot.winner = WinnerBlack;
+		whiteSlot.result = 0.0;
+		blackSlot.result = 1.0;
+		whiteData.lossAsWhite++;
+		blackData.winsAsBlack++;
+	}
+	else if (result == "1/2-1/2")
+	{
+		whiteSlot.winner = blackSlot.winner = WinnerNone;
+		whiteSlot.result = blackSlot.result = 0.5;
+		whiteData.drawsAsWhite++;
+		blackData.drawsAsBlack++;
+	}
+	else
+		return; // game in progress or invalid or something
+
+	// Results usually arrive in game order, but concurrent games
+	// may finish out of order.
+	Encounter* data[] = { &whiteData, &blackData };
+	const Slot newSlots[] = { whiteSlot, blackSlot };
+	for (int i = 0; i < 2; i++)
+	{
+		Encounter& e = *data[i];
+		const Slot& slot = newSlots[i];
+		const QChar c(slot.result == 1.0 ? '1' : slot.result == 0.0 ? '0' : '=');
+
+		int pos = e.slotList.size();
+		while (pos > 0 && e.slotList.at(pos - 1).gameNumber > gameNumber)
+			pos--;
+		e.slotList.insert(pos, slot);
+		e.text.insert(pos, c);
+		e.jsonDirty = true;
+	}
+
+	m_rows[iWhite].resultsDirty = true;
+	m_rows[iWhite].textDirty = true;
+	m_rows[iBlack].resultsDirty = true;
+	m_rows[iBlack].textDirty = true;
+	m_dirty = true;
+}
+
+int CrossTable::headToHead(int player, int opponent) const
+{
+	if (m_rows.at(player).disqualified || m_rows.at(opponent).disqualified)
+		return 0;
+
+	const Encounter& e = encounter(player, opponent);
+	return e.winsAsWhite + e.winsAsBlack - e.lossAsWhite - e.lossAsBlack;
+}
+
+bool CrossTable::lessThan(int first, int second) const
+{
+	const Row& s1 = m_rows.at(first);
+	const Row& s2 = m_rows.at(second);
+
+	if (s1.disqualified != s2.disqualified)
+		return s2.disqualified;
+	if (s1.score != s2.score)
+		return s1.score > s2.score;
+	if (s1.strikes != s2.strikes)
+		return s1.strikes < s2.strikes;
+
+	const int games1 = s1.gamesAsWhite + s1.gamesAsBlack;
+	const int games2 = s2.gamesAsWhite + s2.gamesAsBlack;
+	if (games1 != games2)
+		return games1 < games2;
+
+	const int h2h = headToHead(first, second);
+	if (h2h != 0)
+		return h2h > 0;
+
+	const int wins1 = s1.winsAsWhite + s1.winsAsBlack;
+	const int wins2 = s2.winsAsWhite + s2.winsAsBlack;
+	if (wins1 != wins2)
+		return wins1 > wins2;
+
+	return s1.neustadtlScore > s2.neustadtlScore;
+}
+
+void CrossTable::update()
+{
+	if (!m_dirty)
+		return;
+	m_dirty = false;
+
+	const int count = m_rows.size();
+	QVector<Row> rows(m_rows);
+
+	// calculate scores (nullified by disqualification) and point rate
+	for (int i = 0; i < count; i++)
+	{
+		Row& row = rows[i];
+		row.score = 0;
+		row.gamesAsWhite = row.gamesAsBlack = 0;
+		row.winsAsWhite = row.winsAsBlack = 0;
+		row.lossAsWhite = row.lossAsBlack = 0;
+		row.totalGames = 0;
+		row.performance = 0;
+		row.neustadtlScore = 0;
+		row.elo = 0;
+
+		int totScore = 0;
+		for (int j = 0; j < count; j++)
+		{
+			if (j == i)
+				continue;
+
+			const Encounter& e = encounter(i, j);
+			const int wins = e.winsAsWhite + e.winsAsBlack;
+			const int draws = e.drawsAsWhite + e.drawsAsBlack;
+			totScore += wins * 2 + draws;
+			row.totalGames += e.slotList.size();
+
+			if (row.disqualified || rows.at(j).disqualified)
+				continue;
+
+			row.score += wins + draws / 2.0;
+			row.gamesAsWhite += e.winsAsWhite + e.lossAsWhite + e.drawsAsWhite;
+			row.gamesAsBlack += e.winsAsBlack + e.lossAsBlack + e.drawsAsBlack;
+			row.winsAsWhite += e.winsAsWhite;
+			row.winsAsBlack += e.winsAsBlack;
+			row.lossAsWhite += e.lossAsWhite;
+			row.lossAsBlack += e.lossAsBlack;
+		}
+
+		if (row.totalGames > 0)
+			row.performance = static_cast<qreal>(totScore) / (row.totalGames * 2);
+	}
+
+	// calculate SB (nullified by disqualification)
+	for (int i = 0; i < count; i++)
+	{
+		Row& row = rows[i];
+		if (row.disqualified)
+			continue;
+
+		qreal sb = 0.0;
+		for (int j = 0; j < count; j++)
+		{
+			const Row& other = rows.at(j);
+			if (j == i || other.disqualified)
+				continue;
+
+			const Encounter& e = encounter(i, j);
+			sb += (e.winsAsWhite + e.winsAsBlack) * other.score;
+			sb += (e.drawsAsWhite + e.drawsAsBlack) * other.score / 2.;
+		}
+		row.neustadtlScore = sb;
+	}
+
+	// calculate Elo (not nullified by disqualification)
+	for (int i = 0; i < count; i++)
+	{
+		const int player = m_byName.at(i);
+		Row& row = rows[player];
+
+		for (int j = i + 1; j < count; j++)
+		{
+			const int opponent = m_byName.at(j);
+			Row& other = rows[opponent];
+			const Encounter& e = encounter(player, opponent);
+			const int games = e.slotList.size();
+			if (games == 0)
+				continue;
+
+			const int score = (e.winsAsWhite + e.winsAsBlack) * 2
+					+ e.drawsAsWhite + e.drawsAsBlack;
+			const qreal real = static_cast<qreal>(score) / (games * 2);
+			const qreal expected = 1.0 / (1.0 + qPow(10.0, (other.rating - row.rating) / 400.0));
+			const qreal elo =  m_eloKfactor * (real - expected) * games;
+
+			row.elo += elo;
+			other.elo -= elo;
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		if (!rows.at(i).hasSameStanding(m_rows.at(i)))
+			rows[i].textDirty = true;
+	}
+	m_rows = rows;
+
+	// The sort is stable, so tied players keep their name order
+	m_order = m_byName;
+	std::stable_sort(m_order.begin(), m_order.end(), [this](int a, int b)
+	{
+		return lessThan(a, b);
+	});
+}
+
+void CrossTable::renderEncounter(int player, int opponent)
+{
+	Encounter& e = encounter(player, opponent);
+
+	QVariantMap result;
+	QVariantList scores;
+	result["H2h"] = 0;
+	for (const Slot& slotData : qAsConst(e.slotList))
+	{
+		QVariantMap slot;
+		slot["Game"] = slotData.gameNumber;
+		slot["Result"] = slotData.result;
+		slot["Color"] = slotData.color;
+		result["H2h"] = result["H2h"].toDouble() + slotData.result;
+		switch (slotData.winner)
+		{
+		case WinnerNone:
+			slot["Winner"] = "None";
+			break;
+		case WinnerWhite:
+			slot["Winner"] = "White";
+			break;
+		case WinnerBlack:
+			slot["Winner"] = "Black";
+			break;
+		}
+		scores.append(slot);
+	}
+	result["Text"] = e.text;
+	result["Scores"] = scores;
+
+	// Nesting level: document, "Table", player, "Results", opponent
+	e.json = JsonSerializer(result).toFragment(4);
+	e.jsonDirty = false;
+}
+
+bool CrossTable::writeJson(const QString& fileName,
+			   const QString& event,
+			   const QString& type)
+{
+	update();
+
+	const QString tempName(fileName + "_temp.json");
+	const QString finalName(fileName + ".json");
+	if (QFile::exists(tempName))
+		QFile::remove(tempName);
+	QFile output(tempName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open crosstable JSON file: %s", qUtf8Printable(tempName));
+		return false;
+	}
+
+	QStringList order;
+	for (int player : qAsConst(m_order))
+		order << jsonValue(m_rows.at(player).name);
+
+	QMap<QString, QString> table;
+	for (int rank = 0; rank < m_order.size(); rank++)
+	{
+		const int player = m_order.at(rank);
+		Row& row = m_rows[player];
+
+		if (row.resultsDirty)
+		{
+			QMap<QString, QString> results;
+			for (int opponent : qAsConst(m_byName))
+			{
+				if (opponent == player)
+					continue;
+				if (encounter(player, opponent).jsonDirty)
+					renderEncounter(player, opponent);
+				results[m_rows.at(opponent).name] = encounter(player, opponent).json;
+			}
+			row.results = JsonSerializer::objectFragment(results, 3);
+			row.resultsDirty = false;
+		}
+
+		QMap<QString, QString> obj;
+		obj["Rank"] = jsonValue(rank + 1);
+		obj["Abbreviation"] = jsonValue(row.abbrev);
+		obj["Rating"] = jsonValue(row.rating);
+		obj["Score"] = jsonValue(row.score);
+		obj["GamesAsWhite"] = jsonValue(row.gamesAsWhite);
+		obj["GamesAsBlack"] = jsonValue(row.gamesAsBlack);
+		obj["WinsAsWhite"] = jsonValue(row.winsAsWhite);
+		obj["WinsAsBlack"] = jsonValue(row.winsAsBlack);
+		obj["LossAsWhite"] = jsonValue(row.lossAsWhite);
+		obj["LossAsBlack"] = jsonValue(row.lossAsBlack);
+		obj["Games"] = jsonValue(row.gamesAsWhite + row.gamesAsBlack);
+		obj["Neustadtl"] = jsonValue(row.neustadtlScore);
+		obj["Strikes"] = jsonValue(row.strikes);
+		obj["Performance"] = jsonValue(row.performance * 100.0);
+		obj["Elo"] = jsonValue(row.elo);
+		for (int opponent : qAsConst(m_order))
+		{
+			if (opponent != player && !encounter(player, opponent).slotList.isEmpty())
+				obj["Opponent"] = jsonValue(m_rows.at(opponent).name);
+		}
+		obj["Results"] = row.results;
+
+		table[row.name] = JsonSerializer::objectFragment(obj, 2);
+	}
+
+	QMap<QString, QString> cMap;
+	cMap["Order"] = JsonSerializer::arrayFragment(order, 1);
+	cMap["Table"] = JsonSerializer::objectFragment(table, 1);
+	if (!event.isEmpty())
+		cMap["Event"] = jsonValue(event);
+	if (!type.isEmpty())
+		cMap["Type"] = jsonValue(type);
+
+	QTextStream out(&output);
+	out << JsonSerializer::objectFragment(cMap, 0) << '\n';
+	out.flush();
+	output.close();
+
+	if (QFile::exists(finalName))
+		QFile::remove(finalName);
+	if (!QFile::rename(tempName, finalName))
+	{
+		qWarning("cannot rename crosstable JSON file: %s to %s", qUtf8Printable(tempName), qUtf8Printable(finalName));
+		return false;
+	}
+
+	return true;
+}
+
+bool CrossTable::writeText(const QString& fileName)
+{
+	update();
+
+	const int count = m_rows.size();
+	int maxName = 6;
+	int maxStrikes = 0;
+	qreal largestSB = 1.0;
+	qreal largestScore = 1.0;
+	qreal maxElo = 1;
+	qreal largestPerf = 0.0001;
+	int maxGames = 1;
+
+	for (const Row& row : qAsConst(m_rows))
+	{
+		maxName = qMax(maxName, row.name.length());
+		maxStrikes = qMax(maxStrikes, row.strikes);
+		if (!row.disqualified)
+		{
+			largestSB = qMax(largestSB, row.neustadtlScore);
+			largestScore = qMax(largestScore, row.score);
+		}
+		maxElo = qMax(maxElo, qAbs(row.elo));
+		if (row.totalGames > 0)
+		{
+			largestPerf = qMax(largestPerf, row.performance);
+			maxGames = qMax(maxGames, row.totalGames);
+		}
+	}
+
+	// With two players the encounter is summarized as "+ W = D - L"
+	QVector<QString> cells(count * count);
+	int roundLength = 2;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			if (i == j)
+				continue;
+
+			const Encounter& e = encounter(i, j);
+			QString& cell = cells[i * count + j];
+			if (count == 2)
+				cell = QString("+ %1 = %2 - %3")
+					.arg(e.winsAsWhite + e.winsAsBlack)
+					.arg(e.drawsAsWhite + e.drawsAsBlack)
+					.arg(e.lossAsWhite + e.lossAsBlack);
+			else
+				cell = e.text;
+			roundLength = qMax(roundLength, cell.length());
+		}
+	}
+
+	const int maxScore = fieldWidth(largestScore, 3, 3);
+	const int maxSB = fieldWidth(largestSB, 4, 4);
+	maxGames = fieldWidth(maxGames, 1, 2);
+	maxStrikes = fieldWidth(maxStrikes, 1, 1);
+	const int maxPerf = fieldWidth(largestPerf * 100.0, 3, 4);
+	const int eloWidth = fieldWidth(maxElo, 2, 3);
+
+	QString crossTableHeaderText = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+		.arg("N", 2)
+		.arg("Engine", -maxName)
+		.arg("Rtng", 4)
+		.arg("Pts", maxScore)
+		.arg("Gm", maxGames)
+		.arg("SB", maxSB)
+		.arg("X", maxStrikes)
+		.arg("Elo", eloWidth)
+		.arg("Perf", maxPerf);
+
+	// Every row must be re-rendered if the column layout or the
+	// ranking changes.
+	QString layout = QString("%1 %2 %3 %4 %5 %6 %7 %8:")
+		.arg(maxName).arg(maxScore).arg(maxGames).arg(maxSB)
+		.arg(maxStrikes).arg(eloWidth).arg(maxPerf).arg(roundLength);
+	for (int player : qAsConst(m_order))
+		layout += QString::number(player) + ',';
+	if (layout != m_textLayout)
+	{
+		for (Row& row : m_rows)
+			row.textDirty = true;
+		m_textLayout = layout;
+	}
+
+	QString crossTableBodyText;
+	for (int rank = 0; rank < m_order.size(); rank++)
+	{
+		const int player = m_order.at(rank);
+		Row& row = m_rows[player];
+		crossTableHeaderText += QString(" %1").arg(row.abbrev, -roundLength);
+
+		if (row.textDirty)
+		{
+			QString eloText = row.elo > 0 ? "+" : "";
+			eloText += QString::number(row.elo, 'f', 0);
+			row.text = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+				.arg(rank + 1, 2)
+				.arg(row.name, -maxName)
+				.arg(row.rating, 4)
+				.arg(row.score, maxScore, 'f', 1)
+				.arg(row.gamesAsWhite + row.gamesAsBlack, maxGames)
+				.arg(row.neustadtlScore, maxSB, 'f', 2)
+				.arg(row.strikes, maxStrikes)
+				.arg(eloText, eloWidth)
+				.arg(row.performance * 100.0, maxPerf, 'f', 1);
+
+			for (int opponent : qAsConst(m_order))
+			{
+				if (opponent == player)
+				{
+					row.text += " ";
+					int rl = roundLength;
+					while (rl--)
+						row.text += "\u00B7";
+				}
+				else
+					row.text += QString(" %1").arg(cells.at(player * count + opponent), -roundLength);
+			}
+			row.text += "\n";
+			row.textDirty = false;
+		}
+		crossTableBodyText += row.text;
+	}
+
+	const QString crossTableText = crossTableHeaderText + "\n\n" + crossTableBodyText;
+
+	const QString finalName(fileName + ".txt");
+	QFile output(finalName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open tournament crosstable file: %s", qUtf8Printable(finalName));
+		return false;
+	}
+
+	QTextStream out(&output);
+	out.setCodec("UTF-8"); // otherwise output is converted to ASCII
+	out << crossTableText;
+	return true;
+}
@@ -0,0 +1,163 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CROSSTABLE_H
+#define CROSSTABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QHash>
+
+
+/*!
+ * \brief Persistent crosstable of a tournament
+ *
+ * The crosstable is updated one game result at a time. Each result
+ * only touches the encounter between its two players; standings,
+ * tiebreaks and ranking are derived from the per-encounter totals,
+ * so the cost of an update depends on the number of players but not
+ * on the number of games played.
+ *
+ * The JSON and text outputs cache the rendered encounters and rows
+ * and only re-render the ones that changed since the last write.
+ */
+class CrossTable
+{
+	public:
+		/*! Creates a new empty crosstable. */
+		CrossTable();
+
+		/*! Removes all players and results. */
+		void clear();
+		/*! Sets the K-factor used for the Elo column to \a kfactor. */
+		void setEloKfactor(qreal kfactor);
+
+		/*!
+		 * Sets the data of player \a index.
+		 *
+		 * Players are added in index order; the abbreviation of a
+		 * new player is chosen to be unique among the players
+		 * added before it.
+		 */
+		void setPlayer(int index,
+			       const QString& name,
+			       int rating,
+			       int strikes,
+			       bool disqualified);
+		/*!
+		 * Adds the result of game \a gameNumber between \a white
+		 * and \a black. \a result is the result in short format,
+		 * eg. "1-0". Unfinished games are ignored.
+		 */
+		void addResult(int gameNumber,
+			       const QString& white,
+			       const QString& black,
+			       const QString& result);
+
+		/*!
+		 * Writes the crosstable in JSON format to \a fileName.
+		 * \a event and \a type are included if they're not empty.
+		 */
+		bool writeJson(const QString& fileName,
+			       const QString& event,
+			       const QString& type);
+		/*! Writes the crosstable in text format to \a fileName. */
+		bool writeText(const QString& fileName);
+
+	private:
+		enum Winner
+		{
+			WinnerNone,
+			WinnerWhite,
+			WinnerBlack
+		};
+
+		struct Slot
+		{
+			int gameNumber;
+			Winner winner;
+			double result;
+			int color;
+		};
+
+		struct Encounter
+		{
+			Encounter();
+
+			QList<Slot> slotList;
+			QString text;
+			int winsAsWhite;
+			int winsAsBlack;
+			int lossAsWhite;
+			int lossAsBlack;
+			int drawsAsWhite;
+			int drawsAsBlack;
+			bool jsonDirty;
+			QString json;
+		};
+
+		struct Row
+		{
+			Row();
+
+			bool hasSameStanding(const Row& other) const;
+
+			QString name;
+			QString abbrev;
+			int rating;
+			int strikes;
+			bool disqualified;
+
+			double score;
+			double neustadtlScore;
+			int gamesAsWhite;
+			int gamesAsBlack;
+			int winsAsWhite;
+			int winsAsBlack;
+			int lossAsWhite;
+			int lossAsBlack;
+			int totalGames;
+			double performance;
+			double elo;
+
+			bool resultsDirty;
+			QString results;
+			bool textDirty;
+			QString text;
+		};
+
+		Encounter& encounter(int player, int opponent);
+		const Encounter& encounter(int player, int opponent) const;
+		int headToHead(int player, int opponent) const;
+		bool lessThan(int first, int second) const;
+		void update();
+		void renderEncounter(int player, int opponent);
+
+		qreal m_eloKfactor;
+		bool m_dirty;
+		QVector<Row> m_rows;
+		QVector<Encounter> m_encounters;
+		QHash<QString, int> m_index;
+		QVector<int> m_byName;
+		QVector<int> m_order;
+		QString m_textLayout;
+};
+
+#endif // CROSSTABLE_H
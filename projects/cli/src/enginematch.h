@@ -26,6 +26,10 @@
 #include <QTextStream>
 #include <QElapsedTimer>
 #include <openingbook.h>
+#include <QSet>
+#include "tournamentstore.h"
+#include "crosstable.h"
+#include "gameschedule.h"
 
 class ChessGame;
 class OpeningBook;
@@ -64,8 +68,10 @@ class EngineMatch : public QObject
 
 	private:
 		void printRanking();
-		void generateSchedule(QVariantMap& eMap);
-		void generateCrossTable(QVariantMap& eMap);
+		void resetTables();
+		void updatePlayers();
+		void generateSchedule();
+		void generateCrossTable();
 
 		Tournament* m_tournament;
 		bool m_debug;
@@ -74,6 +80,11 @@ class EngineMatch : public QObject
 		QMap<QString, OpeningBook*> m_books;
 		QElapsedTimer m_startTime;
 		QString m_tournamentFile;
+		TournamentStore m_store;
+		CrossTable m_crossTable;
+		GameSchedule m_schedule;
+		QSet<QString> m_disqualified;
+		int m_maxNameLength;
 		qreal m_eloKfactor;
 		bool m_pgnFormat;
 		bool m_jsonFormat;
@@ -0,0 +1,375 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gameschedule.h"
+#include <QFile>
+#include <QTextStream>
+#include <jsonserializer.h>
+
+namespace {
+
+enum Column
+{
+	WhiteColumn,
+	BlackColumn,
+	WhiteResultColumn,
+	BlackResultColumn,
+	TerminationColumn,
+	PliesColumn,
+	WhiteEvalColumn,
+	BlackEvalColumn,
+	StartColumn,
+	DurationColumn,
+	EcoColumn,
+	FinalFenColumn,
+	OpeningColumn,
+	ColumnCount
+};
+
+QString negatedEval(QString eval)
+{
+	if (eval.isEmpty())
+		return eval;
+	if (eval.at(0) == '-')
+		eval.remove(0, 1);
+	else if (eval != "0.00")
+		eval = "-" + eval;
+	return eval;
+}
+
+} // anonymous namespace
+
+GameSchedule::Entry::Entry()
+	: played(false),
+	  canceled(false),
+	  termLength(0),
+	  fenLength(0)
+{
+}
+
+GameSchedule::GameSchedule()
+{
+}
+
+void GameSchedule::clear()
+{
+	m_entries.clear();
+	m_textLayout.clear();
+}
+
+GameSchedule::Entry& GameSchedule::entry(int index)
+{
+	if (index >= m_entries.size())
+		m_entries.resize(index + 1);
+	return m_entries[index];
+}
+
+void GameSchedule::setGame(int number, const QVariantMap& game)
+{
+	Q_ASSERT(number > 0);
+
+	Entry& e = entry(number - 1);
+	e.played = true;
+	e.text.clear();
+
+	QVariantMap sMap;
+	QStringList columns;
+	for (int i = 0; i < ColumnCount; i++)
+		columns << QString();
+
+	QString opening;
+	if (game.contains("white"))
+	{
+		sMap["White"] = game["white"];
+		columns[WhiteColumn] = game["white"].toString();
+	}
+	if (game.contains("black"))
+	{
+		sMap["Black"] = game["black"];
+		columns[BlackColumn] = game["black"].toString();
+	}
+	if (game.contains("startTime"))
+	{
+		sMap["Start"] = game["startTime"];
+		columns[StartColumn] = game["startTime"].toString();
+	}
+	if (game.contains("result"))
+	{
+		sMap["Result"] = game["result"];
+
+		QString& whiteResult = columns[WhiteResultColumn];
+		QString& blackResult = columns[BlackResultColumn];
+		const QString result = game["result"].toString();
+		if (result == "*")
+			whiteResult = blackResult = result;
+		else if (result == "1-0")
+		{
+			whiteResult = "1";
+			blackResult = "0";
+		}
+		else if (result == "0-1")
+		{
+			blackResult = "1";
+			whiteResult = "0";
+		}
+		else
+			whiteResult = blackResult = "1/2";
+	}
+	if (game.contains("terminationDetails"))
+	{
+		sMap["Termination"] = game["terminationDetails"];
+		columns[TerminationColumn] = game["terminationDetails"].toString();
+	}
+	if (game.contains("gameDuration"))
+	{
+		sMap["Duration"] = game["gameDuration"];
+		columns[DurationColumn] = game["gameDuration"].toString();
+	}
+	if (game.contains("finalFen"))
+	{
+		sMap["FinalFen"] = game["finalFen"];
+		columns[FinalFenColumn] = game["finalFen"].toString();
+	}
+	if (game.contains("ECO"))
+	{
+		sMap["ECO"] = game["ECO"];
+		columns[EcoColumn] = game["ECO"].toString();
+	}
+	if (game.contains("opening"))
+		opening = game["opening"].toString();
+	if (game.contains("variation"))
+	{
+		QString variation = game["variation"].toString();
+		if (!variation.isEmpty())
+			opening += ", " + variation;
+	}
+	if (!opening.isEmpty())
+		sMap["Opening"] = opening;
+	columns[OpeningColumn] = opening;
+	if (game.contains("plyCount"))
+	{
+		sMap["Moves"] = game["plyCount"];
+		columns[PliesColumn] = game["plyCount"].toString();
+	}
+	if (game.contains("whiteEval"))
+	{
+		sMap["WhiteEv"] = game["whiteEval"];
+		columns[WhiteEvalColumn] = game["whiteEval"].toString();
+	}
+	if (game.contains("blackEval"))
+	{
+		const QString blackEval = negatedEval(game["blackEval"].toString());
+		sMap["BlackEv"] = blackEval;
+		columns[BlackEvalColumn] = blackEval;
+	}
+	sMap["Game"] = number;
+
+	e.json = JsonSerializer(sMap).toFragment(1);
+	e.columns = columns;
+	e.termLength = columns.at(TerminationColumn).length();
+	e.fenLength = columns.at(FinalFenColumn).length();
+}
+
+GameSchedule::Entry& GameSchedule::pendingEntry(int index,
+						const QPair<QString, QString>& pairing,
+						bool canceled)
+{
+	Entry& e = entry(index);
+	if (e.white == pairing.first
+	&&  e.black == pairing.second
+	&&  e.canceled == canceled
+	&&  !e.json.isEmpty())
+		return e;
+
+	e.white = pairing.first;
+	e.black = pairing.second;
+	e.canceled = canceled;
+	e.text.clear();
+
+	QVariantMap sMap;
+	sMap["White"] = e.white;
+	sMap["Black"] = e.black;
+	if (canceled)
+		sMap["Termination"] = "Canceled";
+	sMap["Game"] = index + 1;
+	e.json = JsonSerializer(sMap).toFragment(1);
+
+	return e;
+}
+
+bool GameSchedule::writeJson(const QString& fileName,
+			     const QList< QPair<QString, QString> >& pairings,
+			     const QSet<QString>& disqualified)
+{
+	const QString tempName(fileName + "_temp.json");
+	const QString finalName(fileName + ".json");
+	if (QFile::exists(tempName))
+		QFile::remove(tempName);
+	QFile output(tempName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open schedule JSON file: %s", qUtf8Printable(tempName));
+		return false;
+	}
+
+	QStringList sList;
+	for (int i = 0; i < pairings.size(); i++)
+	{
+		if (i < m_entries.size() && m_entries.at(i).played)
+		{
+			sList << m_entries.at(i).json;
+			continue;
+		}
+
+		const QPair<QString, QString>& pairing = pairings.at(i);
+		const bool canceled = disqualified.contains(pairing.first)
+				   || disqualified.contains(pairing.second);
+		sList << pendingEntry(i, pairing, canceled).json;
+	}
+
+	QTextStream out(&output);
+	out << JsonSerializer::arrayFragment(sList, 0) << '\n';
+	out.flush();
+	output.close();
+
+	if (QFile::exists(finalName))
+		QFile::remove(finalName);
+	if (!QFile::rename(tempName, finalName))
+	{
+		qWarning("cannot rename schedule JSON file: %s to %s", qUtf8Printable(tempName), qUtf8Printable(finalName));
+		return false;
+	}
+
+	return true;
+}
+
+bool GameSchedule::writeText(const QString& fileName,
+			     const QList< QPair<QString, QString> >& pairings,
+			     const QSet<QString>& disqualified,
+			     int maxName)
+{
+	const int nrWidth = pairings.size() >= 100 ? 3 : 2;
+	maxName = qMax(maxName, 5);
+	int maxTerm = 11;
+	int maxFen = 9;
+	for (const Entry& e : qAsConst(m_entries))
+	{
+		if (!e.played)
+			continue;
+		maxTerm = qMax(maxTerm, e.termLength);
+		maxFen = qMax(maxFen, e.fenLength);
+	}
+
+	// A new column width requires every line to be re-rendered
+	const QString layout = QString("%1 %2 %3 %4")
+		.arg(nrWidth).arg(maxName).arg(maxTerm).arg(maxFen);
+	if (layout != m_textLayout)
+	{
+		for (Entry& e : m_entries)
+			e.text.clear();
+		m_textLayout = layout;
+	}
+
+	QString scheduleText;
+	scheduleText = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14\n")
+		.arg("Nr", nrWidth)
+		.arg("White", maxName)
+		.arg("", 3)
+		.arg("", -3)
+		.arg("Black", -maxName)
+		.arg("Termination", -maxTerm)
+		.arg("Mov", 3)
+		.arg("WhiteEv", 7)
+		.arg("BlackEv", -7)
+		.arg("Start", -22)
+		.arg("Duration", 8)
+		.arg("ECO", 3)
+		.arg("FinalFen", -maxFen)
+		.arg("Opening");
+
+	for (int i = 0; i < pairings.size(); i++)
+	{
+		const QPair<QString, QString>& pairing = pairings.at(i);
+		Entry* e;
+		QStringList columns;
+
+		if (i < m_entries.size() && m_entries.at(i).played)
+		{
+			e = &m_entries[i];
+			if (!e->text.isEmpty())
+			{
+				scheduleText += e->text;
+				continue;
+			}
+
+			columns = e->columns;
+			if (columns.at(WhiteColumn).isEmpty())
+				columns[WhiteColumn] = pairing.first;
+			if (columns.at(BlackColumn).isEmpty())
+				columns[BlackColumn] = pairing.second;
+		}
+		else
+		{
+			const bool canceled = disqualified.contains(pairing.first)
+					   || disqualified.contains(pairing.second);
+			e = &pendingEntry(i, pairing, canceled);
+			if (!e->text.isEmpty())
+			{
+				scheduleText += e->text;
+				continue;
+			}
+
+			for (int j = 0; j < ColumnCount; j++)
+				columns << QString();
+			columns[WhiteColumn] = pairing.first;
+			columns[BlackColumn] = pairing.second;
+			if (canceled)
+				columns[TerminationColumn] = "Canceled";
+		}
+
+		e->text = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14\n")
+			.arg(QString::number(i + 1), nrWidth)
+			.arg(columns.at(WhiteColumn), maxName)
+			.arg(columns.at(WhiteResultColumn), 3)
+			.arg(columns.at(BlackResultColumn), -3)
+			.arg(columns.at(BlackColumn), -maxName)
+			.arg(columns.at(TerminationColumn), -maxTerm)
+			.arg(columns.at(PliesColumn), 3)
+			.arg(columns.at(WhiteEvalColumn), 7)
+			.arg(columns.at(BlackEvalColumn), -7)
+			.arg(columns.at(StartColumn), -22)
+			.arg(columns.at(DurationColumn), 8)
+			.arg(columns.at(EcoColumn), 3)
+			.arg(columns.at(FinalFenColumn), -maxFen)
+			.arg(columns.at(OpeningColumn));
+		scheduleText += e->text;
+	}
+
+	const QString finalName(fileName + ".txt");
+	QFile output(finalName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open schedule TXT file: %s", qUtf8Printable(finalName));
+		return false;
+	}
+
+	QTextStream out(&output);
+	out.setCodec("ISO 8859-1"); // output is converted to ASCII
+	out << scheduleText;
+	return true;
+}
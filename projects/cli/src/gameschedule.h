@@ -0,0 +1,96 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMESCHEDULE_H
+#define GAMESCHEDULE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QVariant>
+
+
+/*!
+ * \brief Schedule of a tournament's games
+ *
+ * GameSchedule keeps the rendered JSON and text line of every game
+ * and only re-renders the games that changed since the last write,
+ * so recording a game doesn't reformat the whole schedule.
+ */
+class GameSchedule
+{
+	public:
+		/*! Creates a new empty schedule. */
+		GameSchedule();
+
+		/*! Removes all games. */
+		void clear();
+		/*!
+		 * Sets the "matchProgress" entry of game \a number
+		 * (1-based) to \a game.
+		 */
+		void setGame(int number, const QVariantMap& game);
+
+		/*!
+		 * Writes the schedule in JSON format to \a fileName.
+		 *
+		 * \a pairings is the complete pairing list of the
+		 * tournament, and games that haven't started yet between
+		 * \a disqualified players are marked as canceled.
+		 */
+		bool writeJson(const QString& fileName,
+			       const QList< QPair<QString, QString> >& pairings,
+			       const QSet<QString>& disqualified);
+		/*!
+		 * Writes the schedule in text format to \a fileName.
+		 * \a maxName is the length of the longest player name.
+		 */
+		bool writeText(const QString& fileName,
+			       const QList< QPair<QString, QString> >& pairings,
+			       const QSet<QString>& disqualified,
+			       int maxName);
+
+	private:
+		struct Entry
+		{
+			Entry();
+
+			bool played;
+			QString white;
+			QString black;
+			bool canceled;
+			QStringList columns;
+			int termLength;
+			int fenLength;
+			QString json;
+			QString text;
+		};
+
+		Entry& entry(int index);
+		Entry& pendingEntry(int index,
+				    const QPair<QString, QString>& pairing,
+				    bool canceled);
+
+		QVector<Entry> m_entries;
+		QString m_textLayout;
+};
+
+#endif // GAMESCHEDULE_H
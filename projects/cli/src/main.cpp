@@ -39,14 +39,18 @@
 #include <sprt.h>
 #include <board/syzygytablebase.h>
 #include <board/result.h>
-#include <jsonparser.h>
-#include <jsonserializer.h>
 #include <econode.h>
 #include <pgnstream.h>
+#include <livefilewriter.h>
+#include <polyglotbookbuilder.h>
+#include <positionindex.h>
+#include <positionindexbuilder.h>
+#include <pgngameentry.h>
 
 #include "cutechesscoreapp.h"
 #include "matchparser.h"
 #include "enginematch.h"
+#include "tournamentstore.h"
 
 namespace {
 
@@ -129,8 +133,6 @@ OpeningSuite* parseOpenings(const MatchParser::Option& option, Tournament* tourn
 							   format,
 							   order,
 							   start - 1);
-		if (order == OpeningSuite::RandomOrder)
-			qInfo("Indexing opening suite...");
 		ok = suite->initialize();
 		if (ok)
 			return suite;
@@ -342,6 +344,38 @@ bool parseEngine(const QStringList& args, EngineData& data, QVariantMap stMap, Q
 		{
 			data.config.setPondering(true);
 		}
+		// Send positions from the last irreversible move after N plies
+		else if (name == "deltapos")
+		{
+			if (val.toInt() <= 0)
+			{
+				qWarning() << "Invalid position delta threshold:" << val;
+				return false;
+			}
+			data.config.setPositionDeltaPlies(val.toInt());
+		}
+		// Merge thinking updates that arrive within MSECS
+		else if (name == "thinkinterval")
+		{
+			bool ok = false;
+			int msecs = val.toInt(&ok);
+			if (!ok || msecs < 0)
+			{
+				qWarning() << "Invalid thinking update interval:" << val;
+				return false;
+			}
+			data.config.setThinkingInterval(msecs);
+		}
+		// Number of CPUs the engine gets with -affinity
+		else if (name == "threads")
+		{
+			if (val.toInt() <= 0)
+			{
+				qWarning() << "Invalid thread count:" << val;
+				return false;
+			}
+			data.config.setThreadCount(val.toInt());
+		}
 		else if (name == "cuteseal")
 		{
 			bool useCuteseal = (val.toUpper() == "TRUE");
@@ -372,6 +406,8 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	parser.addOption("-each", QVariant::StringList, 1);
 	parser.addOption("-variant", QVariant::String, 1, 1);
 	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-enginepool", QVariant::Int, 1, 1);
+	parser.addOption("-affinity", QVariant::StringList, 0, 2);
 	parser.addOption("-draw", QVariant::StringList);
 	parser.addOption("-resign", QVariant::StringList);
 	parser.addOption("-maxmoves", QVariant::Int, 1, 1);
@@ -396,6 +432,7 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	parser.addOption("-wait", QVariant::Int, 1, 1);
 	parser.addOption("-seeds", QVariant::UInt, 1, 1);
 	parser.addOption("-livepgnout", QVariant::StringList, 1, 4);
+	parser.addOption("-liveflush", QVariant::Int, 1, 1);
 	parser.addOption("-tournamentfile", QVariant::String, 1, 1);
 	parser.addOption("-resume", QVariant::Bool, 0, 0);
 	parser.addOption("-ecopgn", QVariant::String, 1, 1);
@@ -448,13 +485,12 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 					qWarning("cannot open tournament configuration file: %s", qUtf8Printable(tournamentFile));
 					return 0;
 				}
+				input.close();
 
-				QTextStream stream(&input);
-				JsonParser jsonParser(stream);
 				// we don't want to use the tournament file at all unless wantResume == true
 				wantsResume = parser.takeOption("-resume").toBool();
 				if (wantsResume) {
-					tfMap = jsonParser.parse().toMap();
+					tfMap = TournamentStore::read(tournamentFile);
 					if (tfMap.contains("tournamentSettings"))
 						tMap = tfMap["tournamentSettings"].toMap();
 					if (tfMap.contains("engineSettings"))
@@ -721,6 +757,27 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 					tMap.insert("concurrency", value.toInt());
 				}
 			}
+			// Number of idle engines kept running between games
+			else if (name == "-enginepool")
+			{
+				ok = value.toInt() >= 0;
+				if (ok)
+					gameManager->setPlayerPoolSize(value.toInt());
+			}
+			// Pin the engines of each game to CPUs of their own
+			else if (name == "-affinity")
+			{
+				QMap<QString, QString> params =
+					option.toMap("smt=on|numa=on");
+				const QStringList values = QStringList() << "on" << "off";
+
+				ok = values.contains(params["smt"])
+				  && values.contains(params["numa"]);
+				if (ok)
+					gameManager->setCpuAffinity(true,
+								    params["smt"] == "on",
+								    params["numa"] == "on");
+			}
 			// Threshold for draw adjudication
 			else if (name == "-draw")
 			{
@@ -936,6 +993,14 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 					tMap.insert("jsonFormat", wantsJsonFormat);
 				}
 			}
+			// Delay between live file updates
+			else if (name == "-liveflush")
+			{
+				const int msecs = value.toInt();
+				ok = msecs >= 0;
+				if (ok)
+					LiveFileWriter::instance()->setFlushInterval(msecs);
+			}
 			else if (name == "-strikes")
 			{
 				const int st = value.toInt();
@@ -1159,12 +1224,6 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	}
 
 	if (!tournamentFile.isEmpty() && !tMap.isEmpty()) {
-		QFile output(tournamentFile);
-		if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
-			qWarning("cannot open tournament configuration file: %s", qUtf8Printable(tournamentFile));
-			return 0;
-		}
-
 		if (!wantsResume || !tMap.contains("eventDate")) {
 			QString eventDate = QDate::currentDate().toString("yyyy.MM.dd");
 			tournament->setEventDate(eventDate);
@@ -1175,9 +1234,8 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 		eMap.insert("engines", eList);
 		tfMap.insert("engineSettings", eMap);
 
-		QTextStream out(&output);
-		JsonSerializer serializer(tfMap);
-		serializer.serialize(out);
+		if (!TournamentStore::write(tournamentFile, tfMap))
+			return 0;
 	}
 
 	tournament->setAdjudicator(adjudicator);
@@ -1185,6 +1243,154 @@ EngineMatch* parseMatch(const QStringList& args, CuteChessCoreApplication& app)
 	return match;
 }
 
+int makeBook(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-makebook", QVariant::StringList, 2);
+	if (!parser.parse())
+		return 1;
+
+	MatchParser::Option option;
+	option.name = "-makebook";
+	option.value = parser.takeOption("-makebook");
+	QMap<QString, QString> params =
+		option.toMap("file|out|plies=20|threads=0|memory=256");
+	if (params.isEmpty())
+		return 1;
+
+	int plies = params["plies"].toInt();
+	int threads = params["threads"].toInt();
+	int memory = params["memory"].toInt();
+	if (plies <= 0 || threads < 0 || memory <= 0)
+	{
+		qWarning("Invalid -makebook arguments");
+		return 1;
+	}
+
+	QFile file(params["out"]);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning("Could not open book file %s: %s",
+			 qUtf8Printable(file.fileName()),
+			 qUtf8Printable(file.errorString()));
+		return 1;
+	}
+
+	PolyglotBookBuilder builder(plies);
+	if (threads > 0)
+		builder.setThreadCount(threads);
+	builder.setMemoryLimit(qint64(memory) * 1024 * 1024);
+
+	qInfo("Importing games from %s...", qUtf8Printable(params["file"]));
+	if (!builder.addPgnFile(params["file"]))
+		return 1;
+	bool ok = builder.write(&file);
+	qInfo("Wrote %d games to %s", builder.gameCount(),
+	      qUtf8Printable(file.fileName()));
+
+	return ok ? 0 : 1;
+}
+
+int makePositionIndex(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-makeposindex", QVariant::StringList, 1);
+	if (!parser.parse())
+		return 1;
+
+	MatchParser::Option option;
+	option.name = "-makeposindex";
+	option.value = parser.takeOption("-makeposindex");
+	QMap<QString, QString> params =
+		option.toMap("file|threads=0|memory=256");
+	if (params.isEmpty())
+		return 1;
+
+	int threads = params["threads"].toInt();
+	int memory = params["memory"].toInt();
+	if (threads < 0 || memory <= 0)
+	{
+		qWarning("Invalid -makeposindex arguments");
+		return 1;
+	}
+
+	PositionIndexBuilder builder(params["file"]);
+	if (threads > 0)
+		builder.setThreadCount(threads);
+	builder.setMemoryLimit(qint64(memory) * 1024 * 1024);
+
+	const QString indexFile(PositionIndex::indexFileName(params["file"]));
+	qInfo("Indexing games from %s...", qUtf8Printable(params["file"]));
+	if (!builder.write(indexFile))
+		return 1;
+	qInfo("Wrote %d games to %s", builder.gameCount(),
+	      qUtf8Printable(indexFile));
+
+	return 0;
+}
+
+int findPosition(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-findposition", QVariant::StringList, 2);
+	if (!parser.parse())
+		return 1;
+
+	MatchParser::Option option;
+	option.name = "-findposition";
+	option.value = parser.takeOption("-findposition");
+	QMap<QString, QString> params =
+		option.toMap("file|fen|variant=standard");
+	if (params.isEmpty())
+		return 1;
+
+	const quint64 key = PositionIndex::fenKey(params["fen"],
+						  params["variant"]);
+	if (key == 0)
+	{
+		qWarning("Invalid FEN string: %s", qUtf8Printable(params["fen"]));
+		return 1;
+	}
+
+	const QString indexFile(PositionIndex::indexFileName(params["file"]));
+	PositionIndex index;
+	if (!index.open(indexFile) || !index.isCurrent(params["file"]))
+	{
+		qWarning("Position index %s is missing or out of date. "
+			 "Create it with -makeposindex.",
+			 qUtf8Printable(indexFile));
+		return 1;
+	}
+
+	QFile file(params["file"]);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning("Could not open PGN file %s",
+			 qUtf8Printable(params["file"]));
+		return 1;
+	}
+	PgnStream in(&file);
+
+	const QVector<PositionIndex::Hit> hits(index.find(key));
+	QTextStream out(stdout);
+	for (const PositionIndex::Hit& hit : hits)
+	{
+		PgnGameEntry entry;
+		if (!in.seek(index.gamePosition(int(hit.game))) || !entry.read(in))
+			continue;
+
+		out << "Game " << hit.game + 1 << ", ply " << hit.ply << ": "
+		    << entry.tagValue(PgnGameEntry::WhiteTag) << " - "
+		    << entry.tagValue(PgnGameEntry::BlackTag) << ", "
+		    << entry.tagValue(PgnGameEntry::EventTag) << ", round "
+		    << entry.tagValue(PgnGameEntry::RoundTag) << endl;
+	}
+	qInfo("Found %d occurrences in %d indexed games", hits.size(),
+	      index.gameCount());
+
+	return 0;
+}
+
 } // anonymous namespace
 
 int main(int argc, char* argv[])
@@ -1234,6 +1440,12 @@ int main(int argc, char* argv[])
 				out << file.readAll();
 			return 0;
 		}
+		else if (arg == "-makebook")
+			return makeBook(arguments);
+		else if (arg == "-makeposindex")
+			return makePositionIndex(arguments);
+		else if (arg == "-findposition")
+			return findPosition(arguments);
 	}
 
 	s_match = parseMatch(arguments, app);
@@ -1242,5 +1454,10 @@ int main(int argc, char* argv[])
 	QObject::connect(s_match, SIGNAL(finished()), &app, SLOT(quit()));
 
 	s_match->start();
-	return app.exec();
+	int ret = app.exec();
+
+	// Write the final state of the live files
+	LiveFileWriter::instance()->stop();
+
+	return ret;
 }
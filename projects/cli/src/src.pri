@@ -1,8 +1,14 @@
 DEPENDPATH += $$PWD
 HEADERS += $$PWD/enginematch.h \
     $$PWD/cutechesscoreapp.h \
-    $$PWD/matchparser.h
+    $$PWD/matchparser.h \
+    $$PWD/tournamentstore.h \
+    $$PWD/crosstable.h \
+    $$PWD/gameschedule.h
 SOURCES += $$PWD/main.cpp \
     $$PWD/cutechesscoreapp.cpp \
     $$PWD/enginematch.cpp \
-    $$PWD/matchparser.cpp
+    $$PWD/matchparser.cpp \
+    $$PWD/tournamentstore.cpp \
+    $$PWD/crosstable.cpp \
+    $$PWD/gameschedule.cpp
@@ -0,0 +1,305 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tournamentstore.h"
+#include <QSaveFile>
+#include <QTextStream>
+#include <jsonparser.h>
+#include <jsonserializer.h>
+
+TournamentStore::TournamentStore()
+	: m_compactionInterval(50),
+	  m_pendingEvents(0)
+{
+}
+
+TournamentStore::~TournamentStore()
+{
+	if (m_pendingEvents > 0)
+		compact();
+}
+
+QString TournamentStore::fileName() const
+{
+	return m_fileName;
+}
+
+void TournamentStore::setFileName(const QString& fileName)
+{
+	if (fileName == m_fileName)
+		return;
+
+	if (m_journal.isOpen())
+		m_journal.close();
+	m_fileName = fileName;
+}
+
+int TournamentStore::compactionInterval() const
+{
+	return m_compactionInterval;
+}
+
+void TournamentStore::setCompactionInterval(int interval)
+{
+	Q_ASSERT(interval > 0);
+	m_compactionInterval = interval;
+}
+
+QString TournamentStore::journalName(const QString& fileName)
+{
+	return fileName + ".journal";
+}
+
+bool TournamentStore::load()
+{
+	m_data.clear();
+	m_progress.clear();
+	m_pendingEvents = 0;
+
+	if (m_fileName.isEmpty())
+		return false;
+
+	if (QFile::exists(m_fileName))
+	{
+		QFile input(m_fileName);
+		if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			qWarning("cannot open tournament configuration file: %s",
+				 qUtf8Printable(m_fileName));
+			return false;
+		}
+
+		QTextStream stream(&input);
+		JsonParser jsonParser(stream);
+		m_data = jsonParser.parse().toMap();
+	}
+
+	m_progress = m_data.take("matchProgress").toList();
+	replay(m_fileName, m_data, m_progress);
+
+	return true;
+}
+
+QVariantMap TournamentStore::read(const QString& fileName)
+{
+	QFile input(fileName);
+	if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
+		return QVariantMap();
+
+	QTextStream stream(&input);
+	JsonParser jsonParser(stream);
+	QVariantMap data(jsonParser.parse().toMap());
+	if (data.isEmpty())
+		return data;
+
+	QVariantList progress(data.take("matchProgress").toList());
+	replay(fileName, data, progress);
+	data.insert("matchProgress", progress);
+
+	return data;
+}
+
+void TournamentStore::replay(const QString& fileName,
+			     QVariantMap& data,
+			     QVariantList& progress)
+{
+	QFile input(journalName(fileName));
+	if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
+		return;
+
+	QTextStream stream(&input);
+	JsonParser jsonParser(stream);
+	int count = 0;
+
+	forever
+	{
+		// The parser treats the end of the stream as an error, so
+		// a journal that ends cleanly is detected here
+		stream.skipWhiteSpace();
+		if (stream.atEnd())
+			break;
+
+		const QVariant record(jsonParser.parse());
+		// A truncated last record means the previous run was
+		// interrupted while writing it. Everything before it is valid.
+		if (jsonParser.hasError() || record.isNull())
+		{
+			qWarning("ignoring incomplete record in tournament journal %s",
+				 qUtf8Printable(input.fileName()));
+			break;
+		}
+
+		apply(record.toMap(), data, progress);
+		count++;
+	}
+
+	if (count > 0)
+		qInfo("Replayed %d events from tournament journal %s",
+		      count, qUtf8Printable(input.fileName()));
+}
+
+void TournamentStore::apply(const QVariantMap& record,
+			    QVariantMap& data,
+			    QVariantList& progress)
+{
+	const QString event(record.value("event").toString());
+	const int number = record.value("game").toInt();
+	if (number < 1)
+		return;
+
+	if (event == "start")
+	{
+		while (progress.size() >= number)
+			progress.removeLast();
+		progress.append(record.value("data"));
+	}
+	else if (event == "update")
+	{
+		if (number <= progress.size())
+			progress.replace(number - 1, record.value("data"));
+		if (record.contains("strikes"))
+			data.insert("strikes", record.value("strikes"));
+	}
+}
+
+bool TournamentStore::write(const QString& fileName, const QVariantMap& data)
+{
+	// QSaveFile replaces the old snapshot only once the new one has
+	// been written completely, so a crash always leaves one behind.
+	QSaveFile output(fileName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open tournament configuration file: %s",
+			 qUtf8Printable(fileName));
+		return false;
+	}
+
+	QTextStream out(&output);
+	JsonSerializer serializer(data);
+	serializer.serialize(out);
+	out.flush();
+
+	if (!output.commit())
+	{
+		qWarning("cannot write tournament configuration file: %s",
+			 qUtf8Printable(fileName));
+		return false;
+	}
+
+	// The journal only holds events newer than the previous
+	// snapshot, all of which are now part of the new one.
+	const QString journal(journalName(fileName));
+	if (QFile::exists(journal))
+		QFile::remove(journal);
+
+	return true;
+}
+
+bool TournamentStore::compact()
+{
+	if (m_fileName.isEmpty())
+		return false;
+
+	if (m_journal.isOpen())
+		m_journal.close();
+
+	QVariantMap data(m_data);
+	data.insert("matchProgress", m_progress);
+	if (!write(m_fileName, data))
+		return false;
+
+	m_pendingEvents = 0;
+	return true;
+}
+
+QVariantMap TournamentStore::tournamentSettings() const
+{
+	return m_data.value("tournamentSettings").toMap();
+}
+
+const QVariantList& TournamentStore::matchProgress() const
+{
+	return m_progress;
+}
+
+int TournamentStore::gameCount() const
+{
+	return m_progress.size();
+}
+
+QVariantMap TournamentStore::game(int number) const
+{
+	if (number < 1 || number > m_progress.size())
+		return QVariantMap();
+	return m_progress.at(number - 1).toMap();
+}
+
+void TournamentStore::startGame(int number, const QVariantMap& game)
+{
+	QVariantMap record;
+	record.insert("event", "start");
+	record.insert("game", number);
+	record.insert("data", game);
+
+	apply(record, m_data, m_progress);
+	append(record);
+}
+
+void TournamentStore::updateGame(int number,
+				 const QVariantMap& game,
+				 const QVariantMap& strikes)
+{
+	QVariantMap record;
+	record.insert("event", "update");
+	record.insert("game", number);
+	record.insert("data", game);
+	record.insert("strikes", strikes);
+
+	apply(record, m_data, m_progress);
+	append(record);
+}
+
+void TournamentStore::append(const QVariantMap& record)
+{
+	if (m_fileName.isEmpty())
+		return;
+
+	if (++m_pendingEvents >= m_compactionInterval)
+	{
+		compact();
+		return;
+	}
+
+	if (!m_journal.isOpen())
+	{
+		m_journal.setFileName(journalName(m_fileName));
+		if (!m_journal.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+		{
+			qWarning("cannot open tournament journal: %s",
+				 qUtf8Printable(m_journal.fileName()));
+			compact();
+			return;
+		}
+	}
+
+	QTextStream out(&m_journal);
+	JsonSerializer serializer(record);
+	serializer.serialize(out);
+	out.flush();
+	m_journal.flush();
+}
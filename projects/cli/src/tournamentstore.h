@@ -0,0 +1,129 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TOURNAMENTSTORE_H
+#define TOURNAMENTSTORE_H
+
+#include <QString>
+#include <QVariant>
+#include <QFile>
+
+
+/*!
+ * \brief In-memory state of a tournament file with an append-only journal
+ *
+ * The tournament file (snapshot) is only rewritten every
+ * compactionInterval() game events. In between, each event is
+ * appended to a journal file next to the snapshot, so the cost of
+ * recording a game does not depend on the size of the tournament.
+ *
+ * The in-memory state is the source of truth while the tournament
+ * is running. A resumed tournament is restored with read(), which
+ * replays the journal on top of the snapshot.
+ */
+class TournamentStore
+{
+	public:
+		/*! Creates a new empty store. */
+		TournamentStore();
+		/*! Compacts the store and closes the journal. */
+		~TournamentStore();
+
+		/*! Returns the name of the snapshot file. */
+		QString fileName() const;
+		/*! Sets the name of the snapshot file to \a fileName. */
+		void setFileName(const QString& fileName);
+
+		/*! Returns the number of events between two compactions. */
+		int compactionInterval() const;
+		/*!
+		 * Sets the number of game events between two compactions
+		 * to \a interval.
+		 */
+		void setCompactionInterval(int interval);
+
+		/*!
+		 * Loads the tournament state from the snapshot and journal.
+		 *
+		 * Returns false if the snapshot exists but can't be read.
+		 */
+		bool load();
+		/*!
+		 * Writes the in-memory state to the snapshot file and
+		 * removes the journal.
+		 */
+		bool compact();
+
+		/*! Returns the "tournamentSettings" section of the state. */
+		QVariantMap tournamentSettings() const;
+		/*! Returns the list of games ("matchProgress"). */
+		const QVariantList& matchProgress() const;
+		/*! Returns the number of games in matchProgress(). */
+		int gameCount() const;
+		/*!
+		 * Returns the entry of game \a number (1-based), or an
+		 * empty map if the game doesn't exist.
+		 */
+		QVariantMap game(int number) const;
+
+		/*!
+		 * Adds game \a number with data \a game to the tournament.
+		 *
+		 * Any existing entries from \a number onwards are removed.
+		 */
+		void startGame(int number, const QVariantMap& game);
+		/*!
+		 * Replaces the data of game \a number with \a game and the
+		 * players' strike counts with \a strikes.
+		 */
+		void updateGame(int number,
+				const QVariantMap& game,
+				const QVariantMap& strikes);
+
+		/*!
+		 * Reads the tournament state from \a fileName and replays
+		 * its journal on top of it.
+		 *
+		 * Returns an empty map if the file can't be read.
+		 */
+		static QVariantMap read(const QString& fileName);
+		/*!
+		 * Writes \a data as the snapshot to \a fileName and
+		 * removes the journal of the previous run.
+		 */
+		static bool write(const QString& fileName, const QVariantMap& data);
+
+	private:
+		static QString journalName(const QString& fileName);
+		static void replay(const QString& fileName,
+				   QVariantMap& data,
+				   QVariantList& progress);
+		static void apply(const QVariantMap& record,
+				  QVariantMap& data,
+				  QVariantList& progress);
+		void append(const QVariantMap& record);
+
+		QString m_fileName;
+		int m_compactionInterval;
+		int m_pendingEvents;
+		QVariantMap m_data;
+		QVariantList m_progress;
+		QFile m_journal;
+};
+
+#endif // TOURNAMENTSTORE_H
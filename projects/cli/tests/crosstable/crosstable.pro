@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_crosstable
+HEADERS += referencetables.h
+SOURCES += tst_crosstable.cpp \
+    referencetables.cpp \
+    $$PWD/../../src/crosstable.cpp \
+    $$PWD/../../src/gameschedule.cpp
@@ -0,0 +1,37 @@
+#ifndef REFERENCETABLES_H
+#define REFERENCETABLES_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVariant>
+
+/*!
+ * The schedule and crosstable generators of EngineMatch as they were
+ * before CrossTable and GameSchedule replaced them. The tests compare
+ * the output of the new classes against these byte for byte.
+ */
+namespace ReferenceTables {
+
+struct ReferencePlayer
+{
+	QString name;
+	int rating;
+	int strikes;
+};
+
+void writeSchedule(const QString& scheduleFile,
+		   const QVariantList& pList,
+		   QList< QPair<QString, QString> > pairings,
+		   const QList<ReferencePlayer>& players,
+		   int strikeLimit);
+void writeCrossTable(const QString& crossTableFile,
+		     const QVariantList& pList,
+		     const QVariantMap& tsMap,
+		     const QList<ReferencePlayer>& players,
+		     int strikeLimit,
+		     qreal m_eloKfactor);
+
+} // namespace ReferenceTables
+
+#endif // REFERENCETABLES_H
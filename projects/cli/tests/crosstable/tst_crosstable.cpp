@@ -0,0 +1,188 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <jsonparser.h>
+#include <crosstable.h>
+#include <gameschedule.h>
+#include "referencetables.h"
+
+using ReferenceTables::ReferencePlayer;
+
+class tst_CrossTable: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void recordedTournament_data() const;
+		void recordedTournament();
+
+	private:
+		void updatePlayers(int gameCount);
+		void compareOutput(const QVariantList& progress, const QString& step);
+
+		QTemporaryDir m_dir;
+		QVariantMap m_tournament;
+		QList< QPair<QString, QString> > m_pairings;
+		QList<ReferencePlayer> m_players;
+		QSet<QString> m_disqualified;
+		int m_maxNameLength;
+		CrossTable m_crossTable;
+		GameSchedule m_schedule;
+};
+
+void tst_CrossTable::recordedTournament_data() const
+{
+	QTest::addColumn<QString>("fileName");
+
+	QTest::newRow("round-robin") << QFINDTESTDATA("roundrobin.json");
+	QTest::newRow("gauntlet") << QFINDTESTDATA("gauntlet.json");
+}
+
+void tst_CrossTable::updatePlayers(int gameCount)
+{
+	// Like EngineMatch::updatePlayers(), which runs on every game
+	// event. A player's strikes count from game "strikesAfter" on.
+	const int strikeLimit = m_tournament.value("strikes").toInt();
+	const QVariantList players(m_tournament.value("players").toList());
+
+	m_players.clear();
+	m_disqualified.clear();
+	m_maxNameLength = 0;
+	for (int i = 0; i < players.size(); i++)
+	{
+		const QVariantMap player(players.at(i).toMap());
+		ReferencePlayer plr;
+		plr.name = player.value("name").toString();
+		plr.rating = player.value("rating").toInt();
+		plr.strikes = 0;
+		if (gameCount >= player.value("strikesAfter").toInt())
+			plr.strikes = player.value("strikes").toInt();
+
+		const bool disqualified = strikeLimit > 0 && plr.strikes >= strikeLimit;
+		if (disqualified)
+			m_disqualified.insert(plr.name);
+		m_maxNameLength = qMax(m_maxNameLength, plr.name.length());
+		m_crossTable.setPlayer(i, plr.name, plr.rating, plr.strikes, disqualified);
+		m_players << plr;
+	}
+}
+
+void tst_CrossTable::compareOutput(const QVariantList& progress, const QString& step)
+{
+	const QVariantMap settings(m_tournament.value("tournamentSettings").toMap());
+	const QString crossTable(m_dir.path() + "/tournament_crosstable");
+	const QString schedule(m_dir.path() + "/tournament_schedule");
+	const QString refCrossTable(m_dir.path() + "/reference_crosstable");
+	const QString refSchedule(m_dir.path() + "/reference_schedule");
+
+	QVERIFY(m_crossTable.writeJson(crossTable,
+				       settings.value("name").toString(),
+				       settings.value("type").toString()));
+	QVERIFY(m_crossTable.writeText(crossTable));
+	QVERIFY(m_schedule.writeJson(schedule, m_pairings, m_disqualified));
+	QVERIFY(m_schedule.writeText(schedule, m_pairings, m_disqualified,
+				     m_maxNameLength));
+
+	ReferenceTables::writeCrossTable(refCrossTable, progress, settings,
+					 m_players,
+					 m_tournament.value("strikes").toInt(),
+					 m_tournament.value("eloKfactor").toDouble());
+	ReferenceTables::writeSchedule(refSchedule, progress, m_pairings,
+				       m_players,
+				       m_tournament.value("strikes").toInt());
+
+	const QStringList files = QStringList()
+		<< "_crosstable.json" << "_crosstable.txt"
+		<< "_schedule.json" << "_schedule.txt";
+	for (const QString& file : files)
+	{
+		QFile actual(m_dir.path() + "/tournament" + file);
+		QFile expected(m_dir.path() + "/reference" + file);
+		QVERIFY2(actual.open(QIODevice::ReadOnly), qPrintable(actual.fileName()));
+		QVERIFY2(expected.open(QIODevice::ReadOnly), qPrintable(expected.fileName()));
+
+		const QByteArray actualData(actual.readAll());
+		const QByteArray expectedData(expected.readAll());
+		if (actualData != expectedData)
+			qWarning("%s differs after %s:\n%s\nexpected:\n%s",
+				 qUtf8Printable(file), qUtf8Printable(step),
+				 actualData.constData(), expectedData.constData());
+		QVERIFY(actualData == expectedData);
+	}
+}
+
+void tst_CrossTable::recordedTournament()
+{
+	QFETCH(QString, fileName);
+	QVERIFY(m_dir.isValid());
+
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+	QTextStream stream(&file);
+	stream.setCodec("UTF-8");
+	JsonParser parser(stream);
+	m_tournament = parser.parse().toMap();
+	QVERIFY(!parser.hasError());
+
+	m_pairings.clear();
+	const QVariantList pairings(m_tournament.value("pairings").toList());
+	for (const QVariant& pairing : pairings)
+	{
+		const QVariantList players(pairing.toList());
+		m_pairings << qMakePair(players.at(0).toString(),
+					players.at(1).toString());
+	}
+
+	m_crossTable.clear();
+	m_crossTable.setEloKfactor(m_tournament.value("eloKfactor").toDouble());
+	m_schedule.clear();
+	updatePlayers(0);
+
+	// The recorded games are replayed the way EngineMatch records
+	// them: every game is first added as in progress and then
+	// replaced with its final entry. Both tables are written and
+	// compared after each event, so the cached parts are covered.
+	const QVariantList recorded(m_tournament.value("matchProgress").toList());
+	QVariantList progress;
+	for (int i = 0; i < recorded.size(); i++)
+	{
+		const int number = i + 1;
+		const QVariantMap game(recorded.at(i).toMap());
+
+		// Skipped games are recorded as they are
+		QVariantMap started(game);
+		if (game.value("terminationDetails").toString() != "Skipped")
+		{
+			started.clear();
+			started.insert("index", number);
+			started.insert("white", game.value("white"));
+			started.insert("black", game.value("black"));
+			started.insert("startTime", game.value("startTime"));
+			started.insert("result", "*");
+			started.insert("terminationDetails", "in progress");
+		}
+
+		progress << started;
+		updatePlayers(i);
+		m_schedule.setGame(number, started);
+		compareOutput(progress, QString("game %1 started").arg(number));
+		if (QTest::currentTestFailed())
+			return;
+
+		if (started == game)
+			continue;
+
+		progress[i] = game;
+		updatePlayers(number);
+		m_schedule.setGame(number, game);
+		m_crossTable.addResult(number,
+				       game.value("white").toString(),
+				       game.value("black").toString(),
+				       game.value("result").toString());
+		compareOutput(progress, QString("game %1 finished").arg(number));
+		if (QTest::currentTestFailed())
+			return;
+	}
+}
+
+QTEST_MAIN(tst_CrossTable)
+#include "tst_crosstable.moc"
@@ -0,0 +1,18 @@
+TEMPLATE = app
+
+win32:config += CONSOLE
+
+mac {
+	CONFIG -= app_bundle
+}
+
+QT = core testlib
+
+include(../../lib/lib.pri)
+include(../../lib/libexport.pri)
+
+INCLUDEPATH += $$PWD/../src
+DEPENDPATH += $$PWD/../src
+
+OBJECTS_DIR = .obj
+MOC_DIR = .moc
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_tournamentstore
+SOURCES += tst_tournamentstore.cpp \
+    $$PWD/../../src/tournamentstore.cpp
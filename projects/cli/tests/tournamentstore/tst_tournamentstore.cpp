@@ -0,0 +1,140 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <jsonserializer.h>
+#include <tournamentstore.h>
+
+namespace {
+
+int s_warnings = 0;
+
+void countWarnings(QtMsgType type, const QMessageLogContext&, const QString&)
+{
+	if (type == QtWarningMsg)
+		s_warnings++;
+}
+
+} // anonymous namespace
+
+class tst_TournamentStore: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void init();
+		void cleanup();
+
+		void intactJournal();
+		void truncatedJournal();
+		void compaction();
+
+	private:
+		QString writeJournal();
+
+		QTemporaryDir m_dir;
+		QtMessageHandler m_handler;
+};
+
+void tst_TournamentStore::init()
+{
+	s_warnings = 0;
+	m_handler = qInstallMessageHandler(countWarnings);
+}
+
+void tst_TournamentStore::cleanup()
+{
+	qInstallMessageHandler(m_handler);
+}
+
+QString tst_TournamentStore::writeJournal()
+{
+	const QString fileName(m_dir.path() + "/tournament.json");
+	QVariantMap snapshot;
+	snapshot.insert("matchProgress", QVariantList());
+	if (!TournamentStore::write(fileName, snapshot))
+		return QString();
+
+	// The records are written the same way as by TournamentStore
+	QVariantMap game;
+	game.insert("white", "A");
+	QVariantList records;
+	QVariantMap record;
+	record.insert("event", "start");
+	record.insert("game", 1);
+	record.insert("data", game);
+	records << record;
+	game.insert("result", "1-0");
+	record.insert("event", "update");
+	record.insert("data", game);
+	record.insert("strikes", QVariantMap());
+	records << record;
+	record.remove("strikes");
+	record.insert("event", "start");
+	record.insert("game", 2);
+	records << record;
+
+	QFile journal(fileName + ".journal");
+	if (!journal.open(QIODevice::WriteOnly | QIODevice::Text))
+		return QString();
+
+	QString text;
+	QTextStream out(&text);
+	for (const QVariant& value : qAsConst(records))
+	{
+		JsonSerializer serializer(value);
+		serializer.serialize(out);
+	}
+	out.flush();
+	journal.write(text.toUtf8());
+
+	return text;
+}
+
+void tst_TournamentStore::intactJournal()
+{
+	QVERIFY(m_dir.isValid());
+	QVERIFY(!writeJournal().isEmpty());
+
+	const QVariantMap data(TournamentStore::read(m_dir.path() + "/tournament.json"));
+	const QVariantList progress(data.value("matchProgress").toList());
+	QCOMPARE(progress.size(), 2);
+	QCOMPARE(progress.at(0).toMap().value("result").toString(), QString("1-0"));
+	QCOMPARE(s_warnings, 0);
+}
+
+void tst_TournamentStore::truncatedJournal()
+{
+	QVERIFY(m_dir.isValid());
+	const QString text(writeJournal());
+	QVERIFY(!text.isEmpty());
+
+	// Cut the last record in half
+	const QString fileName(m_dir.path() + "/tournament.json");
+	QFile journal(fileName + ".journal");
+	QVERIFY(journal.open(QIODevice::WriteOnly | QIODevice::Truncate));
+	journal.write(text.left(text.size() - 10).toUtf8());
+	journal.close();
+
+	const QVariantMap data(TournamentStore::read(fileName));
+	QCOMPARE(data.value("matchProgress").toList().size(), 1);
+	QCOMPARE(s_warnings, 1);
+}
+
+void tst_TournamentStore::compaction()
+{
+	QVERIFY(m_dir.isValid());
+	QVERIFY(!writeJournal().isEmpty());
+
+	const QString fileName(m_dir.path() + "/tournament.json");
+	const QVariantMap data(TournamentStore::read(fileName));
+	QVERIFY(TournamentStore::write(fileName, data));
+
+	// The new snapshot replaces the old one in place and absorbs
+	// the journal; no temporary file is left next to it.
+	QCOMPARE(QDir(m_dir.path()).entryList(QDir::Files),
+		 QStringList() << "tournament.json");
+	QCOMPARE(TournamentStore::read(fileName), data);
+	QCOMPARE(s_warnings, 0);
+}
+
+QTEST_MAIN(tst_TournamentStore)
+#include "tst_tournamentstore.moc"
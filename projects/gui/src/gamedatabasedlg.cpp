@@ -30,7 +30,8 @@
 #include <pgnstream.h>
 #include <pgngame.h>
 #include <pgngameentry.h>
-#include <polyglotbook.h>
+#include <polyglotbookbuilder.h>
+#include <positionindex.h>
 
 #include "pgndatabasemodel.h"
 #include "pgngameentrymodel.h"
@@ -56,6 +57,7 @@ class PgnGameIterator
 		int count() const;
 		bool hasNext() const;
 		PgnGame next(bool* ok, int depth = INT_MAX - 1);
+		QString nextPosition(qint64* pos);
 
 	private:
 		const GameDatabaseDialog* m_dlg;
@@ -121,6 +123,22 @@ PgnGame PgnGameIterator::next(bool* ok, int depth)
 	return game;
 }
 
+QString PgnGameIterator::nextPosition(qint64* pos)
+{
+	Q_ASSERT(hasNext());
+
+	int dbIndex = m_dlg->databaseIndexFromGame(m_gameIndex);
+	Q_ASSERT(dbIndex != -1);
+
+	const PgnGameEntry* entry = m_dlg->m_pgnGameEntryModel->entryAt(m_gameIndex++);
+	const PgnDatabase* db = m_dlg->m_dbManager->databases().at(dbIndex);
+	if (db->status() != PgnDatabase::Ok)
+		return QString();
+
+	*pos = entry->pos();
+	return db->fileName();
+}
+
 
 class BookExportTask : public ThreadedTask
 {
@@ -132,6 +150,10 @@ class BookExportTask : public ThreadedTask
 			       int maxDepth,
 			       QWidget* parent);
 
+	signals:
+		/*! Emitted if the book can't be written to the file. */
+		void writeFailed(const QString& errorString);
+
 	protected:
 		virtual void run();
 
@@ -158,31 +180,45 @@ BookExportTask::BookExportTask(PgnGameIterator* it,
 
 void BookExportTask::run()
 {
-	QDataStream out(m_file);
-	PolyglotBook openingBook;
+	// The games are parsed by the builder's worker threads in
+	// batches of games from the same file
+	const int batchSize = 512;
+	PolyglotBookBuilder builder(m_depth);
+	QString batchFile;
+	QVector<qint64> batch;
 
 	int i = 0;
 	while (m_it->hasNext())
 	{
-		bool ok;
-		PgnGame game(m_it->next(&ok, m_depth));
+		qint64 pos = 0;
+		const QString fileName(m_it->nextPosition(&pos));
+		i++;
+		if (fileName.isEmpty())
+			continue;
 
-		if (ok)
+		if (fileName != batchFile || batch.size() >= batchSize)
 		{
-			openingBook.import(game, m_depth);
-			if (++i % 512 == 0)
-			{
-				if (cancelRequested())
-					break;
-				emit progressValueChanged(i);
-			}
+			if (cancelRequested())
+				break;
+			if (!batch.isEmpty())
+				builder.addPgnGames(batchFile, batch);
+			emit progressValueChanged(builder.gameCount());
+
+			batchFile = fileName;
+			batch.clear();
 		}
+		batch.append(pos);
 	}
+	if (cancelRequested())
+		builder.cancel();
+	else if (!batch.isEmpty())
+		builder.addPgnGames(batchFile, batch);
 
 	// Write the already imported games to the book
 	// even if cancel was requested.
 	emit statusMessageChanged(tr("Writing opening book to disk"));
-	out << &openingBook;
+	if (!builder.write(m_file))
+		emit writeFailed(m_file->errorString());
 
 	delete m_it;
 	delete m_file;
@@ -366,13 +402,21 @@ void GameDatabaseDialog::databaseSelectionChanged(const QItemSelection& selected
 		return;
 	}
 
+	m_pgnGameEntryModel->setEntries(selectedEntries());
+	ui->m_advancedSearchBtn->setEnabled(true);
+}
+
+QList<const PgnGameEntry*> GameDatabaseDialog::selectedEntries() const
+{
 	QList<const PgnGameEntry*> entries;
 	QMap<int, PgnDatabase*>::const_iterator it;
 	for (it = m_selectedDatabases.constBegin(); it != m_selectedDatabases.constEnd(); ++it)
-		entries.append(it.value()->entries());
+	{
+		for (const PgnGameEntry& entry : it.value()->entries())
+			entries.append(&entry);
+	}
 
-	m_pgnGameEntryModel->setEntries(entries);
-	ui->m_advancedSearchBtn->setEnabled(true);
+	return entries;
 }
 
 void GameDatabaseDialog::gameSelectionChanged(const QModelIndex& current,
@@ -457,6 +501,15 @@ void GameDatabaseDialog::gameSelectionChanged(const QModelIndex& current,
 
 void GameDatabaseDialog::updateSearch(const QString& terms)
 {
+	if (!ui->m_searchEdit->isEnabled())
+	{
+		// Leave the advanced search, which may have replaced the
+		// entries with the games of a position search
+		ui->m_searchEdit->clear();
+		ui->m_searchEdit->setEnabled(true);
+		m_pgnGameEntryModel->setEntries(selectedEntries());
+	}
+
 	ui->m_clearBtn->setEnabled(!terms.isEmpty());
 	m_searchTerms = terms;
 	m_searchTimer.start(500);
@@ -473,24 +526,85 @@ void GameDatabaseDialog::onAdvancedSearch()
 	if (dlg.exec() != QDialog::Accepted)
 		return;
 
+	const QString fen(dlg.fen());
+	QList<const PgnGameEntry*> entries(selectedEntries());
+	if (!fen.isEmpty() && !positionEntries(fen, &entries))
+		return;
+
 	ui->m_searchEdit->setText(tr("[Advanced search]"));
 	ui->m_searchEdit->setEnabled(false);
+	m_pgnGameEntryModel->setEntries(entries);
 	m_pgnGameEntryModel->setFilter(dlg.filter());
 	ui->m_clearBtn->setEnabled(true);
 }
 
+bool GameDatabaseDialog::positionEntries(const QString& fen,
+					 QList<const PgnGameEntry*>* entries)
+{
+	const quint64 key = PositionIndex::fenKey(fen);
+	if (key == 0)
+	{
+		QMessageBox::warning(this, tr("Advanced Search"),
+			tr("Invalid FEN string: %1").arg(fen));
+		return false;
+	}
+
+	entries->clear();
+	QStringList unindexed;
+	QMap<int, PgnDatabase*>::const_iterator it;
+	for (it = m_selectedDatabases.constBegin(); it != m_selectedDatabases.constEnd(); ++it)
+	{
+		const PgnDatabase* db = it.value();
+		PositionIndex index;
+		if (!index.open(PositionIndex::indexFileName(db->fileName()))
+		||  !index.isCurrent(db->fileName())
+		||  index.gameCount() != db->entries().size())
+		{
+			unindexed.append(db->displayName());
+			continue;
+		}
+
+		// The hits of a game are next to each other
+		const QVector<PositionIndex::Hit> hits(index.find(key));
+		int lastGame = -1;
+		for (const PositionIndex::Hit& hit : hits)
+		{
+			if (int(hit.game) == lastGame)
+				continue;
+			lastGame = int(hit.game);
+			entries->append(&db->entries().at(lastGame));
+		}
+	}
+
+	if (!unindexed.isEmpty())
+	{
+		QMessageBox::warning(this, tr("Advanced Search"),
+			tr("These databases have no up-to-date position index "
+			   "and were not searched:\n%1\n\n"
+			   "Enable position indexes in the settings and "
+			   "import the databases again.")
+			.arg(unindexed.join('\n')));
+	}
+
+	return true;
+}
+
 int GameDatabaseDialog::databaseIndexFromGame(int game) const
 {
 	if (m_selectedDatabases.isEmpty())
 		return -1;
 
-	game = m_pgnGameEntryModel->sourceIndex(game);
+	// The model may only have some of the games of a database, eg.
+	// after a position search
+	const PgnGameEntry* entry = m_pgnGameEntryModel->entryAt(game);
 
 	QMap<int, PgnDatabase*>::const_iterator it;
 	for (it = m_selectedDatabases.constBegin(); it != m_selectedDatabases.constEnd(); ++it)
 	{
-		game -= it.value()->entries().count();
-		if (game < 0)
+		const QVector<PgnGameEntry>& entries = it.value()->entries();
+		if (!entries.isEmpty()
+		&&  entry >= entries.constData()
+		&&  entry < entries.constData() + entries.size())
 			return it.key();
 	}
 
@@ -541,6 +655,13 @@ void GameDatabaseDialog::createOpeningBook()
 
 	BookExportTask* task = new BookExportTask(new PgnGameIterator(this),
 						  file, depth, this);
+	connect(task, &BookExportTask::writeFailed, this,
+		[=](const QString& errorString)
+	{
+		QMessageBox::critical(this, tr("File Error"),
+				      tr("Error while saving file %1\n%2")
+				      .arg(fileName, errorString));
+	});
 	task->start();
 }
 
@@ -29,6 +29,7 @@ class GameDatabaseManager;
 class PgnDatabaseModel;
 class PgnGameEntryModel;
 class PgnDatabase;
+class PgnGameEntry;
 class GameViewer;
 
 namespace Ui {
@@ -68,6 +69,9 @@ class GameDatabaseDialog : public QDialog
 	private:
 		friend class PgnGameIterator;
 		int databaseIndexFromGame(int game) const;
+		QList<const PgnGameEntry*> selectedEntries() const;
+		bool positionEntries(const QString& fen,
+				     QList<const PgnGameEntry*>* entries);
 
 		GameViewer* m_gameViewer;
 		PgnGame m_game;
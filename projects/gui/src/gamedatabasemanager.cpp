@@ -18,9 +18,13 @@
 
 #include "gamedatabasemanager.h"
 
+#include <limits>
 #include <QFileInfo>
 #include <QDataStream>
+#include <QSaveFile>
 #include <QThreadPool>
+#include <QSettings>
+#include <QtConcurrentRun>
 
 #include <pgngameentry.h>
 
@@ -30,16 +34,61 @@
 #include "cutechessapp.h"
 
 #define GAME_DATABASE_STATE_MAGIC   0xDEADD00D
-#define GAME_DATABASE_STATE_VERSION 1
+#define GAME_DATABASE_STATE_VERSION 2
+
+namespace {
+
+// Version 1 state files store the entries with QDataStream after the
+// database information. Version 2 state files only store the size
+// and the offset of each database's entry table, and the tables
+// follow the database information.
+struct DatabaseState
+{
+	QString fileName;
+	QDateTime lastModified;
+	QString displayName;
+	qint32 entryCount;
+	qint64 tableOffset;
+	qint64 tableSize;
+};
+
+// The entry tables start at 8-byte boundaries
+qint64 alignTableOffset(qint64 offset)
+{
+	return (offset + 7) & ~qint64(7);
+}
+
+QVector<PgnDatabase::Status> checkDatabaseFiles(const QStringList& fileNames,
+						const QList<QDateTime>& lastModified)
+{
+	QVector<PgnDatabase::Status> statuses;
+	for (int i = 0; i < fileNames.size(); i++)
+	{
+		const QFileInfo fileInfo(fileNames.at(i));
+		if (!fileInfo.exists())
+			statuses << PgnDatabase::DoesNotExist;
+		else if (fileInfo.lastModified() > lastModified.at(i))
+			statuses << PgnDatabase::Modified;
+		else
+			statuses << PgnDatabase::Ok;
+	}
+
+	return statuses;
+}
+
+} // anonymous namespace
 
 GameDatabaseManager::GameDatabaseManager(QObject* parent)
 	: QObject(parent),
 	  m_modified(false)
 {
+	connect(&m_validation, SIGNAL(finished()),
+		this, SLOT(onValidationFinished()));
 }
 
 GameDatabaseManager::~GameDatabaseManager()
 {
+	m_validation.waitForFinished();
 	qDeleteAll(m_databases);
 }
 
@@ -50,34 +99,63 @@ QList<PgnDatabase*> GameDatabaseManager::databases() const
 
 bool GameDatabaseManager::writeState(const QString& fileName)
 {
-	QFile stateFile(fileName);
+	QSaveFile stateFile(fileName);
 
-	if (!stateFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	if (!stateFile.open(QIODevice::WriteOnly))
 		return false;
 
-	QDataStream out(&stateFile);
-	out.setVersion(QDataStream::Qt_4_6); // don't change
+	// The entry tables that haven't been read yet are copied out of
+	// the current state file, which is about to be replaced
+	QVector<QByteArray> tables;
+	for (PgnDatabase* db : qAsConst(m_databases))
+		tables << db->entryTable();
+
+	// The database information is written twice: first to find out
+	// its size, and then with the offsets of the entry tables
+	QByteArray header;
+	qint64 headerSize = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		header.clear();
+		QDataStream out(&header, QIODevice::WriteOnly);
+		out.setVersion(QDataStream::Qt_4_6); // don't change
 
-	// Write magic number and version
-	out << (quint32)GAME_DATABASE_STATE_MAGIC;
-	out << (quint32)GAME_DATABASE_STATE_VERSION;
+		// Write magic number and version
+		out << (quint32)GAME_DATABASE_STATE_MAGIC;
+		out << (quint32)GAME_DATABASE_STATE_VERSION;
 
-	// Write the number of databases
-	out << (qint32)m_databases.count();
+		// Write the number of databases
+		out << (qint32)m_databases.count();
 
-	// Write the contents of the databases
-	for (const PgnDatabase* db : qAsConst(m_databases))
+		// Write the database information
+		qint64 offset = alignTableOffset(headerSize);
+		for (int i = 0; i < m_databases.count(); i++)
+		{
+			const PgnDatabase* db = m_databases.at(i);
+			out << db->fileName();
+			out << db->lastModified();
+			out << db->displayName();
+			out << (qint32)db->entryCount();
+			out << offset;
+			out << (qint64)tables.at(i).size();
+
+			offset = alignTableOffset(offset + tables.at(i).size());
+		}
+		headerSize = header.size();
+	}
+
+	// Write the entry tables
+	stateFile.write(header);
+	for (const QByteArray& table : qAsConst(tables))
 	{
-		out << db->fileName();
-		out << db->lastModified();
-		out << db->displayName();
-		out << (qint32)db->entries().count();
-
-		const auto entries = db->entries();
-		for (const PgnGameEntry* entry : entries)
-			entry->write(out);
+		const qint64 padding = alignTableOffset(stateFile.pos()) - stateFile.pos();
+		stateFile.write(QByteArray(int(padding), '\0'));
+		stateFile.write(table);
 	}
 
+	if (!stateFile.commit())
+		return false;
+
 	m_modified = false;
 
 	return true;
@@ -85,12 +163,12 @@ bool GameDatabaseManager::writeState(const QString& fileName)
 
 bool GameDatabaseManager::readState(const QString& fileName)
 {
-	QFile stateFile(fileName);
+	QSharedPointer<QFile> stateFile(new QFile(fileName));
 
-	if (!stateFile.open(QIODevice::ReadOnly))
+	if (!stateFile->open(QIODevice::ReadOnly))
 		return false;
 
-	QDataStream in(&stateFile);
+	QDataStream in(stateFile.data());
 	in.setVersion(QDataStream::Qt_4_6); // don't change
 
 	// Read and verify the magic value
@@ -107,10 +185,8 @@ bool GameDatabaseManager::readState(const QString& fileName)
 	quint32 version;
 	in >> version;
 
-	if (version < GAME_DATABASE_STATE_VERSION ||
-	    version > GAME_DATABASE_STATE_VERSION)
+	if (version < 1 || version > GAME_DATABASE_STATE_VERSION)
 	{
-		// TODO: Add backward compatibility
 		qWarning("GameDatabaseManager: state file version mismatch");
 		return false;
 	}
@@ -119,65 +195,134 @@ bool GameDatabaseManager::readState(const QString& fileName)
 	qint32 dbCount;
 	in >> dbCount;
 
-	// Read the contents of the databases
-	QString dbFileName;
-	QDateTime dbLastModified;
-	QString dbDisplayName;
+	// Read the database information
+	QVector<DatabaseState> states(qMax(0, dbCount));
 	QList<PgnDatabase*> readDatabases;
 
-	for (int i = 0; i < dbCount; i++)
+	for (DatabaseState& state : states)
 	{
-		in >> dbFileName;
-		in >> dbLastModified;
-		in >> dbDisplayName;
+		in >> state.fileName;
+		in >> state.lastModified;
+		in >> state.displayName;
+		in >> state.entryCount;
+
+		PgnDatabase* db = new PgnDatabase(state.fileName);
+		db->setLastModified(state.lastModified);
+		db->setDisplayName(state.displayName);
+		readDatabases << db;
 
-		// Check if the database exists
-		QFileInfo fileInfo(dbFileName);
-		if (!fileInfo.exists())
+		if (version == 1)
 		{
-			m_modified = true;
-			continue;
+			// Read the entries
+			QVector<PgnGameEntry> entries(qMax(0, state.entryCount));
+			for (PgnGameEntry& entry : entries)
+				entry.read(in);
+			db->setEntries(entries);
 		}
-
-		// Check if the database has been modified
-		if (fileInfo.lastModified() > dbLastModified)
+		else
 		{
-			m_modified = true;
-			importPgnFile(dbFileName);
-			continue;
+			in >> state.tableOffset;
+			in >> state.tableSize;
 		}
+	}
 
-		qint32 dbEntryCount;
-		in >> dbEntryCount;
+	if (in.status() != QDataStream::Ok)
+	{
+		qWarning("GameDatabaseManager: corrupted state file");
+		qDeleteAll(readDatabases);
+		return false;
+	}
 
-		// Read the entries
-		QList<const PgnGameEntry*> entries;
-		for (int j = 0; j < dbEntryCount; j++)
+	// The entry tables are mapped into memory and the entries are
+	// read from them when they're needed
+	if (version >= 2)
+	{
+		const qint64 fileSize = stateFile->size();
+		const uchar* map = stateFile->map(0, fileSize);
+
+		for (int i = 0; i < states.size(); i++)
 		{
-			PgnGameEntry* entry = new PgnGameEntry;
-			entry->read(in);
-			entries << entry;
+			const DatabaseState& state = states.at(i);
+			if (state.tableOffset < 0 || state.tableSize < 0
+			||  state.tableSize > std::numeric_limits<int>::max()
+			||  state.tableOffset > fileSize - state.tableSize)
+			{
+				qWarning("GameDatabaseManager: corrupted state file");
+				qDeleteAll(readDatabases);
+				return false;
+			}
+
+			if (map != nullptr)
+			{
+				const QByteArray table(QByteArray::fromRawData(
+					reinterpret_cast<const char*>(map + state.tableOffset),
+					int(state.tableSize)));
+				readDatabases.at(i)->setEntryTable(table, state.entryCount,
+								   stateFile);
+			}
+			else
+			{
+				stateFile->seek(state.tableOffset);
+				readDatabases.at(i)->setEntryTable(
+					stateFile->read(state.tableSize),
+					state.entryCount);
+			}
 		}
-
-		PgnDatabase* db = new PgnDatabase(dbFileName);
-		db->setEntries(entries);
-		db->setLastModified(dbLastModified);
-		db->setDisplayName(dbDisplayName);
-
-		readDatabases << db;
 	}
 
-	m_modified = false;
+	// Old state files are written again in the current format
+	m_modified = version < GAME_DATABASE_STATE_VERSION;
 
 	m_databases = readDatabases;
 	emit databasesReset();
 
+	validateDatabases();
+
 	return true;
 }
 
+void GameDatabaseManager::validateDatabases()
+{
+	m_validation.waitForFinished();
+
+	QStringList fileNames;
+	QList<QDateTime> lastModified;
+	for (const PgnDatabase* db : qAsConst(m_databases))
+	{
+		fileNames << db->fileName();
+		lastModified << db->lastModified();
+	}
+
+	m_validatedDatabases = m_databases;
+	m_validation.setFuture(QtConcurrent::run(checkDatabaseFiles,
+						 fileNames, lastModified));
+}
+
+void GameDatabaseManager::onValidationFinished()
+{
+	const QVector<PgnDatabase::Status> statuses(m_validation.result());
+	const QList<PgnDatabase*> databases(m_validatedDatabases);
+	m_validatedDatabases.clear();
+
+	for (int i = 0; i < statuses.size(); i++)
+	{
+		// The database may have been removed in the meantime
+		int index = m_databases.indexOf(databases.at(i));
+		if (index == -1)
+			continue;
+
+		if (statuses.at(i) == PgnDatabase::DoesNotExist)
+			removeDatabase(index);
+		else if (statuses.at(i) == PgnDatabase::Modified)
+			importDatabaseAgain(index);
+	}
+}
+
 void GameDatabaseManager::importPgnFile(const QString& fileName)
 {
 	PgnImporter* pgnImporter = new PgnImporter(fileName);
+	pgnImporter->setPositionIndexEnabled(
+		QSettings().value("games/position_index", false).toBool());
 	connect(pgnImporter, SIGNAL(databaseRead(PgnDatabase*)),
 		this, SLOT(addDatabase(PgnDatabase*)));
 
@@ -21,9 +21,11 @@
 
 #include <QObject>
 #include <QList>
+#include <QVector>
+#include <QFutureWatcher>
+#include "pgndatabase.h"
 
 class PgnImporter;
-class PgnDatabase;
 
 /*!
  * \brief Manages chess game databases.
@@ -54,6 +56,11 @@ class GameDatabaseManager : public QObject
 		/*!
 		 * Reads the state from a file pointed by \a fileName.
 		 *
+		 * The game entries of the databases are read when they're
+		 * accessed for the first time. The database files are
+		 * checked in the background: databases that no longer exist
+		 * are removed, and modified databases are imported again.
+		 *
 		 * \sa writeState
 		 */
 		bool readState(const QString& fileName);
@@ -108,9 +115,16 @@ class GameDatabaseManager : public QObject
 		 */
 		void databasesReset();
 
+	private slots:
+		void onValidationFinished();
+
 	private:
+		void validateDatabases();
+
 		QList<PgnDatabase*> m_databases;
 		bool m_modified;
+		QList<PgnDatabase*> m_validatedDatabases;
+		QFutureWatcher<QVector<PgnDatabase::Status>> m_validation;
 
 };
 
@@ -72,3 +72,8 @@ PgnGameFilter GameDatabaseSearchDialog::filter() const
 
 	return filter;
 }
+
+QString GameDatabaseSearchDialog::fen() const
+{
+	return ui->m_fenEdit->text().trimmed();
+}
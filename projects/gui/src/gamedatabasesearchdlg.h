@@ -43,6 +43,11 @@ class GameDatabaseSearchDialog : public QDialog
 
 		/*! Returns the PGN filter. */
 		PgnGameFilter filter() const;
+		/*!
+		 * Returns the FEN string of the position that the games
+		 * must reach, or an empty string if any games match.
+		 */
+		QString fen() const;
 
 	private slots:
 		void onResultChanged(int index);
@@ -22,6 +22,8 @@
 
 PgnDatabase::PgnDatabase(const QString& fileName, QObject* parent)
 	: QObject(parent),
+	  m_hasEntryTable(false),
+	  m_entryCount(0),
 	  m_fileName(fileName),
 	  m_displayName(QFileInfo(fileName).completeBaseName())
 {
@@ -29,20 +31,68 @@ PgnDatabase::PgnDatabase(const QString& fileName, QObject* parent)
 
 PgnDatabase::~PgnDatabase()
 {
-	qDeleteAll(m_entries);
 }
 
-void PgnDatabase::setEntries(const QList<const PgnGameEntry*>& entries)
+void PgnDatabase::setEntries(const QVector<PgnGameEntry>& entries)
 {
-	qDeleteAll(m_entries);
 	m_entries = entries;
+	m_entryCount = entries.size();
+	m_entryTable.clear();
+	m_entryTableFile.reset();
+	m_hasEntryTable = false;
 }
 
-QList<const PgnGameEntry*> PgnDatabase::entries() const
+void PgnDatabase::setEntryTable(const QByteArray& table,
+				int count,
+				const QSharedPointer<QFile>& file)
 {
+	m_entries.clear();
+	m_entryCount = count;
+	m_entryTable = table;
+	m_entryTableFile = file;
+	m_hasEntryTable = true;
+}
+
+QByteArray PgnDatabase::entryTable()
+{
+	if (!m_hasEntryTable)
+		return PgnGameEntry::writeTable(m_entries);
+
+	if (!m_entryTableFile.isNull())
+	{
+		m_entryTable = QByteArray(m_entryTable.constData(),
+					  m_entryTable.size());
+		m_entryTableFile.reset();
+	}
+	return m_entryTable;
+}
+
+void PgnDatabase::readEntryTable() const
+{
+	if (!PgnGameEntry::readTable(m_entryTable, m_entryCount, m_entries))
+	{
+		qWarning("Invalid game entry table in database %s",
+			 qUtf8Printable(m_fileName));
+		m_entryCount = 0;
+	}
+
+	m_entryTable.clear();
+	m_entryTableFile.reset();
+	m_hasEntryTable = false;
+}
+
+const QVector<PgnGameEntry>& PgnDatabase::entries() const
+{
+	if (m_hasEntryTable)
+		readEntryTable();
 	return m_entries;
 }
 
+int PgnDatabase::entryCount() const
+{
+	return m_entryCount;
+}
+
 QString PgnDatabase::fileName() const
 {
 	return m_fileName;
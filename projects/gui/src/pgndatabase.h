@@ -20,9 +20,10 @@
 #define PGN_DATABASE_H
 
 #include <QObject>
-#include <QList>
+#include <QVector>
 #include <QDateTime>
 #include <QFile>
+#include <QSharedPointer>
 #include <pgngame.h>
 #include <pgngameentry.h>
 class PgnStream;
@@ -60,19 +61,46 @@ class PgnDatabase : public QObject
 		/*!
 		 * Set the game entries found in this database to \a entries.
 		 *
-		 * The database takes ownership of the PgnGameEntry objects
-		 * in \a entries.
+		 * The entries are stored contiguously, so pointers to them
+		 * stay valid until the entries are set again.
 		 */
-		void setEntries(const QList<const PgnGameEntry*>& entries);
+		void setEntries(const QVector<PgnGameEntry>& entries);
 		/*!
-		 * Returns the list of game entries in this database.
+		 * Sets the game entries to \a count entries packed in \a table.
+		 *
+		 * The entries are read from the table when they're accessed
+		 * for the first time. If \a table refers to memory mapped
+		 * from \a file, the file is kept open until then.
+		 *
+		 * \sa PgnGameEntry::writeTable()
+		 */
+		void setEntryTable(const QByteArray& table,
+				   int count,
+				   const QSharedPointer<QFile>& file = QSharedPointer<QFile>());
+		/*!
+		 * Returns the game entries packed in a table.
+		 *
+		 * If the entries haven't been read yet, the table is copied
+		 * from the file it refers to, and the file is released.
+		 *
+		 * \sa setEntryTable()
+		 */
+		QByteArray entryTable();
+		/*!
+		 * Returns the game entries in this database.
 		 *
 		 * Game entries are light-weight "pointers" to the database. The game()
 		 * method can be used to read the move information.
 		 *
 		 * \sa game()
 		 */
-		QList<const PgnGameEntry*> entries() const;
+		const QVector<PgnGameEntry>& entries() const;
+		/*!
+		 * Returns the number of game entries.
+		 *
+		 * Unlike entries() this function doesn't read the entries.
+		 */
+		int entryCount() const;
 
 		/*! Returns the file name of this database. */
 		QString fileName() const;
@@ -122,7 +150,13 @@ class PgnDatabase : public QObject
 		Status game(const PgnGameEntry* entry, PgnGame* game);
 
 	private:
-		QList<const PgnGameEntry*> m_entries;
+		void readEntryTable() const;
+
+		mutable QVector<PgnGameEntry> m_entries;
+		mutable QByteArray m_entryTable;
+		mutable QSharedPointer<QFile> m_entryTableFile;
+		mutable bool m_hasEntryTable;
+		mutable int m_entryCount;
 		QDateTime m_lastModified;
 		QString m_fileName;
 		QString m_displayName;
@@ -21,27 +21,26 @@
 #include <pgngameentry.h>
 
 
-struct EntryContains
+struct EntryMatches
 {
-	EntryContains(const QList<const PgnGameEntry*>& entries,
-		      const PgnGameFilter& filter)
-		: m_entries(entries), m_filter(filter) { }
+	EntryMatches(const PgnTagIndex& index, const PgnGameFilter& filter)
+		: m_query(index, filter) { }
 
 	typedef bool result_type;
 
 	inline bool operator()(int index)
 	{
-		return m_entries.at(index)->match(m_filter);
+		return m_query.match(index);
 	}
 
-	const QList<const PgnGameEntry*>& m_entries;
-	PgnGameFilter m_filter;
+	PgnTagIndex::Query m_query;
 };
 
 
 PgnGameEntryModel::PgnGameEntryModel(QObject* parent)
 	: QAbstractItemModel(parent),
-	  m_entryCount(0)
+	  m_entryCount(0),
+	  m_tagIndexBuilt(false)
 {
 	connect(&m_watcher, SIGNAL(resultsReadyAt(int,int)),
 		this, SLOT(onResultsReady()));
@@ -68,6 +67,8 @@ void PgnGameEntryModel::setEntries(const QList<const PgnGameEntry*>& entries)
 	m_watcher.waitForFinished();
 
 	m_entries = entries;
+	m_tagIndex.clear();
+	m_tagIndexBuilt = false;
 
 	if (entries.size() > m_indexes.size())
 	{
@@ -85,14 +86,28 @@ void PgnGameEntryModel::onResultsReady()
 		fetchMore(QModelIndex());
 }
 
-void PgnGameEntryModel::applyFilter(const PgnGameFilter& filter)
+void PgnGameEntryModel::applyFilter(const PgnGameFilter& filter, bool narrow)
 {
 	beginResetModel();
 	m_entryCount = 0;
 
-	m_filtered = QtConcurrent::filtered(m_indexes.constBegin(),
-					    m_indexes.constBegin() + m_entries.size(),
-					    EntryContains(m_entries, filter));
+	// The tag index is only needed for filtering, so it's built
+	// when the entries are filtered for the first time
+	if (!filter.isEmpty() && !m_tagIndexBuilt)
+	{
+		m_tagIndex.build(m_entries);
+		m_tagIndexBuilt = true;
+	}
+
+	QVector<int>::const_iterator begin = m_indexes.constBegin();
+	QVector<int>::const_iterator end = begin + m_entries.size();
+	if (narrow)
+	{
+		begin = m_candidates.constBegin();
+		end = m_candidates.constEnd();
+	}
+	m_filtered = QtConcurrent::filtered(begin, end,
+					    EntryMatches(m_tagIndex, filter));
 
 	m_watcher.setFuture(m_filtered);
 	endResetModel();
@@ -100,11 +115,25 @@ void PgnGameEntryModel::applyFilter(const PgnGameFilter& filter)
 
 void PgnGameEntryModel::setFilter(const PgnGameFilter& filter)
 {
+	// When more characters are typed into the search, only the
+	// games that matched the previous terms have to be searched
+	const bool narrow = m_filtered.isFinished()
+			 && !m_filtered.isCanceled()
+			 && filter.type() == PgnGameFilter::FixedString
+			 && m_filter.type() == PgnGameFilter::FixedString
+			 && !m_filter.isEmpty()
+			 && QByteArray(filter.pattern()).toUpper().contains(
+				QByteArray(m_filter.pattern()).toUpper());
+	QVector<int> candidates;
+	if (narrow)
+		candidates = m_filtered.results().toVector();
+
 	m_watcher.cancel();
 	m_watcher.waitForFinished();
 
+	m_candidates.swap(candidates);
 	m_filter = filter;
-	applyFilter(filter);
+	applyFilter(filter, narrow);
 }
 
 QModelIndex PgnGameEntryModel::index(int row, int column,
@@ -24,7 +24,7 @@
 #include <QFuture>
 #include <QFutureWatcher>
 #include <pgngamefilter.h>
-class PgnGameEntry;
+#include <pgntagindex.h>
 
 /*!
  * \brief Supplies PGN game entry information to views.
@@ -78,10 +78,13 @@ class PgnGameEntryModel : public QAbstractItemModel
 		void onResultsReady();
 
 	private:
-		void applyFilter(const PgnGameFilter& filter);
+		void applyFilter(const PgnGameFilter& filter, bool narrow = false);
 
 		QList<const PgnGameEntry*> m_entries;
+		PgnTagIndex m_tagIndex;
+		bool m_tagIndexBuilt;
 		QVector<int> m_indexes;
+		QVector<int> m_candidates;
 		int m_entryCount;
 		QFuture<int> m_filtered;
 		QFutureWatcher<int> m_watcher;
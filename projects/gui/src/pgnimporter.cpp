@@ -20,14 +20,46 @@
 
 #include <QFile>
 #include <QFileInfo>
+#include <QtConcurrentMap>
 
 #include <pgnstream.h>
 #include <pgngameentry.h>
+#include <pgngamescanner.h>
+#include <positionindex.h>
+#include <positionindexbuilder.h>
 #include "pgndatabase.h"
 
+namespace {
+
+const qint64 ChunkSize = 4 * 1024 * 1024;
+
+struct ChunkRange
+{
+	qint64 begin;
+	qint64 end;
+};
+
+struct ScanChunk
+{
+	ScanChunk(const PgnGameScanner& scanner)
+		: m_scanner(scanner) { }
+
+	typedef PgnGameScanner::Chunk result_type;
+
+	inline PgnGameScanner::Chunk operator()(const ChunkRange& range)
+	{
+		return m_scanner.scan(range.begin, range.end);
+	}
+
+	const PgnGameScanner& m_scanner;
+};
+
+} // anonymous namespace
+
 PgnImporter::PgnImporter(const QString& fileName)
 	: Worker(QString("PGN import: %1").arg(fileName)),
-	  m_fileName(fileName)
+	  m_fileName(fileName),
+	  m_positionIndex(false)
 {
 }
 
@@ -36,12 +68,15 @@ QString PgnImporter::fileName() const
 	return m_fileName;
 }
 
+void PgnImporter::setPositionIndexEnabled(bool enabled)
+{
+	m_positionIndex = enabled;
+}
+
 void PgnImporter::work()
 {
 	QFile file(m_fileName);
 	QFileInfo fileInfo(m_fileName);
-	static const int updateInterval = 1024;
-	int numReadGames = 0;
 
 	if (!fileInfo.exists())
 	{
@@ -49,34 +84,115 @@ void PgnImporter::work()
 		return;
 	}
 
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	if (!file.open(QIODevice::ReadOnly))
 	{
 		emit error(PgnImporter::IoError);
 		return;
 	}
 
-	PgnStream pgnStream(&file);
-	QList<const PgnGameEntry*> games;
+	QVector<PgnGameEntry> games;
+	const qint64 size = file.size();
+	uchar* data = size > 0 ? file.map(0, size) : nullptr;
+	const bool mapped = data != nullptr;
+	if (mapped)
+	{
+		games = scanGames(reinterpret_cast<const char*>(data), size);
+		file.unmap(data);
+	}
+	else
+		games = readGames(&file);
 
-	for (;;)
+	PgnDatabase* db = new PgnDatabase(m_fileName);
+	db->setEntries(games);
+	db->setLastModified(fileInfo.lastModified());
+
+	emit databaseRead(db);
+
+	// The index numbers the games like the scanner, so it's only
+	// built for databases that were scanned
+	if (m_positionIndex && mapped && !cancelRequested())
 	{
-		PgnGameEntry* game = new PgnGameEntry;
-		if (cancelRequested() || !game->read(pgnStream))
+		emit statusChanged(tr("Building position index"));
+		if (!buildPositionIndex() && !cancelRequested())
+			emit statusChanged(tr("Could not build position index"));
+	}
+}
+
+bool PgnImporter::buildPositionIndex()
+{
+	PositionIndexBuilder builder(m_fileName);
+
+	// The builder polls for cancellation itself and discards
+	// a canceled index
+	builder.setCancelCallback([this]() { return cancelRequested(); });
+	return builder.write(PositionIndex::indexFileName(m_fileName));
+}
+
+QVector<PgnGameEntry> PgnImporter::scanGames(const char* data, qint64 size)
+{
+	const PgnGameScanner scanner(data, size);
+	const QVector<qint64> chunks(scanner.chunks(ChunkSize));
+
+	QVector<ChunkRange> ranges;
+	ranges.reserve(chunks.size() - 1);
+	for (int i = 1; i < chunks.size(); i++)
+	{
+		ChunkRange range = { chunks.at(i - 1), chunks.at(i) };
+		ranges.append(range);
+	}
+
+	// The chunks are scanned in parallel, and collected in file
+	// order so that the line numbers can be added up
+	QFuture<PgnGameScanner::Chunk> future =
+		QtConcurrent::mapped(ranges, ScanChunk(scanner));
+
+	QVector<PgnGameEntry> games;
+	qint64 lineCount = 0;
+	PgnGameScanner::State state = { false, false };
+	for (int i = 0; i < ranges.size(); i++)
+	{
+		if (cancelRequested())
 		{
-			delete game;
+			future.cancel();
 			break;
 		}
 
+		// A chunk whose state was guessed wrong, eg. one that
+		// starts inside a comment, is scanned again
+		PgnGameScanner::Chunk chunk(future.resultAt(i));
+		if (chunk.startState != state)
+			chunk = scanner.scan(ranges.at(i).begin,
+					     ranges.at(i).end, state);
+		state = chunk.endState;
+		PgnGameScanner::addLines(chunk.entries, lineCount);
+		lineCount += chunk.lineCount;
+		games += chunk.entries;
+
+		emit databaseReadStatus(startTime(), games.size(),
+					ranges.at(i).end);
+	}
+
+	// The workers must be done before the file is unmapped
+	future.waitForFinished();
+
+	return games;
+}
+
+QVector<PgnGameEntry> PgnImporter::readGames(QIODevice* device)
+{
+	static const int updateInterval = 1024;
+	PgnStream pgnStream(device);
+	QVector<PgnGameEntry> games;
+	PgnGameEntry game;
+
+	while (!cancelRequested() && game.read(pgnStream))
+	{
 		games << game;
-		numReadGames++;
 
-		if (numReadGames % updateInterval == 0)
-			emit databaseReadStatus(startTime(), numReadGames,
+		if (games.size() % updateInterval == 0)
+			emit databaseReadStatus(startTime(), games.size(),
 			    pgnStream.pos());
 	}
-	PgnDatabase* db = new PgnDatabase(m_fileName);
-	db->setEntries(games);
-	db->setLastModified(fileInfo.lastModified());
 
-	emit databaseRead(db);
+	return games;
 }
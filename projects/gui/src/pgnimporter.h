@@ -19,13 +19,20 @@
 #ifndef PGN_IMPORTER_H
 #define PGN_IMPORTER_H
 
+#include <QVector>
 #include <worker.h>
+#include <pgngameentry.h>
 
+class QIODevice;
 class PgnDatabase;
 
 /*!
  * \brief Reads PGN database in a separate thread.
  *
+ * The PGN file is memory-mapped and split into chunks which are
+ * scanned in parallel by PgnGameScanner. Files that can't be mapped
+ * are read sequentially.
+ *
  * \sa PgnDatabase
  */
 class PgnImporter : public Worker
@@ -47,6 +54,13 @@ class PgnImporter : public Worker
 		PgnImporter(const QString& fileName);
 		/*! Returns the file name of the database to be imported. */
 		QString fileName() const;
+		/*!
+		 * If \a enabled is true, a PositionIndex of the database
+		 * is built after the games have been read.
+		 *
+		 * The default value is false.
+		 */
+		void setPositionIndexEnabled(bool enabled);
 
 	protected:
 		void work() override;
@@ -63,7 +77,12 @@ class PgnImporter : public Worker
 		void databaseReadStatus(const QTime& started, int numReadGames, qint64 numReadBytes);
 
 	private:
+		QVector<PgnGameEntry> scanGames(const char* data, qint64 size);
+		QVector<PgnGameEntry> readGames(QIODevice* device);
+		bool buildPositionIndex();
+
 		QString m_fileName;
+		bool m_positionIndex;
 
 };
 
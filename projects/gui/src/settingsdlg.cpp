@@ -64,6 +64,12 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 				      checked);
 	});
 
+	connect(ui->m_positionIndexCheck, &QCheckBox::toggled,
+		[=](bool checked)
+	{
+		QSettings().setValue("games/position_index", checked);
+	});
+
 
 	connect(ui->m_concurrencySpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
 		this, [=](int value)
@@ -209,6 +215,8 @@ void SettingsDialog::readSettings()
 	s.beginGroup("games");
 	ui->m_humanCanPlayAfterTimeoutCheck
 		->setChecked(s.value("human_can_play_after_timeout", true).toBool());
+	ui->m_positionIndexCheck
+		->setChecked(s.value("position_index", false).toBool());
 	ui->m_defaultPgnOutFileEdit
 		->setText(s.value("default_pgn_output_file").toString());
 	s.endGroup();
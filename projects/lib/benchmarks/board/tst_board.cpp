@@ -0,0 +1,388 @@
+#include <QtTest/QtTest>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+
+/*
+ * Benchmarks the move generator with a perft tree walk, and the other
+ * board operations one at a time on the positions at the last ply of
+ * the walk.
+ *
+ * Every position has a known perft node count, which is checked on
+ * each run, so that a faster but wrong move generator fails.
+ */
+class tst_Board: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void init();
+		void cleanup();
+
+		void perft_data() const;
+		void perft();
+		void legalMoves_data() const;
+		void legalMoves();
+		void makeMove_data() const;
+		void makeMove();
+		void isLegalMove_data() const;
+		void isLegalMove();
+		void sanMoveString_data() const;
+		void sanMoveString();
+		void moveFromString_data() const;
+		void moveFromString();
+		void result_data() const;
+		void result();
+
+	private:
+		struct Node
+		{
+			Chess::Board* board;
+			QVector<Chess::Move> moves;
+		};
+
+		void addPositions(quint64 maxNodes) const;
+		void addOperationPositions() const;
+		void collectNodes(Chess::Board* board, int depth);
+
+		QVector<Node> m_nodes;
+};
+
+namespace {
+
+struct Position
+{
+	const char* variant;
+	const char* name;
+	const char* fen;
+	int depth;
+	quint64 nodes;
+};
+
+// The node counts are from the chessboard unit test and from the
+// Chess Programming Wiki
+const Position positions[] =
+{
+	{ "standard", "startpos",
+	  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	  4, Q_UINT64_C(197281) },
+	{ "standard", "kiwipete",
+	  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+	  3, Q_UINT64_C(97862) },
+	{ "standard", "pos4",
+	  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+	  5, Q_UINT64_C(674624) },
+	{ "standard", "promotions",
+	  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	  3, Q_UINT64_C(9467) },
+	{ "fischerandom", "frc2",
+	  "bnrbnkrq/pppppppp/8/8/8/8/PPPPPPPP/BNRBNKRQ w KQkq - 0 1",
+	  4, Q_UINT64_C(233585) },
+	{ "fischerandom", "frc3",
+	  "2rkr3/5PP1/8/5Q2/5q2/8/5pp1/2RKR3 w KQkq - 0 1",
+	  3, Q_UINT64_C(71005) },
+	{ "capablanca", "gothic startpos",
+	  "rnbqckabnr/pppppppppp/10/10/10/10/PPPPPPPPPP/RNBQCKABNR w KQkq - 0 1",
+	  4, Q_UINT64_C(808984) },
+	{ "crazyhouse", "promo1",
+	  "3q1bkr/2p1pBp1/q1n3p1/1N2p3/1Pp5/P4Q~2/BBPp1PPP/R2K2NR[RPPn] b - - 0 28",
+	  3, Q_UINT64_C(6386) },
+	{ "atomic", "pos1",
+	  "8/8/8/8/8/8/3k4/rR4K1 w Q - 0 1",
+	  5, Q_UINT64_C(453449) },
+	{ "berolina", "startpos",
+	  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	  4, Q_UINT64_C(882717) },
+	{ "horde", "dunsany startpos",
+	  "rnbqkbnr/pppppppp/8/8/PPPPPPPP/PPPPPPPP/PPPPPPPP/PPPPPPPP b kq - 0 1",
+	  5, Q_UINT64_C(775839) },
+	{ "andernach", "pos1",
+	  "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+	  4, Q_UINT64_C(523348) },
+	{ "racingkings", "startpos",
+	  "8/8/8/8/8/8/krbnNBRK/qrbnNBRQ w - - 0 1",
+	  4, Q_UINT64_C(296242) },
+	{ "janus", "startpos",
+	  "rjnbkqbnjr/pppppppppp/10/10/10/10/PPPPPPPPPP/RJNBKQBNJR w KQkq - 0 1",
+	  4, Q_UINT64_C(772074) },
+	{ "chancellor", "startpos",
+	  "rnbqkcnbr/ppppppppp/9/9/9/9/9/PPPPPPPPP/RNBQKCNBR w KQkq - 0 1",
+	  4, Q_UINT64_C(436656) },
+	{ "suicide", "endgame1",
+	  "8/2b5/8/3B4/8/8/2P5/8 b - - 0 1",
+	  5, Q_UINT64_C(116051) },
+	{ "courier", "traditional",
+	  "rnebmk1wbenr/1ppppp1pppp1/6f5/p5p4p/P5P4P/6F5/1PPPPP1PPPP1/RNEBMK1WBENR w - - 0 1",
+	  4, Q_UINT64_C(500337) },
+	{ "cambodian", "startpos",
+	  "rnsmksnr/8/pppppppp/8/8/PPPPPPPP/8/RNSKMSNR w DEde 0 0 1",
+	  4, Q_UINT64_C(361793) },
+	{ "sittuyin", "midgame",
+	  "8/8/6R1/s3r3/P5R1/1KP3p1/1F2kr2/8[-] b - 0 0 72",
+	  4, Q_UINT64_C(657824) },
+	{ "ai-wok", "endgame",
+	  "8/8/8/2sp2k1/7p/3P4/6K1/7r w - - 0 1",
+	  5, Q_UINT64_C(30055) },
+	{ "twokings", "endgame1",
+	  "8/8/p1k5/1p1r1K1p/1P5P/P1K5/8/8 b - - 0 121",
+	  4, Q_UINT64_C(36828) },
+	{ "grand", "endgame1",
+	  "10/4k5/6P3/10/10/10/10/10/1p2K5/10 w - - 0 1",
+	  3, Q_UINT64_C(2446) },
+	{ "seirawan", "startpos",
+	  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR[EHeh] w BCDFGbcdfgKQkq - 0 1",
+	  4, Q_UINT64_C(782599) },
+	{ "losalamos", "promotion",
+	  "6/2P3/6/1K1k2/6/6 w - - 0 1",
+	  5, Q_UINT64_C(39171) },
+	{ "chigorin", "promotion",
+	  "8/KP6/8/4k3/8/8/6p1/8 w - - 0 1",
+	  5, Q_UINT64_C(104326) }
+};
+
+// The single operations are measured only on the positions with
+// fewer nodes, because the boards at the last ply are kept in memory
+const quint64 OperationMaxNodes = 120000;
+
+quint64 perftNodes(Chess::Board* board, int depth)
+{
+	const QVector<Chess::Move> moves(board->legalMoves());
+	if (depth <= 1)
+		return moves.size();
+
+	quint64 nodes = 0;
+	for (const Chess::Move& move : moves)
+	{
+		board->makeMove(move);
+		nodes += perftNodes(board, depth - 1);
+		board->undoMove();
+	}
+
+	return nodes;
+}
+
+} // anonymous namespace
+
+void tst_Board::addPositions(quint64 maxNodes) const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<int>("depth");
+	QTest::addColumn<quint64>("nodes");
+
+	for (const Position& pos : positions)
+	{
+		if (maxNodes > 0 && pos.nodes > maxNodes)
+			continue;
+		QTest::newRow(qPrintable(QString("%1 %2").arg(pos.variant, pos.name)))
+			<< QString(pos.variant)
+			<< QString(pos.fen)
+			<< pos.depth
+			<< pos.nodes;
+	}
+}
+
+void tst_Board::addOperationPositions() const
+{
+	addPositions(OperationMaxNodes);
+}
+
+void tst_Board::init()
+{
+	// The operations are measured on the positions at the last ply
+	// of the tree walk, which are collected first
+	if (strcmp(QTest::currentTestFunction(), "perft") == 0)
+		return;
+
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(int, depth);
+	QFETCH(quint64, nodes);
+
+	QScopedPointer<Chess::Board> board(Chess::BoardFactory::create(variant));
+	QVERIFY(board != nullptr);
+	QVERIFY(board->setFenString(fen));
+	collectNodes(board.data(), depth - 1);
+
+	// The moves of the collected positions are the perft leaves
+	quint64 count = 0;
+	for (const Node& node : qAsConst(m_nodes))
+		count += node.moves.size();
+	QCOMPARE(count, nodes);
+}
+
+void tst_Board::cleanup()
+{
+	for (const Node& node : qAsConst(m_nodes))
+		delete node.board;
+	m_nodes.clear();
+}
+
+void tst_Board::collectNodes(Chess::Board* board, int depth)
+{
+	const QVector<Chess::Move> moves(board->legalMoves());
+	if (depth <= 0)
+	{
+		Node node = { board->copy(), moves };
+		m_nodes.append(node);
+		return;
+	}
+
+	for (const Chess::Move& move : moves)
+	{
+		board->makeMove(move);
+		collectNodes(board, depth - 1);
+		board->undoMove();
+	}
+}
+
+void tst_Board::perft_data() const
+{
+	addPositions(0);
+}
+
+void tst_Board::perft()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(int, depth);
+	QFETCH(quint64, nodes);
+
+	QScopedPointer<Chess::Board> board(Chess::BoardFactory::create(variant));
+	QVERIFY(board != nullptr);
+	QVERIFY(board->setFenString(fen));
+
+	QBENCHMARK
+	{
+		QCOMPARE(perftNodes(board.data(), depth), nodes);
+	}
+}
+
+void tst_Board::legalMoves_data() const
+{
+	addOperationPositions();
+}
+
+void tst_Board::legalMoves()
+{
+	quint64 count = 0;
+	QBENCHMARK
+	{
+		count = 0;
+		for (const Node& node : qAsConst(m_nodes))
+			count += node.board->legalMoves().size();
+	}
+	QFETCH(quint64, nodes);
+	QCOMPARE(count, nodes);
+}
+
+void tst_Board::makeMove_data() const
+{
+	addOperationPositions();
+}
+
+void tst_Board::makeMove()
+{
+	QBENCHMARK
+	{
+		for (const Node& node : qAsConst(m_nodes))
+		{
+			for (const Chess::Move& move : node.moves)
+			{
+				node.board->makeMove(move);
+				node.board->undoMove();
+			}
+		}
+	}
+}
+
+void tst_Board::isLegalMove_data() const
+{
+	addOperationPositions();
+}
+
+void tst_Board::isLegalMove()
+{
+	int errors = 0;
+	QBENCHMARK
+	{
+		errors = 0;
+		for (const Node& node : qAsConst(m_nodes))
+		{
+			for (const Chess::Move& move : node.moves)
+			{
+				if (!node.board->isLegalMove(move))
+					errors++;
+			}
+		}
+	}
+	QCOMPARE(errors, 0);
+}
+
+void tst_Board::sanMoveString_data() const
+{
+	addOperationPositions();
+}
+
+void tst_Board::sanMoveString()
+{
+	QBENCHMARK
+	{
+		for (const Node& node : qAsConst(m_nodes))
+		{
+			for (const Chess::Move& move : node.moves)
+				node.board->moveString(move, Chess::Board::StandardAlgebraic);
+		}
+	}
+}
+
+void tst_Board::moveFromString_data() const
+{
+	addOperationPositions();
+}
+
+void tst_Board::moveFromString()
+{
+	QVector<QStringList> strings;
+	for (const Node& node : qAsConst(m_nodes))
+	{
+		QStringList list;
+		for (const Chess::Move& move : node.moves)
+			list << node.board->moveString(move, Chess::Board::StandardAlgebraic);
+		strings << list;
+	}
+
+	int errors = 0;
+	QBENCHMARK
+	{
+		errors = 0;
+		for (int i = 0; i < m_nodes.size(); i++)
+		{
+			const Node& node = m_nodes.at(i);
+			const QStringList& list = strings.at(i);
+			for (int j = 0; j < list.size(); j++)
+			{
+				if (node.board->moveFromString(list.at(j)) != node.moves.at(j))
+					errors++;
+			}
+		}
+	}
+	QCOMPARE(errors, 0);
+}
+
+void tst_Board::result_data() const
+{
+	addOperationPositions();
+}
+
+void tst_Board::result()
+{
+	QBENCHMARK
+	{
+		for (const Node& node : qAsConst(m_nodes))
+			node.board->result();
+	}
+}
+
+QTEST_MAIN(tst_Board)
+#include "tst_board.moc"
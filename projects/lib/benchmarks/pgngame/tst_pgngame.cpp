@@ -1,6 +1,8 @@
 #include <QtTest/QtTest>
+#include <QBuffer>
 #include <pgnstream.h>
 #include <pgngame.h>
+#include <pgngameentry.h>
 
 
 class tst_PgnGame: public QObject
@@ -10,6 +12,10 @@ class tst_PgnGame: public QObject
 	private slots:
 		void parser_data() const;
 		void parser();
+		void device_data() const;
+		void device();
+		void entries_data() const;
+		void entries();
 };
 
 void tst_PgnGame::parser_data() const
@@ -99,5 +105,52 @@ void tst_PgnGame::parser()
 	}
 }
 
+void tst_PgnGame::device_data() const
+{
+	parser_data();
+}
+
+void tst_PgnGame::device()
+{
+	QFETCH(QByteArray, pgn);
+
+	QBuffer buffer(&pgn);
+	QVERIFY(buffer.open(QIODevice::ReadOnly | QIODevice::Text));
+	PgnStream stream(&buffer);
+	PgnGame game;
+	QBENCHMARK
+	{
+		QVERIFY(game.read(stream));
+		stream.rewind();
+	}
+}
+
+void tst_PgnGame::entries_data() const
+{
+	parser_data();
+}
+
+void tst_PgnGame::entries()
+{
+	QFETCH(QByteArray, pgn);
+
+	QByteArray data;
+	for (int i = 0; i < 100; i++)
+		data += pgn + "\n";
+
+	QBuffer buffer(&data);
+	QVERIFY(buffer.open(QIODevice::ReadOnly | QIODevice::Text));
+	PgnStream stream(&buffer);
+	PgnGameEntry entry;
+	QBENCHMARK
+	{
+		int count = 0;
+		while (entry.read(stream))
+			count++;
+		QCOMPARE(count, 100);
+		stream.rewind();
+	}
+}
+
 QTEST_MAIN(tst_PgnGame)
 #include "tst_pgngame.moc"
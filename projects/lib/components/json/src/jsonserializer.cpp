@@ -172,3 +172,59 @@ bool JsonSerializer::serialize(QTextStream& stream)
 		stream << '\n';
 	return ok;
 }
+
+QString JsonSerializer::toFragment(int indentLevel)
+{
+	QString str;
+	QTextStream stream(&str, QIODevice::WriteOnly);
+	if (!serializeNode(stream, m_data, indentLevel))
+		return QString();
+	stream.flush();
+
+	return str;
+}
+
+QString JsonSerializer::objectFragment(const QMap<QString, QString>& members,
+				       int indentLevel)
+{
+	const QString indent(indentLevel, '\t');
+	QString str("{\n");
+
+	QMap<QString, QString>::const_iterator it;
+	for (it = members.constBegin(); it != members.constEnd(); ++it)
+	{
+		str += indent;
+		str += "\t\"";
+		str += jsonString(it.key());
+		str += "\" : ";
+		str += it.value();
+		if (it != members.constEnd() - 1)
+			str += ',';
+		str += '\n';
+	}
+
+	str += indent;
+	str += '}';
+	return str;
+}
+
+QString JsonSerializer::arrayFragment(const QStringList& elements,
+				      int indentLevel)
+{
+	const QString indent(indentLevel, '\t');
+	QString str("[\n");
+
+	for (int i = 0; i < elements.size(); i++)
+	{
+		str += indent;
+		str += '\t';
+		str += elements.at(i);
+		if (i != elements.size() - 1)
+			str += ',';
+		str += '\n';
+	}
+
+	str += indent;
+	str += ']';
+	return str;
+}
@@ -27,6 +27,8 @@
 #define JSONSERIALIZER_H
 
 #include <QString>
+#include <QStringList>
+#include <QMap>
 #include <QVariant>
 #include <QCoreApplication>
 
@@ -65,6 +67,34 @@ class LIB_EXPORT JsonSerializer
 		 * is encountered. Otherwise returns true.
 		 */
 		bool serialize(QTextStream& stream);
+		/*!
+		 * Converts the data into JSON format and returns it as a
+		 * fragment to be embedded at nesting level \a indentLevel
+		 * of a larger document. No trailing newline is added.
+		 *
+		 * Returns an empty string if an invalid or unsupported
+		 * variant type is encountered.
+		 */
+		QString toFragment(int indentLevel = 0);
+
+		/*!
+		 * Returns a JSON object fragment at nesting level
+		 * \a indentLevel whose members are the already serialized
+		 * fragments in \a members, keyed by member name.
+		 *
+		 * The output is identical to serializing the equivalent
+		 * QVariantMap, which allows large documents to be updated
+		 * by re-serializing only the members that changed.
+		 */
+		static QString objectFragment(const QMap<QString, QString>& members,
+					      int indentLevel);
+		/*!
+		 * Returns a JSON array fragment at nesting level
+		 * \a indentLevel made of the already serialized
+		 * fragments in \a elements.
+		 */
+		static QString arrayFragment(const QStringList& elements,
+					     int indentLevel);
 
 		/*! Returns true if an error occured. */
 		bool hasError() const;
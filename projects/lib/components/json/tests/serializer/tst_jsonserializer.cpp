@@ -34,6 +34,7 @@ class tst_JsonSerializer: public QObject
 	private slots:
 		void test_data() const;
 		void test() const;
+		void fragments() const;
 
 	private:
 		QVariant sample1() const;
@@ -233,5 +234,36 @@ void tst_JsonSerializer::test() const
 	QCOMPARE(result, input);
 }
 
+void tst_JsonSerializer::fragments() const
+{
+	const QVariantMap map(sample1().toMap());
+
+	QString expected;
+	QTextStream stream(&expected, QIODevice::Text | QIODevice::WriteOnly);
+	JsonSerializer(map).serialize(stream);
+	stream.flush();
+
+	QMap<QString, QString> members;
+	for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+		members[it.key()] = JsonSerializer(it.value()).toFragment(1);
+	QCOMPARE(JsonSerializer::objectFragment(members, 0) + '\n', expected);
+
+	const QVariantList list(sample2().toList());
+	QStringList elements;
+	for (const QVariant& element : list)
+		elements << JsonSerializer(element).toFragment(1);
+
+	QString expectedList;
+	QTextStream listStream(&expectedList, QIODevice::Text | QIODevice::WriteOnly);
+	JsonSerializer(list).serialize(listStream);
+	listStream.flush();
+	QCOMPARE(JsonSerializer::arrayFragment(elements, 0) + '\n', expectedList);
+
+	QCOMPARE(JsonSerializer::objectFragment(QMap<QString, QString>(), 2),
+		 JsonSerializer(QVariantMap()).toFragment(2));
+	QCOMPARE(JsonSerializer::arrayFragment(QStringList(), 2),
+		 JsonSerializer(QVariantList()).toFragment(2));
+}
+
 QTEST_MAIN(tst_JsonSerializer)
 #include "tst_jsonserializer.moc"
@@ -47,6 +47,11 @@ bool AntiBoard::hasCastling() const
 	return false;
 }
 
+bool AntiBoard::hasStandardLegality() const
+{
+	return false;
+}
+
 bool AntiBoard::kingsCountAssertion( int whiteKings,
 				     int blackKings) const
 {
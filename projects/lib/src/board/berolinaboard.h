@@ -47,6 +47,10 @@ class LIB_EXPORT BerolinaBoard : public StandardBoard
 		// Inherited from StandardBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
+
+	protected:
+		// Inherited from StandardBoard
+		virtual bool hasBitboardBackend() const;
 };
 
 } // namespace Chess
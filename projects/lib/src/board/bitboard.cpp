@@ -0,0 +1,351 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bitboard.h"
+#include <QVector>
+#include <QGlobalStatic>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const quint64 FileA = Q_UINT64_C(0x0101010101010101);
+const quint64 FileH = FileA << 7;
+const quint64 Rank1 = Q_UINT64_C(0xFF);
+const quint64 Rank8 = Rank1 << 56;
+
+const int BishopDirections[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+const int RookDirections[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+
+struct SlidingAttacks
+{
+	quint64 mask;
+	quint64 magic;
+	int shift;
+	int offset;
+
+	inline unsigned index(quint64 occupied) const
+	{
+		#if defined(__BMI2__)
+		return unsigned(_pext_u64(occupied, mask));
+		#else
+		return unsigned(((occupied & mask) * magic) >> shift);
+		#endif
+	}
+};
+
+class Tables
+{
+	public:
+		Tables();
+
+		int fromIndex[120];
+		int toIndex[64];
+		quint64 knight[64];
+		quint64 king[64];
+		quint64 pawn[2][64];
+		quint64 between[64][64];
+		quint64 line[64][64];
+		SlidingAttacks bishop[64];
+		SlidingAttacks rook[64];
+		QVector<quint64> bishopTable;
+		QVector<quint64> rookTable;
+
+	private:
+		static quint64 leaperAttacks(int square,
+					     const int (*steps)[2],
+					     int count);
+		static quint64 sliderAttacks(int square,
+					     quint64 occupied,
+					     const int (*directions)[2]);
+		static void initSliders(SlidingAttacks* sliders,
+					QVector<quint64>& table,
+					const int (*directions)[2]);
+};
+
+// xorshift64* generator for finding the magic numbers. A fixed seed
+// gives the same magics, and the same table layout, on every run.
+class MagicRandom
+{
+	public:
+		MagicRandom() : m_state(Q_UINT64_C(1070372)) {}
+
+		quint64 sparse()
+		{
+			return next() & next() & next();
+		}
+
+	private:
+		quint64 next()
+		{
+			m_state ^= m_state >> 12;
+			m_state ^= m_state << 25;
+			m_state ^= m_state >> 27;
+			return m_state * Q_UINT64_C(2685821657736338717);
+		}
+
+		quint64 m_state;
+};
+
+quint64 Tables::leaperAttacks(int square, const int (*steps)[2], int count)
+{
+	quint64 attacks = 0;
+	int file = square % 8;
+	int rank = square / 8;
+
+	for (int i = 0; i < count; i++)
+	{
+		int f = file + steps[i][0];
+		int r = rank + steps[i][1];
+		if (f >= 0 && f < 8 && r >= 0 && r < 8)
+			attacks |= Chess::Bitboard::squareBit(r * 8 + f);
+	}
+
+	return attacks;
+}
+
+quint64 Tables::sliderAttacks(int square,
+			      quint64 occupied,
+			      const int (*directions)[2])
+{
+	quint64 attacks = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		int f = square % 8 + directions[i][0];
+		int r = square / 8 + directions[i][1];
+		while (f >= 0 && f < 8 && r >= 0 && r < 8)
+		{
+			quint64 bit = Chess::Bitboard::squareBit(r * 8 + f);
+			attacks |= bit;
+			if (occupied & bit)
+				break;
+			f += directions[i][0];
+			r += directions[i][1];
+		}
+	}
+
+	return attacks;
+}
+
+void Tables::initSliders(SlidingAttacks* sliders,
+			 QVector<quint64>& table,
+			 const int (*directions)[2])
+{
+	int size = 0;
+	for (int sq = 0; sq < 64; sq++)
+	{
+		SlidingAttacks& s = sliders[sq];
+
+		// The edges don't matter for occupancy unless the
+		// piece is on them
+		quint64 edges = ((Rank1 | Rank8) & ~(Rank1 << (8 * (sq / 8))))
+			      | ((FileA | FileH) & ~(FileA << (sq % 8)));
+		s.mask = sliderAttacks(sq, 0, directions) & ~edges;
+		s.shift = 64 - Chess::Bitboard::count(s.mask);
+		s.magic = 0;
+		s.offset = size;
+		size += 1 << Chess::Bitboard::count(s.mask);
+	}
+	table.resize(size);
+
+	QVector<quint64> occupancy;
+	QVector<quint64> reference;
+	#if !defined(__BMI2__)
+	MagicRandom random;
+	QVector<int> epoch;
+	#endif
+
+	for (int sq = 0; sq < 64; sq++)
+	{
+		SlidingAttacks& s = sliders[sq];
+		quint64* attacks = table.data() + s.offset;
+
+		// Enumerate all subsets of the mask (Carry-Rippler trick)
+		occupancy.clear();
+		reference.clear();
+		quint64 b = 0;
+		do
+		{
+			occupancy.append(b);
+			reference.append(sliderAttacks(sq, b, directions));
+			b = (b - s.mask) & s.mask;
+		} while (b != 0);
+
+		#if defined(__BMI2__)
+		for (int i = 0; i < occupancy.size(); i++)
+			attacks[s.index(occupancy.at(i))] = reference.at(i);
+		#else
+		// Try random sparse numbers until one maps every subset
+		// to an index without destructive collisions
+		epoch.fill(0, occupancy.size());
+		for (int attempt = 1; ; attempt++)
+		{
+			do
+				s.magic = random.sparse();
+			while (Chess::Bitboard::count((s.magic * s.mask) >> 56) < 6);
+
+			int i;
+			for (i = 0; i < occupancy.size(); i++)
+			{
+				unsigned idx = s.index(occupancy.at(i));
+				if (epoch.at(idx) < attempt)
+				{
+					epoch[idx] = attempt;
+					attacks[idx] = reference.at(i);
+				}
+				else if (attacks[idx] != reference.at(i))
+					break;
+			}
+			if (i == occupancy.size())
+				break;
+		}
+		#endif
+	}
+}
+
+Tables::Tables()
+{
+	static const int knightSteps[8][2] = {
+		{1, 2}, {2, 1}, {2, -1}, {1, -2},
+		{-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+	};
+	static const int kingSteps[8][2] = {
+		{1, 0}, {1, 1}, {0, 1}, {-1, 1},
+		{-1, 0}, {-1, -1}, {0, -1}, {1, -1}
+	};
+	static const int pawnSteps[2][2][2] = {
+		{ {-1, 1}, {1, 1} },
+		{ {-1, -1}, {1, -1} }
+	};
+
+	// The mailbox of an 8x8 Board is 10 squares wide, with two
+	// rows of wall squares above and below the board
+	for (int i = 0; i < 120; i++)
+	{
+		int file = i % 10 - 1;
+		int rank = 9 - i / 10;
+		if (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+			fromIndex[i] = rank * 8 + file;
+		else
+			fromIndex[i] = -1;
+	}
+	for (int sq = 0; sq < 64; sq++)
+	{
+		toIndex[sq] = (9 - sq / 8) * 10 + 1 + sq % 8;
+		knight[sq] = leaperAttacks(sq, knightSteps, 8);
+		king[sq] = leaperAttacks(sq, kingSteps, 8);
+		pawn[0][sq] = leaperAttacks(sq, pawnSteps[0], 2);
+		pawn[1][sq] = leaperAttacks(sq, pawnSteps[1], 2);
+	}
+
+	initSliders(bishop, bishopTable, BishopDirections);
+	initSliders(rook, rookTable, RookDirections);
+
+	for (int sq1 = 0; sq1 < 64; sq1++)
+	{
+		quint64 bit1 = Chess::Bitboard::squareBit(sq1);
+		for (int sq2 = 0; sq2 < 64; sq2++)
+		{
+			quint64 bit2 = Chess::Bitboard::squareBit(sq2);
+			between[sq1][sq2] = 0;
+			line[sq1][sq2] = 0;
+			if (sq1 == sq2)
+				continue;
+
+			if (sliderAttacks(sq1, 0, BishopDirections) & bit2)
+			{
+				line[sq1][sq2] = (sliderAttacks(sq1, 0, BishopDirections)
+						& sliderAttacks(sq2, 0, BishopDirections))
+						| bit1 | bit2;
+				between[sq1][sq2] = sliderAttacks(sq1, bit2, BishopDirections)
+						  & sliderAttacks(sq2, bit1, BishopDirections);
+			}
+			else if (sliderAttacks(sq1, 0, RookDirections) & bit2)
+			{
+				line[sq1][sq2] = (sliderAttacks(sq1, 0, RookDirections)
+						& sliderAttacks(sq2, 0, RookDirections))
+						| bit1 | bit2;
+				between[sq1][sq2] = sliderAttacks(sq1, bit2, RookDirections)
+						  & sliderAttacks(sq2, bit1, RookDirections);
+			}
+		}
+	}
+}
+
+Q_GLOBAL_STATIC(Tables, s_tables)
+
+} // anonymous namespace
+
+namespace Chess {
+namespace Bitboard {
+
+int fromSquareIndex(int index)
+{
+	Q_ASSERT(index >= 0 && index < 120);
+	return s_tables->fromIndex[index];
+}
+
+int toSquareIndex(int square)
+{
+	Q_ASSERT(square >= 0 && square < 64);
+	return s_tables->toIndex[square];
+}
+
+quint64 knightAttacks(int square)
+{
+	return s_tables->knight[square];
+}
+
+quint64 kingAttacks(int square)
+{
+	return s_tables->king[square];
+}
+
+quint64 pawnAttacks(int side, int square)
+{
+	return s_tables->pawn[side][square];
+}
+
+quint64 bishopAttacks(int square, quint64 occupied)
+{
+	const Tables* t = s_tables();
+	const SlidingAttacks& s = t->bishop[square];
+	return t->bishopTable.at(s.offset + s.index(occupied));
+}
+
+quint64 rookAttacks(int square, quint64 occupied)
+{
+	const Tables* t = s_tables();
+	const SlidingAttacks& s = t->rook[square];
+	return t->rookTable.at(s.offset + s.index(occupied));
+}
+
+quint64 between(int square1, int square2)
+{
+	return s_tables->between[square1][square2];
+}
+
+quint64 line(int square1, int square2)
+{
+	return s_tables->line[square1][square2];
+}
+
+} // namespace Bitboard
+} // namespace Chess
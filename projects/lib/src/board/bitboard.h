@@ -0,0 +1,115 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+namespace Chess {
+
+/*!
+ * \brief Attack tables for 8x8 boards
+ *
+ * A bitboard is a 64-bit set of squares where bit 0 is a1, bit 7 is h1
+ * and bit 63 is h8. The functions in this namespace return the squares
+ * attacked by a piece on an empty or occupied board.
+ *
+ * Sliding attacks use magic bitboards, or the BMI2 PEXT instruction if
+ * the library is compiled with BMI2 support (eg. -mbmi2). The tables
+ * are initialized the first time they're needed.
+ *
+ * \sa WesternBoard
+ */
+namespace Bitboard {
+
+/*! Returns the bitboard of \a square. */
+inline quint64 squareBit(int square)
+{
+	return Q_UINT64_C(1) << square;
+}
+
+/*! Returns the lowest square in \a bits, which must not be empty. */
+inline int lsb(quint64 bits)
+{
+	Q_ASSERT(bits != 0);
+	return int(qCountTrailingZeroBits(bits));
+}
+
+/*! Removes the lowest square from \a bits and returns it. */
+inline int popLsb(quint64& bits)
+{
+	int square = lsb(bits);
+	bits &= bits - 1;
+	return square;
+}
+
+/*! Returns true if \a bits contains more than one square. */
+inline bool moreThanOne(quint64 bits)
+{
+	return (bits & (bits - 1)) != 0;
+}
+
+/*! Returns the number of squares in \a bits. */
+inline int count(quint64 bits)
+{
+	return int(qPopulationCount(bits));
+}
+
+/*!
+ * Converts \a index, a square index of an 8x8 Board, into a
+ * bitboard square. Returns -1 if \a index is a wall square.
+ */
+int fromSquareIndex(int index);
+/*! Converts bitboard square \a square into a square index. */
+int toSquareIndex(int square);
+
+/*! Returns the squares attacked by a knight on \a square. */
+quint64 knightAttacks(int square);
+/*! Returns the squares attacked by a king on \a square. */
+quint64 kingAttacks(int square);
+/*!
+ * Returns the squares attacked by a pawn of side \a side on \a square.
+ * \a side is 0 for White and 1 for Black.
+ */
+quint64 pawnAttacks(int side, int square);
+/*!
+ * Returns the squares attacked by a bishop on \a square when
+ * \a occupied squares are occupied.
+ */
+quint64 bishopAttacks(int square, quint64 occupied);
+/*!
+ * Returns the squares attacked by a rook on \a square when
+ * \a occupied squares are occupied.
+ */
+quint64 rookAttacks(int square, quint64 occupied);
+/*!
+ * Returns the squares strictly between \a square1 and \a square2 if
+ * they're on the same rank, file or diagonal; otherwise returns 0.
+ */
+quint64 between(int square1, int square2);
+/*!
+ * Returns the whole rank, file or diagonal that goes through
+ * \a square1 and \a square2, or 0 if there isn't one.
+ */
+quint64 line(int square1, int square2);
+
+} // namespace Bitboard
+} // namespace Chess
+#endif // BITBOARD_H
@@ -886,9 +886,18 @@ bool Board::isRepetition(const Chess::Move& move)
 	return isRepeat;
 }
 
+bool Board::generateLegalMoves(QVarLengthArray<Move>& moves)
+{
+	Q_UNUSED(moves);
+	return false;
+}
+
 bool Board::canMove()
 {
 	QVarLengthArray<Move> moves;
+	if (generateLegalMoves(moves))
+		return !moves.isEmpty();
+
 	generateMoves(moves);
 
 	for (int i = 0; i < moves.size(); i++)
@@ -905,6 +914,14 @@ QVector<Move> Board::legalMoves()
 	QVarLengthArray<Move> moves;
 	QVector<Move> legalMoves;
 
+	if (generateLegalMoves(moves))
+	{
+		legalMoves.reserve(moves.size());
+		for (int i = 0; i < moves.size(); i++)
+			legalMoves << moves[i];
+		return legalMoves;
+	}
+
 	generateMoves(moves);
 	legalMoves.reserve(moves.size());
 
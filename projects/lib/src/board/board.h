@@ -471,6 +471,17 @@ class LIB_EXPORT Board
 		 * after \a move is legal.
 		 */
 		virtual bool vIsLegalMove(const Move& move);
+		/*!
+		 * Generates the legal moves of the side to move.
+		 *
+		 * This function is called by legalMoves() and canMove().
+		 * Returns false if the variant doesn't have a legal move
+		 * generator, in which case the legal moves are found by
+		 * testing pseudo-legal moves with vIsLegalMove().
+		 *
+		 * The default implementation returns false.
+		 */
+		virtual bool generateLegalMoves(QVarLengthArray<Move>& moves);
 		/*!
 		 * Returns the type of piece captured by \a move.
 		 * Returns Piece::NoPiece if \a move is not a capture.
@@ -1,6 +1,7 @@
 DEPENDPATH += $$PWD
 SOURCES += $$PWD/board.cpp \
     $$PWD/westernboard.cpp \
+    $$PWD/bitboard.cpp \
     $$PWD/square.cpp \
     $$PWD/standardboard.cpp \
     $$PWD/ncheckboard.cpp \
@@ -60,6 +61,7 @@ HEADERS += $$PWD/board.h \
     $$PWD/move.h \
     $$PWD/piece.h \
     $$PWD/westernboard.h \
+    $$PWD/bitboard.h \
     $$PWD/square.h \
     $$PWD/standardboard.h \
     $$PWD/ncheckboard.h \
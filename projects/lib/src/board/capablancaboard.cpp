@@ -48,6 +48,11 @@ QString CapablancaBoard::defaultFenString() const
 	return "rnabqkbcnr/pppppppppp/10/10/10/10/PPPPPPPPPP/RNABQKBCNR w KQkq - 0 1";
 }
 
+bool CapablancaBoard::hasStandardLegality() const
+{
+	return true;
+}
+
 void CapablancaBoard::addPromotions(int sourceSquare,
 				int targetSquare,
 				QVarLengthArray<Move>& moves) const
@@ -44,6 +44,11 @@ QString ExtinctionBoard::defaultFenString() const
 	return "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 }
 
+bool ExtinctionBoard::hasStandardLegality() const
+{
+	return false;
+}
+
 bool ExtinctionBoard::kingsCountAssertion(int, int) const
 {
 	return extinctPiece(Side::White).isEmpty()
@@ -63,6 +63,7 @@ class LIB_EXPORT ExtinctionBoard : public StandardBoard
 		// Inherited from StandardBoard
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
+		virtual bool hasStandardLegality() const;
 		virtual bool inCheck(Side side, int square = 0) const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
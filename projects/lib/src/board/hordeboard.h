@@ -59,6 +59,7 @@ class LIB_EXPORT HordeBoard : public StandardBoard
 	protected:
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
+		virtual bool hasBitboardBackend() const;
 		virtual bool vIsLegalMove(const Move& m);
 	private:
 		bool hasMaterial(Side side) const;
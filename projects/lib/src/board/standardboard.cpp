@@ -1072,6 +1072,16 @@ QString StandardBoard::defaultFenString() const
 	return "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 }
 
+bool StandardBoard::hasStandardLegality() const
+{
+	return true;
+}
+
+bool StandardBoard::hasBitboardBackend() const
+{
+	return true;
+}
+
 Result StandardBoard::tablebaseResult(unsigned int* dtz) const
 {
 	SyzygyTablebase::PieceList pieces;
@@ -19,6 +19,11 @@
 #include "syzygytablebase.h"
 #include <QDir>
 #include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QGlobalStatic>
 #include <QStringList>
 #include <tbprobe.h>
 #include "westernboard.h"
@@ -29,6 +34,17 @@ bool s_initialized = false, s_initOK = false, s_noRule50 = false;
 int s_pieces = INT_MAX;
 QMutex s_mutex;
 
+QAtomicInteger<quint64> s_lookups;
+QAtomicInteger<quint64> s_cacheHits;
+QAtomicInteger<quint64> s_wdlProbes;
+QAtomicInteger<quint64> s_dtzProbes;
+QAtomicInteger<quint64> s_lockWaitNsecs;
+
+const int DefaultCacheSize = 65536;
+const int CacheShardCount = 16;
+// The fifty-move counter of WDL cache entries
+const int WdlRule50 = -1;
+
 int tbSquare(const Chess::Square& square)
 {
 	if (!square.isValid())
@@ -36,6 +52,220 @@ int tbSquare(const Chess::Square& square)
 	return square.rank() * 8 + square.file();
 }
 
+struct TbPosition
+{
+	quint64 white;
+	quint64 black;
+	quint64 kings;
+	quint64 queens;
+	quint64 rooks;
+	quint64 bishops;
+	quint64 knights;
+	quint64 pawns;
+	unsigned ep;
+	int rule50;
+	bool wtm;
+};
+
+bool operator==(const TbPosition& p1, const TbPosition& p2)
+{
+	return p1.white == p2.white
+	    && p1.black == p2.black
+	    && p1.kings == p2.kings
+	    && p1.queens == p2.queens
+	    && p1.rooks == p2.rooks
+	    && p1.bishops == p2.bishops
+	    && p1.knights == p2.knights
+	    && p1.pawns == p2.pawns
+	    && p1.ep == p2.ep
+	    && p1.rule50 == p2.rule50
+	    && p1.wtm == p2.wtm;
+}
+
+uint qHash(const TbPosition& pos, uint seed = 0)
+{
+	// The occupancy and the piece types identify the position
+	quint64 h = pos.white;
+	for (quint64 x : { pos.black, pos.kings, pos.queens, pos.rooks,
+			   pos.bishops, pos.knights, pos.pawns })
+		h = (h ^ x) * Q_UINT64_C(0x9e3779b97f4a7c15);
+	h ^= (quint64(pos.ep) << 1) ^ (quint64(pos.rule50) << 8) ^ quint64(pos.wtm);
+	h ^= h >> 29;
+
+	return uint(h ^ (h >> 32)) ^ seed;
+}
+
+/*
+ * A bounded cache of probe results shared by all games.
+ *
+ * The positions are spread over shards that have their own locks,
+ * so concurrent games rarely wait for each other. When a shard is
+ * full, its oldest entry is replaced.
+ */
+class TbResultCache
+{
+	public:
+		TbResultCache();
+
+		void setSize(int entries);
+		bool find(const TbPosition& pos, unsigned* result);
+		void insert(const TbPosition& pos, unsigned result);
+
+	private:
+		struct Shard
+		{
+			QMutex mutex;
+			QHash<TbPosition, unsigned> results;
+			QVector<TbPosition> order;
+			int next;
+		};
+
+		Shard& shard(uint hash);
+
+		Shard m_shards[CacheShardCount];
+		QAtomicInt m_shardSize;
+};
+
+TbResultCache::TbResultCache()
+	: m_shardSize(0)
+{
+	setSize(DefaultCacheSize);
+}
+
+void TbResultCache::setSize(int entries)
+{
+	const int shardSize = (qMax(0, entries) + CacheShardCount - 1) / CacheShardCount;
+	for (Shard& s : m_shards)
+	{
+		QMutexLocker locker(&s.mutex);
+		s.results.clear();
+		s.results.reserve(shardSize);
+		s.order.clear();
+		s.next = 0;
+	}
+	m_shardSize.store(shardSize);
+}
+
+TbResultCache::Shard& TbResultCache::shard(uint hash)
+{
+	return m_shards[(hash >> 16) % CacheShardCount];
+}
+
+bool TbResultCache::find(const TbPosition& pos, unsigned* result)
+{
+	if (m_shardSize.load() == 0)
+		return false;
+
+	Shard& s = shard(qHash(pos));
+	QMutexLocker locker(&s.mutex);
+	auto it = s.results.constFind(pos);
+	if (it == s.results.constEnd())
+		return false;
+
+	*result = it.value();
+	return true;
+}
+
+void TbResultCache::insert(const TbPosition& pos, unsigned result)
+{
+	const int shardSize = m_shardSize.load();
+	if (shardSize == 0)
+		return;
+
+	Shard& s = shard(qHash(pos));
+	QMutexLocker locker(&s.mutex);
+	if (s.results.contains(pos))
+		return;
+
+	if (s.order.size() < shardSize)
+		s.order.append(pos);
+	else
+	{
+		// Replace the oldest entry
+		s.next %= s.order.size();
+		s.results.remove(s.order.at(s.next));
+		s.order[s.next++] = pos;
+	}
+	s.results.insert(pos, result);
+}
+
+Q_GLOBAL_STATIC(TbResultCache, s_cache)
+
+/*
+ * Returns the winner of a position with WDL value \a wdl for the
+ * side to move. The 50 move rule is taken into account unless it
+ * has been disabled.
+ */
+Chess::Side wdlWinner(unsigned wdl, bool wtm)
+{
+	switch (wdl)
+	{
+	case TB_BLESSED_LOSS:
+		if (!s_noRule50)
+			break;
+		// Fallthrough
+	case TB_LOSS:
+		return wtm? Chess::Side::Black: Chess::Side::White;
+	case TB_DRAW:
+		break;
+	case TB_CURSED_WIN:
+		if (!s_noRule50)
+			break;
+		// Fallthrough
+	case TB_WIN:
+		return wtm? Chess::Side::White: Chess::Side::Black;
+	}
+
+	return Chess::Side::NoSide;
+}
+
+unsigned probeWdl(const TbPosition& pos)
+{
+	unsigned result;
+	if (s_cache->find(pos, &result))
+	{
+		s_cacheHits.fetchAndAddRelaxed(1);
+		return result;
+	}
+
+	// The WDL probe is thread-safe, and doesn't use the fifty-move
+	// counter
+	s_wdlProbes.fetchAndAddRelaxed(1);
+	result = tb_probe_wdl(pos.white, pos.black, pos.kings, pos.queens,
+		pos.rooks, pos.bishops, pos.knights, pos.pawns, 0, 0, pos.ep,
+		pos.wtm);
+	s_cache->insert(pos, result);
+
+	return result;
+}
+
+unsigned probeRoot(const TbPosition& pos)
+{
+	unsigned result;
+	if (s_cache->find(pos, &result))
+	{
+		s_cacheHits.fetchAndAddRelaxed(1);
+		return result;
+	}
+
+	// The root probe isn't thread-safe
+	if (!s_mutex.tryLock())
+	{
+		QElapsedTimer timer;
+		timer.start();
+		s_mutex.lock();
+		s_lockWaitNsecs.fetchAndAddRelaxed(timer.nsecsElapsed());
+	}
+	s_dtzProbes.fetchAndAddRelaxed(1);
+	result = tb_probe_root(pos.white, pos.black, pos.kings, pos.queens,
+		pos.rooks, pos.bishops, pos.knights, pos.pawns, pos.rule50, 0,
+		pos.ep, pos.wtm, nullptr);
+	s_mutex.unlock();
+
+	s_cache->insert(pos, result);
+	return result;
+}
+
 } // anonymous namespace
 
 bool SyzygyTablebase::initialize(const QString& path)
@@ -66,6 +296,23 @@ void SyzygyTablebase::setNoRule50()
 	s_noRule50 = true;
 }
 
+void SyzygyTablebase::setCacheSize(int entries)
+{
+	s_cache->setSize(entries);
+}
+
+SyzygyTablebase::Statistics SyzygyTablebase::statistics()
+{
+	Statistics stats;
+	stats.lookups = s_lookups.load();
+	stats.cacheHits = s_cacheHits.load();
+	stats.wdlProbes = s_wdlProbes.load();
+	stats.dtzProbes = s_dtzProbes.load();
+	stats.lockWaitNsecs = s_lockWaitNsecs.load();
+
+	return stats;
+}
+
 Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 					   const Chess::Square& enpassantSq,
 					   Castling castling,
@@ -80,11 +327,13 @@ Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 	if (pieces.size() > s_pieces)
 		return Chess::Result();
 
-	bool wtm = (side == Chess::Side::White);
-	unsigned ep = (tbSquare(enpassantSq) < 0? 0: tbSquare(enpassantSq));
-	uint64_t white = 0, black = 0;
-	uint64_t kings = 0, queens = 0, rooks = 0, bishops = 0, knights = 0,
-		pawns = 0;
+	TbPosition pos;
+	pos.wtm = (side == Chess::Side::White);
+	pos.ep = (tbSquare(enpassantSq) < 0? 0: tbSquare(enpassantSq));
+	pos.rule50 = rule50;
+	pos.white = pos.black = 0;
+	pos.kings = pos.queens = pos.rooks = pos.bishops = pos.knights =
+		pos.pawns = 0;
 	typedef QPair<Chess::Square, Chess::Piece> PcSq;
 	for (const PcSq& item : pieces)
 	{
@@ -93,60 +342,54 @@ Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 		unsigned sq = tbSquare(item.first);
 		uint64_t bit = ((uint64_t)1 << sq);
 		if (item.second.side() == Chess::Side::White)
-			white |= bit;
+			pos.white |= bit;
 		else
-			black |= bit;
+			pos.black |= bit;
 		switch (item.second.type())
 		{
 		case Chess::WesternBoard::Pawn:
-			pawns |= bit; break;
+			pos.pawns |= bit; break;
 		case Chess::WesternBoard::Knight:
-			knights |= bit; break;
+			pos.knights |= bit; break;
 		case Chess::WesternBoard::Bishop:
-			bishops |= bit; break;
+			pos.bishops |= bit; break;
 		case Chess::WesternBoard::Rook:
-			rooks |= bit; break;
+			pos.rooks |= bit; break;
 		case Chess::WesternBoard::Queen:
-			queens |= bit; break;
+			pos.queens |= bit; break;
 		case Chess::WesternBoard::King:
-			kings |= bit; break;
+			pos.kings |= bit; break;
 		}
 	}
+	s_lookups.fetchAndAddRelaxed(1);
 
-	s_mutex.lock();
-	unsigned result = tb_probe_root(white, black, kings, queens, rooks,
-		bishops, knights, pawns, rule50, 0, ep, wtm, nullptr);
-	s_mutex.unlock();
+	if (dtz == nullptr)
+	{
+		TbPosition wdlPos(pos);
+		wdlPos.rule50 = WdlRule50;
+		unsigned wdl = probeWdl(wdlPos);
+
+		// Draws are final. Wins and losses are final if the
+		// fifty-move counter can't turn them into draws, otherwise
+		// the DTZ tables decide.
+		if (wdl != TB_RESULT_FAILED
+		&&  (wdl == TB_DRAW || wdl == TB_CURSED_WIN
+		     || wdl == TB_BLESSED_LOSS || s_noRule50 || rule50 == 0))
+			return Chess::Result(Chess::Result::Adjudication,
+					     wdlWinner(wdl, pos.wtm),
+					     "SyzygyTB");
+	}
+
+	unsigned result = probeRoot(pos);
 
-	Chess::Side winner(Chess::Side::NoSide); 
+	Chess::Side winner(Chess::Side::NoSide);
 	if (result == TB_RESULT_FAILED)
 		return Chess::Result();
 	if (result == TB_RESULT_CHECKMATE)
-		winner = (wtm? Chess::Side::Black: Chess::Side::White);
-	else if (result == TB_RESULT_STALEMATE)
-		winner = Chess::Side::NoSide;
-	else
-	{
-		switch (TB_GET_WDL(result))
-		{
-		case TB_BLESSED_LOSS:
-			if (!s_noRule50)
-				break;
-			// Fallthrough
-		case TB_LOSS:
-			winner = (wtm? Chess::Side::Black: Chess::Side::White);
-			break;
-		case TB_DRAW:
-			break;
-		case TB_CURSED_WIN:
-			if (!s_noRule50)
-				break;
-			// Fallthrough
-		case TB_WIN:
-			winner = (wtm? Chess::Side::White: Chess::Side::Black);
-			break;
-		}
-	}
+		winner = (pos.wtm? Chess::Side::Black: Chess::Side::White);
+	else if (result != TB_RESULT_STALEMATE)
+		winner = wdlWinner(TB_GET_WDL(result), pos.wtm);
+
 	if (dtz != nullptr)
 		*dtz = TB_GET_DTZ(result);
 	return Chess::Result(Chess::Result::Adjudication, winner, "SyzygyTB");
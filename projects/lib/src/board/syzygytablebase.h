@@ -54,6 +54,21 @@ class LIB_EXPORT SyzygyTablebase
 		/*! Synonym for QList< QPair<Chess::Square, Chess::Piece> >. */
 		typedef QList< QPair<Chess::Square, Chess::Piece> > PieceList;
 
+		/*! Tablebase probing statistics. */
+		struct Statistics
+		{
+			/*! Number of positions looked up with result(). */
+			quint64 lookups;
+			/*! Number of probes answered by the result cache. */
+			quint64 cacheHits;
+			/*! Number of WDL table probes. */
+			quint64 wdlProbes;
+			/*! Number of root DTZ probes. */
+			quint64 dtzProbes;
+			/*! Time spent waiting for the DTZ probe lock in ns. */
+			quint64 lockWaitNsecs;
+		};
+
 		/*!
 		 * Initializes the tablebases.
 		 *
@@ -77,6 +92,17 @@ class LIB_EXPORT SyzygyTablebase
 		 * Disable the 50 move rule from consideration.
 		 */
 		static void setNoRule50();
+		/*!
+		 * Sets the maximum number of probe results kept in the
+		 * result cache to \a entries, and clears the cache.
+		 *
+		 * The cache is shared by all games and split into shards
+		 * with their own locks. The default size is 65536 entries.
+		 * A size of 0 disables the cache.
+		 */
+		static void setCacheSize(int entries);
+		/*! Returns the probing statistics since the program started. */
+		static Statistics statistics();
 		/*!
 		 * Returns the expected game result for the positions specified
 		 * by \a side, \a enpassantSq, \a castling and \a pieces.
@@ -88,6 +114,11 @@ class LIB_EXPORT SyzygyTablebase
 		 * If the position isn't found in the tablebases, a null result
 		 * is returned.
 		 *
+		 * If \a dtz is null, the thread-safe WDL tables are probed
+		 * first, and the root DTZ probe, which has to be serialized,
+		 * is only needed for wins and losses that may still be
+		 * drawn by the 50 move rule.
+		 *
 		 * \sa Chess::Board::tablebaseResult()
 		 */
 		static Chess::Result result(const Chess::Side& side,
@@ -19,7 +19,35 @@
 #include <QStringList>
 #include "westernzobrist.h"
 #include "boardtransition.h"
+#include "bitboard.h"
 
+namespace {
+
+// The position of a WesternBoard in bitboard format
+struct BitboardPosition
+{
+	quint64 sides[2];
+	quint64 pieces[Chess::WesternBoard::King + 1];
+
+	// Returns the pieces of the opponent of \a side that
+	// attack \a square when \a occupied squares are occupied.
+	quint64 attackers(int side, int square, quint64 occupied) const
+	{
+		using namespace Chess::Bitboard;
+		typedef Chess::WesternBoard WB;
+
+		quint64 diagonal = pieces[WB::Bishop] | pieces[WB::Queen];
+		quint64 straight = pieces[WB::Rook] | pieces[WB::Queen];
+		return ((pawnAttacks(side, square) & pieces[WB::Pawn])
+		      | (knightAttacks(square) & pieces[WB::Knight])
+		      | (kingAttacks(square) & pieces[WB::King])
+		      | (bishopAttacks(square, occupied) & diagonal)
+		      | (rookAttacks(square, occupied) & straight))
+		      & sides[1 - side];
+	}
+};
+
+} // anonymous namespace
 
 namespace Chess {
 
@@ -37,8 +65,14 @@ WesternBoard::WesternBoard(WesternZobrist* zobrist)
 	  m_hasEnPassantCaptures(true),
 	  m_pawnAmbiguous(false),
 	  m_multiDigitNotation(false),
+	  m_hasStandardLegality(false),
+	  m_hasBitboards(false),
+	  m_bitboardsEnabled(true),
+	  m_legalityShortcutEnabled(true),
 	  m_zobrist(zobrist)
 {
+	m_checkInfo.isValid = false;
+
 	setPieceType(Pawn, tr("pawn"), "P");
 	setPieceType(Knight, tr("knight"), "N", KnightMovement);
 	setPieceType(Bishop, tr("bishop"), "B", BishopMovement);
@@ -91,12 +125,41 @@ bool WesternBoard::variantHasChanneling(Side, int) const
 	return false;
 }
 
+bool WesternBoard::hasStandardLegality() const
+{
+	return false;
+}
+
+bool WesternBoard::hasBitboardBackend() const
+{
+	return false;
+}
+
+bool WesternBoard::usesBitboards() const
+{
+	return m_hasBitboards && m_bitboardsEnabled;
+}
+
+void WesternBoard::setBitboardsEnabled(bool enabled)
+{
+	m_bitboardsEnabled = enabled;
+}
+
+void WesternBoard::setLegalityShortcutEnabled(bool enabled)
+{
+	m_legalityShortcutEnabled = enabled;
+}
+
 void WesternBoard::vInitialize()
 {
 	m_kingCanCapture = kingCanCapture();
 	m_hasCastling = hasCastling();
 	m_pawnHasDoubleStep = pawnHasDoubleStep();
 	m_hasEnPassantCaptures = hasEnPassantCaptures();
+	m_hasStandardLegality = hasStandardLegality();
+	m_hasBitboards = m_hasStandardLegality && hasBitboardBackend()
+		      && width() == 8 && height() == 8
+		      && m_kingCanCapture && m_pawnHasDoubleStep;
 
 	m_arwidth = width() + 2;
 
@@ -113,6 +176,8 @@ void WesternBoard::vInitialize()
 	m_castleTarget[Side::Black][QueenSide] = 2 * m_arwidth + 1 + castlingFile(QueenSide);
 	m_castleTarget[Side::Black][KingSide] = 2 * m_arwidth + 1 + castlingFile(KingSide);
 
+	m_checkInfo.isValid = false;
+
 	m_knightOffsets.resize(8);
 	m_knightOffsets[0] = -2 * m_arwidth - 1;
 	m_knightOffsets[1] = -2 * m_arwidth + 1;
@@ -148,7 +213,8 @@ inline int WesternBoard::pawnPushOffset(const PawnStep& ps, int sign) const
 int WesternBoard::captureType(const Move& move) const
 {
 	if (pieceAt(move.sourceSquare()).type() == Pawn
-	&&  move.targetSquare() == m_enpassantSquare)
+	&&  move.targetSquare() == m_enpassantSquare
+	&&  isPawnCaptureStep(move.sourceSquare(), move.targetSquare()))
 		return Pawn;
 
 	return Board::captureType(move);
@@ -221,7 +287,8 @@ QString WesternBoard::sanMoveString(const Move& move)
 			needFile = true;
 			needRank = true; // for Xboard-compatibility
 		}
-		if (target == m_enpassantSquare)
+		if (target == m_enpassantSquare
+		&&  isPawnCaptureStep(source, target))
 			capture = Piece(side.opposite(), Pawn);
 		if (capture.isValid())
 			needFile = true;
@@ -464,12 +531,12 @@ Move WesternBoard::moveFromSanString(const QString& str)
 	int target = squareIndex(targetSq);
 
 	// Make sure that the move string is right about whether
-	// or not the move is a capture.
-	bool isCapture = false;
-	if (pieceAt(target).side() == side.opposite()
-	||  (target == m_enpassantSquare && piece.type() == Pawn))
-		isCapture = true;
-	if (isCapture != stringIsCapture)
+	// or not the move is a capture. A pawn move to the en-passant
+	// square is only a capture if the pawn makes a capture step.
+	const bool toEnpassant = target == m_enpassantSquare
+			      && piece.type() == Pawn;
+	if (!toEnpassant
+	&&  (pieceAt(target).side() == side.opposite()) != stringIsCapture)
 		return Move();
 
 	// Promotion
@@ -505,6 +572,9 @@ Move WesternBoard::moveFromSanString(const QString& str)
 			continue;
 		if (move.promotion() != promotion)
 			continue;
+		if (toEnpassant
+		&&  isPawnCaptureStep(move.sourceSquare(), target) != stringIsCapture)
+			continue;
 
 		if (!vIsLegalMove(move))
 			continue;
@@ -695,6 +765,7 @@ bool WesternBoard::parseCastlingRights(QChar c)
 
 bool WesternBoard::vSetFenString(const QStringList& fen)
 {
+	m_checkInfo.isValid = false;
 	if (fen.size() < 2)
 		return false;
 	QStringList::const_iterator token = fen.begin();
@@ -897,6 +968,7 @@ void WesternBoard::vMakeMove(const Move& move, BoardTransition* transition)
 
 	Q_ASSERT(target != 0);
 
+	m_checkInfo.isValid = false;
 	MoveData md = { capture, epSq, epTgt, m_castlingRights,
 			NoCastlingSide, m_reversibleMoveCount };
 
@@ -949,7 +1021,7 @@ void WesternBoard::vMakeMove(const Move& move, BoardTransition* transition)
 		isReversible = false;
 
 		// Make an en-passant capture
-		if (target == epSq)
+		if (target == epSq && isPawnCaptureStep(source, target))
 		{
 			int epTarget = epTgt;
 			setSquare(epTarget, Piece::NoPiece);
@@ -1027,6 +1099,7 @@ void WesternBoard::vUndoMove(const Move& move)
 	int source = move.sourceSquare();
 	int target = move.targetSquare();
 
+	m_checkInfo.isValid = false;
 	m_sign *= -1;
 	Side side = sideToMove();
 
@@ -1101,7 +1174,6 @@ void WesternBoard::generateMovesForPiece(QVarLengthArray<Move>& moves,
 
 bool WesternBoard::inCheck(Side side, int square) const
 {
-	Side opSide = side.opposite();
 	if (square == 0)
 	{
 		square = m_kingSquare[side];
@@ -1110,6 +1182,32 @@ bool WesternBoard::inCheck(Side side, int square) const
 			return false;
 	}
 
+	return isAttacked(side, square, nullptr);
+}
+
+inline Piece WesternBoard::pieceAfter(int square,
+				      Side side,
+				      const SquareChanges* changes) const
+{
+	if (changes != nullptr)
+	{
+		if (square == changes->occupied[0]
+		||  square == changes->occupied[1])
+			return Piece(side, Pawn);
+		if (square == changes->vacated[0]
+		||  square == changes->vacated[1])
+			return Piece::NoPiece;
+	}
+
+	return pieceAt(square);
+}
+
+bool WesternBoard::isAttacked(Side side,
+			      int square,
+			      const SquareChanges* changes) const
+{
+	Side opSide = side.opposite();
+
 	// Pawn attacks
 	int sign = (side == Side::White) ? 1 : -1;
 
@@ -1118,7 +1216,7 @@ bool WesternBoard::inCheck(Side side, int square) const
 		if (pStep.type == CaptureStep)
 		{
 			int fromSquare = square - pawnPushOffset(pStep, -sign);
-			if (pieceAt(fromSquare) == Piece(opSide, Pawn))
+			if (pieceAfter(fromSquare, side, changes) == Piece(opSide, Pawn))
 				return true;
 		}
 	}
@@ -1129,7 +1227,7 @@ bool WesternBoard::inCheck(Side side, int square) const
 	// Knight, archbishop, chancellor attacks
 	for (int i = 0; i < m_knightOffsets.size(); i++)
 	{
-		piece = pieceAt(square + m_knightOffsets[i]);
+		piece = pieceAfter(square + m_knightOffsets[i], side, changes);
 		if (piece.side() == opSide
 		&&  pieceHasMovement(piece.type(), KnightMovement))
 			return true;
@@ -1141,9 +1239,9 @@ bool WesternBoard::inCheck(Side side, int square) const
 		int offset = m_bishopOffsets[i];
 		int targetSquare = square + offset;
 		if (m_kingCanCapture
-		&&  pieceAt(targetSquare) == opKing)
+		&&  pieceAfter(targetSquare, side, changes) == opKing)
 			return true;
-		while ((piece = pieceAt(targetSquare)).isEmpty()
+		while ((piece = pieceAfter(targetSquare, side, changes)).isEmpty()
 		||     piece.side() == opSide)
 		{
 			if (!piece.isEmpty())
@@ -1162,9 +1260,9 @@ bool WesternBoard::inCheck(Side side, int square) const
 		int offset = m_rookOffsets[i];
 		int targetSquare = square + offset;
 		if (m_kingCanCapture
-		&&  pieceAt(targetSquare) == opKing)
+		&&  pieceAfter(targetSquare, side, changes) == opKing)
 			return true;
-		while ((piece = pieceAt(targetSquare)).isEmpty()
+		while ((piece = pieceAfter(targetSquare, side, changes)).isEmpty()
 		||     piece.side() == opSide)
 		{
 			if (!piece.isEmpty())
@@ -1237,9 +1335,395 @@ bool WesternBoard::vIsLegalMove(const Move& move)
 	&&  captureType(move) != Piece::NoPiece)
 		return false;
 
+	if (m_hasStandardLegality
+	&&  m_legalityShortcutEnabled
+	&&  move.sourceSquare() != 0
+	&&  m_kingSquare[sideToMove()] != 0)
+		return isLegalWithoutMoving(move);
+
 	return Board::vIsLegalMove(move);
 }
 
+void WesternBoard::updateCheckInfo()
+{
+	CheckInfo& info = m_checkInfo;
+	Side side = sideToMove();
+	Side opSide = side.opposite();
+	int square = m_kingSquare[side];
+
+	info.isValid = true;
+	info.checkerCount = 0;
+	info.checker = 0;
+	info.checkOffset = 0;
+	info.pins.clear();
+
+	// Pawn checks
+	int sign = (side == Side::White) ? 1 : -1;
+
+	for (const PawnStep& pStep: m_pawnSteps)
+	{
+		if (pStep.type == CaptureStep)
+		{
+			int fromSquare = square - pawnPushOffset(pStep, -sign);
+			if (pieceAt(fromSquare) == Piece(opSide, Pawn))
+			{
+				info.checkerCount++;
+				info.checker = fromSquare;
+			}
+		}
+	}
+
+	// Knight, archbishop, chancellor checks
+	for (int i = 0; i < m_knightOffsets.size(); i++)
+	{
+		int fromSquare = square + m_knightOffsets[i];
+		Piece piece = pieceAt(fromSquare);
+		if (piece.side() == opSide
+		&&  pieceHasMovement(piece.type(), KnightMovement))
+		{
+			info.checkerCount++;
+			info.checker = fromSquare;
+		}
+	}
+
+	// Sliding checks and pins. A piece of the side to move is pinned
+	// if it's the only piece between the king and an opposing slider.
+	Piece opKing(opSide, King);
+	for (int dir = 0; dir < 2; dir++)
+	{
+		const QVarLengthArray<int>& offsets =
+			(dir == 0) ? m_bishopOffsets : m_rookOffsets;
+		unsigned movement = (dir == 0) ? BishopMovement : RookMovement;
+
+		for (int i = 0; i < offsets.size(); i++)
+		{
+			int offset = offsets[i];
+			int targetSquare = square + offset;
+			if (m_kingCanCapture
+			&&  pieceAt(targetSquare) == opKing)
+			{
+				info.checkerCount++;
+				info.checker = targetSquare;
+				continue;
+			}
+
+			int pinned = 0;
+			for (;; targetSquare += offset)
+			{
+				Piece piece = pieceAt(targetSquare);
+				if (piece.isEmpty())
+					continue;
+				if (piece.isWall())
+					break;
+				if (piece.side() == side)
+				{
+					if (pinned != 0)
+						break;
+					pinned = targetSquare;
+					continue;
+				}
+
+				if (pieceHasMovement(piece.type(), movement))
+				{
+					if (pinned != 0)
+					{
+						Pin pin = { pinned, offset, targetSquare };
+						info.pins.append(pin);
+					}
+					else
+					{
+						info.checkerCount++;
+						info.checker = targetSquare;
+						info.checkOffset = offset;
+					}
+				}
+				break;
+			}
+		}
+	}
+}
+
+bool WesternBoard::isPawnCaptureStep(int source, int target) const
+{
+	for (const PawnStep& pStep: m_pawnSteps)
+	{
+		if (pStep.type == CaptureStep
+		&&  source + pawnPushOffset(pStep, m_sign) == target)
+			return true;
+	}
+
+	return false;
+}
+
+bool WesternBoard::isOnRay(int square, int from, int offset, int to) const
+{
+	for (int i = from + offset; ; i += offset)
+	{
+		if (i == square)
+			return true;
+		if (i == to)
+			return false;
+	}
+}
+
+bool WesternBoard::isLegalWithoutMoving(const Move& move)
+{
+	Side side = sideToMove();
+	int source = move.sourceSquare();
+	int target = move.targetSquare();
+	int king = m_kingSquare[side];
+
+	if (!m_checkInfo.isValid)
+		updateCheckInfo();
+	const CheckInfo& info = m_checkInfo;
+
+	if (source == king)
+	{
+		CastlingSide cside = castlingSide(move);
+		if (cside == NoCastlingSide)
+		{
+			SquareChanges changes = { {king, -1}, {-1, -1} };
+			return !isAttacked(side, target, &changes);
+		}
+
+		// The king can't castle out of check, and no square
+		// between its initial and final squares (including the
+		// final square) may be attacked after castling.
+		if (info.checkerCount > 0)
+			return false;
+
+		int kingTarget = m_castleTarget[side][cside];
+		int rookTarget = (cside == QueenSide) ? kingTarget + 1 : kingTarget - 1;
+		SquareChanges changes = { {king, target}, {kingTarget, rookTarget} };
+		int offset = (king <= kingTarget) ? 1 : -1;
+
+		for (int i = king; ; i += offset)
+		{
+			if (isAttacked(side, i, &changes))
+				return false;
+			if (i == kingTarget)
+				return true;
+		}
+	}
+
+	if (info.checkerCount > 1)
+		return false;
+
+	// An en-passant capture removes the captured pawn from a third
+	// square, which may uncover an attack against the king. A pawn
+	// that reaches the square with a non-capturing step (possible in
+	// Berolina chess) doesn't capture anything.
+	if (target == m_enpassantSquare
+	&&  pieceAt(source).type() == Pawn
+	&&  isPawnCaptureStep(source, target))
+	{
+		if (m_enpassantTarget == 0)
+			return Board::vIsLegalMove(move);
+
+		SquareChanges changes = { {source, m_enpassantTarget}, {target, -1} };
+		return !isAttacked(side, king, &changes);
+	}
+
+	for (int i = 0; i < info.pins.size(); i++)
+	{
+		const Pin& pin = info.pins.at(i);
+		if (pin.square == source)
+		{
+			if (!isOnRay(target, king, pin.offset, pin.pinner))
+				return false;
+			break;
+		}
+	}
+
+	if (info.checkerCount == 1)
+	{
+		return target == info.checker
+		    || (info.checkOffset != 0
+		    &&  isOnRay(target, king, info.checkOffset, info.checker));
+	}
+
+	return true;
+}
+
+bool WesternBoard::generateLegalMoves(QVarLengthArray<Move>& moves)
+{
+	if (!usesBitboards())
+		return false;
+
+	return generateBitboardMoves(moves);
+}
+
+bool WesternBoard::generateBitboardMoves(QVarLengthArray<Move>& moves) const
+{
+	using namespace Bitboard;
+
+	const Side side = sideToMove();
+	const Side opSide = side.opposite();
+	if (m_kingSquare[side] == 0
+	||  (m_enpassantSquare != 0 && m_enpassantTarget == 0))
+		return false;
+
+	const quint64 backRanks = Q_UINT64_C(0xFF000000000000FF);
+	BitboardPosition pos;
+	pos.sides[Side::White] = pos.sides[Side::Black] = 0;
+	for (int i = 0; i <= King; i++)
+		pos.pieces[i] = 0;
+
+	for (int sq = 0; sq < 64; sq++)
+	{
+		const Piece piece = pieceAt(toSquareIndex(sq));
+		if (piece.isEmpty())
+			continue;
+		// Leave unknown pieces and pawns on the back ranks
+		// to the mailbox generator
+		if (piece.type() > King
+		||  (piece.type() == Pawn && (squareBit(sq) & backRanks)))
+			return false;
+
+		pos.sides[piece.side()] |= squareBit(sq);
+		pos.pieces[piece.type()] |= squareBit(sq);
+	}
+
+	const quint64 us = pos.sides[side];
+	const quint64 them = pos.sides[opSide];
+	const quint64 occupied = us | them;
+	const int kingSq = fromSquareIndex(m_kingSquare[side]);
+	const quint64 kingBit = squareBit(kingSq);
+	const quint64 checkers = pos.attackers(side, kingSq, occupied);
+
+	// A piece is pinned if it's the only piece between the king
+	// and an opposing slider
+	quint64 pinned = 0;
+	quint64 snipers =
+		((bishopAttacks(kingSq, 0) & (pos.pieces[Bishop] | pos.pieces[Queen]))
+	       | (rookAttacks(kingSq, 0) & (pos.pieces[Rook] | pos.pieces[Queen])))
+	       & them;
+	while (snipers)
+	{
+		quint64 blockers = between(kingSq, popLsb(snipers)) & occupied;
+		if (blockers != 0 && !moreThanOne(blockers))
+			pinned |= blockers & us;
+	}
+
+	// King moves. The king can't hide from a slider on its own ray.
+	quint64 targets = kingAttacks(kingSq) & ~us;
+	while (targets)
+	{
+		int to = popLsb(targets);
+		if (!pos.attackers(side, to, occupied ^ kingBit))
+			moves.append(Move(m_kingSquare[side], toSquareIndex(to)));
+	}
+	if (moreThanOne(checkers))
+		return true;
+
+	// In check the other pieces must capture the checker or block it
+	quint64 allowed = ~us;
+	if (checkers)
+		allowed &= between(kingSq, lsb(checkers)) | checkers;
+
+	quint64 pieces = us & ~pos.pieces[Pawn] & ~pos.pieces[King];
+	while (pieces)
+	{
+		int from = popLsb(pieces);
+		quint64 bit = squareBit(from);
+		quint64 attacks = 0;
+
+		if (bit & pos.pieces[Knight])
+			attacks = knightAttacks(from);
+		if (bit & (pos.pieces[Bishop] | pos.pieces[Queen]))
+			attacks |= bishopAttacks(from, occupied);
+		if (bit & (pos.pieces[Rook] | pos.pieces[Queen]))
+			attacks |= rookAttacks(from, occupied);
+
+		attacks &= allowed;
+		if (bit & pinned)
+			attacks &= line(kingSq, from);
+
+		int source = toSquareIndex(from);
+		while (attacks)
+			moves.append(Move(source, toSquareIndex(popLsb(attacks))));
+	}
+
+	// Pawn moves
+	const int up = (side == Side::White) ? 8 : -8;
+	const quint64 startRank = (side == Side::White)
+		? Q_UINT64_C(0x000000000000FF00) : Q_UINT64_C(0x00FF000000000000);
+	quint64 pawns = us & pos.pieces[Pawn];
+	while (pawns)
+	{
+		int from = popLsb(pawns);
+		quint64 mask = allowed;
+		if (squareBit(from) & pinned)
+			mask &= line(kingSq, from);
+
+		quint64 dest = pawnAttacks(side, from) & them;
+		int to = from + up;
+		if (!(occupied & squareBit(to)))
+		{
+			dest |= squareBit(to);
+			to += up;
+			if ((squareBit(from) & startRank)
+			&&  !(occupied & squareBit(to)))
+				dest |= squareBit(to);
+		}
+		dest &= mask;
+
+		int source = toSquareIndex(from);
+		while (dest)
+		{
+			to = popLsb(dest);
+			if (squareBit(to) & backRanks)
+				addPromotions(source, toSquareIndex(to), moves);
+			else
+				moves.append(Move(source, toSquareIndex(to)));
+		}
+	}
+
+	// En-passant captures. Removing two pawns from the same rank
+	// can expose the king, so test the resulting position directly.
+	if (m_enpassantSquare != 0)
+	{
+		int epSq = fromSquareIndex(m_enpassantSquare);
+		quint64 captured = squareBit(fromSquareIndex(m_enpassantTarget));
+		quint64 epPawns = pawnAttacks(opSide, epSq) & us & pos.pieces[Pawn];
+		while (epPawns)
+		{
+			int from = popLsb(epPawns);
+			quint64 occ = (occupied ^ squareBit(from) ^ captured)
+				    | squareBit(epSq);
+			if (!(pos.attackers(side, kingSq, occ) & ~captured))
+				moves.append(Move(toSquareIndex(from),
+						  m_enpassantSquare));
+		}
+	}
+
+	// Castling. The king's path is tested with the king and the rook
+	// on their destination squares, like isLegalPosition() does.
+	if (checkers)
+		return true;
+	for (int i = QueenSide; i <= KingSide; i++)
+	{
+		int rookSq = m_castlingRights.rookSquare[side][i];
+		if (rookSq == 0 || !canCastle(CastlingSide(i)))
+			continue;
+
+		int kingTarget = fromSquareIndex(m_castleTarget[side][i]);
+		int rookTarget = (i == QueenSide) ? kingTarget + 1 : kingTarget - 1;
+		quint64 occ = (occupied ^ kingBit ^ squareBit(fromSquareIndex(rookSq)))
+			    | squareBit(kingTarget) | squareBit(rookTarget);
+		quint64 path = between(kingSq, kingTarget)
+			     | kingBit | squareBit(kingTarget);
+
+		bool attacked = false;
+		while (path && !attacked)
+			attacked = pos.attackers(side, popLsb(path), occ) != 0;
+		if (!attacked)
+			moves.append(Move(m_kingSquare[side], rookSq));
+	}
+
+	return true;
+}
+
 void WesternBoard::addPromotions(int sourceSquare,
 				 int targetSquare,
 				 QVarLengthArray<Move>& moves) const
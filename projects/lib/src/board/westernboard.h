@@ -54,6 +54,30 @@ class LIB_EXPORT WesternBoard : public Board
 		/*! Creates a new WesternBoard object. */
 		WesternBoard(WesternZobrist* zobrist);
 
+		/*!
+		 * Returns true if legal moves are generated with bitboards.
+		 * \sa hasBitboardBackend()
+		 */
+		bool usesBitboards() const;
+		/*!
+		 * Enables or disables the bitboard move generator.
+		 *
+		 * The bitboard generator is enabled by default in variants
+		 * that support it. When it's disabled the mailbox generator
+		 * is used instead, which is mainly useful for testing.
+		 */
+		void setBitboardsEnabled(bool enabled);
+		/*!
+		 * Enables or disables the legality check that doesn't
+		 * make the move.
+		 *
+		 * The check is enabled by default in variants with
+		 * standard legality rules. When it's disabled every move
+		 * is made and undone to see if it leaves the king in
+		 * check, which is mainly useful for testing.
+		 */
+		void setLegalityShortcutEnabled(bool enabled);
+
 		// Inherited from Board
 		virtual int width() const;
 		virtual int height() const;
@@ -142,6 +166,33 @@ class LIB_EXPORT WesternBoard : public Board
 		 * \sa SeirawanBoard
 		 */
 		virtual bool variantHasChanneling(Side side, int square) const;
+		/*!
+		 * Returns true if a move is legal exactly when it doesn't
+		 * leave the king under attack as defined by WesternBoard's
+		 * inCheck(), and the move has no side effects beyond those
+		 * of standard chess moves.
+		 *
+		 * Such variants can test the legality of a move without
+		 * making it: checking pieces and pinned pieces are found
+		 * once per position, and each move is compared against them.
+		 * The default value is false.
+		 * \sa StandardBoard
+		 * \sa CapablancaBoard
+		 */
+		virtual bool hasStandardLegality() const;
+		/*!
+		 * Returns true if the variant can generate its legal moves
+		 * with bitboards.
+		 *
+		 * The bitboard generator implements the rules of standard
+		 * chess for the standard pieces on an 8x8 board, so variants
+		 * that change the movement of the pieces must return false.
+		 * The bitboards are only used if hasStandardLegality()
+		 * also returns true.
+		 * The default value is false.
+		 * \sa StandardBoard
+		 */
+		virtual bool hasBitboardBackend() const;
 		/*!
 		 * Adds pawn promotions to a move list.
 		 *
@@ -217,6 +268,7 @@ class LIB_EXPORT WesternBoard : public Board
 						   int pieceType,
 						   int square) const;
 		virtual bool vIsLegalMove(const Move& move);
+		virtual bool generateLegalMoves(QVarLengthArray<Move>& moves);
 		virtual bool isLegalPosition();
 		virtual int captureType(const Move& move) const;
 
@@ -239,11 +291,48 @@ class LIB_EXPORT WesternBoard : public Board
 			int reversibleMoveCount;
 		};
 
+		// Squares emptied and filled by a move that hasn't been
+		// made. Unused entries are -1.
+		struct SquareChanges
+		{
+			int vacated[2];
+			int occupied[2];
+		};
+
+		// A piece pinned against its own king
+		struct Pin
+		{
+			int square;
+			int offset;
+			int pinner;
+		};
+
+		// Checking pieces and pinned pieces of the side to move
+		struct CheckInfo
+		{
+			bool isValid;
+			int checkerCount;
+			int checker;
+			int checkOffset;
+			QVarLengthArray<Pin, 8> pins;
+		};
+
 		void generateCastlingMoves(QVarLengthArray<Move>& moves) const;
+		bool generateBitboardMoves(QVarLengthArray<Move>& moves) const;
 		void generatePawnMoves(int sourceSquare,
 				       QVarLengthArray<Move>& moves) const;
 
 		bool canCastle(CastlingSide castlingSide) const;
+		bool isAttacked(Side side,
+				int square,
+				const SquareChanges* changes) const;
+		inline Piece pieceAfter(int square,
+					Side side,
+					const SquareChanges* changes) const;
+		void updateCheckInfo();
+		bool isOnRay(int square, int from, int offset, int to) const;
+		bool isPawnCaptureStep(int source, int target) const;
+		bool isLegalWithoutMoving(const Move& move);
 		QString castlingRightsString(FenNotation notation) const;
 		CastlingSide castlingSide(const Move& move) const;
 		void setEnpassantSquare(int square,
@@ -269,9 +358,14 @@ class LIB_EXPORT WesternBoard : public Board
 		bool m_hasEnPassantCaptures;
 		bool m_pawnAmbiguous;
 		bool m_multiDigitNotation;
+		bool m_hasStandardLegality;
+		bool m_hasBitboards;
+		bool m_bitboardsEnabled;
+		bool m_legalityShortcutEnabled;
 		QVector<MoveData> m_history;
 		CastlingRights m_castlingRights;
 		int m_castleTarget[2][2];
+		CheckInfo m_checkInfo;
 		const WesternZobrist* m_zobrist;
 
 		QVarLengthArray<int> m_knightOffsets;
@@ -21,7 +21,9 @@
 #include <QTimer>
 #include <QStringRef>
 #include <QtAlgorithms>
+#include <cstring>
 #include "engineoption.h"
+#include "engineprocess.h"
 
 
 int ChessEngine::s_count = 0;
@@ -81,7 +83,15 @@ ChessEngine::ChessEngine(QObject* parent)
 	  m_idleTimer(new QTimer(this)),
 	  m_protocolStartTimer(new QTimer(this)),
 	  m_ioDevice(nullptr),
+	  m_readPos(0),
+	  m_readTotal(0),
+	  m_lineTimePos(0),
+	  m_readNs(-1),
+	  m_writeNs(-1),
+	  m_clockStartPending(false),
 	  m_restartMode(EngineConfiguration::RestartAuto),
+	  m_positionDeltaPlies(0),
+	  m_thinkingInterval(EngineConfiguration::DefaultThinkingInterval),
 	  m_cuteseal(false)
 {
 	m_pingTimer->setSingleShot(true);
@@ -100,6 +110,9 @@ ChessEngine::ChessEngine(QObject* parent)
 	m_protocolStartTimer->setInterval(125000);
 	connect(m_protocolStartTimer, SIGNAL(timeout()),
 		this, SLOT(onProtocolStartTimeout()));
+
+	// A reserved buffer keeps its memory when it's emptied
+	m_readBuffer.reserve(4096);
 }
 
 ChessEngine::~ChessEngine()
@@ -118,6 +131,11 @@ void ChessEngine::setDevice(QIODevice* device)
 
 	m_ioDevice = device;
 	m_ioDevice->setParent(this);
+	m_readBuffer.resize(0);
+	m_readPos = 0;
+	m_readTotal = 0;
+	m_lineTimes.clear();
+	m_lineTimePos = 0;
 
 	connect(m_ioDevice, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
 	connect(m_ioDevice, SIGNAL(readChannelFinished()), this, SLOT(onCrashed()));
@@ -146,6 +164,8 @@ void ChessEngine::applyConfiguration(const EngineConfiguration& configuration)
 	m_whiteEvalPov = configuration.whiteEvalPov();
 	m_pondering = configuration.pondering();
 	m_restartMode = configuration.restartMode();
+	m_positionDeltaPlies = configuration.positionDeltaPlies();
+	m_thinkingInterval = configuration.thinkingInterval();
 	setClaimsValidated(configuration.areClaimsValidated());
 
 	if (configuration.rating())
@@ -306,6 +326,16 @@ bool ChessEngine::isCuteseal() const
 	return m_cuteseal;
 }
 
+int ChessEngine::positionDeltaPlies() const
+{
+	return m_positionDeltaPlies;
+}
+
+int ChessEngine::thinkingInterval() const
+{
+	return m_thinkingInterval;
+}
+
 void ChessEngine::endGame(const Chess::Result& result)
 {
 	ChessPlayer::endGame(result);
@@ -457,32 +487,106 @@ void ChessEngine::write(const QString& data, WriteMode mode)
 	}
 
 	Q_ASSERT(m_ioDevice->isWritable());
-	emit debugMessage(QString(">%1(%2): %3")
-			  .arg(name())
-			  .arg(m_id)
-			  .arg(data));
+	if (hasDebugReceivers())
+		emit debugMessage(QString(">%1(%2): %3")
+				  .arg(name())
+				  .arg(m_id)
+				  .arg(data));
 
 	if (m_ioDevice->write(data.toLatin1() + "\n") == -1)
 		qWarning("Writing to engine %s(%d) failed",
 			 qUtf8Printable(name()), m_id);
+	m_writeNs = TimeControl::monotonicNs();
+}
+
+void ChessEngine::startClockOnWrite()
+{
+	// A buffered command is sent when the buffer is flushed
+	if (!m_writeBuffer.isEmpty())
+	{
+		m_clockStartPending = true;
+		return;
+	}
+
+	m_clockStartPending = false;
+	restartClock(m_writeNs);
+}
+
+qint64 ChessEngine::inputTimestampNs() const
+{
+	return m_readNs;
+}
+
+bool ChessEngine::hasDebugReceivers() const
+{
+	return receivers(SIGNAL(debugMessage(QString))) > 0;
 }
 
 void ChessEngine::onReadyRead()
 {
-	while (m_ioDevice->isReadable() && m_ioDevice->canReadLine())
+	// Each line is stamped with the time it arrived, so the time
+	// the lines wait for parsing isn't charged to the engine. The
+	// pipe reactor knows when each line really arrived; otherwise
+	// the lines arrived by now.
+	const qint64 nowNs = TimeControl::monotonicNs();
+#ifdef Q_OS_LINUX
+	auto process = qobject_cast<EngineProcess*>(m_ioDevice);
+#endif
+
+	// Append the available input to a reusable buffer and split it
+	// into lines in place. Only complete lines are converted to
+	// strings, and the consumed bytes are dropped at the end.
+	const qint64 available = m_ioDevice->bytesAvailable();
+	if (available > 0)
 	{
-		QString line = QString(m_ioDevice->readLine());
-		if (line.endsWith('\n'))
-			line.chop(1);
-		if (line.endsWith('\r'))
-			line.chop(1);
-		if (line.isEmpty())
+		const int size = m_readBuffer.size();
+		m_readBuffer.resize(size + int(available));
+		const qint64 count = m_ioDevice->read(m_readBuffer.data() + size,
+						      available);
+		m_readBuffer.resize(size + int(qMax(count, qint64(0))));
+
+		// Note the arrival time of every line end that was read
+		const char* begin = m_readBuffer.constData() + size;
+		const char* data = begin;
+		const char* bufferEnd = m_readBuffer.constData() + m_readBuffer.size();
+		while ((data = static_cast<const char*>(
+			memchr(data, '\n', size_t(bufferEnd - data)))) != nullptr)
+		{
+			qint64 ns = -1;
+#ifdef Q_OS_LINUX
+			if (process != nullptr)
+				ns = process->readTimestampNs(m_readTotal + (data - begin));
+#endif
+			m_lineTimes.append(ns < 0 ? nowNs : ns);
+			data++;
+		}
+		m_readTotal += m_readBuffer.size() - size;
+	}
+
+	while (m_ioDevice->isReadable())
+	{
+		// parseLine() may process more input, so the position
+		// and the data pointer can't be cached across lines
+		const char* data = m_readBuffer.constData() + m_readPos;
+		const char* end = static_cast<const char*>(
+			memchr(data, '\n', size_t(m_readBuffer.size() - m_readPos)));
+		if (end == nullptr)
+			break;
+
+		int length = int(end - data);
+		m_readPos += length + 1;
+		m_readNs = m_lineTimes.at(m_lineTimePos++);
+		if (length > 0 && data[length - 1] == '\r')
+			length--;
+		if (length == 0)
 			continue;
 
-		emit debugMessage(QString("<%1(%2): %3")
-				  .arg(name())
-				  .arg(m_id)
-				  .arg(line));
+		const QString line(QString::fromUtf8(data, length));
+		if (hasDebugReceivers())
+			emit debugMessage(QString("<%1(%2): %3")
+					  .arg(name())
+					  .arg(m_id)
+					  .arg(line));
 		parseLine(line);
 
 		if (m_idleTimer->isActive())
@@ -493,6 +597,15 @@ void ChessEngine::onReadyRead()
 				m_idleTimer->stop();
 		}
 	}
+
+	if (m_readPos > 0)
+	{
+		m_readBuffer.remove(0, m_readPos);
+		m_readPos = 0;
+		m_lineTimes.remove(0, m_lineTimePos);
+		m_lineTimePos = 0;
+	}
+	m_readNs = -1;
 }
 
 void ChessEngine::flushWriteBuffer()
@@ -503,11 +616,18 @@ void ChessEngine::flushWriteBuffer()
 	for (const QString& line : qAsConst(m_writeBuffer))
 		write(line);
 	m_writeBuffer.clear();
+
+	if (m_clockStartPending)
+	{
+		m_clockStartPending = false;
+		restartClock(m_writeNs);
+	}
 }
 
 void ChessEngine::clearWriteBuffer()
 {
 	m_writeBuffer.clear();
+	m_clockStartPending = false;
 }
 
 void ChessEngine::onProtocolStartTimeout()
@@ -22,6 +22,7 @@
 #include "chessplayer.h"
 #include <QVariant>
 #include <QStringList>
+#include <QVector>
 #include "engineconfiguration.h"
 
 class QIODevice;
@@ -232,6 +233,32 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 
 		bool isCuteseal() const;
 
+		/*!
+		 * Returns the game length, in plies, after which the engine
+		 * may send positions relative to the last irreversible move.
+		 * \sa EngineConfiguration::positionDeltaPlies()
+		 */
+		int positionDeltaPlies() const;
+		/*!
+		 * Returns the minimum time in milliseconds between two
+		 * thinking updates.
+		 * \sa EngineConfiguration::thinkingInterval()
+		 */
+		int thinkingInterval() const;
+
+		/*!
+		 * Starts the move clock when the last command passed to
+		 * write() is actually sent to the engine.
+		 *
+		 * Subclasses call this right after writing the command that
+		 * starts a search, so that the time a buffered command waits
+		 * isn't charged to the engine.
+		 */
+		void startClockOnWrite();
+
+		// Inherited from ChessPlayer
+		virtual qint64 inputTimestampNs() const;
+
 	protected slots:
 		// Inherited from ChessPlayer
 		virtual void onTimeout();
@@ -276,6 +303,8 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		void onProtocolStartTimeout();
 
 	private:
+		bool hasDebugReceivers() const;
+
 		static int s_count;
 
 		int m_id;
@@ -288,11 +317,21 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		QTimer* m_idleTimer;
 		QTimer* m_protocolStartTimer;
 		QIODevice *m_ioDevice;
+		QByteArray m_readBuffer;
+		int m_readPos;
+		qint64 m_readTotal;
+		QVector<qint64> m_lineTimes;
+		int m_lineTimePos;
+		qint64 m_readNs;
+		qint64 m_writeNs;
+		bool m_clockStartPending;
 		QStringList m_writeBuffer;
 		QStringList m_variants;
 		QList<EngineOption*> m_options;
 		QMap<QString, QVariant> m_optionBuffer;
 		EngineConfiguration::RestartMode m_restartMode;
+		int m_positionDeltaPlies;
+		int m_thinkingInterval;
 		QString m_configurationString;
 		bool m_cuteseal;
 };
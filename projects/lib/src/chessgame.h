@@ -28,6 +28,7 @@
 #include "board/move.h"
 #include "timecontrol.h"
 #include "gameadjudicator.h"
+#include "livejsonserializer.h"
 
 namespace Chess { class Board; }
 class ChessPlayer;
@@ -125,7 +126,7 @@ class LIB_EXPORT ChessGame : public QObject
 		void addPgnMove(const Chess::Move& move, const QString& comment);
 		void emitLastMove();
 
-		void updateLiveFiles() const;
+		void updateLiveFiles();
 
 		QString evalString(const MoveEvaluation& eval, const Chess::Move& move);
         QString statusString(const Chess::Move& move, bool doMove);
@@ -157,6 +158,7 @@ class LIB_EXPORT ChessGame : public QObject
 		PgnGame::PgnMode m_livePgnOutMode = PgnGame::Minimal;
 		bool m_pgnFormat = false;
 		bool m_jsonFormat = false;
+		LiveJsonSerializer m_liveJson;
 };
 
 #endif // CHESSGAME_H
@@ -33,6 +33,7 @@ ChessPlayer::ChessPlayer(QObject* parent)
 	  m_rating(0)
 {
 	m_timer->setSingleShot(true);
+	m_timer->setTimerType(Qt::PreciseTimer);
 	connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
 }
 
@@ -129,12 +130,35 @@ void ChessPlayer::startClock()
 	m_timeControl.startTimer();
 
 	if (!m_timeControl.isInfinite())
+		startFlagTimer(0);
+}
+
+void ChessPlayer::restartClock(qint64 timestampNs)
+{
+	if (m_state != Thinking)
+		return;
+
+	m_timeControl.startTimer(timestampNs);
+
+	// The flag timer runs from the new start of the clock
+	if (!m_timeControl.isInfinite() && m_timer->isActive())
 	{
-		int t = m_timeControl.timeLeft() + m_timeControl.expiryMargin() + getMaxNetLagMs();
-		m_timer->start(qMax(t, 0) + 200);
+		const qint64 spentNs = TimeControl::monotonicNs() - timestampNs;
+		startFlagTimer(int(qMax(spentNs, qint64(0)) / 1000000));
 	}
 }
 
+void ChessPlayer::startFlagTimer(int spentMs)
+{
+	int t = m_timeControl.timeLeft() + m_timeControl.expiryMargin() + getMaxNetLagMs();
+	m_timer->start(qMax(qMax(t, 0) + 200 - spentMs, 0));
+}
+
+qint64 ChessPlayer::inputTimestampNs() const
+{
+	return -1;
+}
+
 void ChessPlayer::makeBookMove(const Chess::Move& move)
 {
 	m_timeControl.startTimer();
@@ -256,7 +280,7 @@ void ChessPlayer::claimResult(const Chess::Result& result)
 		return;
 
 	m_timer->stop();
-	m_timeControl.update();
+	m_timeControl.update(true, -1, inputTimestampNs());
 	if (m_state == Thinking)
 		setState(Observing);
 	m_claimedResult = true;
@@ -280,7 +304,7 @@ void ChessPlayer::emitMove(const Chess::Move& move, int64_t overrideMoveTimeMs)
 	if (m_state == Thinking)
 		setState(Observing);
 
-	m_timeControl.update(true, overrideMoveTimeMs);
+	m_timeControl.update(true, overrideMoveTimeMs, inputTimestampNs());
 	m_eval.setTime(m_timeControl.lastMoveTime());
 
 	m_timer->stop();
@@ -285,6 +285,28 @@ class LIB_EXPORT ChessPlayer : public QObject
 		 * cuteseal is enabled.
 		 */
 		void emitMove(const Chess::Move& move, int64_t overrideMoveTimeMs = -1);
+
+		/*!
+		 * Restarts the move clock at \a timestampNs.
+		 *
+		 * Players that send their move requests asynchronously use
+		 * this to start the clock when the request was actually sent.
+		 * Does nothing if the player isn't thinking.
+		 *
+		 * \sa TimeControl::monotonicNs()
+		 */
+		void restartClock(qint64 timestampNs);
+		/*!
+		 * Returns the time when the input that is being processed
+		 * arrived, or -1 if it isn't known.
+		 *
+		 * The move clock stops at this time instead of the moment
+		 * the move is processed. The default implementation
+		 * returns -1.
+		 *
+		 * \sa TimeControl::monotonicNs()
+		 */
+		virtual qint64 inputTimestampNs() const;
 		
 		/*! Returns the opposing player. */
 		const ChessPlayer* opponent() const;
@@ -314,6 +336,7 @@ class LIB_EXPORT ChessPlayer : public QObject
 		virtual int getMaxNetLagMs() const { return 0; }
 	private:
 		void startClock();
+		void startFlagTimer(int spentMs);
 
 		QString m_name;
 		QString m_error;
@@ -0,0 +1,393 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cpuallocator.h"
+#include <algorithm>
+#include <QMap>
+#include <QSet>
+#include <QPair>
+#include <QStringList>
+#include <QThread>
+#ifdef Q_OS_LINUX
+  #include <cerrno>
+  #include <sched.h>
+  #include <unistd.h>
+  #include <sys/resource.h>
+  #include <QDir>
+  #include <QFile>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+const char* const CpuDir = "/sys/devices/system/cpu";
+
+QString readSysFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return QString();
+	return QString::fromLatin1(file.readAll()).trimmed();
+}
+
+int readSysInt(const QString& fileName, int defaultValue)
+{
+	bool ok = false;
+	int value = readSysFile(fileName).toInt(&ok);
+	return ok ? value : defaultValue;
+}
+
+bool canLeaveIdle()
+{
+	// The kernel lets a thread leave SCHED_IDLE if its nice value
+	// is within RLIMIT_NICE, or if the caller has CAP_SYS_NICE
+	if (geteuid() == 0)
+		return true;
+
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NICE, &limit) != 0)
+		return false;
+	if (limit.rlim_cur == RLIM_INFINITY)
+		return true;
+
+	errno = 0;
+	const int nice = getpriority(PRIO_PROCESS, 0);
+	if (nice == -1 && errno != 0)
+		return false;
+	return rlim_t(20 - nice) <= limit.rlim_cur;
+}
+#endif
+
+} // anonymous namespace
+
+CpuAllocator::CpuAllocator()
+	: m_respectSmt(true),
+	  m_respectNuma(true)
+{
+}
+
+CpuAllocator::CpuAllocator(const QList<Cpu>& cpus)
+	: m_cpus(cpus),
+	  m_respectSmt(true),
+	  m_respectNuma(true)
+{
+	buildUnits();
+}
+
+QList<CpuAllocator::Cpu> CpuAllocator::systemCpus()
+{
+	QList<Cpu> cpus;
+
+#ifdef Q_OS_LINUX
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	const bool hasMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+	QList<int> ids(parseList(readSysFile(QString("%1/online").arg(CpuDir))));
+	if (ids.isEmpty())
+	{
+		for (int i = 0; i < QThread::idealThreadCount(); i++)
+			ids << i;
+	}
+
+	// Core ids are only unique inside a package
+	QMap<QPair<int, int>, int> cores;
+	for (int id : qAsConst(ids))
+	{
+		if (hasMask && (id >= CPU_SETSIZE || !CPU_ISSET(id, &allowed)))
+			continue;
+
+		const QString dir(QString("%1/cpu%2").arg(CpuDir).arg(id));
+		const int package = readSysInt(dir + "/topology/physical_package_id", 0);
+		const int coreId = readSysInt(dir + "/topology/core_id", -1 - id);
+		const QPair<int, int> key(package, coreId);
+		if (!cores.contains(key))
+			cores.insert(key, cores.size());
+
+		int node = 0;
+		const QStringList nodes(QDir(dir).entryList(QStringList() << "node*",
+							    QDir::Dirs));
+		if (!nodes.isEmpty())
+			node = nodes.first().mid(4).toInt();
+
+		Cpu cpu = { id, cores.value(key), node };
+		cpus << cpu;
+	}
+#else
+	for (int i = 0; i < QThread::idealThreadCount(); i++)
+	{
+		Cpu cpu = { i, i, 0 };
+		cpus << cpu;
+	}
+#endif
+
+	return cpus;
+}
+
+int CpuAllocator::cpuCount() const
+{
+	return m_cpus.size();
+}
+
+int CpuAllocator::freeCpuCount() const
+{
+	int count = 0;
+	for (const Unit& unit : m_units)
+	{
+		if (!unit.used)
+			count += unit.cpus.size();
+	}
+
+	return count;
+}
+
+bool CpuAllocator::respectsSmt() const
+{
+	return m_respectSmt;
+}
+
+void CpuAllocator::setRespectSmt(bool enabled)
+{
+	m_respectSmt = enabled;
+	buildUnits();
+}
+
+bool CpuAllocator::respectsNuma() const
+{
+	return m_respectNuma;
+}
+
+void CpuAllocator::setRespectNuma(bool enabled)
+{
+	m_respectNuma = enabled;
+}
+
+void CpuAllocator::buildUnits()
+{
+	// Allocated CPUs stay allocated
+	QSet<int> used;
+	for (const Unit& unit : qAsConst(m_units))
+	{
+		if (unit.used)
+			used.unite(unit.cpus.toSet());
+	}
+
+	m_units.clear();
+	QMap<QPair<int, int>, int> cores;
+	for (const Cpu& cpu : qAsConst(m_cpus))
+	{
+		const QPair<int, int> key(cpu.node, m_respectSmt ? cpu.core : -1 - cpu.id);
+		QMap<QPair<int, int>, int>::const_iterator it(cores.constFind(key));
+		if (it == cores.constEnd())
+		{
+			Unit unit = { QList<int>() << cpu.id, cpu.node, false };
+			cores.insert(key, m_units.size());
+			m_units.append(unit);
+		}
+		else
+			m_units[it.value()].cpus << cpu.id;
+	}
+
+	for (Unit& unit : m_units)
+	{
+		for (int id : qAsConst(unit.cpus))
+		{
+			if (used.contains(id))
+				unit.used = true;
+		}
+	}
+}
+
+QList<int> CpuAllocator::take(const QVector<int>& units, int count)
+{
+	QList<int> cpus;
+	for (int i = 0; i < count; i++)
+	{
+		Unit& unit = m_units[units.at(i)];
+		unit.used = true;
+		cpus << unit.cpus;
+	}
+
+	std::sort(cpus.begin(), cpus.end());
+	return cpus;
+}
+
+QList<int> CpuAllocator::allocate(int count)
+{
+	if (count <= 0)
+		return QList<int>();
+
+	QVector<int> freeUnits;
+	QMap<int, QVector<int> > nodeUnits;
+	for (int i = 0; i < m_units.size(); i++)
+	{
+		if (m_units.at(i).used)
+			continue;
+		freeUnits << i;
+		nodeUnits[m_units.at(i).node] << i;
+	}
+
+	// Use the fullest node that still has room, which leaves
+	// the larger holes for the following games
+	if (m_respectNuma)
+	{
+		const QVector<int>* best = nullptr;
+		for (const QVector<int>& units : qAsConst(nodeUnits))
+		{
+			if (units.size() >= count
+			&&  (best == nullptr || units.size() < best->size()))
+				best = &units;
+		}
+		if (best != nullptr)
+			return take(*best, count);
+	}
+
+	if (freeUnits.size() < count)
+		return QList<int>();
+	return take(freeUnits, count);
+}
+
+void CpuAllocator::release(const QList<int>& cpus)
+{
+	for (Unit& unit : m_units)
+	{
+		for (int id : qAsConst(unit.cpus))
+		{
+			if (cpus.contains(id))
+			{
+				unit.used = false;
+				break;
+			}
+		}
+	}
+}
+
+QString CpuAllocator::toString(const QList<int>& cpus)
+{
+	QList<int> ids(cpus);
+	std::sort(ids.begin(), ids.end());
+
+	QStringList ranges;
+	int i = 0;
+	while (i < ids.size())
+	{
+		int j = i;
+		while (j + 1 < ids.size() && ids.at(j + 1) == ids.at(j) + 1)
+			j++;
+
+		if (j == i)
+			ranges << QString::number(ids.at(i));
+		else
+			ranges << QString("%1-%2").arg(ids.at(i)).arg(ids.at(j));
+		i = j + 1;
+	}
+
+	return ranges.join(',');
+}
+
+QList<int> CpuAllocator::parseList(const QString& str)
+{
+	QList<int> cpus;
+	const QStringList ranges(str.split(',', QString::SkipEmptyParts));
+	for (const QString& range : ranges)
+	{
+		bool ok1 = false;
+		bool ok2 = false;
+		const int first = range.section('-', 0, 0).trimmed().toInt(&ok1);
+		const int last = range.contains('-')
+			? range.section('-', 1, 1).trimmed().toInt(&ok2)
+			: first;
+		if (!ok1 || (range.contains('-') && !ok2) || first < 0 || last < first)
+			return QList<int>();
+
+		for (int id = first; id <= last; id++)
+			cpus << id;
+	}
+
+	return cpus;
+}
+
+bool CpuAllocator::setProcessAffinity(qint64 pid, const QList<int>& cpus)
+{
+#ifdef Q_OS_LINUX
+	if (pid <= 0 || cpus.isEmpty())
+		return false;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int id : cpus)
+	{
+		if (id >= 0 && id < CPU_SETSIZE)
+			CPU_SET(id, &set);
+	}
+
+	// The affinity of a process is really the affinity of each of
+	// its threads
+	QStringList tasks(QDir(QString("/proc/%1/task").arg(pid))
+			  .entryList(QDir::Dirs | QDir::NoDotAndDotDot));
+	if (tasks.isEmpty())
+		tasks << QString::number(pid);
+
+	bool ok = false;
+	for (const QString& task : qAsConst(tasks))
+	{
+		if (sched_setaffinity(pid_t(task.toLongLong()), sizeof(set), &set) == 0)
+			ok = true;
+	}
+
+	return ok;
+#else
+	Q_UNUSED(pid);
+	Q_UNUSED(cpus);
+	return false;
+#endif
+}
+
+bool CpuAllocator::setProcessIdle(qint64 pid, bool idle)
+{
+#ifdef Q_OS_LINUX
+	if (pid <= 0 || (idle && !canLeaveIdle()))
+		return false;
+
+	QStringList tasks(QDir(QString("/proc/%1/task").arg(pid))
+			  .entryList(QDir::Dirs | QDir::NoDotAndDotDot));
+	if (tasks.isEmpty())
+		tasks << QString::number(pid);
+
+	struct sched_param param;
+	param.sched_priority = 0;
+	const int policy = idle ? SCHED_IDLE : SCHED_OTHER;
+
+	bool ok = false;
+	for (const QString& task : qAsConst(tasks))
+	{
+		const pid_t tid = pid_t(task.toLongLong());
+		// Threads that were given another policy are left alone
+		if (!idle && sched_getscheduler(tid) != SCHED_IDLE)
+			continue;
+		if (sched_setscheduler(tid, policy, &param) == 0)
+			ok = true;
+	}
+
+	return ok;
+#else
+	Q_UNUSED(pid);
+	Q_UNUSED(idle);
+	return false;
+#endif
+}
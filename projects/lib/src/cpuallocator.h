@@ -0,0 +1,144 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CPUALLOCATOR_H
+#define CPUALLOCATOR_H
+
+#include <QList>
+#include <QVector>
+#include <QString>
+
+/*!
+ * \brief Hands out disjoint sets of CPUs
+ *
+ * CpuAllocator keeps track of which CPUs of the machine are in use,
+ * so that the engines of concurrent games can be pinned to CPUs of
+ * their own instead of migrating between cores and competing for
+ * the same caches.
+ *
+ * If SMT siblings are respected, whole physical cores are allocated,
+ * so that two games never share a core. If NUMA nodes are respected,
+ * a set is taken from a single node whenever one has enough free
+ * CPUs.
+ *
+ * \sa GameManager::setCpuAffinity()
+ */
+class LIB_EXPORT CpuAllocator
+{
+	public:
+		/*! A logical CPU. */
+		struct Cpu
+		{
+			/*! The CPU number used by the operating system. */
+			int id;
+			/*!
+			 * The physical core of the CPU. SMT siblings have
+			 * the same core number.
+			 */
+			int core;
+			/*! The NUMA node of the CPU. */
+			int node;
+		};
+
+		/*! Creates an allocator without any CPUs. */
+		CpuAllocator();
+		/*! Creates an allocator for \a cpus. */
+		explicit CpuAllocator(const QList<Cpu>& cpus);
+
+		/*!
+		 * Returns the CPUs this process may run on.
+		 *
+		 * On Linux the topology is read from sysfs. Elsewhere every
+		 * CPU is reported as a core of its own in node 0.
+		 */
+		static QList<Cpu> systemCpus();
+
+		/*! Returns the total number of CPUs. */
+		int cpuCount() const;
+		/*! Returns the number of CPUs that aren't allocated. */
+		int freeCpuCount() const;
+
+		/*! Returns true if whole physical cores are allocated. */
+		bool respectsSmt() const;
+		/*! Sets SMT sibling awareness to \a enabled. */
+		void setRespectSmt(bool enabled);
+		/*! Returns true if sets are kept inside NUMA nodes. */
+		bool respectsNuma() const;
+		/*! Sets NUMA node awareness to \a enabled. */
+		void setRespectNuma(bool enabled);
+
+		/*!
+		 * Allocates \a count CPUs (or physical cores if SMT
+		 * siblings are respected) and returns their ids in
+		 * ascending order.
+		 *
+		 * Returns an empty list if there aren't enough free CPUs.
+		 */
+		QList<int> allocate(int count);
+		/*! Returns \a cpus to the allocator. */
+		void release(const QList<int>& cpus);
+
+		/*! Returns \a cpus in the "0-3,8" format of Linux CPU lists. */
+		static QString toString(const QList<int>& cpus);
+		/*! Parses a Linux CPU list such as "0-3,8". */
+		static QList<int> parseList(const QString& str);
+
+		/*!
+		 * Pins every thread of process \a pid to \a cpus.
+		 *
+		 * Threads the process creates later inherit the affinity.
+		 * Returns false if the affinity couldn't be set; this is
+		 * always the case on platforms other than Linux.
+		 */
+		static bool setProcessAffinity(qint64 pid, const QList<int>& cpus);
+		/*!
+		 * Moves every thread of process \a pid to the idle
+		 * scheduling class if \a idle is true, or back to the
+		 * normal class if it's false.
+		 *
+		 * Idle threads only run on CPUs that nothing else needs.
+		 * Only threads that are in the idle class are moved back.
+		 * Threads the process creates later inherit the class of
+		 * the thread that creates them.
+		 *
+		 * An unprivileged process can only leave the idle class
+		 * if RLIMIT_NICE allows its nice value, so the process is
+		 * only made idle when it could be moved back. Returns
+		 * false if no thread was moved; this is always the case
+		 * on platforms other than Linux.
+		 */
+		static bool setProcessIdle(qint64 pid, bool idle);
+
+	private:
+		struct Unit
+		{
+			QList<int> cpus;
+			int node;
+			bool used;
+		};
+
+		void buildUnits();
+		QList<int> take(const QVector<int>& units, int count);
+
+		QList<Cpu> m_cpus;
+		QVector<Unit> m_units;
+		bool m_respectSmt;
+		bool m_respectNuma;
+};
+
+#endif // CPUALLOCATOR_H
@@ -24,6 +24,12 @@
 
 namespace {
 
+/*
+ * The maximum number of plies in the built-in catalog, which doesn't
+ * store it. It's deeper than any line of the catalog's source.
+ */
+const int DefaultMaxPlies = 60;
+
 int ecoFromString(const QString& ecoString)
 {
 	if (ecoString.length() < 2)
@@ -59,16 +65,18 @@ QDataStream& operator>>(QDataStream& in, EcoNode& node)
 }
 
 QStringList EcoNode::s_openings;
-QMap<quint64, EcoNode> EcoNode::s_catalog;
+QVector<EcoNode> EcoNode::s_nodes;
+QVector<EcoNode::Slot> EcoNode::s_slots;
+int EcoNode::s_maxPlies = 0;
 
 void EcoNode::initialize()
 {
 	static QMutex mutex;
-	if (!s_catalog.isEmpty())
+	if (!s_slots.isEmpty())
 		return;
 
 	mutex.lock();
-	if (s_catalog.isEmpty())
+	if (s_slots.isEmpty())
 	{
 		Q_INIT_RESOURCE(eco);
 
@@ -79,7 +87,13 @@ void EcoNode::initialize()
 		{
 			QDataStream in(&file);
 			in.setVersion(QDataStream::Qt_4_6);
-			in >> s_openings >> s_catalog;
+
+			QMap<quint64, EcoNode> catalog;
+			qint32 maxPlies = DefaultMaxPlies;
+			in >> s_openings >> catalog;
+			if (!in.atEnd())
+				in >> maxPlies;
+			setCatalog(catalog, maxPlies);
 		}
 	}
 	mutex.unlock();
@@ -87,7 +101,7 @@ void EcoNode::initialize()
 
 void EcoNode::initialize(PgnStream& in)
 {
-	if (!s_catalog.isEmpty())
+	if (!s_slots.isEmpty())
 		return;
 
 	if (!in.isOpen())
@@ -97,6 +111,8 @@ void EcoNode::initialize(PgnStream& in)
 	}
 
 	QMap<QString, int> tmpOpenings;
+	QMap<quint64, EcoNode> catalog;
+	int maxPlies = 0;
 
 	PgnGame game;
 	while (game.read(in, INT_MAX - 1, false))
@@ -113,25 +129,89 @@ void EcoNode::initialize(PgnStream& in)
 					tmpOpenings[openingStr] = opening;
 					s_openings.append(openingStr);
 				}
-				s_catalog[game.key()] = EcoNode(opening,
-												game.tagValue("Variation"),
-												game.tagValue("ECO"));
+				catalog[game.key()] = EcoNode(opening,
+											  game.tagValue("Variation"),
+											  game.tagValue("ECO"));
+				maxPlies = qMax(maxPlies, game.moves().size());
 			}
 		}
 	}
+
+	setCatalog(catalog, maxPlies);
+}
+
+void EcoNode::setCatalog(const QMap<quint64, EcoNode>& catalog, int maxPlies)
+{
+	// Keep the table at most half full so that the probe sequences
+	// stay short
+	int size = 16;
+	while (size < catalog.size() * 2)
+		size *= 2;
+
+	QVector<Slot> table(size, Slot{0, -1});
+	QVector<EcoNode> nodes;
+	nodes.reserve(catalog.size());
+
+	const int mask = size - 1;
+	QMap<quint64, EcoNode>::const_iterator it;
+	for (it = catalog.constBegin(); it != catalog.constEnd(); ++it)
+	{
+		// Zobrist keys are random, so their bits are used as is
+		int i = int(it.key() ^ (it.key() >> 32)) & mask;
+		while (table.at(i).node >= 0)
+			i = (i + 1) & mask;
+
+		table[i].key = it.key();
+		table[i].node = nodes.size();
+		nodes.append(it.value());
+	}
+
+	s_nodes = nodes;
+	s_maxPlies = maxPlies;
+	s_slots = table;
+}
+
+QMap<quint64, EcoNode> EcoNode::catalog()
+{
+	QMap<quint64, EcoNode> catalog;
+	for (const Slot& slot : qAsConst(s_slots))
+	{
+		if (slot.node >= 0)
+			catalog[slot.key] = s_nodes.at(slot.node);
+	}
+
+	return catalog;
 }
 
 const EcoNode* EcoNode::find(quint64 key)
 {
-	if (s_catalog.isEmpty())
+	if (s_slots.isEmpty())
+		initialize();
+	if (s_slots.isEmpty())
+		return nullptr;
+
+	const int mask = s_slots.size() - 1;
+	for (int i = int(key ^ (key >> 32)) & mask; ; i = (i + 1) & mask)
+	{
+		const Slot& slot = s_slots.at(i);
+		if (slot.node < 0)
+			return nullptr;
+		if (slot.key == key)
+			return &s_nodes.at(slot.node);
+	}
+}
+
+int EcoNode::maxPlies()
+{
+	if (s_slots.isEmpty())
 		initialize();
 
-	return s_catalog.contains(key) ? &s_catalog[key] : nullptr;
+	return s_maxPlies;
 }
 
 void EcoNode::write(const QString& fileName)
 {
-	if (s_catalog.isEmpty())
+	if (s_slots.isEmpty())
 		return;
 
 	QFile file(fileName);
@@ -143,7 +223,7 @@ void EcoNode::write(const QString& fileName)
 
 	QDataStream out(&file);
 	out.setVersion(QDataStream::Qt_4_6);
-	out << s_openings << s_catalog;
+	out << s_openings << catalog() << qint32(s_maxPlies);
 }
 
 EcoNode::EcoNode()
@@ -21,6 +21,7 @@
 
 #include <QStringList>
 #include <QMap>
+#include <QVector>
 #include "pgngame.h"
 class QDataStream;
 class PgnStream;
@@ -35,7 +36,8 @@ class PgnStream;
  * The ECO catalog can be generated from a PGN collection or from a binary file
  * that's part of the cutechess library (the default). A node corresponding
  * to a PgnGame can be found by the game's moves Zobrist keys to the find()
- * function.
+ * function. The nodes are kept in an open-addressing hash table indexed by
+ * the Zobrist keys.
  *
  * \note The Encyclopaedia of Chess Openings only applies to games of standard
  * chess that start from the default starting position.
@@ -64,6 +66,12 @@ class LIB_EXPORT EcoNode
 		 * initialize() is called first if the tree is uninitialized.
 		 */
 		static const EcoNode* find(quint64 key);
+		/*!
+		 * Returns the number of plies in the longest opening line of
+		 * the catalog. Positions after more plies are never found.
+		 * initialize() is called first if the tree is uninitialized.
+		 */
+		static int maxPlies();
 		/*! Writes the ECO catalog in binary format to \a fileName. */
 		static void write(const QString& fileName);
 
@@ -71,10 +79,22 @@ class LIB_EXPORT EcoNode
 		friend LIB_EXPORT QDataStream& operator<<(QDataStream& out, const EcoNode& node);
 		friend LIB_EXPORT QDataStream& operator>>(QDataStream& in, EcoNode& node);
 
+		struct Slot
+		{
+			quint64 key;
+			qint32 node;
+		};
+
 		EcoNode(int opening, const QString& variation, const QString& eco);
 
+		static void setCatalog(const QMap<quint64, EcoNode>& catalog,
+				       int maxPlies);
+		static QMap<quint64, EcoNode> catalog();
+
 		static QStringList s_openings;
-		static QMap<quint64, EcoNode> s_catalog;
+		static QVector<EcoNode> s_nodes;
+		static QVector<Slot> s_slots;
+		static int s_maxPlies;
 
 		qint16 m_ecoCode;
 		qint32 m_opening;
@@ -45,6 +45,22 @@ bool EngineBuilder::isHuman() const
 	return false;
 }
 
+bool EngineBuilder::isReusable() const
+{
+	// Engines that restart between games have nothing to reuse
+	return m_config.restartMode() != EngineConfiguration::RestartOn;
+}
+
+int EngineBuilder::cpuCount() const
+{
+	return m_config.threadCount();
+}
+
+bool EngineBuilder::isPondering() const
+{
+	return m_config.pondering();
+}
+
 ChessPlayer* EngineBuilder::create(QObject* receiver,
 				   const char* method,
 				   QObject* parent,
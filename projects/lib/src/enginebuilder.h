@@ -38,6 +38,9 @@ class LIB_EXPORT EngineBuilder : public PlayerBuilder
 
 		// Inherited from PlayerBuilder
 		virtual bool isHuman() const;
+		virtual bool isReusable() const;
+		virtual int cpuCount() const;
+		virtual bool isPondering() const;
 		virtual ChessPlayer* create(QObject* receiver,
 					    const char* method,
 					    QObject* parent,
@@ -28,6 +28,9 @@ EngineConfiguration::EngineConfiguration()
 	  m_pondering(false),
 	  m_validateClaims(true),
 	  m_restartMode(RestartAuto),
+	  m_positionDeltaPlies(0),
+	  m_thinkingInterval(DefaultThinkingInterval),
+	  m_threadCount(1),
 	  m_rating(0),
 	  m_strikes(0),
       m_restart_score(0),
@@ -46,6 +49,9 @@ EngineConfiguration::EngineConfiguration(const QString& name,
 	  m_pondering(false),
 	  m_validateClaims(true),
 	  m_restartMode(RestartAuto),
+	  m_positionDeltaPlies(0),
+	  m_thinkingInterval(DefaultThinkingInterval),
+	  m_threadCount(1),
 	  m_rating(0),
 	  m_strikes(0),
       m_restart_score(0),
@@ -59,6 +65,9 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 	  m_pondering(false),
 	  m_validateClaims(true),
 	  m_restartMode(RestartAuto),
+	  m_positionDeltaPlies(0),
+	  m_thinkingInterval(DefaultThinkingInterval),
+	  m_threadCount(1),
 	  m_rating(0),
 	  m_strikes(0),
       m_restart_score(0),
@@ -90,6 +99,15 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 			setRestartMode(RestartOff);
 	}
 
+	if (map.contains("deltaPosition"))
+		setPositionDeltaPlies(map["deltaPosition"].toInt());
+
+	if (map.contains("thinkingInterval"))
+		setThinkingInterval(map["thinkingInterval"].toInt());
+
+	if (map.contains("threads"))
+		setThreadCount(map["threads"].toInt());
+
 	if (map.contains("validateClaims"))
 		setClaimsValidated(map["validateClaims"].toBool());
 
@@ -128,6 +146,9 @@ EngineConfiguration::EngineConfiguration(const EngineConfiguration& other)
 	  m_pondering(other.m_pondering),
 	  m_validateClaims(other.m_validateClaims),
 	  m_restartMode(other.m_restartMode),
+	  m_positionDeltaPlies(other.m_positionDeltaPlies),
+	  m_thinkingInterval(other.m_thinkingInterval),
+	  m_threadCount(other.m_threadCount),
 	  m_rating(other.m_rating),
 	  m_strikes(other.m_strikes),
       m_restart_score(other.m_restart_score),
@@ -157,6 +178,9 @@ EngineConfiguration& EngineConfiguration::operator=(EngineConfiguration&& other)
 	m_pondering = other.m_pondering;
 	m_validateClaims = other.m_validateClaims;
 	m_restartMode = other.m_restartMode;
+	m_positionDeltaPlies = other.m_positionDeltaPlies;
+	m_thinkingInterval = other.m_thinkingInterval;
+	m_threadCount = other.m_threadCount;
 	m_options = other.m_options;
 	m_rating = other.m_rating;
 	m_strikes = other.m_strikes;
@@ -194,6 +218,15 @@ QVariant EngineConfiguration::toVariant() const
 	else if (m_restartMode == RestartOff)
 		map.insert("restart", "off");
 
+	if (m_positionDeltaPlies > 0)
+		map.insert("deltaPosition", m_positionDeltaPlies);
+
+	if (m_thinkingInterval != DefaultThinkingInterval)
+		map.insert("thinkingInterval", m_thinkingInterval);
+
+	if (m_threadCount != 1)
+		map.insert("threads", m_threadCount);
+
 	if (!m_validateClaims)
 		map.insert("validateClaims", false);
 
@@ -416,6 +449,36 @@ void EngineConfiguration::setRestartMode(RestartMode mode)
 	m_restartMode = mode;
 }
 
+int EngineConfiguration::positionDeltaPlies() const
+{
+	return m_positionDeltaPlies;
+}
+
+void EngineConfiguration::setPositionDeltaPlies(int plies)
+{
+	m_positionDeltaPlies = plies > 0 ? plies : 0;
+}
+
+int EngineConfiguration::thinkingInterval() const
+{
+	return m_thinkingInterval;
+}
+
+void EngineConfiguration::setThinkingInterval(int msecs)
+{
+	m_thinkingInterval = msecs > 0 ? msecs : 0;
+}
+
+int EngineConfiguration::threadCount() const
+{
+	return m_threadCount;
+}
+
+void EngineConfiguration::setThreadCount(int count)
+{
+	m_threadCount = qMax(count, 1);
+}
+
 bool EngineConfiguration::areClaimsValidated() const
 {
 	return m_validateClaims;
@@ -452,6 +515,9 @@ EngineConfiguration& EngineConfiguration::operator=(const EngineConfiguration& o
 		m_pondering = other.m_pondering;
 		m_validateClaims = other.m_validateClaims;
 		m_restartMode = other.m_restartMode;
+		m_positionDeltaPlies = other.m_positionDeltaPlies;
+		m_thinkingInterval = other.m_thinkingInterval;
+		m_threadCount = other.m_threadCount;
 		m_rating = other.m_rating;
 		m_strikes = other.m_strikes;
 		m_restart_score = other.m_restart_score;
@@ -488,6 +554,9 @@ bool EngineConfiguration::operator==(const EngineConfiguration& other) const
 		|| m_pondering != other.m_pondering
 		|| m_validateClaims != other.m_validateClaims
 		|| m_restartMode != other.m_restartMode
+		|| m_positionDeltaPlies != other.m_positionDeltaPlies
+		|| m_thinkingInterval != other.m_thinkingInterval
+		|| m_threadCount != other.m_threadCount
 		|| m_rating != other.m_rating
 		|| m_strikes != other.m_strikes
 		|| m_name != other.m_name
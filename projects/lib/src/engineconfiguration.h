@@ -44,6 +44,9 @@ class LIB_EXPORT EngineConfiguration
 			RestartOff	//!< The engine is never restarted between games
 		};
 
+		/*! The default thinking update interval in milliseconds. */
+		static const int DefaultThinkingInterval = 50;
+
 		/*! Creates an empty chess engine configuration. */
 		EngineConfiguration();
 		/*!
@@ -220,6 +223,43 @@ class LIB_EXPORT EngineConfiguration
 		/*! Sets the restart mode to \a mode. */
 		void setRestartMode(RestartMode mode);
 
+		/*!
+		 * Returns the game length, in plies, after which positions
+		 * are sent to the engine relative to the last irreversible
+		 * move instead of the start of the game.
+		 *
+		 * Only UCI engines use this setting. The default value is 0,
+		 * which means the whole game is always sent.
+		 */
+		int positionDeltaPlies() const;
+		/*! Sets the position delta threshold to \a plies. */
+		void setPositionDeltaPlies(int plies);
+
+		/*!
+		 * Returns the minimum time in milliseconds between two
+		 * thinking updates from the engine.
+		 *
+		 * Updates that arrive sooner are merged, keeping only the
+		 * newest one of each principal variation. Only UCI engines
+		 * use this setting. The default value is
+		 * DefaultThinkingInterval; 0 sends every update right away.
+		 */
+		int thinkingInterval() const;
+		/*! Sets the thinking update interval to \a msecs. */
+		void setThinkingInterval(int msecs);
+
+		/*!
+		 * Returns the number of CPUs the engine uses.
+		 *
+		 * When the game manager pins engines to CPUs, this many
+		 * CPUs are reserved for the engine. The default value is 1.
+		 *
+		 * \sa GameManager::setCpuAffinity()
+		 */
+		int threadCount() const;
+		/*! Sets the number of CPUs the engine uses to \a count. */
+		void setThreadCount(int count);
+
 		/*!
 		 * Returns true if result claims from the engine are validated;
 		 * otherwise returns false.
@@ -258,6 +298,9 @@ class LIB_EXPORT EngineConfiguration
 		bool m_pondering;
 		bool m_validateClaims;
 		RestartMode m_restartMode;
+		int m_positionDeltaPlies;
+		int m_thinkingInterval;
+		int m_threadCount;
 		int m_rating;
 		int m_strikes;
 		int m_restart_score;
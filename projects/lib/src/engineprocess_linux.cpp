@@ -0,0 +1,557 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engineprocess_linux.h"
+#include <QFile>
+#include <QVector>
+#include <QThread>
+#include <QTimer>
+#include <QSocketNotifier>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace {
+
+void closeFd(int* fd)
+{
+	if (*fd == -1)
+		return;
+	::close(*fd);
+	*fd = -1;
+}
+
+// How often and for how long a process whose output has ended is
+// polled until it exits
+const int ReapInterval = 10;
+const int ReapTimeout = 5000;
+
+bool redirect(int fd, int target)
+{
+	// dup2() keeps the close-on-exec flag if the descriptors are equal
+	if (fd == target)
+		return fcntl(fd, F_SETFD, 0) != -1;
+	return dup2(fd, target) != -1;
+}
+
+} // anonymous namespace
+
+EngineProcess::EngineProcess(QObject* parent)
+	: QIODevice(parent),
+	  m_pid(-1),
+	  m_started(false),
+	  m_readFinished(false),
+	  m_exitCode(0),
+	  m_exitStatus(EngineProcess::NormalExit),
+	  m_stdErrFileMode(Truncate),
+	  m_inWrite(-1),
+	  m_outRead(-1),
+	  m_channel(nullptr),
+	  m_writeNotifier(nullptr),
+	  m_bufferPos(0),
+	  m_readTotal(0),
+	  m_reapTimer(new QTimer(this))
+{
+	m_reapTimer->setInterval(ReapInterval);
+	connect(m_reapTimer, SIGNAL(timeout()), this, SLOT(onReapTimeout()));
+}
+
+EngineProcess::~EngineProcess()
+{
+	if (m_pid != -1)
+	{
+		qWarning("EngineProcess: Destroyed while process is still running.");
+		kill();
+		waitForFinished(-1);
+	}
+	cleanup();
+}
+
+int EngineProcess::exitCode() const
+{
+	return m_exitCode;
+}
+
+EngineProcess::ExitStatus EngineProcess::exitStatus() const
+{
+	return m_exitStatus;
+}
+
+qint64 EngineProcess::processId() const
+{
+	return m_pid == -1 ? 0 : qint64(m_pid);
+}
+
+qint64 EngineProcess::readTimestampNs(qint64 pos) const
+{
+	// The line ends are in ascending order
+	auto it = std::upper_bound(m_lineTimes.constBegin(), m_lineTimes.constEnd(),
+				   pos, [](qint64 pos, const LineTime& line)
+	{
+		return pos < line.end;
+	});
+	if (it == m_lineTimes.constEnd())
+		return -1;
+	return it->ns;
+}
+
+qint64 EngineProcess::bytesAvailable() const
+{
+	return qint64(m_buffer.size() - m_bufferPos) + QIODevice::bytesAvailable();
+}
+
+qint64 EngineProcess::bytesToWrite() const
+{
+	return qint64(m_writeBuffer.size()) + QIODevice::bytesToWrite();
+}
+
+bool EngineProcess::canReadLine() const
+{
+	return memchr(m_buffer.constData() + m_bufferPos, '\n',
+		      size_t(m_buffer.size() - m_bufferPos)) != nullptr
+	||     QIODevice::canReadLine();
+}
+
+void EngineProcess::cleanup()
+{
+	m_reapTimer->stop();
+	if (m_channel != nullptr)
+	{
+		PipeReactor::instance()->remove(m_channel);
+		delete m_channel;
+		m_channel = nullptr;
+	}
+
+	delete m_writeNotifier;
+	m_writeNotifier = nullptr;
+	m_writeBuffer.clear();
+	closeFd(&m_inWrite);
+	closeFd(&m_outRead);
+
+	m_started = false;
+}
+
+void EngineProcess::close()
+{
+	if (!isOpen())
+		return;
+
+	emit aboutToClose();
+	kill();
+	waitForFinished(-1);
+	cleanup();
+	m_buffer.clear();
+	m_bufferPos = 0;
+	m_lineTimes.clear();
+	QIODevice::close();
+}
+
+bool EngineProcess::isSequential() const
+{
+	return true;
+}
+
+QString EngineProcess::workingDirectory() const
+{
+	return m_workDir;
+}
+
+void EngineProcess::setWorkingDirectory(const QString& dir)
+{
+	m_workDir = dir;
+}
+
+void EngineProcess::setStandardErrorFile(const QString& fileName, OpenMode mode)
+{
+	m_stdErrFile = fileName;
+	m_stdErrFileMode = mode;
+}
+
+QStringList EngineProcess::splitCommand(const QString& command)
+{
+	QStringList args;
+	QString arg;
+	bool inArg = false;
+	bool quoted = false;
+
+	for (const QChar& c : command)
+	{
+		if (c == '\"')
+		{
+			quoted = !quoted;
+			inArg = true;
+		}
+		else if (c.isSpace() && !quoted)
+		{
+			if (inArg)
+				args << arg;
+			arg.clear();
+			inArg = false;
+		}
+		else
+		{
+			arg += c;
+			inArg = true;
+		}
+	}
+	if (inArg)
+		args << arg;
+
+	return args;
+}
+
+int EngineProcess::openStandardError(const QString& fileName, OpenMode mode)
+{
+	if (fileName.isEmpty())
+		return ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+	int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+	flags |= (mode & Append) ? O_APPEND : O_TRUNC;
+	return ::open(QFile::encodeName(fileName).constData(), flags, 0666);
+}
+
+void EngineProcess::start(const QString& program,
+			  const QStringList& arguments,
+			  OpenMode mode)
+{
+	if (isOpen())
+		close();
+
+	m_started = false;
+	m_readFinished = false;
+	m_exitCode = 0;
+	m_exitStatus = NormalExit;
+	m_readTotal = 0;
+	m_lineTimes.clear();
+
+	// Writing to a process that exited must fail instead of
+	// terminating Cute Chess
+	::signal(SIGPIPE, SIG_IGN);
+
+	// Everything the child needs is prepared before fork(), because
+	// only async-signal-safe functions may be called after it
+	QVector<QByteArray> argData;
+	argData << QFile::encodeName(program);
+	for (const QString& arg : arguments)
+		argData << QFile::encodeName(arg);
+	QVector<char*> argv;
+	for (QByteArray& arg : argData)
+		argv << arg.data();
+	argv << nullptr;
+	char* const* args = argv.constData();
+
+	const QByteArray workDir(QFile::encodeName(m_workDir));
+	sigset_t signalMask;
+	sigemptyset(&signalMask);
+
+	int errFd = openStandardError(m_stdErrFile, m_stdErrFileMode);
+	int inPipe[2] = { -1, -1 };
+	int outPipe[2] = { -1, -1 };
+	int execPipe[2] = { -1, -1 };
+	pid_t pid = -1;
+
+	if (errFd != -1
+	&&  pipe2(inPipe, O_CLOEXEC) == 0
+	&&  pipe2(outPipe, O_CLOEXEC) == 0
+	&&  pipe2(execPipe, O_CLOEXEC) == 0)
+		pid = fork();
+
+	if (pid == 0)
+	{
+		// The child process
+		::signal(SIGPIPE, SIG_DFL);
+		pthread_sigmask(SIG_SETMASK, &signalMask, nullptr);
+
+		if (redirect(inPipe[0], STDIN_FILENO)
+		&&  redirect(outPipe[1], STDOUT_FILENO)
+		&&  redirect(errFd, STDERR_FILENO)
+		&&  (workDir.isEmpty() || chdir(workDir.constData()) == 0))
+			execvp(args[0], args);
+
+		const int error = errno;
+		const ssize_t ret = ::write(execPipe[1], &error, sizeof(error));
+		Q_UNUSED(ret);
+		_exit(127);
+	}
+
+	const int error = errno;
+	closeFd(&errFd);
+	closeFd(&inPipe[0]);
+	closeFd(&outPipe[1]);
+	closeFd(&execPipe[1]);
+	m_inWrite = inPipe[1];
+	m_outRead = outPipe[0];
+
+	if (pid == -1)
+	{
+		setErrorString(QString::fromLocal8Bit(strerror(error)));
+		closeFd(&execPipe[0]);
+		cleanup();
+		return;
+	}
+
+	// The pipe is closed without any data if the program was executed
+	int execError = 0;
+	ssize_t n;
+	do
+		n = ::read(execPipe[0], &execError, sizeof(execError));
+	while (n == -1 && errno == EINTR);
+	closeFd(&execPipe[0]);
+
+	if (n > 0)
+	{
+		setErrorString(QString::fromLocal8Bit(strerror(execError)));
+		waitpid(pid, nullptr, 0);
+		cleanup();
+		return;
+	}
+
+	m_pid = pid;
+
+	// Only Cute Chess' end of the input pipe is non-blocking
+	const int flags = fcntl(m_inWrite, F_GETFL);
+	if (flags == -1 || fcntl(m_inWrite, F_SETFL, flags | O_NONBLOCK) == -1)
+	{
+		setErrorString(QString::fromLocal8Bit(strerror(errno)));
+		kill();
+		waitForFinished(-1);
+		cleanup();
+		return;
+	}
+	m_writeNotifier = new QSocketNotifier(m_inWrite, QSocketNotifier::Write, this);
+	m_writeNotifier->setEnabled(false);
+	connect(m_writeNotifier, SIGNAL(activated(int)), this, SLOT(onWritable()));
+
+	m_channel = new PipeReactor::Channel(m_outRead, this, "onLinesQueued");
+	if (!PipeReactor::instance()->add(m_channel))
+	{
+		setErrorString(tr("Cannot read the output of the process"));
+		kill();
+		waitForFinished(-1);
+		cleanup();
+		return;
+	}
+
+	m_started = true;
+
+	// Make QIODevice aware that the device is now open. The input
+	// is already buffered by the reactor.
+	QIODevice::open(mode | Unbuffered);
+}
+
+void EngineProcess::start(const QString& program,
+			  OpenMode mode)
+{
+	QStringList args(splitCommand(program));
+	if (args.isEmpty())
+		return;
+
+	QString prog = args.first();
+	args.removeFirst();
+	start(prog, args, mode);
+}
+
+void EngineProcess::kill()
+{
+	if (m_pid != -1)
+		::kill(m_pid, SIGKILL);
+}
+
+bool EngineProcess::reap(bool block)
+{
+	if (m_pid == -1)
+		return true;
+
+	int status = 0;
+	pid_t ret;
+	do
+		ret = waitpid(m_pid, &status, block ? 0 : WNOHANG);
+	while (ret == -1 && errno == EINTR);
+
+	if (ret == 0)
+		return false;
+
+	if (ret != -1 && WIFEXITED(status))
+	{
+		m_exitCode = WEXITSTATUS(status);
+		m_exitStatus = NormalExit;
+	}
+	else
+	{
+		m_exitCode = (ret != -1 && WIFSIGNALED(status)) ? WTERMSIG(status) : -1;
+		m_exitStatus = CrashExit;
+	}
+
+	m_pid = -1;
+	emit finished(m_exitCode, m_exitStatus);
+	return true;
+}
+
+bool EngineProcess::waitForFinished(int msecs)
+{
+	if (m_pid == -1)
+		return false;
+	if (msecs == -1)
+		return reap(true);
+
+	QElapsedTimer timer;
+	timer.start();
+	while (!reap(false))
+	{
+		if (timer.elapsed() >= msecs)
+			return false;
+		QThread::msleep(1);
+	}
+
+	return true;
+}
+
+bool EngineProcess::waitForStarted(int msecs)
+{
+	Q_UNUSED(msecs);
+	return m_started;
+}
+
+qint64 EngineProcess::readData(char* data, qint64 maxSize)
+{
+	const int available = m_buffer.size() - m_bufferPos;
+	if (available <= 0)
+		return m_readFinished ? -1 : 0;
+
+	// Forget the lines returned by the previous reads
+	int done = 0;
+	while (done < m_lineTimes.size() && m_lineTimes.at(done).end <= m_readTotal)
+		done++;
+	m_lineTimes.remove(0, done);
+
+	const int n = int(qMin(qint64(available), maxSize));
+	memcpy(data, m_buffer.constData() + m_bufferPos, size_t(n));
+	m_bufferPos += n;
+	m_readTotal += n;
+
+	if (m_bufferPos == m_buffer.size())
+	{
+		m_buffer.resize(0);
+		m_bufferPos = 0;
+	}
+
+	return n;
+}
+
+qint64 EngineProcess::writeData(const char* data, qint64 maxSize)
+{
+	if (m_inWrite == -1)
+		return -1;
+
+	// The data is written after anything that's still buffered
+	m_writeBuffer.append(data, int(maxSize));
+	if (!flush())
+		return -1;
+
+	return maxSize;
+}
+
+bool EngineProcess::flush()
+{
+	int written = 0;
+	while (written < m_writeBuffer.size())
+	{
+		const ssize_t n = ::write(m_inWrite, m_writeBuffer.constData() + written,
+					  size_t(m_writeBuffer.size() - written));
+		if (n == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+
+			setErrorString(QString::fromLocal8Bit(strerror(errno)));
+			m_writeBuffer.clear();
+			m_writeNotifier->setEnabled(false);
+			return false;
+		}
+		written += int(n);
+	}
+
+	m_writeBuffer.remove(0, written);
+	// The rest is written when the process has read enough
+	// of its input
+	m_writeNotifier->setEnabled(!m_writeBuffer.isEmpty());
+
+	return true;
+}
+
+void EngineProcess::onWritable()
+{
+	if (m_inWrite != -1)
+		flush();
+}
+
+void EngineProcess::onLinesQueued()
+{
+	if (m_channel == nullptr)
+		return;
+
+	// A finished channel has queued all of its lines, so they're
+	// all taken below
+	m_channel->acknowledge();
+	const bool finished = m_channel->isFinished();
+
+	bool received = false;
+	QByteArray line;
+	qint64 timestampNs;
+	while (m_channel->takeLine(&line, &timestampNs))
+	{
+		m_buffer.append(line);
+		const qint64 end = m_readTotal + m_buffer.size() - m_bufferPos;
+		m_lineTimes.append({ end, timestampNs });
+		received = true;
+	}
+	PipeReactor::instance()->resume(m_channel);
+
+	if (received)
+		emit readyRead();
+
+	// The receivers of readyRead() may have closed the device
+	if (m_channel == nullptr || !finished || m_readFinished)
+		return;
+
+	m_readFinished = true;
+
+	// The process usually closes its output when it exits, but it
+	// may not have exited yet. It's polled for a while so that
+	// finished() is emitted without blocking the thread.
+	if (!reap(false))
+	{
+		m_reapTime.start();
+		m_reapTimer->start();
+	}
+	emit readChannelFinished();
+}
+
+void EngineProcess::onReapTimeout()
+{
+	// A process that keeps running without output is killed when
+	// the device is closed or destroyed
+	if (reap(false) || m_reapTime.elapsed() >= ReapTimeout)
+		m_reapTimer->stop();
+}
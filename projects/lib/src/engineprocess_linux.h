@@ -0,0 +1,219 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEPROCESS_LINUX_H
+#define ENGINEPROCESS_LINUX_H
+
+#include <QIODevice>
+#include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
+#include <sys/types.h>
+#include "pipereactor_linux.h"
+
+class QTimer;
+class QSocketNotifier;
+
+/*!
+ * \brief A replacement for QProcess on Linux
+ *
+ * EngineProcess runs a chess engine with its standard input and
+ * output connected to pipes, like QProcess does. The output isn't
+ * read by the thread that owns the process but by the PipeReactor
+ * shared by all processes, which splits it into lines and notes
+ * the time each line arrived.
+ *
+ * The input is written to a non-blocking pipe. What the pipe can't
+ * take, eg. when the process stops reading, is buffered and written
+ * later from the event loop, so a write never blocks the caller.
+ *
+ * Only the parts of the QProcess interface that Cute Chess needs
+ * are implemented. Standard error is discarded unless it's
+ * redirected with setStandardErrorFile().
+ *
+ * \note This class is for Linux only
+ * \sa PipeReactor
+ */
+class LIB_EXPORT EngineProcess : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*! The process' exit status. */
+		enum ExitStatus
+		{
+			NormalExit,	//!< The process exited normally
+			CrashExit	//!< The process crashed
+		};
+
+		/*! Creates a new EngineProcess. */
+		explicit EngineProcess(QObject* parent = nullptr);
+		/*!
+		 * Destructs the EngineProcess and frees all resources.
+		 * If the process is still running, it is killed.
+		 */
+		virtual ~EngineProcess();
+
+		// Inherited from QIODevice
+		virtual qint64 bytesAvailable() const;
+		virtual qint64 bytesToWrite() const;
+		virtual bool canReadLine() const;
+		virtual void close();
+		virtual bool isSequential() const;
+
+		/*! Returns the exit code of the last process that finished. */
+		int exitCode() const;
+		/*! Returns the exit status of the last process that finished. */
+		ExitStatus exitStatus() const;
+		/*!
+		 * Returns the process id of the running process, or 0 if
+		 * no process is running.
+		 */
+		qint64 processId() const;
+		/*!
+		 * Returns the monotonic time, in nanoseconds, when the line
+		 * containing the output byte at \a pos was read from the
+		 * pipe, or -1 if the time isn't known.
+		 *
+		 * \a pos counts the bytes returned by read() since the
+		 * process was started. The times are kept for the output
+		 * that hasn't been read yet and for the output returned by
+		 * the most recent read().
+		 *
+		 * \sa TimeControl::monotonicNs()
+		 */
+		qint64 readTimestampNs(qint64 pos) const;
+
+		/*!
+		 * Returns the process' working directory.
+		 * Returns an empty string if the working directory wasn't
+		 * set with setWorkingDirectory().
+		 */
+		QString workingDirectory() const;
+		/*!
+		 * Sets the working directory to dir.
+		 * EngineProcess will start the process in this directory.
+		 */
+		void setWorkingDirectory(const QString& dir);
+		/*!
+		 * Redirects the process' standard error to the file fileName.
+		 * The file will be appended to if mode is Append; otherwise
+		 * it will be truncated.
+		 */
+		void setStandardErrorFile(const QString& fileName,
+					  OpenMode mode = Truncate);
+
+		/*!
+		 * Starts the program \a program in a new process, passing the
+		 * command line arguments in \a arguments. The OpenMode is set
+		 * to \a mode.
+		 *
+		 * \note Unlike the same function in QProcess, this one will
+		 * block until the program has been executed or has failed
+		 * to execute.
+		 *
+		 * \note To check if the process started successfully, call
+		 * the waitForStarted() method.
+		 */
+		void start(const QString& program,
+			   const QStringList& arguments,
+			   OpenMode mode = ReadWrite);
+		/*!
+		 * Starts the program \a program with OpenMode \a mode.
+		 * The program's arguments are separated by spaces, and
+		 * double quotes group an argument that contains spaces.
+		 */
+		void start(const QString& program,
+			   OpenMode mode = ReadWrite);
+
+		/*!
+		 * Blocks until the process has finished and the finished()
+		 * signal has been emitted.
+		 *
+		 * Times out after \a msecs milliseconds. If \a msecs is -1
+		 * the function will not time out.
+		 *
+		 * \return true if the process finished.
+		 */
+		bool waitForFinished(int msecs = 30000);
+
+		/*!
+		 * Returns true if the process started successfully.
+		 * Doesn't really wait for anything since the start() method
+		 * already did the waiting.
+		 */
+		bool waitForStarted(int msecs = 30000);
+
+	public slots:
+		/*! Kills the process, causing it to exit immediately. */
+		void kill();
+
+	signals:
+		/*!
+		 * Emitted when the process finishes.
+		 * \param exitCode exit code of the process
+		 * \param exitStatus exit status of the process
+		 */
+		void finished(int exitCode, ExitStatus exitStatus);
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private slots:
+		void onLinesQueued();
+		void onReapTimeout();
+		void onWritable();
+
+	private:
+		static QStringList splitCommand(const QString& command);
+		static int openStandardError(const QString& fileName, OpenMode mode);
+
+		bool reap(bool block);
+		bool flush();
+		void cleanup();
+
+		pid_t m_pid;
+		bool m_started;
+		bool m_readFinished;
+		int m_exitCode;
+		ExitStatus m_exitStatus;
+		QString m_workDir;
+		QString m_stdErrFile;
+		OpenMode m_stdErrFileMode;
+		int m_inWrite;
+		int m_outRead;
+		PipeReactor::Channel* m_channel;
+		QSocketNotifier* m_writeNotifier;
+		QByteArray m_writeBuffer;
+		struct LineTime
+		{
+			qint64 end;
+			qint64 ns;
+		};
+
+		QByteArray m_buffer;
+		int m_bufferPos;
+		qint64 m_readTotal;
+		QVector<LineTime> m_lineTimes;
+		QTimer* m_reapTimer;
+		QElapsedTimer m_reapTime;
+};
+
+#endif // ENGINEPROCESS_LINUX_H
@@ -18,10 +18,30 @@
 
 #include "gamemanager.h"
 #include <QThread>
-#include <algorithm>
 #include "playerbuilder.h"
 #include "chessgame.h"
 #include "chessplayer.h"
+#include "chessengine.h"
+#include "engineprocess.h"
+
+namespace {
+
+qint64 engineProcessId(ChessPlayer* player)
+{
+#ifndef Q_OS_WIN32
+	auto engine = qobject_cast<ChessEngine*>(player);
+	if (engine == nullptr)
+		return 0;
+	auto process = qobject_cast<EngineProcess*>(engine->device());
+	if (process != nullptr)
+		return process->processId();
+#else
+	Q_UNUSED(player);
+#endif
+	return 0;
+}
+
+} // anonymous namespace
 
 class GameInitializer : public QObject
 {
@@ -34,33 +54,53 @@ class GameInitializer : public QObject
 
 		const PlayerBuilder* whiteBuilder() const;
 		const PlayerBuilder* blackBuilder() const;
-		void swapPlayers();
+		ChessPlayer* player(int side) const;
+		void setPlayer(int side,
+			       const PlayerBuilder* builder,
+			       ChessPlayer* player);
+		void setPendingPlayers(int count);
 		void setGame(ChessGame* game);
+		void setCpus(const QList<int>& cpus);
 
 	public slots:
 		void initializeGame();
+		void preparePlayer();
 		void finish();
+		void transferPlayer(ChessPlayer* player, GameInitializer* target);
+		void receivePlayer(ChessPlayer* player);
+		void releasePlayer(ChessPlayer* player);
 
 	signals:
 		void gameInitialized(bool success);
+		void playerPrepared(bool success);
 		void finished();
 
 	private slots:
 		void onPlayerQuit();
 
 	private:
+		ChessPlayer* createPlayer(int side, QString* error);
 		void deletePlayer(int index);
+		void applyCpuAffinity();
+		void restorePriority();
+		QList<ChessPlayer*> players() const;
 
 		int m_playerCount;
+		int m_pendingPlayers;
+		bool m_initializePending;
 		bool m_finishing;
 		const PlayerBuilder* m_builder[2];
 		ChessPlayer* m_player[2];
+		QList<ChessPlayer*> m_obsoletePlayers;
+		QList<int> m_cpus;
 		ChessGame* m_game;
 };
 
 GameInitializer::GameInitializer(const PlayerBuilder* white,
 				 const PlayerBuilder* black)
 	: m_playerCount(0),
+	  m_pendingPlayers(0),
+	  m_initializePending(false),
 	  m_finishing(false),
 	  m_game(nullptr)
 {
@@ -75,16 +115,20 @@ GameInitializer::GameInitializer(const PlayerBuilder* white,
 
 GameInitializer::~GameInitializer()
 {
-	for (int i = 0; i < 2; i++)
+	// The idle players in the pool are children too
+	const QList<ChessPlayer*> list(players());
+	for (ChessPlayer* player : list)
 	{
-		if (m_player[i] == nullptr)
-			continue;
-
-		m_player[i]->disconnect();
-		m_player[i]->kill();
+		player->disconnect();
+		player->kill();
 	}
 }
 
+QList<ChessPlayer*> GameInitializer::players() const
+{
+	return findChildren<ChessPlayer*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
 const PlayerBuilder* GameInitializer::whiteBuilder() const
 {
 	return m_builder[Chess::Side::White];
@@ -95,10 +139,31 @@ const PlayerBuilder* GameInitializer::blackBuilder() const
 	return m_builder[Chess::Side::Black];
 }
 
-void GameInitializer::swapPlayers()
+ChessPlayer* GameInitializer::player(int side) const
+{
+	return m_player[side];
+}
+
+void GameInitializer::setPlayer(int side,
+				const PlayerBuilder* builder,
+				ChessPlayer* player)
+{
+	// A player that isn't in the pool can't be used by other games
+	ChessPlayer* oldPlayer = m_player[side];
+	if (oldPlayer != nullptr
+	&&  oldPlayer != player
+	&&  !m_builder[side]->isReusable())
+		m_obsoletePlayers << oldPlayer;
+
+	m_builder[side] = builder;
+	m_player[side] = player;
+}
+
+void GameInitializer::setPendingPlayers(int count)
 {
-	std::swap(m_builder[0], m_builder[1]);
-	std::swap(m_player[0], m_player[1]);
+	// Called from the manager's thread before any of the players
+	// are transferred, so receivePlayer() can't run at the same time
+	m_pendingPlayers = count;
 }
 
 void GameInitializer::setGame(ChessGame* game)
@@ -106,6 +171,25 @@ void GameInitializer::setGame(ChessGame* game)
 	m_game = game;
 }
 
+void GameInitializer::setCpus(const QList<int>& cpus)
+{
+	m_cpus = cpus;
+}
+
+ChessPlayer* GameInitializer::createPlayer(int side, QString* error)
+{
+	// Formatting the debugging messages is expensive,
+	// so they're only redirected if someone listens
+	auto manager = qobject_cast<GameManager*>(thread()->parent());
+	QObject* receiver = nullptr;
+	if (manager != nullptr && manager->hasDebugReceivers())
+		receiver = manager;
+
+	return m_builder[side]->create(receiver,
+				       SIGNAL(debugMessage(QString)),
+				       this, error);
+}
+
 void GameInitializer::deletePlayer(int index)
 {
 	ChessPlayer* player = m_player[index];
@@ -125,6 +209,18 @@ void GameInitializer::deletePlayer(int index)
 
 void GameInitializer::initializeGame()
 {
+	// Wait for the players that are moved from other threads
+	if (m_pendingPlayers > 0)
+	{
+		m_initializePending = true;
+		return;
+	}
+	m_initializePending = false;
+
+	for (ChessPlayer* player : qAsConst(m_obsoletePlayers))
+		releasePlayer(player);
+	m_obsoletePlayers.clear();
+
 	for (int i = 0; i < 2; i++)
 	{
 		// Delete a disconnected player (crashed engine) so that
@@ -138,9 +234,7 @@ void GameInitializer::initializeGame()
 		if (m_player[i] == nullptr)
 		{
 			QString error;
-			m_player[i] = m_builder[i]->create(thread()->parent(),
-							   SIGNAL(debugMessage(QString)),
-							   this, &error);
+			m_player[i] = createPlayer(i, &error);
 			m_game->setError(error);
 
 			if (m_player[i] == nullptr)
@@ -155,31 +249,122 @@ void GameInitializer::initializeGame()
 		m_game->setPlayer(Chess::Side::Type(i), m_player[i]);
 	}
 	m_playerCount = 2;
+	restorePriority();
+	applyCpuAffinity();
 
 	emit gameInitialized(true);
 }
 
+void GameInitializer::applyCpuAffinity()
+{
+	if (m_cpus.isEmpty())
+		return;
+
+	// Reused engines are pinned again, because their previous
+	// CPUs may belong to another game by now
+	const QString cpus(CpuAllocator::toString(m_cpus));
+	for (int i = 0; i < 2; i++)
+	{
+		auto engine = qobject_cast<ChessEngine*>(m_player[i]);
+		if (engine == nullptr)
+			continue;
+
+		const qint64 pid = engineProcessId(engine);
+		if (!CpuAllocator::setProcessAffinity(pid, m_cpus))
+			qWarning("Cannot pin engine %s to CPUs %s",
+				 qUtf8Printable(engine->name()),
+				 qUtf8Printable(cpus));
+	}
+
+	qInfo("Game %s vs %s runs on CPUs %s",
+	      qUtf8Printable(m_player[Chess::Side::White]->name()),
+	      qUtf8Printable(m_player[Chess::Side::Black]->name()),
+	      qUtf8Printable(cpus));
+}
+
+void GameInitializer::restorePriority()
+{
+	// A prepared engine leaves the idle class when a game picks
+	// it up. Engines that were never idle are left alone.
+	for (int i = 0; i < 2; i++)
+		CpuAllocator::setProcessIdle(engineProcessId(m_player[i]), false);
+}
+
+void GameInitializer::preparePlayer()
+{
+	// The player starts up while it waits in the pool
+	QString error;
+	ChessPlayer* player = createPlayer(Chess::Side::White, &error);
+	m_player[Chess::Side::White] = player;
+	if (player == nullptr)
+		qWarning("Cannot prepare player %s: %s",
+			 qUtf8Printable(m_builder[Chess::Side::White]->name()),
+			 qUtf8Printable(error));
+
+	// The engine process only gets CPU time that the games in
+	// progress don't use while it initializes. Lowering the
+	// priority of this thread alone wouldn't slow the engine down.
+	CpuAllocator::setProcessIdle(engineProcessId(player), true);
+
+	emit playerPrepared(m_player[Chess::Side::White] != nullptr);
+}
+
 void GameInitializer::finish()
 {
 	if (m_finishing)
 		return;
 	m_finishing = true;
 
+	const QList<ChessPlayer*> list(players());
+	m_playerCount = list.size();
 	if (m_playerCount <= 0)
 	{
 		emit finished();
 		return;
 	}
 
-	for (int i = 0; i < 2; i++)
+	for (ChessPlayer* player : list)
 	{
-		if (m_player[i] == nullptr)
-			continue;
-
-		connect(m_player[i], SIGNAL(disconnected()),
+		connect(player, SIGNAL(disconnected()),
 			this, SLOT(onPlayerQuit()),
 			Qt::QueuedConnection);
-		m_player[i]->quit();
+		player->quit();
+	}
+}
+
+void GameInitializer::transferPlayer(ChessPlayer* player,
+				     GameInitializer* target)
+{
+	Q_ASSERT(player->thread() == thread());
+
+	// Objects with a parent can't be moved to another thread
+	player->setParent(nullptr);
+	player->moveToThread(target->thread());
+	QMetaObject::invokeMethod(target, "receivePlayer",
+				  Qt::QueuedConnection,
+				  Q_ARG(ChessPlayer*, player));
+}
+
+void GameInitializer::receivePlayer(ChessPlayer* player)
+{
+	// A claimed player that failed to start is created by
+	// initializeGame() instead
+	if (player != nullptr)
+		player->setParent(this);
+
+	if (--m_pendingPlayers <= 0 && m_initializePending)
+		initializeGame();
+}
+
+void GameInitializer::releasePlayer(ChessPlayer* player)
+{
+	if (player->state() == ChessPlayer::Disconnected)
+		player->deleteLater();
+	else
+	{
+		connect(player, SIGNAL(disconnected()),
+			player, SLOT(deleteLater()));
+		player->quit();
 	}
 }
 
@@ -201,7 +386,12 @@ class GameThread : public QThread
 		virtual ~GameThread();
 
 		bool isReady() const;
+		bool isPreparing() const;
+		QList<int> cpus() const;
+		void setCpus(const QList<int>& cpus);
 		void newGame(ChessGame* game);
+		void preparePlayer();
+		void endPreparing();
 		void finish();
 		void finishAndDelete();
 
@@ -215,6 +405,7 @@ class GameThread : public QThread
 
 	signals:
 		void gameInitialized(bool success);
+		void playerPrepared(bool success);
 		void ready();
 
 	private slots:
@@ -222,9 +413,11 @@ class GameThread : public QThread
 
 	private:
 		bool m_ready;
+		bool m_preparing;
 		GameManager::StartMode m_startMode;
 		GameManager::CleanupMode m_cleanupMode;
 		ChessGame* m_game;
+		QList<int> m_cpus;
 		GameInitializer* m_initializer;
 };
 
@@ -233,6 +426,7 @@ GameThread::GameThread(const PlayerBuilder* white,
 		       QObject* parent)
 	: QThread(parent),
 	  m_ready(true),
+	  m_preparing(false),
 	  m_startMode(GameManager::StartImmediately),
 	  m_cleanupMode(GameManager::DeletePlayers),
 	  m_game(nullptr),
@@ -240,6 +434,8 @@ GameThread::GameThread(const PlayerBuilder* white,
 {
 	connect(m_initializer, SIGNAL(gameInitialized(bool)),
 		this, SIGNAL(gameInitialized(bool)));
+	connect(m_initializer, SIGNAL(playerPrepared(bool)),
+		this, SIGNAL(playerPrepared(bool)));
 	connect(m_initializer, SIGNAL(finished()),
 		m_initializer, SLOT(deleteLater()),
 		Qt::QueuedConnection);
@@ -258,8 +454,28 @@ bool GameThread::isReady() const
 	return m_ready;
 }
 
+bool GameThread::isPreparing() const
+{
+	return m_preparing;
+}
+
+QList<int> GameThread::cpus() const
+{
+	return m_cpus;
+}
+
+void GameThread::setCpus(const QList<int>& cpus)
+{
+	m_cpus = cpus;
+}
+
 void GameThread::newGame(ChessGame* game)
 {
+	// A thread that prepared a player runs at normal priority
+	// again when it hosts a game
+	if (priority() == QThread::LowPriority)
+		setPriority(QThread::NormalPriority);
+
 	m_ready = false;
 	m_game = game;
 	connect(game, SIGNAL(destroyed()),
@@ -267,10 +483,32 @@ void GameThread::newGame(ChessGame* game)
 		Qt::QueuedConnection);
 
 	m_initializer->setGame(m_game);
+	m_initializer->setCpus(m_cpus);
 	QMetaObject::invokeMethod(m_initializer, "initializeGame",
 				  Qt::QueuedConnection);
 }
 
+void GameThread::preparePlayer()
+{
+	m_ready = false;
+	m_preparing = true;
+	m_cleanupMode = GameManager::ReusePlayers;
+
+	// The player shouldn't slow down the games in progress. This
+	// only affects the thread that talks to the engine, and does
+	// nothing on Linux. GameInitializer::preparePlayer() makes the
+	// engine process idle where that's possible.
+	setPriority(QThread::LowPriority);
+	QMetaObject::invokeMethod(m_initializer, "preparePlayer",
+				  Qt::QueuedConnection);
+}
+
+void GameThread::endPreparing()
+{
+	m_ready = true;
+	m_preparing = false;
+}
+
 void GameThread::finish()
 {
 	if (m_initializer == nullptr)
@@ -334,8 +572,12 @@ GameManager::GameManager(QObject* parent)
 	: QObject(parent),
 	  m_finishing(false),
 	  m_concurrency(1),
+	  m_cpuAffinity(false),
+	  m_playerPoolSize(-1),
 	  m_activeQueuedGameCount(0)
 {
+	qRegisterMetaType<ChessPlayer*>();
+	qRegisterMetaType<GameInitializer*>();
 }
 
 QList<ChessGame*> GameManager::activeGames() const
@@ -353,15 +595,193 @@ void GameManager::setConcurrency(int concurrency)
 	m_concurrency = concurrency;
 }
 
+int GameManager::playerPoolSize() const
+{
+	if (m_playerPoolSize < 0)
+		return m_concurrency * 2;
+	return m_playerPoolSize;
+}
+
+void GameManager::setPlayerPoolSize(int size)
+{
+	m_playerPoolSize = size;
+}
+
+bool GameManager::cpuAffinity() const
+{
+	return m_cpuAffinity;
+}
+
+void GameManager::setCpuAffinity(bool enabled,
+				 bool respectSmt,
+				 bool respectNuma)
+{
+#ifndef Q_OS_LINUX
+	if (enabled)
+	{
+		qWarning("CPU affinity is only supported on Linux");
+		enabled = false;
+	}
+#endif
+	m_cpuAffinity = enabled;
+	if (enabled && m_cpuAllocator.cpuCount() == 0)
+		m_cpuAllocator = CpuAllocator(CpuAllocator::systemCpus());
+	m_cpuAllocator.setRespectSmt(respectSmt);
+	m_cpuAllocator.setRespectNuma(respectNuma);
+}
+
+bool GameManager::hasDebugReceivers() const
+{
+	return receivers(SIGNAL(debugMessage(QString))) > 0;
+}
+
 void GameManager::cleanupIdleThreads()
 {
+	// Pooled players of busy threads are deleted right away, the
+	// others when their thread finishes
+	for (const PooledPlayer& pooled : qAsConst(m_playerPool))
+	{
+		if (pooled.thread->isReady())
+			continue;
+		QMetaObject::invokeMethod(pooled.thread->initializer(),
+					  "releasePlayer",
+					  Qt::QueuedConnection,
+					  Q_ARG(ChessPlayer*, pooled.player));
+	}
+	m_playerPool.clear();
+
 	QList<GameThread*>::iterator it = m_activeThreads.begin();
 	while (it != m_activeThreads.end())
 	{
 		GameThread* thread = *it;
 		Q_ASSERT(thread != nullptr);
 
-		if (thread->isReady())
+		// Players that are still starting up aren't needed anymore,
+		// unless a game is waiting for them
+		if (thread->isReady()
+		||  (thread->isPreparing() && !isClaimed(thread)))
+		{
+			it = m_activeThreads.erase(it);
+			thread->finishAndDelete();
+		}
+		else
+			++it;
+	}
+}
+
+int GameManager::pooledPlayerCount(const PlayerBuilder* builder,
+				   const GameThread* thread) const
+{
+	int count = 0;
+	for (const PooledPlayer& pooled : m_playerPool)
+	{
+		if (pooled.builder == builder && pooled.thread == thread)
+			count++;
+	}
+
+	return count;
+}
+
+void GameManager::poolPlayers(GameThread* thread)
+{
+	GameInitializer* initializer = thread->initializer();
+	for (int i = 0; i < 2; i++)
+	{
+		const PlayerBuilder* builder = i == Chess::Side::White
+			? initializer->whiteBuilder() : initializer->blackBuilder();
+		ChessPlayer* player = initializer->player(i);
+		if (player == nullptr || !builder->isReusable())
+			continue;
+
+		PooledPlayer pooled = { builder, player, thread, false };
+		m_playerPool << pooled;
+	}
+}
+
+void GameManager::unpoolPlayers(GameThread* thread)
+{
+	QList<PooledPlayer>::iterator it = m_playerPool.begin();
+	while (it != m_playerPool.end())
+	{
+		if (it->thread == thread)
+			it = m_playerPool.erase(it);
+		else
+			++it;
+	}
+}
+
+void GameManager::releasePreparedPlayers()
+{
+	QList<PooledPlayer>::iterator it = m_playerPool.begin();
+	while (it != m_playerPool.end())
+	{
+		if (!it->prepared)
+		{
+			++it;
+			continue;
+		}
+
+		QMetaObject::invokeMethod(it->thread->initializer(),
+					  "releasePlayer",
+					  Qt::QueuedConnection,
+					  Q_ARG(ChessPlayer*, it->player));
+		it = m_playerPool.erase(it);
+	}
+}
+
+GameThread* GameManager::unclaimedPreparingThread(const PlayerBuilder* builder) const
+{
+	for (GameThread* thread : m_activeThreads)
+	{
+		if (thread->isPreparing()
+		&&  thread->initializer() != nullptr
+		&&  thread->initializer()->whiteBuilder() == builder
+		&&  !isClaimed(thread))
+			return thread;
+	}
+
+	return nullptr;
+}
+
+bool GameManager::isClaimed(const GameThread* thread) const
+{
+	for (const ClaimedPlayer& claim : m_claimedPlayers)
+	{
+		if (claim.source == thread)
+			return true;
+	}
+
+	return false;
+}
+
+void GameManager::trimPlayerPool()
+{
+	// Delete the players that have been idle the longest
+	while (m_playerPool.size() > playerPoolSize())
+	{
+		const PooledPlayer pooled = m_playerPool.takeFirst();
+		QMetaObject::invokeMethod(pooled.thread->initializer(),
+					  "releasePlayer",
+					  Qt::QueuedConnection,
+					  Q_ARG(ChessPlayer*, pooled.player));
+	}
+
+	// Delete the idle threads that don't host pooled players
+	QList<GameThread*>::iterator it = m_activeThreads.begin();
+	while (it != m_activeThreads.end())
+	{
+		GameThread* thread = *it;
+		bool hostsPlayers = false;
+		for (const PooledPlayer& pooled : qAsConst(m_playerPool))
+		{
+			if (pooled.thread == thread)
+			{
+				hostsPlayers = true;
+				break;
+			}
+		}
+
+		if (thread->isReady() && !hostsPlayers)
 		{
 			it = m_activeThreads.erase(it);
 			thread->finishAndDelete();
@@ -374,6 +794,8 @@ void GameManager::cleanupIdleThreads()
 void GameManager::cleanup()
 {
 	m_finishing = false;
+	m_playerPool.clear();
+	m_claimedPlayers.clear();
 
 	// Remove terminated threads from the list
 	QList< QPointer<GameThread> >::iterator it = m_threads.begin();
@@ -434,6 +856,52 @@ void GameManager::newGame(ChessGame* game,
 	startQueuedGame();
 }
 
+void GameManager::prepareGame(const PlayerBuilder* white,
+			      const PlayerBuilder* black)
+{
+	Q_ASSERT(white != nullptr);
+	Q_ASSERT(black != nullptr);
+
+	if (m_finishing
+	||  playerPoolSize() == 0
+	||  m_activeQueuedGameCount < m_concurrency)
+		return;
+
+	const PlayerBuilder* builders[2] = { white, black };
+	for (int i = 0; i < 2; i++)
+	{
+		const PlayerBuilder* builder = builders[i];
+		if (!builder->isReusable() || (i == 1 && black == white))
+			continue;
+
+		// Players that are busy now will be back in the pool
+		// when their game ends
+		int count = 0;
+		for (const PooledPlayer& pooled : qAsConst(m_playerPool))
+		{
+			if (pooled.builder == builder)
+				count++;
+		}
+		for (GameThread* thread : qAsConst(m_activeThreads))
+		{
+			if (thread->isReady() || thread->initializer() == nullptr)
+				continue;
+			GameInitializer* initializer = thread->initializer();
+			if (thread->isPreparing() && !isClaimed(thread))
+				count += initializer->whiteBuilder() == builder;
+			else if (thread->cleanupMode() == ReusePlayers)
+			{
+				count += initializer->whiteBuilder() == builder;
+				count += initializer->blackBuilder() == builder;
+			}
+		}
+
+		const int needed = black == white ? 2 : 1;
+		for (; count < needed; count++)
+			createThread(builder, builder)->preparePlayer();
+	}
+}
+
 void GameManager::onThreadQuit()
 {
 	GameThread* thread = qobject_cast<GameThread*>(QObject::sender());
@@ -457,12 +925,15 @@ void GameManager::onThreadReady()
 
 	m_activeGames.removeOne(game);
 	m_threads.removeAll(nullptr);
+	releaseCpus(thread);
 
 	if (thread->cleanupMode() == DeletePlayers)
 	{
 		m_activeThreads.removeOne(thread);
 		thread->finishAndDelete();
 	}
+	else
+		poolPlayers(thread);
 
 	if (thread->startMode() == Enqueue)
 	{
@@ -470,11 +941,83 @@ void GameManager::onThreadReady()
 		startQueuedGame();
 	}
 
+	// The next game had the first pick of the pooled players
+	if (thread->cleanupMode() == ReusePlayers && !m_finishing)
+		trimPlayerPool();
+
 	emit gameDestroyed(game);
 	if (m_finishing && m_activeGames.isEmpty())
 		cleanup();
 }
 
+void GameManager::onPlayerPrepared(bool success)
+{
+	GameThread* thread = qobject_cast<GameThread*>(sender());
+	Q_ASSERT(thread != nullptr);
+
+	// The thread was finished while the player was starting
+	if (thread->initializer() == nullptr)
+		return;
+
+	thread->endPreparing();
+
+	// A game that started while the player was starting waits for
+	// it. The player is handed over even if it failed to start, so
+	// that the game doesn't wait forever.
+	for (int i = 0; i < m_claimedPlayers.size(); i++)
+	{
+		if (m_claimedPlayers.at(i).source != thread)
+			continue;
+
+		const ClaimedPlayer claim = m_claimedPlayers.takeAt(i);
+		GameInitializer* initializer = thread->initializer();
+		ChessPlayer* player = success
+			? initializer->player(Chess::Side::White) : nullptr;
+		if (claim.target != nullptr
+		&&  claim.target->initializer() != nullptr)
+		{
+			GameInitializer* target = claim.target->initializer();
+			if (player != nullptr)
+			{
+				target->setPlayer(claim.side,
+						  initializer->whiteBuilder(),
+						  player);
+				QMetaObject::invokeMethod(initializer,
+							  "transferPlayer",
+							  Qt::QueuedConnection,
+							  Q_ARG(ChessPlayer*, player),
+							  Q_ARG(GameInitializer*, target));
+			}
+			else
+				QMetaObject::invokeMethod(target,
+							  "receivePlayer",
+							  Qt::QueuedConnection,
+							  Q_ARG(ChessPlayer*, nullptr));
+		}
+
+		// The thread is finished after the transfer, which was
+		// queued first
+		m_threads.removeOne(thread);
+		m_activeThreads.removeOne(thread);
+		thread->finishAndDelete();
+		return;
+	}
+
+	if (!success || m_finishing)
+	{
+		m_threads.removeOne(thread);
+		m_activeThreads.removeOne(thread);
+		thread->finishAndDelete();
+		return;
+	}
+
+	PooledPlayer pooled = { thread->initializer()->whiteBuilder(),
+				thread->initializer()->player(Chess::Side::White),
+				thread,
+				true };
+	m_playerPool << pooled;
+}
+
 void GameManager::onGameInitialized(bool success)
 {
 	GameThread* gameThread = qobject_cast<GameThread*>(sender());
@@ -488,6 +1031,8 @@ void GameManager::onGameInitialized(bool success)
 
 		m_threads.removeOne(gameThread);
 		m_activeThreads.removeOne(gameThread);
+		unpoolPlayers(gameThread);
+		releaseCpus(gameThread);
 
 		connect(gameThread, SIGNAL(destroyed()),
 			game, SLOT(emitStartFailed()));
@@ -498,7 +1043,7 @@ void GameManager::onGameInitialized(bool success)
 
 	m_activeGames << game;
 	if (gameThread->startMode() == Enqueue)
-		cleanupIdleThreads();
+		trimPlayerPool();
 
 	game->moveToThread(gameThread);
 	connect(game, SIGNAL(started(ChessGame*)),
@@ -509,43 +1054,159 @@ void GameManager::onGameInitialized(bool success)
 	startQueuedGame();
 }
 
+GameThread* GameManager::createThread(const PlayerBuilder* white,
+				      const PlayerBuilder* black)
+{
+	GameThread* gameThread = new GameThread(white, black, this);
+	m_threads << gameThread;
+	m_activeThreads << gameThread;
+	connect(gameThread, SIGNAL(ready()),
+		this, SLOT(onThreadReady()));
+	connect(gameThread, SIGNAL(gameInitialized(bool)),
+		this, SLOT(onGameInitialized(bool)),
+		Qt::QueuedConnection);
+	connect(gameThread, SIGNAL(playerPrepared(bool)),
+		this, SLOT(onPlayerPrepared(bool)),
+		Qt::QueuedConnection);
+
+	gameThread->start();
+	return gameThread;
+}
+
 GameThread* GameManager::getThread(const PlayerBuilder* white,
 				   const PlayerBuilder* black)
 {
 	Q_ASSERT(white != nullptr);
 	Q_ASSERT(black != nullptr);
 
+	// Use the idle thread that hosts most of the pooled players
+	// the game needs, so that few players have to be moved
+	GameThread* gameThread = nullptr;
+	int maxScore = -1;
 	for (GameThread* thread : qAsConst(m_activeThreads))
 	{
 		if (!thread->isReady())
 			continue;
 
-		GameInitializer* tmp = thread->initializer();
-		if (tmp->whiteBuilder() == black
-		&&  tmp->blackBuilder() == white)
-			tmp->swapPlayers();
-		if (tmp->whiteBuilder() == white && tmp->blackBuilder() == black)
-			return thread;
+		const int whiteCount = pooledPlayerCount(white, thread);
+		int score = qMin(whiteCount, 1);
+		if (black == white)
+			score += qMin(whiteCount - score, 1);
+		else
+			score += qMin(pooledPlayerCount(black, thread), 1);
+
+		if (score > maxScore)
+		{
+			gameThread = thread;
+			maxScore = score;
+		}
 	}
+	if (gameThread == nullptr)
+		gameThread = createThread(white, black);
+
+	// Check out the players from the pool. Players that live in
+	// other threads are moved to the game's thread before the game
+	// is initialized.
+	GameInitializer* initializer = gameThread->initializer();
+	const PlayerBuilder* builders[2] = { white, black };
+	GameThread* sourceThreads[2] = { nullptr, nullptr };
+	int transferCount = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		int index = -1;
+		for (int j = 0; j < m_playerPool.size(); j++)
+		{
+			const PooledPlayer& pooled = m_playerPool.at(j);
+			if (pooled.builder != builders[i])
+				continue;
+			index = j;
+			if (pooled.thread == gameThread)
+				break;
+		}
 
-	GameThread* gameThread = new GameThread(white, black, this);
-	m_threads << gameThread;
-	m_activeThreads << gameThread;
-	connect(gameThread, SIGNAL(ready()),
-		this, SLOT(onThreadReady()));
-	connect(gameThread, SIGNAL(gameInitialized(bool)),
-		this, SLOT(onGameInitialized(bool)),
-		Qt::QueuedConnection);
+		if (index == -1)
+		{
+			// A player that is still starting up for this game
+			// is handed over when it's ready, instead of
+			// starting a second copy of the engine
+			GameThread* preparing = unclaimedPreparingThread(builders[i]);
+			if (preparing != nullptr)
+			{
+				ClaimedPlayer claim = { preparing, gameThread, i };
+				m_claimedPlayers << claim;
+				transferCount++;
+			}
+			initializer->setPlayer(i, builders[i], nullptr);
+			continue;
+		}
+
+		const PooledPlayer pooled = m_playerPool.takeAt(index);
+		initializer->setPlayer(i, builders[i], pooled.player);
+		if (pooled.thread != gameThread)
+		{
+			sourceThreads[i] = pooled.thread;
+			transferCount++;
+		}
+	}
+
+	// The transfers are only started after the initializer knows
+	// how many players to wait for, because the first player can
+	// arrive in the game's thread before the second one is set
+	initializer->setPendingPlayers(transferCount);
+	for (int i = 0; i < 2; i++)
+	{
+		if (sourceThreads[i] == nullptr)
+			continue;
+		QMetaObject::invokeMethod(sourceThreads[i]->initializer(),
+					  "transferPlayer",
+					  Qt::QueuedConnection,
+					  Q_ARG(ChessPlayer*, initializer->player(i)),
+					  Q_ARG(GameInitializer*, initializer));
+	}
+
+	// The players that were prepared for this game but weren't
+	// needed after all
+	releasePreparedPlayers();
 
-	gameThread->start();
 	return gameThread;
 }
 
+void GameManager::allocateCpus(GameThread* thread,
+				const PlayerBuilder* white,
+				const PlayerBuilder* black)
+{
+	// The engines take turns thinking unless one of them ponders
+	int count = qMax(white->cpuCount(), black->cpuCount());
+	if (white->isPondering() || black->isPondering())
+		count = white->cpuCount() + black->cpuCount();
+	if (count <= 0)
+		return;
+
+	const QList<int> cpus(m_cpuAllocator.allocate(count));
+	if (cpus.isEmpty())
+		qWarning("Not enough free CPUs for %s vs %s, the game runs "
+			 "without CPU affinity",
+			 qUtf8Printable(white->name()),
+			 qUtf8Printable(black->name()));
+	thread->setCpus(cpus);
+}
+
+void GameManager::releaseCpus(GameThread* thread)
+{
+	m_cpuAllocator.release(thread->cpus());
+	thread->setCpus(QList<int>());
+}
+
 void GameManager::startGame(const GameEntry& entry)
 {
-	GameThread* gameThread = getThread(entry.white, entry.black);
+	GameThread* gameThread = entry.cleanupMode == ReusePlayers
+		? getThread(entry.white, entry.black)
+		: createThread(entry.white, entry.black);
 	Q_ASSERT(gameThread != nullptr);
 
+	if (m_cpuAffinity)
+		allocateCpus(gameThread, entry.white, entry.black);
+
 	gameThread->setStartMode(entry.startMode);
 	gameThread->setCleanupMode(entry.cleanupMode);
 	gameThread->newGame(entry.game);
@@ -22,6 +22,7 @@
 #include <QObject>
 #include <QList>
 #include <QPointer>
+#include "cpuallocator.h"
 class ChessGame;
 class ChessPlayer;
 class PlayerBuilder;
@@ -64,7 +65,10 @@ class LIB_EXPORT GameManager : public QObject
 			/*!
 			 * The players are left alive after the game is deleted.
 			 * If a new game with the same builder objects is started,
-			 * the players are reused for that game.
+			 * the players are reused for that game, regardless of
+			 * their opponents.
+			 *
+			 * \sa setPlayerPoolSize()
 			 */
 			ReusePlayers
 		};
@@ -97,6 +101,70 @@ class LIB_EXPORT GameManager : public QObject
 		 * \sa concurrency()
 		 */
 		void setConcurrency(int concurrency);
+		/*!
+		 * Returns the maximum number of idle players that are kept
+		 * alive for future games.
+		 *
+		 * \sa setPlayerPoolSize()
+		 */
+		int playerPoolSize() const;
+		/*!
+		 * Sets the maximum number of idle players to \a size.
+		 *
+		 * Players of games started in \a ReusePlayers mode are put
+		 * in a pool when their game ends. A new game takes its
+		 * players from the pool if it finds players created by the
+		 * same builders, so that eg. engines don't have to be
+		 * started and initialized again when the pairings change.
+		 * When the pool is full the players that have been idle the
+		 * longest are deleted. Players whose builder isn't reusable
+		 * never enter the pool.
+		 *
+		 * A negative \a size (the default) sets the size to twice
+		 * the concurrency limit. If \a size is 0, players are only
+		 * reused by the game that starts right after theirs ended.
+		 *
+		 * \sa PlayerBuilder::isReusable()
+		 */
+		void setPlayerPoolSize(int size);
+		/*!
+		 * Returns true if the engines of each game are pinned to
+		 * CPUs of their own; otherwise returns false.
+		 *
+		 * \sa setCpuAffinity()
+		 */
+		bool cpuAffinity() const;
+		/*!
+		 * Sets CPU affinity to \a enabled.
+		 *
+		 * With CPU affinity every game that starts gets a set of
+		 * CPUs that no other running game uses, and the processes of
+		 * both engines are pinned to it. The set has as many CPUs as
+		 * the engine with the most threads needs, or the sum of both
+		 * if either engine ponders. If there aren't enough free CPUs
+		 * the game runs without affinity. The CPUs are returned when
+		 * the game is deleted.
+		 *
+		 * If \a respectSmt is true, whole physical cores are reserved
+		 * so that games don't share cores through SMT siblings. If
+		 * \a respectNuma is true, a set is taken from a single NUMA
+		 * node whenever possible.
+		 *
+		 * CPU affinity is only supported on Linux. It should be set
+		 * before any games are started.
+		 *
+		 * \sa PlayerBuilder::cpuCount()
+		 */
+		void setCpuAffinity(bool enabled,
+				    bool respectSmt = true,
+				    bool respectNuma = true);
+		/*!
+		 * Returns true if the debugMessage() signal is connected.
+		 *
+		 * New players only send their debugging messages to the
+		 * manager if someone listens to them.
+		 */
+		bool hasDebugReceivers() const;
 
 		/*!
 		 * Cleans up and deletes all idle game threads
@@ -104,7 +172,8 @@ class LIB_EXPORT GameManager : public QObject
 		 * This function cleans up and removes all resources used by
 		 * game threads that are waiting for new games. The resources
 		 * include the players and the thread they're living in. The
-		 * PlayerBuilder objects will not be deleted.
+		 * player pool is emptied too. The PlayerBuilder objects will
+		 * not be deleted.
 		 *
 		 * Generally this function should be called after a tournament
 		 * has ended.
@@ -123,8 +192,8 @@ class LIB_EXPORT GameManager : public QObject
 		 *
 		 * Construction of the players is delayed to the moment when the
 		 * game starts. If the same builder objects (\a white and \a black)
-		 * were used in a previous game, the players are reused instead of
-		 * constructing new players.
+		 * were used in a previous game, the players are taken from the
+		 * player pool instead of constructing new players.
 		 *
 		 * If \a mode is StartImmediately, the game starts immediately
 		 * even if the number of active games is over the \a concurrency
@@ -145,6 +214,32 @@ class LIB_EXPORT GameManager : public QObject
 			     const PlayerBuilder* black,
 			     StartMode startMode = StartImmediately,
 			     CleanupMode cleanupMode = DeletePlayers);
+		/*!
+		 * Starts the players of a game that is expected to start
+		 * soon between \a white and \a black.
+		 *
+		 * Reusable players that aren't already in the player pool
+		 * or busy in a game are created in new threads and put in
+		 * the pool when they're ready, so that the game doesn't
+		 * have to wait for them when it's started with newGame()
+		 * in \a ReusePlayers mode. If the next game doesn't need
+		 * them, the prepared players are deleted.
+		 *
+		 * On Linux the engine processes run in the idle scheduling
+		 * class until a game picks them up, so they don't take CPU
+		 * time from the games in progress. That needs root or an
+		 * RLIMIT_NICE that lets the engines leave the idle class
+		 * again (see CpuAllocator::setProcessIdle()). Otherwise,
+		 * and on other platforms, only the threads that talk to
+		 * the engines get a low priority, which doesn't slow down
+		 * the engines themselves.
+		 *
+		 * Nothing is done if a game slot is free (the game would
+		 * start right away), if the player pool is disabled, or if
+		 * the manager is finishing.
+		 */
+		void prepareGame(const PlayerBuilder* white,
+				 const PlayerBuilder* black);
 
 	public slots:
 		/*!
@@ -187,6 +282,7 @@ class LIB_EXPORT GameManager : public QObject
 		void onThreadReady();
 		void onThreadQuit();
 		void onGameInitialized(bool success);
+		void onPlayerPrepared(bool success);
 
 	private:
 		struct GameEntry
@@ -198,19 +294,53 @@ class LIB_EXPORT GameManager : public QObject
 			CleanupMode cleanupMode;
 		};
 
+		struct PooledPlayer
+		{
+			const PlayerBuilder* builder;
+			ChessPlayer* player;
+			GameThread* thread;
+			bool prepared;
+		};
+
+		struct ClaimedPlayer
+		{
+			GameThread* source;
+			QPointer<GameThread> target;
+			int side;
+		};
+
+		GameThread* createThread(const PlayerBuilder* white,
+					 const PlayerBuilder* black);
 		GameThread* getThread(const PlayerBuilder* white,
 				      const PlayerBuilder* black);
+		int pooledPlayerCount(const PlayerBuilder* builder,
+				      const GameThread* thread) const;
+		void poolPlayers(GameThread* thread);
+		void unpoolPlayers(GameThread* thread);
+		void releasePreparedPlayers();
+		GameThread* unclaimedPreparingThread(const PlayerBuilder* builder) const;
+		bool isClaimed(const GameThread* thread) const;
+		void trimPlayerPool();
+		void allocateCpus(GameThread* thread,
+				  const PlayerBuilder* white,
+				  const PlayerBuilder* black);
+		void releaseCpus(GameThread* thread);
 		void startGame(const GameEntry& entry);
 		void startQueuedGame();
 		void cleanup();
 
 		bool m_finishing;
 		int m_concurrency;
+		bool m_cpuAffinity;
+		int m_playerPoolSize;
 		int m_activeQueuedGameCount;
 		QList< QPointer<GameThread> > m_threads;
 		QList<GameThread*> m_activeThreads;
 		QList<GameEntry> m_gameEntries;
 		QList<ChessGame*> m_activeGames;
+		QList<PooledPlayer> m_playerPool;
+		QList<ClaimedPlayer> m_claimedPlayers;
+		CpuAllocator m_cpuAllocator;
 };
 
 #endif // GAMEMANAGER_H
@@ -0,0 +1,94 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "linequeue.h"
+
+namespace {
+
+quint32 ringSize(int capacity)
+{
+	quint32 size = 1;
+	while (size < quint32(qMax(capacity, 1)))
+		size <<= 1;
+	return size;
+}
+
+} // anonymous namespace
+
+LineQueue::LineQueue(int capacity)
+	: m_entries(new Entry[ringSize(capacity)]),
+	  m_mask(ringSize(capacity) - 1),
+	  m_head(0),
+	  m_tail(0)
+{
+}
+
+LineQueue::~LineQueue()
+{
+	delete[] m_entries;
+}
+
+int LineQueue::capacity() const
+{
+	return int(m_mask + 1);
+}
+
+bool LineQueue::isEmpty() const
+{
+	return m_head.load() == m_tail.loadAcquire();
+}
+
+bool LineQueue::isFull() const
+{
+	// The indices wrap around, but their difference doesn't
+	return m_tail.load() - m_head.loadAcquire() > m_mask;
+}
+
+bool LineQueue::push(const QByteArray& line, qint64 timestampNs)
+{
+	const quint32 tail = m_tail.load();
+	if (tail - m_head.loadAcquire() > m_mask)
+		return false;
+
+	Entry& entry = m_entries[tail & m_mask];
+	entry.line = line;
+	entry.timestampNs = timestampNs;
+	m_tail.storeRelease(tail + 1);
+
+	return true;
+}
+
+bool LineQueue::pop(QByteArray* line, qint64* timestampNs)
+{
+	Q_ASSERT(line != nullptr);
+	Q_ASSERT(timestampNs != nullptr);
+
+	const quint32 head = m_head.load();
+	if (head == m_tail.loadAcquire())
+		return false;
+
+	// The entry gives up its reference here, so the producer never
+	// frees the memory of a line the consumer is still using
+	Entry& entry = m_entries[head & m_mask];
+	line->swap(entry.line);
+	entry.line.clear();
+	*timestampNs = entry.timestampNs;
+	m_head.storeRelease(head + 1);
+
+	return true;
+}
@@ -0,0 +1,88 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LINEQUEUE_H
+#define LINEQUEUE_H
+
+#include <QByteArray>
+#include <QAtomicInteger>
+
+/*!
+ * \brief A lock-free queue of timestamped lines
+ *
+ * LineQueue is a fixed-size ring buffer for exactly one producer
+ * thread and one consumer thread. Neither side ever blocks or takes
+ * a lock: the producer only writes the tail index and the consumer
+ * only writes the head index, and each entry is published by
+ * storing the index with release semantics.
+ *
+ * It hands complete lines of engine output, along with the time
+ * they were read, from the pipe reactor to the engine's own thread.
+ *
+ * \sa PipeReactor
+ */
+class LIB_EXPORT LineQueue
+{
+	public:
+		/*!
+		 * Creates a new queue that holds at least \a capacity
+		 * lines. The capacity is rounded up to a power of two.
+		 */
+		explicit LineQueue(int capacity = 1024);
+		/*! Destroys the queue and the lines in it. */
+		~LineQueue();
+
+		/*! Returns the maximum number of lines in the queue. */
+		int capacity() const;
+		/*! Returns true if there are no lines to pop. */
+		bool isEmpty() const;
+		/*! Returns true if no more lines can be pushed. */
+		bool isFull() const;
+
+		/*!
+		 * Appends \a line, read at \a timestampNs, to the queue.
+		 * Returns false if the queue is full.
+		 *
+		 * \note Only the producer thread may call this function.
+		 */
+		bool push(const QByteArray& line, qint64 timestampNs);
+		/*!
+		 * Removes the oldest line from the queue and stores it in
+		 * \a line and its timestamp in \a timestampNs.
+		 * Returns false if the queue is empty.
+		 *
+		 * \note Only the consumer thread may call this function.
+		 */
+		bool pop(QByteArray* line, qint64* timestampNs);
+
+	private:
+		Q_DISABLE_COPY(LineQueue)
+
+		struct Entry
+		{
+			QByteArray line;
+			qint64 timestampNs;
+		};
+
+		Entry* const m_entries;
+		const quint32 m_mask;
+		QAtomicInteger<quint32> m_head;
+		QAtomicInteger<quint32> m_tail;
+};
+
+#endif // LINEQUEUE_H
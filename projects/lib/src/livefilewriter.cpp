@@ -0,0 +1,205 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "livefilewriter.h"
+#include <QSaveFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QGlobalStatic>
+
+Q_GLOBAL_STATIC(LiveFileWriter, s_liveFileWriter)
+
+LiveFileWriter* LiveFileWriter::instance()
+{
+	return s_liveFileWriter();
+}
+
+LiveFileWriter::LiveFileWriter(QObject* parent)
+	: QThread(parent),
+	  m_flushInterval(250),
+	  m_capacity(64),
+	  m_stopping(false),
+	  m_flushing(false),
+	  m_writing(false)
+{
+}
+
+LiveFileWriter::~LiveFileWriter()
+{
+	stop();
+}
+
+int LiveFileWriter::flushInterval() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_flushInterval;
+}
+
+void LiveFileWriter::setFlushInterval(int msecs)
+{
+	QMutexLocker locker(&m_mutex);
+	m_flushInterval = qMax(0, msecs);
+}
+
+int LiveFileWriter::capacity() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_capacity;
+}
+
+void LiveFileWriter::setCapacity(int count)
+{
+	QMutexLocker locker(&m_mutex);
+	m_capacity = qMax(1, count);
+	m_jobsTaken.wakeAll();
+}
+
+void LiveFileWriter::writePgn(const QString& fileName,
+			      const PgnGame& game,
+			      PgnGame::PgnMode mode)
+{
+	Job job;
+	job.isPgn = true;
+	job.game = game;
+	job.mode = mode;
+	enqueue(fileName, job);
+}
+
+void LiveFileWriter::writeText(const QString& fileName, const QString& text)
+{
+	Job job;
+	job.isPgn = false;
+	job.mode = PgnGame::Verbose;
+	job.text = text;
+	enqueue(fileName, job);
+}
+
+void LiveFileWriter::enqueue(const QString& fileName, const Job& job)
+{
+	QMutexLocker locker(&m_mutex);
+
+	while (m_pending.size() >= m_capacity && !m_pending.contains(fileName))
+		m_jobsTaken.wait(&m_mutex);
+
+	m_pending[fileName] = job;
+	if (!isRunning())
+	{
+		m_stopping = false;
+		start(QThread::LowPriority);
+	}
+	m_jobAdded.wakeAll();
+}
+
+void LiveFileWriter::flush()
+{
+	QMutexLocker locker(&m_mutex);
+	while (!m_pending.isEmpty() || m_writing)
+	{
+		// Skip the rest of the flush interval
+		m_flushing = true;
+		m_jobAdded.wakeAll();
+		m_idle.wait(&m_mutex);
+	}
+}
+
+void LiveFileWriter::stop()
+{
+	m_mutex.lock();
+	m_stopping = true;
+	m_jobAdded.wakeAll();
+	m_mutex.unlock();
+
+	wait();
+
+	m_mutex.lock();
+	m_stopping = false;
+	m_mutex.unlock();
+}
+
+void LiveFileWriter::run()
+{
+	QMutexLocker locker(&m_mutex);
+
+	for (;;)
+	{
+		while (m_pending.isEmpty() && !m_stopping)
+			m_jobAdded.wait(&m_mutex);
+		if (m_pending.isEmpty())
+			break;
+
+		// Give the games some time to make more moves, unless
+		// somebody is waiting for the files to be written
+		QElapsedTimer timer;
+		timer.start();
+		while (!m_stopping && !m_flushing && timer.elapsed() < m_flushInterval)
+		{
+			if (!m_jobAdded.wait(&m_mutex, m_flushInterval - timer.elapsed()))
+				break;
+			if (m_pending.size() >= m_capacity)
+				break;
+		}
+
+		QMap<QString, Job> jobs;
+		jobs.swap(m_pending);
+		m_writing = true;
+		m_jobsTaken.wakeAll();
+		locker.unlock();
+
+		QMap<QString, Job>::iterator it;
+		for (it = jobs.begin(); it != jobs.end(); ++it)
+			writeFile(it.key(), it.value());
+
+		locker.relock();
+		m_writing = false;
+		if (m_pending.isEmpty())
+			m_flushing = false;
+		m_idle.wakeAll();
+	}
+}
+
+bool LiveFileWriter::writeFile(const QString& fileName, Job& job)
+{
+	// QSaveFile writes to a temporary file and renames it over the
+	// old file, so readers always see either the old or the new file
+	QSaveFile output(fileName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open live output file: %s", qUtf8Printable(fileName));
+		return false;
+	}
+
+	QTextStream out(&output);
+	if (job.isPgn)
+	{
+		// Write the whole game, not just the moves since the
+		// previous snapshot
+		job.game.resetCursor();
+		job.game.write(out, job.mode);
+	}
+	else
+		out << job.text;
+	out.flush();
+
+	if (!output.commit())
+	{
+		qWarning("cannot write live output file: %s", qUtf8Printable(fileName));
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,116 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIVEFILEWRITER_H
+#define LIVEFILEWRITER_H
+
+#include <QThread>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include "pgngame.h"
+
+/*!
+ * \brief A background thread that writes live game files
+ *
+ * Games in progress hand over snapshots of their PGN data, or of
+ * any other text, and return immediately. The writer thread waits
+ * for the flush interval so that several moves are written at once,
+ * and only the newest snapshot of each file is kept.
+ *
+ * Every file is written to a temporary file first and then renamed,
+ * so readers never see a partially written file.
+ *
+ * All games share the same writer, which is returned by instance().
+ */
+class LIB_EXPORT LiveFileWriter : public QThread
+{
+	public:
+		/*! Returns the shared live file writer. */
+		static LiveFileWriter* instance();
+
+		/*! Creates a new, idle LiveFileWriter. */
+		explicit LiveFileWriter(QObject* parent = nullptr);
+		/*! Writes the pending files and stops the thread. */
+		virtual ~LiveFileWriter();
+
+		/*!
+		 * Returns the time in milliseconds that the writer waits
+		 * for more updates before writing the files.
+		 * The default value is 250.
+		 */
+		int flushInterval() const;
+		/*! Sets the flush interval to \a msecs milliseconds. */
+		void setFlushInterval(int msecs);
+		/*!
+		 * Returns the maximum number of files waiting to be written.
+		 *
+		 * If the limit is reached, writePgn() and writeText() block
+		 * until the writer has caught up. Updates to a file that's
+		 * already waiting never block. The default value is 64.
+		 */
+		int capacity() const;
+		/*! Sets the maximum number of pending files to \a count. */
+		void setCapacity(int count);
+
+		/*!
+		 * Schedules \a game to be written to \a fileName in \a mode.
+		 *
+		 * The file only contains \a game. A copy of \a game is
+		 * taken, so \a game may be modified right away.
+		 */
+		void writePgn(const QString& fileName,
+			      const PgnGame& game,
+			      PgnGame::PgnMode mode);
+		/*! Schedules \a text to be written to \a fileName. */
+		void writeText(const QString& fileName, const QString& text);
+
+		/*! Blocks until every pending file has been written. */
+		void flush();
+		/*! Writes the pending files and stops the thread. */
+		void stop();
+
+	protected:
+		// Inherited from QThread
+		virtual void run();
+
+	private:
+		struct Job
+		{
+			bool isPgn;
+			PgnGame game;
+			PgnGame::PgnMode mode;
+			QString text;
+		};
+
+		void enqueue(const QString& fileName, const Job& job);
+		static bool writeFile(const QString& fileName, Job& job);
+
+		int m_flushInterval;
+		int m_capacity;
+		bool m_stopping;
+		bool m_flushing;
+		bool m_writing;
+		QMap<QString, Job> m_pending;
+		mutable QMutex m_mutex;
+		QWaitCondition m_jobAdded;
+		QWaitCondition m_jobsTaken;
+		QWaitCondition m_idle;
+};
+
+#endif // LIVEFILEWRITER_H
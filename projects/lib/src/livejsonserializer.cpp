@@ -0,0 +1,262 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "livejsonserializer.h"
+#include <QStringList>
+#include <QVariantMap>
+#include <jsonserializer.h>
+#include "board/board.h"
+
+namespace {
+
+// The move records are elements of the "Moves" array, which is a
+// member of the top-level object
+const int MoveIndentLevel = 2;
+
+QString squareString(const Chess::Square& square)
+{
+	QString str(QChar('a' + square.file()));
+	str += QChar('1' + square.rank());
+	return str;
+}
+
+} // anonymous namespace
+
+LiveJsonSerializer::LiveJsonSerializer()
+	: m_board(nullptr),
+	  m_moveCount(0)
+{
+}
+
+LiveJsonSerializer::~LiveJsonSerializer()
+{
+	delete m_board;
+}
+
+void LiveJsonSerializer::clear()
+{
+	delete m_board;
+	m_board = nullptr;
+	m_variant.clear();
+	m_startingFen.clear();
+	m_moveCount = 0;
+	m_lastMove = PgnGame::MoveData();
+	m_moves.clear();
+}
+
+bool LiveJsonSerializer::resetBoard(const PgnGame& game)
+{
+	clear();
+
+	m_board = game.createBoard();
+	if (m_board == nullptr)
+		return false;
+
+	m_variant = game.variant();
+	m_startingFen = game.startingFenString();
+	return true;
+}
+
+QString LiveJsonSerializer::serialize(const PgnGame& game)
+{
+	const QVector<PgnGame::MoveData>& moves = game.moves();
+
+	// The cached records are only valid if the game still starts
+	// with the cached moves
+	if (m_board == nullptr
+	||  game.variant() != m_variant
+	||  game.startingFenString() != m_startingFen
+	||  (m_moveCount > 0
+	     && (moves.size() <= m_moveCount
+		 || moves.at(m_moveCount - 1).key != m_lastMove.key
+		 || moves.at(m_moveCount - 1).move != m_lastMove.move)))
+	{
+		if (!resetBoard(game))
+			return QString();
+	}
+
+	const QString indent(MoveIndentLevel, '\t');
+
+	// Every move but the last one is final, so cache its record
+	for (; m_moveCount < moves.size() - 1; m_moveCount++)
+	{
+		m_moves += indent;
+		m_moves += moveRecord(moves.at(m_moveCount));
+		m_moves += ",\n";
+	}
+	if (m_moveCount > 0)
+		m_lastMove = moves.at(m_moveCount - 1);
+
+	QString moveArray("[\n");
+	moveArray += m_moves;
+	if (!moves.isEmpty())
+	{
+		// The last record isn't cached, so take its move back
+		const int plyCount = m_board->plyCount();
+		moveArray += indent;
+		moveArray += moveRecord(moves.last());
+		moveArray += '\n';
+		if (m_board->plyCount() > plyCount)
+			m_board->undoMove();
+	}
+	moveArray += QString(MoveIndentLevel - 1, '\t');
+	moveArray += ']';
+
+	QMap<QString, QString> members;
+	addEngineOptions(game.initialComment(), members);
+
+	QVariantMap headers;
+	const QList< QPair<QString, QString> > tags(game.tags());
+	for (const QPair<QString, QString>& tag : tags)
+		headers[tag.first] = tag.second;
+	members["Headers"] = JsonSerializer(headers).toFragment(MoveIndentLevel - 1);
+	members["Moves"] = moveArray;
+
+	return JsonSerializer::objectFragment(members, 0) + '\n';
+}
+
+void LiveJsonSerializer::addEngineOptions(const QString& comment,
+					  QMap<QString, QString>& members)
+{
+	const QStringList engines(comment.split(',', QString::SkipEmptyParts));
+	for (const QString& str : engines)
+	{
+		const QString engine(str.trimmed());
+		const int ePos = engine.indexOf(':');
+		if (ePos <= 0)
+			continue;
+
+		QVariantList optionList;
+		const QStringList options(engine.mid(ePos + 1).split(';', QString::SkipEmptyParts));
+		for (const QString& optionStr : options)
+		{
+			const QString option(optionStr.trimmed());
+			QVariantMap optionMap;
+			const int oPos = option.indexOf('=');
+			if (oPos > 0)
+			{
+				optionMap["Name"] = option.left(oPos).trimmed();
+				optionMap["Value"] = option.mid(oPos + 1).trimmed();
+			}
+			else
+				optionMap["Name"] = option;
+			optionList << optionMap;
+		}
+
+		members[engine.left(ePos).trimmed()] =
+			JsonSerializer(optionList).toFragment(MoveIndentLevel - 1);
+	}
+}
+
+QString LiveJsonSerializer::moveRecord(const PgnGame::MoveData& move)
+{
+	QVariantMap moveMap;
+	QVariantMap adjudicationMap;
+
+	moveMap["m"] = move.moveString;
+	moveMap["from"] = squareString(move.move.sourceSquare());
+	moveMap["to"] = squareString(move.move.targetSquare());
+	moveMap["book"] = false;
+
+	const QStringList stats(move.comment.split(',', QString::SkipEmptyParts));
+	for (const QString& statStr : stats)
+	{
+		const QString stat(statStr.trimmed());
+		if (stat == "book")
+		{
+			moveMap["book"] = true;
+			continue;
+		}
+
+		const int pos = stat.indexOf('=');
+		if (pos <= 0)
+		{
+			// real comment
+			moveMap["rem"] = stat;
+			continue;
+		}
+
+		const QString name(stat.left(pos).trimmed());
+		const QString value(stat.mid(pos + 1).trimmed());
+		if (name == "pv")
+		{
+			// The PV starts from the position before the move.
+			// Its moves are played on the scratch board once,
+			// and taken back right away.
+			QVariantList pvList;
+			int pvMoveCount = 0;
+			const QStringList pvMoves(value.split(' ', QString::SkipEmptyParts));
+			for (const QString& pvMoveStr : pvMoves)
+			{
+				const Chess::Move pvMove(m_board->moveFromString(pvMoveStr));
+				if (pvMove.isNull())
+					break;
+				const Chess::GenericMove gm(m_board->genericMove(pvMove));
+
+				m_board->makeMove(pvMove);
+				pvMoveCount++;
+
+				QVariantMap pvMap;
+				pvMap["m"] = pvMoveStr;
+				pvMap["fen"] = m_board->fenString();
+				pvMap["from"] = squareString(gm.sourceSquare());
+				pvMap["to"] = squareString(gm.targetSquare());
+				pvList << pvMap;
+			}
+			for (; pvMoveCount > 0; pvMoveCount--)
+				m_board->undoMove();
+
+			QVariantMap pvMap;
+			pvMap["San"] = value;
+			pvMap["Moves"] = pvList;
+			moveMap["pv"] = pvMap;
+		}
+		else if (name == "mb")
+		{
+			QVariantMap materialMap;
+			int idx = 0;
+			for (const char* piece : {"p", "n", "b", "r", "q"})
+			{
+				materialMap[piece] = value.mid(idx, 2).toInt();
+				idx += 2;
+			}
+			moveMap["material"] = materialMap;
+		}
+		else if (name == "R50")
+			adjudicationMap["FiftyMoves"] = value.toInt();
+		else if (name == "Rd")
+			adjudicationMap["Draw"] = value.toInt();
+		else if (name == "Rr")
+			adjudicationMap["ResignOrWin"] = value.toInt();
+		else
+			moveMap[name] = value;
+	}
+	if (!adjudicationMap.isEmpty())
+		moveMap["adjudication"] = adjudicationMap;
+
+	// Leave the board in the position after the move
+	const Chess::Move boardMove(m_board->moveFromGenericMove(move.move));
+	if (!boardMove.isNull())
+		m_board->makeMove(boardMove);
+	else
+		qWarning("Illegal move in live JSON output: %s",
+			 qUtf8Printable(move.moveString));
+	moveMap["fen"] = m_board->fenString();
+
+	return JsonSerializer(moveMap).toFragment(MoveIndentLevel);
+}
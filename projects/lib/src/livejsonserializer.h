@@ -0,0 +1,79 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIVEJSONSERIALIZER_H
+#define LIVEJSONSERIALIZER_H
+
+#include <QString>
+#include <QMap>
+#include "pgngame.h"
+
+namespace Chess { class Board; }
+
+/*!
+ * \brief Serializes a game in progress to the live JSON format
+ *
+ * The document has a "Headers" object with the PGN tags, a list of
+ * options for every engine, and a "Moves" array with one record per
+ * move. A move record contains the move's squares, the FEN string
+ * after the move, the material balance, the adjudication counters
+ * and the principal variation with a FEN string for every PV move.
+ *
+ * The serializer is meant to be called after every move of the same
+ * game. All move records except the last one are cached in their
+ * serialized form, so each call only replays the new moves and their
+ * principal variations on a scratch board. The last record is always
+ * rebuilt because its comment can still change, eg. when the game
+ * ends. If the game doesn't continue the cached moves, the cache is
+ * discarded and the whole game is serialized again.
+ */
+class LIB_EXPORT LiveJsonSerializer
+{
+	public:
+		/*! Creates a new LiveJsonSerializer. */
+		LiveJsonSerializer();
+		/*! Destroys the serializer. */
+		~LiveJsonSerializer();
+
+		/*! Discards the cached move records. */
+		void clear();
+		/*!
+		 * Returns \a game as a JSON document.
+		 *
+		 * Returns an empty string if the game's starting position
+		 * can't be set up.
+		 */
+		QString serialize(const PgnGame& game);
+
+	private:
+		Q_DISABLE_COPY(LiveJsonSerializer)
+
+		bool resetBoard(const PgnGame& game);
+		QString moveRecord(const PgnGame::MoveData& move);
+		static void addEngineOptions(const QString& comment,
+					    QMap<QString, QString>& members);
+
+		Chess::Board* m_board;
+		QString m_variant;
+		QString m_startingFen;
+		int m_moveCount;
+		PgnGame::MoveData m_lastMove;
+		QString m_moves;
+};
+
+#endif // LIVEJSONSERIALIZER_H
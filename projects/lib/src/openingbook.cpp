@@ -19,13 +19,101 @@
 #include "openingbook.h"
 #include <QString>
 #include <QFile>
+#include <QFileInfo>
 #include <QDataStream>
+#include <QHash>
+#include <QMutex>
+#include <QWeakPointer>
+#include <QGlobalStatic>
 #include <QtDebug>
 #include "pgngame.h"
 #include "pgnstream.h"
 #include "mersenne.h"
 
 
+/*
+ * A read-only memory mapping of a book file.
+ *
+ * The mappings are shared by canonical file name, so every book that
+ * reads the same file uses the same pages. A file is unmapped when
+ * the last book that uses it is destroyed.
+ */
+class OpeningBookFile
+{
+	public:
+		static QSharedPointer<const OpeningBookFile> open(const QString& filename);
+
+		const uchar* data() const { return m_data; }
+		qint64 size() const { return m_size; }
+
+	private:
+		explicit OpeningBookFile(const QString& filename);
+
+		QFile m_file;
+		const uchar* m_data;
+		qint64 m_size;
+};
+
+namespace {
+
+struct OpeningBookFiles
+{
+	QMutex mutex;
+	QHash<QString, QWeakPointer<const OpeningBookFile>> files;
+};
+
+Q_GLOBAL_STATIC(OpeningBookFiles, s_bookFiles)
+
+} // anonymous namespace
+
+OpeningBookFile::OpeningBookFile(const QString& filename)
+	: m_file(filename),
+	  m_data(nullptr),
+	  m_size(0)
+{
+	if (!m_file.open(QIODevice::ReadOnly))
+		return;
+
+	m_size = m_file.size();
+	if (m_size > 0)
+		m_data = m_file.map(0, m_size);
+}
+
+QSharedPointer<const OpeningBookFile> OpeningBookFile::open(const QString& filename)
+{
+	const QString path(QFileInfo(filename).canonicalFilePath());
+	if (path.isEmpty())
+		return QSharedPointer<const OpeningBookFile>();
+
+	QMutexLocker locker(&s_bookFiles->mutex);
+	auto& files = s_bookFiles->files;
+
+	QSharedPointer<const OpeningBookFile> file(files.value(path).toStrongRef());
+	if (!file.isNull())
+		return file;
+
+	OpeningBookFile* newFile = new OpeningBookFile(path);
+	if (newFile->m_data == nullptr)
+	{
+		delete newFile;
+		return QSharedPointer<const OpeningBookFile>();
+	}
+
+	// Forget the files that aren't used anymore
+	for (auto it = files.begin(); it != files.end(); )
+	{
+		if (it.value().isNull())
+			it = files.erase(it);
+		else
+			++it;
+	}
+
+	file = QSharedPointer<const OpeningBookFile>(newFile);
+	files.insert(path, file);
+	return file;
+}
+
+
 QDataStream& operator>>(QDataStream& in, OpeningBook* book)
 {
 	while (in.status() == QDataStream::Ok)
@@ -59,6 +147,7 @@ OpeningBook::~OpeningBook()
 bool OpeningBook::read(const QString& filename)
 {
 	m_filename = filename;
+	m_file.clear();
 	QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly))
 		return false;
@@ -71,7 +160,12 @@ bool OpeningBook::read(const QString& filename)
 	}
 
 	if (m_mode == Disk)
+	{
+		// Without a mapping the file is searched with seek() and
+		// read() instead
+		m_file = OpeningBookFile::open(filename);
 		return true;
+	}
 
 	m_map.clear();
 	QDataStream in(&file);
@@ -218,10 +312,109 @@ QList<OpeningBook::Entry> OpeningBook::entriesFromDisk(quint64 key) const
 	return entries;
 }
 
+OpeningBook::Entry OpeningBook::entryFromData(const uchar* data,
+					      quint64* key) const
+{
+	const QByteArray bytes(QByteArray::fromRawData(
+		reinterpret_cast<const char*>(data), entrySize()));
+	QDataStream in(bytes);
+	return readEntry(in, key);
+}
+
+quint64 OpeningBook::keyFromData(const uchar* data) const
+{
+	quint64 key = 0;
+	entryFromData(data, &key);
+	return key;
+}
+
+QList<OpeningBook::Entry> OpeningBook::entriesFromMappedFile(quint64 key) const
+{
+	QList<Entry> entries;
+
+	const uchar* data = m_file->data();
+	const int step = entrySize();
+	const qint64 n = m_file->size() / step;
+	if (n <= 0)
+		return entries;
+
+	// The keys are Zobrist hashes, which are spread evenly over
+	// their range, so interpolation gives a close first guess
+	const quint64 lowKey = keyFromData(data);
+	const quint64 highKey = keyFromData(data + (n - 1) * step);
+	qint64 guess = 0;
+	if (key >= highKey)
+		guess = n - 1;
+	else if (key > lowKey)
+	{
+		guess = qint64(double(key - lowKey) / double(highKey - lowKey)
+			       * double(n - 1));
+		guess = qBound(qint64(0), guess, n - 1);
+	}
+
+	// Gallop from the guess until the first entry with a key
+	// not less than \a key is within [first, last]
+	qint64 first;
+	qint64 last;
+	qint64 gap = 1;
+	if (keyFromData(data + guess * step) < key)
+	{
+		first = guess + 1;
+		last = guess + gap;
+		while (last < n && keyFromData(data + last * step) < key)
+		{
+			first = last + 1;
+			gap *= 2;
+			last = guess + gap;
+		}
+		last = qMin(last, n);
+	}
+	else
+	{
+		last = guess;
+		first = guess - gap;
+		while (first >= 0 && keyFromData(data + first * step) >= key)
+		{
+			last = first;
+			gap *= 2;
+			first = guess - gap;
+		}
+		first = first < 0 ? 0 : first + 1;
+	}
+
+	// Branch-free binary search for the lower bound
+	qint64 size = last - first;
+	if (size > 0)
+	{
+		while (size > 1)
+		{
+			const qint64 half = size / 2;
+			first = keyFromData(data + (first + half) * step) < key
+				? first + half : first;
+			size -= half;
+		}
+		first += keyFromData(data + first * step) < key;
+	}
+
+	// All entries of the same key are next to each other
+	for (qint64 i = first; i < n; i++)
+	{
+		quint64 entryKey = 0;
+		const Entry entry(entryFromData(data + i * step, &entryKey));
+		if (entryKey != key)
+			break;
+		entries << entry;
+	}
+
+	return entries;
+}
+
 QList<OpeningBook::Entry> OpeningBook::entries(quint64 key) const
 {
 	if (m_mode == Ram)
 		return m_map.values(key);
+	if (!m_file.isNull())
+		return entriesFromMappedFile(key);
 	return entriesFromDisk(key);
 }
 
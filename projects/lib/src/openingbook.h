@@ -21,12 +21,14 @@
 
 #include <QtGlobal>
 #include <QMultiMap>
+#include <QSharedPointer>
 #include "board/genericmove.h"
 
 class QString;
 class QDataStream;
 class PgnGame;
 class PgnStream;
+class OpeningBookFile;
 
 
 /*!
@@ -47,7 +49,13 @@ class LIB_EXPORT OpeningBook
 		enum AccessMode
 		{
 			Ram,	//!< Load the entire book to RAM
-			Disk	//!< Read moves directly from disk
+			/*!
+			 * Read moves directly from the book file.
+			 *
+			 * The file is memory-mapped once and the mapping is
+			 * shared by all books that read the same file.
+			 */
+			Disk
 		};
 
 		/*!
@@ -149,12 +157,29 @@ class LIB_EXPORT OpeningBook
 		virtual void writeEntry(const Map::const_iterator& it,
 					QDataStream& out) const = 0;
 
+		/*!
+		 * Returns the book entry stored at \a data in the book
+		 * file's format, and sets \a key to its hash.
+		 *
+		 * \a data points to entrySize() bytes. The default
+		 * implementation uses readEntry().
+		 */
+		virtual Entry entryFromData(const uchar* data, quint64* key) const;
+		/*!
+		 * Returns the hash of the book entry stored at \a data.
+		 *
+		 * The default implementation uses entryFromData().
+		 */
+		virtual quint64 keyFromData(const uchar* data) const;
+
 	private:
 		QList<Entry> entriesFromDisk(quint64 key) const;
+		QList<Entry> entriesFromMappedFile(quint64 key) const;
 
 		AccessMode m_mode;
 		QString m_filename;
 		Map m_map;
+		QSharedPointer<const OpeningBookFile> m_file;
 };
 
 /*!
@@ -17,12 +17,27 @@
 */
 
 #include "openingsuite.h"
+#include <cstring>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QCryptographicHash>
 #include <QTextStream>
 #include "pgnstream.h"
+#include "pgngamescanner.h"
 #include "epdrecord.h"
 #include "mersenne.h"
 
+namespace {
+
+const quint32 IndexMagic = 0x4343494f; // "CCIO"
+const quint32 IndexVersion = 2;
+const qint64 ScanBlockSize = 1024 * 1024;
+
+} // anonymous namespace
+
 OpeningSuite::OpeningSuite(const QString& fen)
 	: m_format(EpdFormat),
 	  m_order(SequentialOrder),
@@ -115,20 +130,30 @@ bool OpeningSuite::initialize()
 	if (m_format == PgnFormat)
 		m_pgnStream = new PgnStream(m_file);
 
-	if (m_order == RandomOrder)
+	bool needsIndex = (m_order == RandomOrder || m_startIndex > 0);
+	if (needsIndex && !readIndex() && !buildIndex())
 	{
-		// Create a shuffled vector of file positions
-		for (;;)
-		{
-			FilePosition pos;
-			if (m_format == EpdFormat)
-				pos = getEpdPos();
-			else if (m_format == PgnFormat)
-				pos = getPgnPos();
+		delete m_pgnStream;
+		m_pgnStream = nullptr;
+		delete m_file;
+		m_file = nullptr;
+		return false;
+	}
 
-			if (pos.pos == -1)
-				break;
+	if (m_format == EpdFormat)
+		m_epdStream = new QTextStream(m_file);
 
+	if (m_order == RandomOrder)
+	{
+		// Shuffle the file positions while going through them in
+		// file order, so that a random seed picks the same openings
+		// as before
+		QVector<FilePosition> positions;
+		positions.swap(m_filePositions);
+		m_filePositions.reserve(positions.size());
+
+		for (const FilePosition& pos : qAsConst(positions))
+		{
 			int i = Mersenne::random() % (m_filePositions.size() + 1);
 			if (i == m_filePositions.size())
 				m_filePositions.append(pos);
@@ -139,25 +164,20 @@ bool OpeningSuite::initialize()
 			}
 		}
 	}
-	else if (m_order == SequentialOrder)
+	else if (m_order == SequentialOrder && needsIndex)
 	{
-		for (int i = 0; i < m_startIndex; i++)
+		// Resume from the start index. The suite wraps around
+		// after the last opening.
+		if (!m_filePositions.isEmpty())
 		{
-			FilePosition pos;
+			const FilePosition& pos =
+				m_filePositions.at(m_startIndex % m_filePositions.size());
 			if (m_format == EpdFormat)
-				pos = getEpdPos();
+				m_epdStream->seek(pos.pos);
 			else if (m_format == PgnFormat)
-				pos = getPgnPos();
-
-			if (pos.pos == -1)
-				break;
+				m_pgnStream->seek(pos.pos, pos.lineNumber);
 		}
-	}
-
-	if (m_format == EpdFormat)
-	{
-		m_file->reset();
-		m_epdStream = new QTextStream(m_file);
+		m_filePositions.clear();
 	}
 
 	return true;
@@ -228,60 +248,170 @@ PgnGame OpeningSuite::nextGame(int maxPlies)
 	return game;
 }
 
-OpeningSuite::FilePosition OpeningSuite::getPgnPos()
+QString OpeningSuite::indexFileName(const QString& fileName)
 {
-	FilePosition pos = { -1, -1 };
-	if (!m_pgnStream->nextGame())
-		return pos;
+	return fileName + ".index";
+}
 
-	pos.pos = m_pgnStream->pos();
-	pos.lineNumber = m_pgnStream->lineNumber();
+bool OpeningSuite::readIndex()
+{
+	QFile file(indexFileName(m_fileName));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
 
-	char c;
-	bool inTag = false;
-	bool inQuotes = false;
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_0);
+
+	quint32 magic = 0;
+	quint32 version = 0;
+	qint32 format = -1;
+	qint64 size = -1;
+	qint64 modified = -1;
+	QByteArray hash;
+	quint32 count = 0;
+	in >> magic >> version >> format >> size >> modified >> hash >> count;
+
+	const QFileInfo info(m_fileName);
+	if (in.status() != QDataStream::Ok
+	||  magic != IndexMagic
+	||  version != IndexVersion
+	||  format != qint32(m_format)
+	||  size != info.size()
+	||  qint64(count) * 16 > file.size())
+		return false;
 
-	while ((c = m_pgnStream->readChar()) != 0)
+	// A changed modification time alone doesn't invalidate the
+	// index if the contents of the file are still the same
+	bool touched = modified != info.lastModified().toMSecsSinceEpoch();
+	if (touched)
 	{
-		if (!inTag)
-		{
-			if (c == '[')
-				inTag = true;
-			else if (!isspace(c))
-			{
-				m_pgnStream->rewindChar();
-				break;
-			}
-
-			continue;
-		}
+		QFile suite(m_fileName);
+		QCryptographicHash fileHash(QCryptographicHash::Sha1);
+		if (!suite.open(QIODevice::ReadOnly)
+		||  !fileHash.addData(&suite)
+		||  fileHash.result() != hash)
+			return false;
+	}
 
-		if ((c == ']' && !inQuotes) || c == '\n' || c == '\r')
-		{
-			inTag = false;
-			inQuotes = false;
-		}
-		else if (c == '\"')
-			inQuotes = !inQuotes;
+	m_filePositions.resize(count);
+	for (FilePosition& pos : m_filePositions)
+		in >> pos.pos >> pos.lineNumber;
+	if (in.status() != QDataStream::Ok)
+	{
+		m_filePositions.clear();
+		return false;
 	}
 
-	return pos;
+	if (touched)
+		writeIndex(info, hash);
+	return true;
 }
 
-OpeningSuite::FilePosition OpeningSuite::getEpdPos()
+bool OpeningSuite::buildIndex()
 {
-	FilePosition pos = { m_file->pos(), -1 };
+	qInfo("Indexing opening suite %s...", qUtf8Printable(m_fileName));
+
+	// Read the file as binary data so that the offsets can be used
+	// for seeking on any platform
+	QFile file(m_fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Can't open opening suite %s",
+			 qUtf8Printable(m_fileName));
+		return false;
+	}
 
-	while (m_file->readLine().isEmpty())
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	QByteArray block;
+	qint64 blockPos = 0;
+	qint64 lineNumber = 1;
+	bool lineStart = true;
+	bool prevTag = false;
+	bool inComment = false;
+	bool skipLine = false;
+
+	// An EPD record starts on every non-empty line. A PGN game
+	// starts with a tag line that doesn't follow another tag line,
+	// and lines inside brace comments aren't tag lines. The rest
+	// of a tag line, a ';' comment or a '%' escape line is skipped.
+	while (!(block = file.read(ScanBlockSize)).isEmpty())
 	{
-		if (m_file->atEnd())
+		hash.addData(block);
+		const char* data = block.constData();
+		const int size = block.size();
+
+		for (int i = 0; i < size; )
 		{
-			pos.pos = -1;
-			break;
+			if (lineStart)
+			{
+				const char c = data[i];
+				if (c == ' ' || c == '\t' || c == '\r')
+				{
+					i++;
+					continue;
+				}
+				lineStart = false;
+
+				if (c == '\n')
+				{
+					// Empty line
+				}
+				else if (m_format == EpdFormat)
+					m_filePositions.append({ blockPos + i, lineNumber });
+				else if (c == '[' && !inComment)
+				{
+					if (!prevTag)
+						m_filePositions.append({ blockPos + i, lineNumber });
+					prevTag = true;
+					skipLine = true;
+				}
+				else
+				{
+					prevTag = false;
+					skipLine = (c == '%' && !inComment);
+				}
+			}
+
+			const char* nl = static_cast<const char*>(
+				memchr(data + i, '\n', size - i));
+			if (m_format == PgnFormat && !skipLine)
+			{
+				const char* lineEnd = nl != nullptr ? nl : data + size;
+				skipLine = PgnGameScanner::scanComments(
+					data + i, lineEnd, inComment);
+			}
+			if (nl == nullptr)
+				break;
+			i = int(nl - data) + 1;
+			lineNumber++;
+			lineStart = true;
+			skipLine = false;
 		}
-		else
-			pos.pos = m_file->pos();
+
+		blockPos += size;
 	}
 
-	return pos;
+	writeIndex(QFileInfo(m_fileName), hash.result());
+	return true;
+}
+
+void OpeningSuite::writeIndex(const QFileInfo& info,
+			      const QByteArray& hash) const
+{
+	// Failing to write the index isn't an error. The suite is
+	// just indexed again the next time.
+	QSaveFile file(indexFileName(m_fileName));
+	if (!file.open(QIODevice::WriteOnly))
+		return;
+
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_0);
+	out << IndexMagic << IndexVersion << qint32(m_format)
+	    << info.size() << info.lastModified().toMSecsSinceEpoch()
+	    << hash << quint32(m_filePositions.size());
+	for (const FilePosition& pos : m_filePositions)
+		out << pos.pos << pos.lineNumber;
+
+	if (out.status() == QDataStream::Ok)
+		file.commit();
 }
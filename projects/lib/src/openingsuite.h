@@ -23,6 +23,7 @@
 #include "pgngame.h"
 class QString;
 class QFile;
+class QFileInfo;
 class QTextStream;
 class PgnStream;
 
@@ -91,11 +92,15 @@ class LIB_EXPORT OpeningSuite
 		/*!
 		 * Initializes the opening suite.
 		 *
-		 * If \a order is SequentialOrder, this function just opens
-		 * the opening suite file and gets ready to read data. If
-		 * \a order is RandomOrder, the file positions of all the
-		 * openings are parsed from the file, which could take some
-		 * time if the file is large.
+		 * If \a order is SequentialOrder and the start index is 0,
+		 * this function just opens the opening suite file and gets
+		 * ready to read data. Otherwise the file positions of all
+		 * the openings are needed.
+		 *
+		 * The file positions are stored in an index file next to
+		 * the opening suite, see indexFileName(). The index is only
+		 * built if it doesn't exist yet or if the opening suite has
+		 * changed since, so a large suite is scanned just once.
 		 *
 		 * Returns true if successful; otherwise returns false.
 		 */
@@ -106,6 +111,12 @@ class LIB_EXPORT OpeningSuite
 		 */
 		PgnGame nextGame(int maxPlies);
 
+		/*!
+		 * Returns the name of the index file of the opening suite
+		 * file \a fileName.
+		 */
+		static QString indexFileName(const QString& fileName);
+
 	private:
 		struct FilePosition
 		{
@@ -113,8 +124,10 @@ class LIB_EXPORT OpeningSuite
 			qint64 lineNumber;
 		};
 
-		FilePosition getPgnPos();
-		FilePosition getEpdPos();
+		bool readIndex();
+		bool buildIndex();
+		void writeIndex(const QFileInfo& info,
+				const QByteArray& hash) const;
 
 		Format m_format;
 		Order m_order;
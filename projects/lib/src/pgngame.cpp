@@ -53,7 +53,8 @@ QTextStream& operator<<(QTextStream& out, PgnGame& game)
 PgnGame::PgnGame()
 	: m_startingSide(Chess::Side::White),
 	  m_tagReceiver(nullptr),
-	  m_key(0)
+	  m_key(0),
+	  m_ecoNode(nullptr)
 {
 }
 
@@ -67,6 +68,7 @@ void PgnGame::clear()
 	m_startingSide = Chess::Side();
 	m_tags.clear();
 	m_moves.clear();
+	m_ecoNode = nullptr;
 
     resetCursor();
 }
@@ -115,11 +117,16 @@ void PgnGame::addMove(const MoveData& data, quint64 key, bool addEco)
 	m_moves.append(data);
 	m_key = key;
 
-	if (addEco && isStandard())
+	// No opening line is longer than EcoNode::maxPlies(), and the
+	// tags only change when the game reaches a new opening
+	if (addEco
+	&&  m_moves.size() <= EcoNode::maxPlies()
+	&&  isStandard())
 	{
 		const EcoNode* eco = EcoNode::find(key);
-		if (eco)
+		if (eco && eco != m_ecoNode)
 		{
+			m_ecoNode = eco;
 			setTag("ECO", eco->ecoCode());
 			setTag("Opening", eco->opening());
 			setTag("Variation", eco->variation());
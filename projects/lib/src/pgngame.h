@@ -231,6 +231,7 @@ class LIB_EXPORT PgnGame
 		QDateTime m_gameStartTime;
 		QTime m_gameDuration;
 		quint64 m_key;
+		const EcoNode* m_ecoNode;
 
         // PGN optimization
         int m_tag_changed = 1;
@@ -18,13 +18,18 @@
 
 #include "pgngameentry.h"
 #include <cctype>
+#include <cstring>
 #include <QDataStream>
 #include <QMap>
+#include <QtEndian>
 #include "pgnstream.h"
 #include "pgngamefilter.h"
 
 namespace {
 
+// The size of an entry's record in a table
+const int s_tableRecordSize = 24;
+
 int s_stringContains(const char* s1, const char* s2, int size)
 {
 	Q_ASSERT(s1 != nullptr);
@@ -97,17 +102,19 @@ QDataStream& operator<<(QDataStream& out, const PgnGameEntry& entry)
 }
 
 PgnGameEntry::PgnGameEntry()
-	: m_pos(0),
+	: m_offset(0),
+	  m_size(0),
+	  m_pos(0),
 	  m_lineNumber(1)
 {
 }
 
 bool PgnGameEntry::match(const PgnGameFilter& filter) const
 {
-	const char* data = m_data.constData();
+	const char* data = tagData();
 
 	if (filter.type() == PgnGameFilter::FixedString)
-		return s_stringContains(data, filter.pattern(), m_data.size()) != -1;
+		return s_stringContains(data, filter.pattern(), m_size) != -1;
 
 	int whitePlayer = 0;
 
@@ -259,6 +266,12 @@ void PgnGameEntry::addTag(const QByteArray& tagValue)
 
 	m_data.append(char(size));
 	m_data.append(tagValue.constData(), size);
+	m_size = m_data.size();
+}
+
+const char* PgnGameEntry::tagData() const
+{
+	return m_data.constData() + m_offset;
 }
 
 void PgnGameEntry::clear()
@@ -266,6 +279,8 @@ void PgnGameEntry::clear()
 	m_pos = 0;
 	m_lineNumber = 1;
 	m_data.clear();
+	m_offset = 0;
+	m_size = 0;
 }
 
 bool PgnGameEntry::read(PgnStream& in)
@@ -276,6 +291,8 @@ bool PgnGameEntry::read(PgnStream& in)
 	m_pos = in.pos();
 	m_lineNumber = in.lineNumber();
 	m_data.clear();
+	m_offset = 0;
+	m_size = 0;
 
 	char c;
 	QByteArray tagName;
@@ -344,6 +361,8 @@ bool PgnGameEntry::read(QDataStream& in)
 	in >> m_pos;
 	in >> m_lineNumber;
 	in >> m_data;
+	m_offset = 0;
+	m_size = m_data.size();
 
 	return in.status() == QDataStream::Ok;
 }
@@ -355,7 +374,68 @@ void PgnGameEntry::write(QDataStream& out) const
 
 	out << m_pos;
 	out << m_lineNumber;
-	out << m_data;
+	out << QByteArray::fromRawData(tagData(), m_size);
+}
+
+QByteArray PgnGameEntry::writeTable(const QVector<PgnGameEntry>& entries)
+{
+	int poolSize = 0;
+	for (const PgnGameEntry& entry : entries)
+		poolSize += entry.m_size;
+
+	const int recordsSize = entries.size() * s_tableRecordSize;
+	QByteArray table(recordsSize + poolSize, Qt::Uninitialized);
+	uchar* record = reinterpret_cast<uchar*>(table.data());
+	char* pool = table.data() + recordsSize;
+
+	int offset = 0;
+	for (const PgnGameEntry& entry : entries)
+	{
+		qToLittleEndian<qint64>(entry.m_pos, record);
+		qToLittleEndian<qint64>(entry.m_lineNumber, record + 8);
+		qToLittleEndian<quint32>(quint32(offset), record + 16);
+		qToLittleEndian<quint32>(quint32(entry.m_size), record + 20);
+		record += s_tableRecordSize;
+
+		memcpy(pool + offset, entry.tagData(), size_t(entry.m_size));
+		offset += entry.m_size;
+	}
+
+	return table;
+}
+
+bool PgnGameEntry::readTable(const QByteArray& table,
+			     int count,
+			     QVector<PgnGameEntry>& entries)
+{
+	const qint64 recordsSize = qint64(count) * s_tableRecordSize;
+	if (count < 0 || recordsSize > table.size())
+		return false;
+
+	// Every entry refers to the same copy of the pool
+	const QByteArray pool(table.constData() + recordsSize,
+			      table.size() - int(recordsSize));
+	const uchar* record = reinterpret_cast<const uchar*>(table.constData());
+
+	QVector<PgnGameEntry> tmp(count);
+	for (PgnGameEntry& entry : tmp)
+	{
+		const quint32 offset = qFromLittleEndian<quint32>(record + 16);
+		const quint32 size = qFromLittleEndian<quint32>(record + 20);
+		if (offset > quint32(pool.size())
+		||  size > quint32(pool.size()) - offset)
+			return false;
+
+		entry.m_pos = qFromLittleEndian<qint64>(record);
+		entry.m_lineNumber = qFromLittleEndian<qint64>(record + 8);
+		entry.m_data = pool;
+		entry.m_offset = int(offset);
+		entry.m_size = int(size);
+		record += s_tableRecordSize;
+	}
+
+	entries.swap(tmp);
+	return true;
 }
 
 qint64 PgnGameEntry::pos() const
@@ -368,14 +448,23 @@ qint64 PgnGameEntry::lineNumber() const
 	return m_lineNumber;
 }
 
-QString PgnGameEntry::tagValue(TagType type) const
+QByteArray PgnGameEntry::rawTagValue(TagType type) const
 {
+	if (m_size == 0)
+		return QByteArray();
+
+	const char* data = tagData();
 	int i = 0;
 	for (int j = 0; j < type; j++)
-		i += m_data[i] + 1;
+		i += data[i] + 1;
 
-	int size = m_data[i];
-	if (size == 0)
+	return QByteArray::fromRawData(data + i + 1, data[i]);
+}
+
+QString PgnGameEntry::tagValue(TagType type) const
+{
+	const QByteArray value(rawTagValue(type));
+	if (value.isEmpty())
 		return QString();
-	return m_data.mid(i + 1, size);
+	return QString::fromUtf8(value.constData(), value.size());
 }
@@ -20,6 +20,7 @@
 #define PGNGAMEENTRY_H
 
 #include <QDate>
+#include <QVector>
 #include "board/result.h"
 class PgnStream;
 class PgnGameFilter;
@@ -33,9 +34,10 @@ class QDataStream;
  * the position and line number in a PGN stream.
  * This class was designed for high-performance and low memory
  * consumption, which is useful for quickly loading large game
- * collections.
+ * collections. The packed tags of many entries can share one
+ * buffer, see PgnGameScanner.
  *
- * \sa PgnGame, PgnStream
+ * \sa PgnGame, PgnStream, PgnGameScanner
  */
 class LIB_EXPORT PgnGameEntry
 {
@@ -75,6 +77,32 @@ class LIB_EXPORT PgnGameEntry
 		 */
 		void write(QDataStream& out) const;
 
+		/*!
+		 * Packs \a entries into a table that can be read without
+		 * parsing, eg. from a memory-mapped file.
+		 *
+		 * The table starts with a fixed-size record for every entry:
+		 * the stream position and line number as 64-bit integers,
+		 * and the offset and size of the packed tags as 32-bit
+		 * integers. The records are followed by a pool of packed
+		 * tags. All integers are little-endian.
+		 *
+		 * \sa readTable()
+		 */
+		static QByteArray writeTable(const QVector<PgnGameEntry>& entries);
+		/*!
+		 * Reads \a count entries from \a table into \a entries.
+		 *
+		 * The entries share one copy of the tag pool, so \a table
+		 * doesn't have to stay valid afterwards.
+		 * Returns true if successful; otherwise returns false.
+		 *
+		 * \sa writeTable()
+		 */
+		static bool readTable(const QByteArray& table,
+				      int count,
+				      QVector<PgnGameEntry>& entries);
+
 		/*!
 		 * Returns true if the PGN tags match \a filter.
 		 * The matching is case insensitive.
@@ -90,9 +118,16 @@ class LIB_EXPORT PgnGameEntry
 		QString tagValue(TagType type) const;
 
 	private:
+		friend class PgnGameScanner;
+		friend class PgnTagIndex;
+
 		void addTag(const QByteArray& tagValue);
+		const char* tagData() const;
+		QByteArray rawTagValue(TagType type) const;
 
 		QByteArray m_data;
+		int m_offset;
+		int m_size;
 
 		qint64 m_pos;
 		qint64 m_lineNumber;
@@ -39,6 +39,22 @@ PgnGameFilter::PgnGameFilter(const QString& pattern)
 {
 }
 
+bool PgnGameFilter::isEmpty() const
+{
+	if (m_type == FixedString)
+		return m_pattern.isEmpty();
+
+	return m_event.isEmpty()
+	    && m_site.isEmpty()
+	    && m_player.isEmpty()
+	    && m_opponent.isEmpty()
+	    && m_minDate.isNull()
+	    && m_maxDate.isNull()
+	    && m_minRound == 0
+	    && m_maxRound == 0
+	    && m_result == AnyResult;
+}
+
 void PgnGameFilter::setPattern(const QString& pattern)
 {
 	m_type = FixedString;
@@ -76,6 +76,8 @@ class LIB_EXPORT PgnGameFilter
 
 		/*! Returns the type of the filter. */
 		Type type() const;
+		/*! Returns true if the filter doesn't filter out any games. */
+		bool isEmpty() const;
 
 		/*! Returns the pattern for \a FixedString mode. */
 		const char* pattern() const;
@@ -0,0 +1,301 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgngamescanner.h"
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// The tags of a PgnGameEntry, in the order of PgnGameEntry::TagType
+const char* const s_tagNames[] =
+{
+	"Event", "Site", "Date", "Round", "White", "Black", "Result", "Variant"
+};
+const int TagCount = 8;
+const int MaxTagSize = 127;
+// How far back to look for a brace when guessing whether a chunk
+// starts inside a comment
+const qint64 MaxCommentGuess = 64 * 1024;
+
+bool isIndentation(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+} // anonymous namespace
+
+PgnGameScanner::PgnGameScanner(const char* data, qint64 size)
+	: m_data(data),
+	  m_size(size)
+{
+	Q_ASSERT(data != nullptr || size == 0);
+}
+
+QVector<qint64> PgnGameScanner::chunks(qint64 chunkSize) const
+{
+	Q_ASSERT(chunkSize > 0);
+
+	QVector<qint64> ret;
+	ret.append(0);
+
+	for (qint64 pos = chunkSize; pos < m_size; pos += chunkSize)
+	{
+		const char* nl = static_cast<const char*>(
+			memchr(m_data + pos, '\n', size_t(m_size - pos)));
+		if (nl == nullptr)
+			break;
+
+		pos = nl - m_data + 1;
+		if (pos >= m_size)
+			break;
+		ret.append(pos);
+	}
+	ret.append(m_size);
+
+	return ret;
+}
+
+bool PgnGameScanner::scanComments(const char* begin,
+				  const char* end,
+				  bool& inComment)
+{
+	const char* p = begin;
+	while (p < end)
+	{
+		if (inComment)
+		{
+			p = static_cast<const char*>(memchr(p, '}', size_t(end - p)));
+			if (p == nullptr)
+				return false;
+			inComment = false;
+			p++;
+			continue;
+		}
+
+		const char* brace = static_cast<const char*>(
+			memchr(p, '{', size_t(end - p)));
+		const char* braceEnd = brace != nullptr ? brace : end;
+		if (memchr(p, ';', size_t(braceEnd - p)) != nullptr)
+			return true;
+		if (brace == nullptr)
+			return false;
+		inComment = true;
+		p = brace + 1;
+	}
+
+	return false;
+}
+
+PgnGameScanner::State PgnGameScanner::guessState(qint64 pos) const
+{
+	// The nearest brace before pos tells whether pos is inside a
+	// comment, unless the brace is in a tag value or a ';' comment
+	State state = { false, false };
+	const qint64 limit = qMax(qint64(0), pos - MaxCommentGuess);
+	for (qint64 i = pos - 1; i >= limit; i--)
+	{
+		if (m_data[i] == '}')
+			break;
+		if (m_data[i] == '{')
+		{
+			state.inComment = true;
+			break;
+		}
+	}
+
+	if (!state.inComment)
+		state.afterTag = followsTag(pos);
+	return state;
+}
+
+bool PgnGameScanner::followsTag(qint64 pos) const
+{
+	// Look for the last non-empty line before the line at pos
+	qint64 end = pos - 1;
+	while (end >= 0)
+	{
+		qint64 start = end;
+		while (start > 0 && m_data[start - 1] != '\n')
+			start--;
+
+		qint64 i = start;
+		while (i < end && isIndentation(m_data[i]))
+			i++;
+		if (i < end)
+			return m_data[i] == '[';
+
+		end = start - 1;
+	}
+
+	return false;
+}
+
+void PgnGameScanner::readTags(qint64 pos, QByteArray& tags) const
+{
+	// Parse the tag section the same way as PgnGameEntry::read()
+	char values[TagCount][MaxTagSize];
+	int sizes[TagCount] = {};
+
+	char value[MaxTagSize];
+	int valueSize = 0;
+	const char* name = nullptr;
+	int nameSize = 0;
+	bool haveTagName = false;
+	bool inTag = false;
+	bool inQuotes = false;
+
+	for (qint64 i = pos; i < m_size && m_data[i] != 0; i++)
+	{
+		const char c = m_data[i];
+
+		if (!inTag)
+		{
+			if (c == '[')
+			{
+				inTag = true;
+				name = m_data + i + 1;
+			}
+			else if (!isspace(uchar(c)))
+				break;
+
+			continue;
+		}
+
+		if ((c == ']' && !inQuotes) || c == '\n' || c == '\r')
+		{
+			for (int type = 0; type < TagCount; type++)
+			{
+				if (strlen(s_tagNames[type]) == size_t(nameSize)
+				&&  memcmp(s_tagNames[type], name, nameSize) == 0)
+				{
+					memcpy(values[type], value, valueSize);
+					sizes[type] = valueSize;
+					break;
+				}
+			}
+
+			nameSize = 0;
+			valueSize = 0;
+			inTag = false;
+			inQuotes = false;
+			haveTagName = false;
+			continue;
+		}
+
+		if (!haveTagName)
+		{
+			if (c == ' ')
+				haveTagName = true;
+			else
+				nameSize++;
+		}
+		else if (c == '\"')
+			inQuotes = !inQuotes;
+		else if (inQuotes && valueSize < MaxTagSize)
+			value[valueSize++] = c;
+	}
+
+	for (int type = 0; type < TagCount; type++)
+	{
+		tags.append(char(sizes[type]));
+		tags.append(values[type], sizes[type]);
+	}
+}
+
+PgnGameScanner::Chunk PgnGameScanner::scan(qint64 begin, qint64 end) const
+{
+	return scan(begin, end, begin > 0 ? guessState(begin) : State());
+}
+
+PgnGameScanner::Chunk PgnGameScanner::scan(qint64 begin,
+					   qint64 end,
+					   const State& state) const
+{
+	Q_ASSERT(begin >= 0 && begin <= end && end <= m_size);
+
+	Chunk chunk;
+	chunk.lineCount = 0;
+	chunk.startState = state;
+	QByteArray tags;
+	bool inComment = state.inComment;
+	bool prevTag = state.afterTag;
+
+	for (qint64 i = begin; i < end; )
+	{
+		while (i < end && isIndentation(m_data[i]))
+			i++;
+		if (i >= end)
+			break;
+
+		// memchr() is vectorized by the C library, so skipping to
+		// the next line is much faster than reading the characters
+		const char* nl = static_cast<const char*>(
+			memchr(m_data + i, '\n', size_t(end - i)));
+		const char* lineEnd = nl != nullptr ? nl : m_data + end;
+
+		if (inComment)
+		{
+			if (m_data[i] != '\n')
+				prevTag = false;
+			scanComments(m_data + i, lineEnd, inComment);
+		}
+		else if (m_data[i] == '[')
+		{
+			// Braces in tag values don't start comments
+			if (!prevTag)
+			{
+				PgnGameEntry entry;
+				entry.m_pos = i;
+				entry.m_lineNumber = chunk.lineCount + 1;
+				entry.m_offset = tags.size();
+				readTags(i, tags);
+				entry.m_size = tags.size() - entry.m_offset;
+				chunk.entries.append(entry);
+			}
+			prevTag = true;
+		}
+		else if (m_data[i] != '\n')
+		{
+			prevTag = false;
+			if (m_data[i] != '%')
+				scanComments(m_data + i, lineEnd, inComment);
+		}
+
+		if (nl == nullptr)
+			break;
+		chunk.lineCount++;
+		i = nl - m_data + 1;
+	}
+
+	chunk.endState.inComment = inComment;
+	chunk.endState.afterTag = prevTag;
+
+	// The entries share the packed tags of the chunk
+	for (PgnGameEntry& entry : chunk.entries)
+		entry.m_data = tags;
+
+	return chunk;
+}
+
+void PgnGameScanner::addLines(QVector<PgnGameEntry>& entries,
+			      qint64 lineCount)
+{
+	for (PgnGameEntry& entry : entries)
+		entry.m_lineNumber += lineCount;
+}
@@ -0,0 +1,140 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNGAMESCANNER_H
+#define PGNGAMESCANNER_H
+
+#include <QVector>
+#include "pgngameentry.h"
+
+/*!
+ * \brief Finds the games of a PGN collection in memory
+ *
+ * PgnGameScanner reads game entries directly from PGN data, usually
+ * a memory-mapped file, without going through a PgnStream. The data
+ * can be split into chunks that are scanned independently, eg. by
+ * several threads.
+ *
+ * A game starts with a tag line that doesn't follow another tag
+ * line. Lines inside brace comments aren't tag lines, so a chunk
+ * that starts inside a comment must be scanned with the state that
+ * the previous chunk ended in. The packed tags of the games of a
+ * chunk are stored in one buffer that the entries share.
+ *
+ * \sa PgnGameEntry
+ */
+class LIB_EXPORT PgnGameScanner
+{
+	public:
+		/*! The state of the scanner at the start of a line. */
+		struct State
+		{
+			/*! True if the line starts inside a brace comment. */
+			bool inComment;
+			/*! True if the previous non-empty line is a tag line. */
+			bool afterTag;
+
+			/*! Returns true if \a other is the same state. */
+			bool operator==(const State& other) const
+			{
+				return inComment == other.inComment
+				    && afterTag == other.afterTag;
+			}
+			/*! Returns true if \a other is a different state. */
+			bool operator!=(const State& other) const
+			{
+				return !(*this == other);
+			}
+		};
+
+		/*! The game entries of a chunk. */
+		struct Chunk
+		{
+			/*! The games that start in the chunk. */
+			QVector<PgnGameEntry> entries;
+			/*! The number of line breaks in the chunk. */
+			qint64 lineCount;
+			/*! The state the chunk was scanned from. */
+			State startState;
+			/*! The state at the end of the chunk. */
+			State endState;
+		};
+
+		/*!
+		 * Creates a new scanner for \a size bytes of PGN data
+		 * in \a data.
+		 *
+		 * The data must stay valid while the scanner is used.
+		 */
+		PgnGameScanner(const char* data, qint64 size);
+
+		/*!
+		 * Splits the data into chunks of about \a chunkSize bytes.
+		 *
+		 * Returns the positions where the chunks start, followed
+		 * by the size of the data. Every chunk starts on a new line.
+		 */
+		QVector<qint64> chunks(qint64 chunkSize) const;
+		/*!
+		 * Returns the games whose first tag line starts between
+		 * \a begin and \a end.
+		 *
+		 * \a begin must be the start of a line. The line numbers
+		 * of the entries are relative to \a begin, and must be
+		 * moved with addLines() if \a begin isn't 0.
+		 *
+		 * The state at \a begin is guessed from the preceding
+		 * data. If the chunk's \a startState differs from the
+		 * \a endState of the previous chunk, the guess was wrong
+		 * and the chunk must be scanned again with that state.
+		 */
+		Chunk scan(qint64 begin, qint64 end) const;
+		/*!
+		 * Returns the games whose first tag line starts between
+		 * \a begin and \a end, when the line at \a begin starts
+		 * in \a state.
+		 */
+		Chunk scan(qint64 begin, qint64 end, const State& state) const;
+
+		/*!
+		 * Follows the comments of the move text between \a begin
+		 * and \a end, which must not span more than one line.
+		 *
+		 * \a inComment tells whether the text starts inside a
+		 * brace comment, and is updated to tell whether it ends
+		 * inside one. Returns true if the rest of the line is a
+		 * ';' comment.
+		 */
+		static bool scanComments(const char* begin,
+					 const char* end,
+					 bool& inComment);
+
+		/*! Adds \a lineCount to the line numbers of \a entries. */
+		static void addLines(QVector<PgnGameEntry>& entries,
+				     qint64 lineCount);
+
+	private:
+		State guessState(qint64 pos) const;
+		bool followsTag(qint64 pos) const;
+		void readTags(qint64 pos, QByteArray& tags) const;
+
+		const char* m_data;
+		qint64 m_size;
+};
+
+#endif // PGNGAMESCANNER_H
@@ -24,50 +24,15 @@
 
 namespace {
 
-void skipSection(PgnStream* in, char start)
-{
-	char end;
-	switch (start)
-	{
-	case '(':
-		end = ')';
-		break;
-	case '{':
-		end = '}';
-		break;
-	case ';':
-	case '%':
-		start = 0;
-		end = '\n';
-		break;
-	default:
-		return;
-	}
-
-	int level = 1;
-	char c;
-	while ((c = in->readChar()) != 0)
-	{
-		if (c == end && --level == 0)
-			break;
-		if (c == start)
-			level++;
-	}
-}
+const int BufferSize = 64 * 1024;
+const int TokenCapacity = 256;
 
 } // anonymous namespace
 
 PgnStream::PgnStream(const QString& variant)
-	: m_board(nullptr),
-	  m_pos(0),
-	  m_lineNumber(1),
-	  m_lastChar(0),
-	  m_tokenType(NoToken),
-	  m_device(nullptr),
-	  m_string(nullptr),
-	  m_status(Ok),
-	  m_phase(OutOfGame)
+	: m_board(nullptr)
 {
+	reset();
 	setVariant(variant);
 }
 
@@ -92,12 +57,20 @@ PgnStream::~PgnStream()
 
 void PgnStream::reset()
 {
-	m_pos = 0;
+	m_bufferPos = 0;
 	m_lineNumber = 1;
-	m_lastChar = 0;
+	m_data = nullptr;
+	m_size = 0;
+	m_index = 0;
+	m_skipCr = false;
+
+	// The tokens keep their capacity between reads
 	m_tokenString.clear();
+	m_tokenString.reserve(TokenCapacity);
 	m_tagName.clear();
+	m_tagName.reserve(TokenCapacity);
 	m_tagValue.clear();
+	m_tagValue.reserve(TokenCapacity);
 	m_tokenType = NoToken;
 	m_device = nullptr;
 	m_string = nullptr;
@@ -121,6 +94,7 @@ void PgnStream::setDevice(QIODevice* device)
 
 	reset();
 	m_device = device;
+	m_bufferPos = device->pos();
 }
 
 const QByteArray* PgnStream::string() const
@@ -133,6 +107,8 @@ void PgnStream::setString(const QByteArray* string)
 	Q_ASSERT(string != nullptr);
 	reset();
 	m_string = string;
+	m_data = string->constData();
+	m_size = string->size();
 }
 
 QString PgnStream::variant() const
@@ -162,9 +138,7 @@ bool PgnStream::isOpen() const
 
 qint64 PgnStream::pos() const
 {
-	if (m_device)
-		return m_device->pos();
-	return m_pos;
+	return m_bufferPos + m_index;
 }
 
 qint64 PgnStream::lineNumber() const
@@ -172,32 +146,53 @@ qint64 PgnStream::lineNumber() const
 	return m_lineNumber;
 }
 
-char PgnStream::readChar()
+bool PgnStream::fillBuffer()
 {
-	char c;
-	if (m_device)
-	{
-		if (!m_device->getChar(&m_lastChar))
-		{
-			m_status = ReadPastEnd;
-			return 0;
-		}
-		c = m_lastChar;
-	}
-	else if (m_string && m_pos < m_string->size())
+	if (m_string)
 	{
-		c = m_string->at(m_pos++);
+		// The string may have grown since the last read
+		m_data = m_string->constData();
+		m_size = m_string->size();
+		if (m_index < m_size)
+			return true;
 	}
-	else
+	else if (m_device)
 	{
-		m_status = ReadPastEnd;
-		return 0;
+		if (m_buffer.size() != BufferSize + 1)
+			m_buffer.resize(BufferSize + 1);
+		if (m_size == 0)
+			m_bufferPos = m_device->pos();
+
+		// Keep the last character in the buffer so that it can
+		// be rewound
+		char* buffer = m_buffer.data();
+		const int keep = (m_size > 0) ? 1 : 0;
+		const char last = keep ? m_data[m_size - 1] : 0;
+
+		// Read the raw data so that the positions match the device
+		// positions. The carriage returns that text mode would
+		// remove are skipped by readChar() instead.
+		m_skipCr = m_device->isTextModeEnabled();
+		if (m_skipCr)
+			m_device->setTextModeEnabled(false);
+		const qint64 n = m_device->read(buffer + keep, BufferSize);
+		if (m_skipCr)
+			m_device->setTextModeEnabled(true);
+
+		if (n > 0)
+		{
+			if (keep)
+				buffer[0] = last;
+			m_bufferPos += m_size - keep;
+			m_data = buffer;
+			m_size = keep + int(n);
+			m_index = keep;
+			return true;
+		}
 	}
 
-	if (c == '\n')
-		m_lineNumber++;
-
-	return c;
+	m_status = ReadPastEnd;
+	return false;
 }
 
 void PgnStream::rewind()
@@ -209,19 +204,10 @@ void PgnStream::rewindChar()
 {
 	Q_ASSERT(pos() > 0);
 
-	char c;
-	if (m_device)
-	{
-		c = m_lastChar;
-		m_device->ungetChar(m_lastChar);
-		m_lastChar = 0;
-	}
-	else if (m_string)
-		c = m_string->at(m_pos--);
-	else
+	if (m_index <= 0)
 		return;
 
-	if (c == '\n')
+	if (m_data[--m_index] == '\n')
 		m_lineNumber--;
 }
 
@@ -233,20 +219,31 @@ bool PgnStream::seek(qint64 pos, qint64 lineNumber)
 	bool ok = false;
 	if (m_device)
 	{
-		ok = m_device->seek(pos);
-		m_pos = 0;
+		// Seeking inside the buffer doesn't need a new read
+		if (m_size > 0 && pos >= m_bufferPos && pos <= m_bufferPos + m_size)
+		{
+			m_index = int(pos - m_bufferPos);
+			ok = true;
+		}
+		else
+		{
+			ok = m_device->seek(pos);
+			m_bufferPos = pos;
+			m_data = nullptr;
+			m_size = 0;
+			m_index = 0;
+		}
 	}
 	else if (m_string)
 	{
 		ok = pos < m_string->size();
-		m_pos = pos;
+		m_index = int(pos);
 	}
 	if (!ok)
 		return false;
 
 	m_status = Ok;
 	m_lineNumber = lineNumber;
-	m_lastChar = 0;
 	m_phase = OutOfGame;
 
 	return true;
@@ -257,16 +254,71 @@ PgnStream::Status PgnStream::status() const
 	return m_status;
 }
 
+void PgnStream::skipSection(char start)
+{
+	char end;
+	switch (start)
+	{
+	case '(':
+		end = ')';
+		break;
+	case '{':
+		end = '}';
+		break;
+	case ';':
+	case '%':
+		start = 0;
+		end = '\n';
+		break;
+	default:
+		return;
+	}
+
+	int level = 1;
+	for (;;)
+	{
+		while (m_index < m_size)
+		{
+			const char c = m_data[m_index++];
+			if (c == '\n')
+				m_lineNumber++;
+			if (c == 0 || (c == end && --level == 0))
+				return;
+			if (c == start)
+				level++;
+		}
+
+		if (!fillBuffer())
+			return;
+	}
+}
+
 void PgnStream::parseUntil(const char* chars)
 {
 	Q_ASSERT(chars != nullptr);
 
-	char c;
-	while ((c = readChar()) != 0)
+	// Append the token a span at a time. Every terminator set has
+	// line breaks, so the token can't span lines.
+	for (;;)
 	{
-		if (strchr(chars, c))
-			break;
-		m_tokenString.append(c);
+		const int start = m_index;
+		while (m_index < m_size)
+		{
+			const char c = m_data[m_index];
+			if ((uchar(c) <= ' ' || c == '.') && (c == 0 || strchr(chars, c)))
+				break;
+			m_index++;
+		}
+		m_tokenString.append(m_data + start, m_index - start);
+
+		if (m_index < m_size)
+		{
+			if (m_data[m_index++] == '\n')
+				m_lineNumber++;
+			return;
+		}
+		if (!fillBuffer())
+			return;
 	}
 }
 
@@ -276,8 +328,8 @@ void PgnStream::parseTag()
 	int phase = 0;
 	char c;
 
-	m_tagName.clear();
-	m_tagValue.clear();
+	m_tagName.resize(0);
+	m_tagValue.resize(0);
 
 	while ((c = readChar()) != 0)
 	{
@@ -337,9 +389,35 @@ void PgnStream::parseComment(char opBracket)
 	int level = 1;
 	char clBracket = (opBracket == '(') ? ')' : '}';
 
-	char c;
-	while ((c = readChar()) != 0)
+	for (;;)
 	{
+		// Append the plain characters a span at a time
+		const int start = m_index;
+		while (m_index < m_size)
+		{
+			const char c = m_data[m_index];
+			if (c == opBracket || c == clBracket
+			||  c == '\n' || c == '\r' || c == 0)
+				break;
+			m_index++;
+		}
+		m_tokenString.append(m_data + start, m_index - start);
+
+		if (m_index >= m_size)
+		{
+			if (!fillBuffer())
+				return;
+			continue;
+		}
+
+		const char c = m_data[m_index++];
+		if (c == 0)
+			return;
+		if (c == '\r' && m_skipCr)
+			continue;
+		if (c == '\n')
+			m_lineNumber++;
+
 		if (c == opBracket)
 			level++;
 		else if (c == clBracket && --level <= 0)
@@ -352,20 +430,37 @@ void PgnStream::parseComment(char opBracket)
 
 bool PgnStream::nextGame()
 {
-	char c;
-	while ((c = readChar()) != 0)
+	// Skip the move text without tokenizing it
+	for (;;)
 	{
-		if (c == '[')
+		while (m_index < m_size)
 		{
-			rewindChar();
-			m_phase = InTags;
-			return true;
+			const char c = m_data[m_index++];
+			switch (c)
+			{
+			case '\n':
+				m_lineNumber++;
+				break;
+			case '[':
+				rewindChar();
+				m_phase = InTags;
+				return true;
+			case '(':
+			case '{':
+			case ';':
+			case '%':
+				skipSection(c);
+				break;
+			case 0:
+				return false;
+			default:
+				break;
+			}
 		}
-		else
-			skipSection(this, c);
-	}
 
-	return false;
+		if (!fillBuffer())
+			return false;
+	}
 }
 
 PgnStream::TokenType PgnStream::readNext()
@@ -374,7 +469,7 @@ PgnStream::TokenType PgnStream::readNext()
 		return NoToken;
 
 	m_tokenType = NoToken;
-	m_tokenString.clear();
+	m_tokenString.resize(0);
 
 	char c;
 	while ((c = readChar()) != 0)
@@ -390,7 +485,7 @@ PgnStream::TokenType PgnStream::readNext()
 		case '%':
 			// Escape mechanism (skip this line)
 			parseUntil("\n\r");
-			m_tokenString.clear();
+			m_tokenString.resize(0);
 			break;
 		case '[':
 			if (m_phase != InTags)
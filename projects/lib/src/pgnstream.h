@@ -21,6 +21,7 @@
 
 #include <QtGlobal>
 #include <QString>
+#include <QByteArray>
 class QIODevice;
 namespace Chess { class Board; }
 
@@ -30,7 +31,9 @@ namespace Chess { class Board; }
  *
  * PgnStream is used for reading PGN games from a QIODevice or a string.
  * It has its own input methods, and keeps track of the current line
- * number which can be used to report errors in the games. PgnStream
+ * number which can be used to report errors in the games. A device is
+ * read in large blocks, and the tokens are copied from the blocks a
+ * span at a time. PgnStream
  * also has its own Chess::Board object, so that the same board can be
  * easily used with all the games in the stream. The chess variant can
  * be changed at any time, so it's possible to read PGN streams that
@@ -123,7 +126,12 @@ class LIB_EXPORT PgnStream
 		/*! Returns true if the stream is open. */
 		bool isOpen() const;
 
-		/*! Returns the current position in the stream. */
+		/*!
+		 * Returns the current position in the stream.
+		 *
+		 * \note The stream reads ahead, so the position of the
+		 * device may be beyond this position.
+		 */
 		qint64 pos() const;
 
 		/*! Returns the current line number. */
@@ -164,7 +172,9 @@ class LIB_EXPORT PgnStream
 		 * is available; otherwise returns false.
 		 *
 		 * This function must be called once for each new game, or
-		 * nothing can be parsed.
+		 * nothing can be parsed. The rest of the previous game is
+		 * skipped without tokenizing it, so reading only the tags
+		 * of each game is fast.
 		 *
 		 * \sa readNext()
 		 */
@@ -200,14 +210,20 @@ class LIB_EXPORT PgnStream
 			InGame
 		};
 
+		bool fillBuffer();
+		void skipSection(char start);
 		void parseUntil(const char* chars);
 		void parseTag();
 		void parseComment(char opBracket);
 
 		Chess::Board* m_board;
-		qint64 m_pos;
+		qint64 m_bufferPos;
 		qint64 m_lineNumber;
-		char m_lastChar;
+		const char* m_data;
+		int m_size;
+		int m_index;
+		bool m_skipCr;
+		QByteArray m_buffer;
 		QByteArray m_tokenString;
 		QByteArray m_tagName;
 		QByteArray m_tagValue;
@@ -218,4 +234,21 @@ class LIB_EXPORT PgnStream
 		Phase m_phase;
 };
 
+inline char PgnStream::readChar()
+{
+	for (;;)
+	{
+		if (m_index >= m_size && !fillBuffer())
+			return 0;
+
+		const char c = m_data[m_index++];
+		if (c == '\n')
+			m_lineNumber++;
+		else if (c == '\r' && m_skipCr)
+			continue;
+
+		return c;
+	}
+}
+
 #endif // PGNSTREAM_H
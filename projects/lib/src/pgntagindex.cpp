@@ -0,0 +1,388 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgntagindex.h"
+#include <cctype>
+#include <limits>
+#include <QHash>
+#include <QDate>
+#include "pgngamefilter.h"
+
+namespace {
+
+// The date of entries whose Date tag can't be parsed
+const qint64 NoDate = std::numeric_limits<qint64>::max();
+
+enum PlayerMatch
+{
+	PlayerMatches = 1,
+	OpponentMatches = 2
+};
+
+enum ResultMatch
+{
+	WhiteIsFirstMatches = 1,
+	BlackIsFirstMatches = 2
+};
+
+int stringToInt(const char* s, int size)
+{
+	int num = 0;
+	for (int i = 0; i < size; i++)
+	{
+		if (!isdigit(s[i]))
+			return 0;
+		num = num * 10 + (s[i] - '0');
+	}
+
+	return num;
+}
+
+// Parses the Date tag the same way as PgnGameEntry::match()
+qint64 parseDate(const QByteArray& value)
+{
+	if (value.size() < 10)
+		return NoDate;
+
+	const char* str = value.constData();
+	int year = stringToInt(str, 4);
+	if (year == 0)
+		return NoDate;
+	int month = stringToInt(str + 5, 2);
+	if (month == 0)
+		month = 1;
+	int day = stringToInt(str + 8, 2);
+	if (day == 0)
+		day = 1;
+
+	return QDate(year, month, day).toJulianDay();
+}
+
+bool resultMatches(const Chess::Result& result,
+		   const PgnGameFilter& filter,
+		   int whitePlayer)
+{
+	int winner = 0;
+	if (!result.winner().isNull())
+	{
+		if (whitePlayer == 1)
+			winner = result.winner() + 1;
+		else if (result.winner() == Chess::Side::White)
+			winner = 2;
+		else
+			winner = 1;
+	}
+
+	bool ok;
+	switch (filter.result())
+	{
+	case PgnGameFilter::EitherPlayerWins:
+		ok = !result.winner().isNull();
+		break;
+	case PgnGameFilter::WhiteWins:
+		ok = result.winner() == Chess::Side::White;
+		break;
+	case PgnGameFilter::BlackWins:
+		ok = result.winner() == Chess::Side::Black;
+		break;
+	case PgnGameFilter::FirstPlayerWins:
+		ok = winner == 1;
+		break;
+	case PgnGameFilter::FirstPlayerLoses:
+		ok = winner == 2;
+		break;
+	case PgnGameFilter::Draw:
+		ok = result.isDraw();
+		break;
+	case PgnGameFilter::Unfinished:
+		ok = result.isNone();
+		break;
+	default:
+		ok = true;
+		break;
+	}
+
+	return ok != filter.isResultInverted();
+}
+
+QVector<quint8> containsTable(const QVector<QByteArray>& values,
+			      const QByteArray& pattern)
+{
+	QVector<quint8> table;
+	if (pattern.isEmpty())
+		return table;
+
+	const QByteArray upperPattern(pattern.toUpper());
+	table.reserve(values.size());
+	for (const QByteArray& value : values)
+		table.append(value.contains(upperPattern));
+
+	return table;
+}
+
+} // anonymous namespace
+
+PgnTagIndex::Query::Query(const PgnTagIndex& index,
+			  const PgnGameFilter& filter)
+	: m_index(&index),
+	  m_fixedString(filter.type() == PgnGameFilter::FixedString),
+	  m_matchAll(false),
+	  m_playerSide(filter.playerSide()),
+	  m_playerLength(qstrlen(filter.player())),
+	  m_opponentLength(qstrlen(filter.opponent()))
+{
+	if (m_fixedString)
+	{
+		// An empty pattern matches every entry
+		const QByteArray pattern(filter.pattern());
+		m_matchAll = pattern.isEmpty();
+		if (m_matchAll)
+			return;
+
+		for (int tag = 0; tag < TagCount; tag++)
+		{
+			if (tag == dictionary(tag))
+			{
+				const Dictionary& dict = index.m_dictionaries[tag];
+				m_tables[tag] = containsTable(dict.upperValues, pattern);
+			}
+		}
+		return;
+	}
+
+	const Dictionary* dicts = index.m_dictionaries;
+	m_tables[PgnGameEntry::EventTag] =
+		containsTable(dicts[PgnGameEntry::EventTag].upperValues,
+			      filter.event());
+	m_tables[PgnGameEntry::SiteTag] =
+		containsTable(dicts[PgnGameEntry::SiteTag].upperValues,
+			      filter.site());
+
+	if (!filter.minDate().isNull() || !filter.maxDate().isNull())
+	{
+		const qint64 minDate = filter.minDate().isNull()
+			? 0 : filter.minDate().toJulianDay();
+		const qint64 maxDate = filter.maxDate().isNull()
+			? 0 : filter.maxDate().toJulianDay();
+		QVector<quint8>& table = m_tables[PgnGameEntry::DateTag];
+		for (qint64 date : index.m_dates)
+		{
+			table.append(date != NoDate
+				  && (filter.minDate().isNull() || date >= minDate)
+				  && (filter.maxDate().isNull() || date <= maxDate));
+		}
+	}
+
+	if (filter.minRound() != 0 || filter.maxRound() != 0)
+	{
+		QVector<quint8>& table = m_tables[PgnGameEntry::RoundTag];
+		for (int round : index.m_rounds)
+		{
+			table.append(round != 0
+				  && (filter.minRound() == 0 || round >= filter.minRound())
+				  && (filter.maxRound() == 0 || round <= filter.maxRound()));
+		}
+	}
+
+	// The players of both colors share a dictionary and a table
+	const QByteArray player(filter.player());
+	const QByteArray opponent(filter.opponent());
+	if (!player.isEmpty() || !opponent.isEmpty())
+	{
+		const QByteArray upperPlayer(player.toUpper());
+		const QByteArray upperOpponent(opponent.toUpper());
+		QVector<quint8>& table = m_tables[PgnGameEntry::WhiteTag];
+		for (const QByteArray& value : dicts[PgnGameEntry::WhiteTag].upperValues)
+		{
+			quint8 bits = 0;
+			if (value.contains(upperPlayer))
+				bits |= PlayerMatches;
+			if (value.contains(upperOpponent))
+				bits |= OpponentMatches;
+			table.append(bits);
+		}
+	}
+
+	if (filter.result() != PgnGameFilter::AnyResult)
+	{
+		QVector<quint8>& table = m_tables[PgnGameEntry::ResultTag];
+		for (const Chess::Result& result : index.m_results)
+		{
+			quint8 bits = 0;
+			if (resultMatches(result, filter, 1))
+				bits |= WhiteIsFirstMatches;
+			if (resultMatches(result, filter, 2))
+				bits |= BlackIsFirstMatches;
+			table.append(bits);
+		}
+	}
+}
+
+bool PgnTagIndex::Query::match(int entry) const
+{
+	return m_fixedString ? matchAny(entry) : matchAdvanced(entry);
+}
+
+bool PgnTagIndex::Query::matchAny(int entry) const
+{
+	if (m_matchAll)
+		return true;
+
+	for (int tag = 0; tag < TagCount; tag++)
+	{
+		const QVector<quint8>& table = m_tables[dictionary(tag)];
+		if (table.at(m_index->m_columns[tag].at(entry)))
+			return true;
+	}
+
+	return false;
+}
+
+bool PgnTagIndex::Query::matchAdvanced(int entry) const
+{
+	const QVector<quint32>* columns = m_index->m_columns;
+	for (int tag = PgnGameEntry::EventTag; tag <= PgnGameEntry::RoundTag; tag++)
+	{
+		const QVector<quint8>& table = m_tables[tag];
+		if (!table.isEmpty() && !table.at(columns[tag].at(entry)))
+			return false;
+	}
+
+	// The first player is the one whose name matches best, like
+	// in PgnGameEntry::match()
+	int whitePlayer = 1;
+	const QVector<quint8>& players = m_tables[PgnGameEntry::WhiteTag];
+	if (!players.isEmpty())
+	{
+		const quint8 white = players.at(columns[PgnGameEntry::WhiteTag].at(entry));
+		const quint8 black = players.at(columns[PgnGameEntry::BlackTag].at(entry));
+
+		int len1 = -1;
+		int len2 = -1;
+		if (m_playerSide != Chess::Side::Black && (white & PlayerMatches))
+			len1 = m_playerLength;
+		if (m_playerSide != Chess::Side::White && (white & OpponentMatches))
+			len2 = m_opponentLength;
+		if (len1 == -1 && len2 == -1)
+			return false;
+		whitePlayer = (len1 >= len2) ? 1 : 2;
+
+		len1 = -1;
+		len2 = -1;
+		if (m_playerSide != Chess::Side::White && whitePlayer != 1
+		&&  (black & PlayerMatches))
+			len1 = m_playerLength;
+		if (m_playerSide != Chess::Side::Black && whitePlayer != 2
+		&&  (black & OpponentMatches))
+			len2 = m_opponentLength;
+		if (len1 == -1 && len2 == -1)
+			return false;
+	}
+	else if (m_playerSide == Chess::Side::Black)
+		whitePlayer = 2;
+
+	const QVector<quint8>& results = m_tables[PgnGameEntry::ResultTag];
+	if (!results.isEmpty())
+	{
+		const quint8 bits = results.at(columns[PgnGameEntry::ResultTag].at(entry));
+		if (!(bits & (whitePlayer == 1 ? WhiteIsFirstMatches
+					       : BlackIsFirstMatches)))
+			return false;
+	}
+
+	return true;
+}
+
+
+PgnTagIndex::PgnTagIndex()
+{
+}
+
+int PgnTagIndex::dictionary(int tag)
+{
+	return tag == PgnGameEntry::BlackTag ? int(PgnGameEntry::WhiteTag) : tag;
+}
+
+void PgnTagIndex::build(const QList<const PgnGameEntry*>& entries)
+{
+	clear();
+
+	QHash<QByteArray, quint32> ids[TagCount];
+	for (int tag = 0; tag < TagCount; tag++)
+		m_columns[tag].reserve(entries.size());
+
+	for (const PgnGameEntry* entry : entries)
+	{
+		for (int tag = 0; tag < TagCount; tag++)
+		{
+			const int dict = dictionary(tag);
+			const QByteArray value(entry->rawTagValue(PgnGameEntry::TagType(tag)));
+			QHash<QByteArray, quint32>::const_iterator it(ids[dict].constFind(value));
+
+			quint32 id;
+			if (it != ids[dict].constEnd())
+				id = it.value();
+			else
+			{
+				// The lookup key only refers to the packed tags,
+				// so the dictionary keeps a deep copy
+				const QByteArray copy(value.constData(), value.size());
+				id = quint32(m_dictionaries[dict].values.size());
+				ids[dict].insert(copy, id);
+				m_dictionaries[dict].values.append(copy);
+				m_dictionaries[dict].upperValues.append(copy.toUpper());
+			}
+			m_columns[tag].append(id);
+		}
+	}
+
+	for (const QByteArray& value : qAsConst(m_dictionaries[PgnGameEntry::DateTag].values))
+		m_dates.append(parseDate(value));
+	for (const QByteArray& value : qAsConst(m_dictionaries[PgnGameEntry::RoundTag].values))
+		m_rounds.append(stringToInt(value.constData(), value.size()));
+	for (const QByteArray& value : qAsConst(m_dictionaries[PgnGameEntry::ResultTag].values))
+		m_results.append(Chess::Result(QString::fromLatin1(value)));
+}
+
+void PgnTagIndex::clear()
+{
+	for (int tag = 0; tag < TagCount; tag++)
+	{
+		m_columns[tag].clear();
+		m_dictionaries[tag].values.clear();
+		m_dictionaries[tag].upperValues.clear();
+	}
+	m_dates.clear();
+	m_rounds.clear();
+	m_results.clear();
+}
+
+int PgnTagIndex::size() const
+{
+	return m_columns[0].size();
+}
+
+int PgnTagIndex::valueCount(PgnGameEntry::TagType type) const
+{
+	return m_dictionaries[dictionary(type)].values.size();
+}
+
+quint32 PgnTagIndex::valueId(int entry, PgnGameEntry::TagType type) const
+{
+	return m_columns[type].at(entry);
+}
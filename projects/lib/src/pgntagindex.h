@@ -0,0 +1,115 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNTAGINDEX_H
+#define PGNTAGINDEX_H
+
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+#include "pgngameentry.h"
+class PgnGameFilter;
+
+/*!
+ * \brief A column-wise copy of the tags of PGN game entries
+ *
+ * PgnTagIndex stores the tags of a list of PgnGameEntry objects
+ * column by column. Every distinct tag value is stored only once in
+ * a dictionary, and the columns hold dictionary ids. The players of
+ * both colors share one dictionary. Dates, rounds and results are
+ * parsed once when the dictionaries are built.
+ *
+ * A Query evaluates a PgnGameFilter against every dictionary value
+ * up front, so matching an entry only takes a few table lookups
+ * instead of parsing and searching the packed tags of the entry.
+ *
+ * \sa PgnGameEntry::match()
+ */
+class LIB_EXPORT PgnTagIndex
+{
+	public:
+		/*! A PgnGameFilter prepared for matching the entries of an index. */
+		class LIB_EXPORT Query
+		{
+			public:
+				/*!
+				 * Creates a new query for the entries of \a index
+				 * that match \a filter.
+				 *
+				 * The index must not change while the query is used.
+				 */
+				Query(const PgnTagIndex& index, const PgnGameFilter& filter);
+
+				/*!
+				 * Returns true if entry \a entry of the index
+				 * matches the filter.
+				 */
+				bool match(int entry) const;
+
+			private:
+				bool matchAny(int entry) const;
+				bool matchAdvanced(int entry) const;
+
+				const PgnTagIndex* m_index;
+				bool m_fixedString;
+				bool m_matchAll;
+				Chess::Side m_playerSide;
+				int m_playerLength;
+				int m_opponentLength;
+				// One value per dictionary id. Empty tables
+				// match every value.
+				QVector<quint8> m_tables[PgnGameEntry::VariantTag + 1];
+		};
+
+		/*! Creates a new empty index. */
+		PgnTagIndex();
+
+		/*! Replaces the contents of the index with the tags of \a entries. */
+		void build(const QList<const PgnGameEntry*>& entries);
+		/*! Removes every entry from the index. */
+		void clear();
+
+		/*! Returns the number of entries. */
+		int size() const;
+		/*! Returns the number of distinct values of tag \a type. */
+		int valueCount(PgnGameEntry::TagType type) const;
+		/*! Returns the dictionary id of tag \a type of \a entry. */
+		quint32 valueId(int entry, PgnGameEntry::TagType type) const;
+
+	private:
+		enum
+		{
+			TagCount = PgnGameEntry::VariantTag + 1
+		};
+
+		struct Dictionary
+		{
+			QVector<QByteArray> values;
+			QVector<QByteArray> upperValues;
+		};
+
+		static int dictionary(int tag);
+
+		QVector<quint32> m_columns[TagCount];
+		Dictionary m_dictionaries[TagCount];
+		QVector<qint64> m_dates;
+		QVector<int> m_rounds;
+		QVector<Chess::Result> m_results;
+};
+
+#endif // PGNTAGINDEX_H
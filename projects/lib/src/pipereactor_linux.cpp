@@ -0,0 +1,322 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pipereactor_linux.h"
+#include <QGlobalStatic>
+#include <QMutexLocker>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "timecontrol.h"
+
+Q_GLOBAL_STATIC(PipeReactor, s_pipeReactor)
+
+
+PipeReactor::Channel::Channel(int fd, QObject* receiver, const char* method)
+	: m_fd(fd),
+	  m_receiver(receiver),
+	  m_method(method),
+	  m_partialNs(-1),
+	  m_watched(false),
+	  m_eof(false),
+	  m_notified(0),
+	  m_stalled(0),
+	  m_finished(0)
+{
+	Q_ASSERT(receiver != nullptr);
+	Q_ASSERT(method != nullptr);
+}
+
+int PipeReactor::Channel::fd() const
+{
+	return m_fd;
+}
+
+bool PipeReactor::Channel::takeLine(QByteArray* line, qint64* timestampNs)
+{
+	return m_queue.pop(line, timestampNs);
+}
+
+bool PipeReactor::Channel::isFinished() const
+{
+	return m_finished.loadAcquire() != 0;
+}
+
+void PipeReactor::Channel::acknowledge()
+{
+	m_notified.fetchAndStoreOrdered(0);
+}
+
+
+PipeReactor* PipeReactor::instance()
+{
+	return s_pipeReactor();
+}
+
+PipeReactor::PipeReactor()
+	: QThread(),
+	  m_epollFd(epoll_create1(EPOLL_CLOEXEC)),
+	  m_wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+	  m_quit(false)
+{
+	if (m_epollFd == -1 || m_wakeFd == -1)
+	{
+		qWarning("Cannot create the pipe reactor: %s", strerror(errno));
+		return;
+	}
+
+	// The wake-up descriptor is the only one without a channel
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = nullptr;
+	epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+	start();
+}
+
+PipeReactor::~PipeReactor()
+{
+	m_mutex.lock();
+	m_quit = true;
+	m_mutex.unlock();
+
+	wake();
+	wait();
+
+	if (m_wakeFd != -1)
+		::close(m_wakeFd);
+	if (m_epollFd != -1)
+		::close(m_epollFd);
+}
+
+bool PipeReactor::add(Channel* channel)
+{
+	Q_ASSERT(channel != nullptr);
+
+	if (m_epollFd == -1 || m_wakeFd == -1)
+		return false;
+
+	const int flags = fcntl(channel->m_fd, F_GETFL);
+	if (flags == -1 || fcntl(channel->m_fd, F_SETFL, flags | O_NONBLOCK) == -1)
+		return false;
+
+	QMutexLocker locker(&m_mutex);
+	if (!watch(channel, true))
+		return false;
+	m_channels.insert(channel);
+
+	return true;
+}
+
+void PipeReactor::remove(Channel* channel)
+{
+	Q_ASSERT(channel != nullptr);
+
+	QMutexLocker locker(&m_mutex);
+	watch(channel, false);
+	m_channels.remove(channel);
+	m_resumed.remove(channel);
+}
+
+void PipeReactor::resume(Channel* channel)
+{
+	Q_ASSERT(channel != nullptr);
+
+	// The flag is taken here, so the reactor knows that it has
+	// to come back to the channel
+	if (!channel->m_stalled.testAndSetOrdered(1, 0))
+		return;
+
+	m_mutex.lock();
+	m_resumed.insert(channel);
+	m_mutex.unlock();
+
+	wake();
+}
+
+void PipeReactor::wake()
+{
+	if (m_wakeFd == -1)
+		return;
+
+	const quint64 value = 1;
+	if (::write(m_wakeFd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+		qWarning("Cannot wake the pipe reactor: %s", strerror(errno));
+}
+
+bool PipeReactor::watch(Channel* channel, bool enabled)
+{
+	if (channel->m_watched == enabled)
+		return true;
+
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = channel;
+	if (epoll_ctl(m_epollFd, enabled ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+		      channel->m_fd, &event) == -1)
+	{
+		qWarning("Cannot %s pipe %d in the reactor: %s",
+			 enabled ? "watch" : "unwatch",
+			 channel->m_fd, strerror(errno));
+		return false;
+	}
+
+	channel->m_watched = enabled;
+	return true;
+}
+
+void PipeReactor::run()
+{
+	epoll_event events[MaxEvents];
+
+	for (;;)
+	{
+		const int count = epoll_wait(m_epollFd, events, MaxEvents, -1);
+		if (count == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			qWarning("The pipe reactor failed: %s", strerror(errno));
+			return;
+		}
+
+		QMutexLocker locker(&m_mutex);
+		for (int i = 0; i < count; i++)
+		{
+			auto channel = static_cast<Channel*>(events[i].data.ptr);
+			if (channel == nullptr)
+			{
+				quint64 value;
+				while (::read(m_wakeFd, &value, sizeof(value)) > 0)
+					;
+			}
+			// The channel may have been removed after the events
+			// were returned
+			else if (m_channels.contains(channel))
+				read(channel);
+		}
+
+		if (m_quit)
+			return;
+
+		for (Channel* channel : qAsConst(m_resumed))
+			queueLines(channel);
+		m_resumed.clear();
+	}
+}
+
+void PipeReactor::read(Channel* channel)
+{
+	// One read per pipe and round is enough with level-triggered
+	// events, and a chatty engine can't starve the others
+	ssize_t n;
+	do
+		n = ::read(channel->m_fd, m_buffer, BufSize);
+	while (n == -1 && errno == EINTR);
+
+	if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return;
+
+	if (n > 0)
+	{
+		channel->m_partialNs = TimeControl::monotonicNs();
+		channel->m_partial.append(m_buffer, int(n));
+	}
+	else
+	{
+		// The pipe was closed, or it's broken
+		channel->m_eof = true;
+		watch(channel, false);
+	}
+
+	queueLines(channel);
+}
+
+void PipeReactor::queueLines(Channel* channel)
+{
+	if (channel->m_finished.load() != 0)
+		return;
+
+	const QByteArray& data = channel->m_partial;
+	bool queued = false;
+	int pos = 0;
+
+	for (;;)
+	{
+		// Lines keep their newlines, so the receiver gets the
+		// exact output of the process
+		bool full = false;
+		while (pos < data.size())
+		{
+			const char* start = data.constData() + pos;
+			const char* end = static_cast<const char*>(
+				memchr(start, '\n', size_t(data.size() - pos)));
+
+			int length = data.size() - pos;
+			if (end != nullptr)
+				length = int(end - start) + 1;
+			else if (!channel->m_eof)
+				break;
+
+			if (!channel->m_queue.push(data.mid(pos, length),
+						   channel->m_partialNs))
+			{
+				full = true;
+				break;
+			}
+			queued = true;
+			pos += length;
+		}
+
+		if (!full)
+		{
+			if (!channel->m_eof)
+				watch(channel, true);
+			break;
+		}
+
+		// Stop reading until the receiver has made room. If it
+		// already did so, there's no need to wait.
+		if (!channel->m_eof)
+			watch(channel, false);
+		channel->m_stalled.fetchAndStoreOrdered(1);
+		if (channel->m_queue.isFull()
+		||  !channel->m_stalled.testAndSetOrdered(1, 0))
+			break;
+	}
+
+	if (pos > 0)
+		channel->m_partial.remove(0, pos);
+
+	if (channel->m_eof
+	&&  channel->m_partial.isEmpty()
+	&&  channel->m_stalled.load() == 0)
+	{
+		channel->m_finished.storeRelease(1);
+		queued = true;
+	}
+
+	if (queued && channel->m_notified.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(channel->m_receiver, channel->m_method,
+					  Qt::QueuedConnection);
+}
@@ -0,0 +1,147 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPEREACTOR_LINUX_H
+#define PIPEREACTOR_LINUX_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QMutex>
+#include <QSet>
+#include <QAtomicInt>
+#include "linequeue.h"
+
+/*!
+ * \brief A thread that reads the output of every engine process
+ *
+ * Instead of one reader per engine, or a pipe notifier in each game
+ * thread, all the pipes are watched by a single epoll loop. Output
+ * is read as soon as it arrives, split into lines and timestamped
+ * right there, so the time an engine's move waits for a busy game
+ * thread isn't charged to the engine.
+ *
+ * Complete lines are passed on in a LineQueue, and the receiver of
+ * the channel is notified with a queued call. The game logic stays
+ * on the game threads. If a receiver falls so far behind that its
+ * queue fills up, the reactor stops reading its pipe until the
+ * receiver calls resume().
+ *
+ * All processes share the same reactor, which is returned by
+ * instance().
+ *
+ * \note This class is for Linux only
+ * \sa EngineProcess
+ */
+class LIB_EXPORT PipeReactor : public QThread
+{
+	public:
+		/*! The read end of a pipe served by the reactor. */
+		class Channel
+		{
+			public:
+				/*!
+				 * Creates a channel for the non-blocking file
+				 * descriptor \a fd. Slot \a method of \a receiver
+				 * is called when new lines are queued, or when
+				 * the pipe is closed.
+				 */
+				Channel(int fd, QObject* receiver, const char* method);
+
+				/*! Returns the file descriptor of the pipe. */
+				int fd() const;
+				/*!
+				 * Takes the next line from the queue.
+				 * Returns false if there are no lines.
+				 */
+				bool takeLine(QByteArray* line, qint64* timestampNs);
+				/*!
+				 * Returns true if the pipe was closed and every
+				 * line has been queued.
+				 */
+				bool isFinished() const;
+				/*!
+				 * Allows a new notification. The receiver calls
+				 * this before it takes the lines.
+				 */
+				void acknowledge();
+
+			private:
+				friend class PipeReactor;
+
+				int m_fd;
+				QObject* m_receiver;
+				const char* m_method;
+				LineQueue m_queue;
+				QByteArray m_partial;
+				qint64 m_partialNs;
+				bool m_watched;
+				bool m_eof;
+				QAtomicInt m_notified;
+				QAtomicInt m_stalled;
+				QAtomicInt m_finished;
+		};
+
+		/*! Returns the shared pipe reactor. */
+		static PipeReactor* instance();
+
+		/*! Creates a new reactor and starts its thread. */
+		PipeReactor();
+		/*! Stops the reactor thread. */
+		virtual ~PipeReactor();
+
+		/*! Starts reading the pipe of \a channel. */
+		bool add(Channel* channel);
+		/*!
+		 * Stops reading the pipe of \a channel.
+		 *
+		 * When this function returns the reactor doesn't use
+		 * \a channel anymore, so it can be destroyed.
+		 */
+		void remove(Channel* channel);
+		/*!
+		 * Resumes reading the pipe of \a channel after its
+		 * receiver has made room in the queue. Does nothing if
+		 * the reactor didn't stop reading the pipe.
+		 *
+		 * The receiver calls this after taking the lines.
+		 */
+		void resume(Channel* channel);
+
+	protected:
+		// Inherited from QThread
+		virtual void run();
+
+	private:
+		static const int BufSize = 0x10000;
+		static const int MaxEvents = 64;
+
+		bool watch(Channel* channel, bool enabled);
+		void read(Channel* channel);
+		void queueLines(Channel* channel);
+		void wake();
+
+		int m_epollFd;
+		int m_wakeFd;
+		bool m_quit;
+		QSet<Channel*> m_channels;
+		QSet<Channel*> m_resumed;
+		QMutex m_mutex;
+		char m_buffer[BufSize];
+};
+
+#endif // PIPEREACTOR_LINUX_H
@@ -30,6 +30,21 @@ PlayerBuilder::~PlayerBuilder()
 {
 }
 
+bool PlayerBuilder::isReusable() const
+{
+	return !isHuman();
+}
+
+int PlayerBuilder::cpuCount() const
+{
+	return 0;
+}
+
+bool PlayerBuilder::isPondering() const
+{
+	return false;
+}
+
 QString PlayerBuilder::name() const
 {
 	return m_name;
@@ -48,6 +48,33 @@ class LIB_EXPORT PlayerBuilder
 		 * otherwise returns false.
 		 */
 		virtual bool isHuman() const = 0;
+		/*!
+		 * Returns true if the players created by the builder can be
+		 * kept alive between games and reused against any opponent.
+		 *
+		 * The default implementation returns true for players that
+		 * aren't human.
+		 *
+		 * \sa GameManager::setPlayerPoolSize()
+		 */
+		virtual bool isReusable() const;
+		/*!
+		 * Returns the number of CPUs a player needs while it's
+		 * thinking.
+		 *
+		 * The default implementation returns 0, which means that the
+		 * player doesn't need CPUs of its own.
+		 *
+		 * \sa GameManager::setCpuAffinity()
+		 */
+		virtual int cpuCount() const;
+		/*!
+		 * Returns true if the players also think on their
+		 * opponent's time; otherwise returns false.
+		 *
+		 * The default implementation returns false.
+		 */
+		virtual bool isPondering() const;
 		/*! Returns the player's name. */
 		QString name() const;
 		/*! Sets the player's name to \a name. */
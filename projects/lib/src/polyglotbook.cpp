@@ -18,6 +18,7 @@
 
 #include "polyglotbook.h"
 #include <QDataStream>
+#include <QtEndian>
 
 namespace {
 
@@ -36,7 +37,14 @@ Chess::GenericMove moveFromBits(quint16 pgMove)
 	return Chess::GenericMove(source, target, promotion);
 }
 
-quint16 moveToBits(const Chess::GenericMove& move)
+} // anonymous namespace
+
+PolyglotBook::PolyglotBook(AccessMode mode)
+	: OpeningBook(mode)
+{
+}
+
+quint16 PolyglotBook::moveToBits(const Chess::GenericMove& move)
 {
 	using Chess::Square;
 	
@@ -52,13 +60,6 @@ quint16 moveToBits(const Chess::GenericMove& move)
 	return target | source | promotion;
 }
 
-} // anonymous namespace
-
-PolyglotBook::PolyglotBook(AccessMode mode)
-	: OpeningBook(mode)
-{
-}
-
 int PolyglotBook::entrySize() const
 {
 	return 16;
@@ -88,3 +89,19 @@ void PolyglotBook::writeEntry(const Map::const_iterator& it,
 	// Store the data. Again, big-endian is used by default.
 	out << key << pgMove << weight << learn;
 }
+
+OpeningBook::Entry PolyglotBook::entryFromData(const uchar* data,
+					       quint64* key) const
+{
+	// The same big-endian layout that readEntry() reads
+	*key = qFromBigEndian<quint64>(data);
+	quint16 pgMove = qFromBigEndian<quint16>(data + 8);
+	quint16 weight = qFromBigEndian<quint16>(data + 10);
+
+	return { moveFromBits(pgMove), weight };
+}
+
+quint64 PolyglotBook::keyFromData(const uchar* data) const
+{
+	return qFromBigEndian<quint64>(data);
+}
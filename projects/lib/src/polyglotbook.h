@@ -36,12 +36,17 @@ class LIB_EXPORT PolyglotBook: public OpeningBook
 		/*! Creates a new PolyglotBook with access mode \a mode. */
 		PolyglotBook(AccessMode mode = Ram);
 
+		/*! Returns \a move in the 16-bit encoding of Polyglot books. */
+		static quint16 moveToBits(const Chess::GenericMove& move);
+
 	protected:
 		// Inherited from OpeningBook
 		virtual int entrySize() const;
 		virtual Entry readEntry(QDataStream& in, quint64* key) const;
 		virtual void writeEntry(const Map::const_iterator& it,
 					QDataStream& out) const;
+		virtual Entry entryFromData(const uchar* data, quint64* key) const;
+		virtual quint64 keyFromData(const uchar* data) const;
 };
 
 #endif // POLYGLOT_BOOK_H
@@ -0,0 +1,669 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "polyglotbookbuilder.h"
+#include <algorithm>
+#include <climits>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QRunnable>
+#include <QThread>
+#include <QtEndian>
+#include <QtDebug>
+#include "polyglotbook.h"
+#include "pgngame.h"
+#include "pgnstream.h"
+
+namespace {
+
+const qint64 DefaultMemoryLimit = 256 * 1024 * 1024;
+const int MinRecords = 1024;
+const qint64 ChunkSize = 4 * 1024 * 1024;
+const int RunBufferSize = 8192;
+const int OutputBufferSize = 64 * 1024;
+const int EntrySize = 16;
+const quint32 MaxWeight = 0xFFFF;
+
+/*
+ * Returns the position after the last game boundary in \a data, or
+ * -1 if there is none. A game starts with a tag after an empty line.
+ */
+int gameBoundary(const QByteArray& data)
+{
+	for (int pos = data.lastIndexOf("\n[");
+	     pos > 0;
+	     pos = data.lastIndexOf("\n[", pos - 1))
+	{
+		int i = pos - 1;
+		if (data.at(i) == '\r' && i > 0)
+			i--;
+		if (data.at(i) == '\n')
+			return pos + 1;
+	}
+
+	return -1;
+}
+
+} // anonymous namespace
+
+
+class PolyglotBookBuilder::Job : public QRunnable
+{
+	public:
+		Job(PolyglotBookBuilder* builder, const QByteArray& data);
+		Job(PolyglotBookBuilder* builder,
+		    const QString& fileName,
+		    const QVector<qint64>& offsets);
+
+		// Inherited from QRunnable
+		virtual void run();
+
+	private:
+		bool addGame(PgnStream& in, QVector<Record>& records);
+
+		PolyglotBookBuilder* m_builder;
+		QByteArray m_data;
+		QString m_fileName;
+		QVector<qint64> m_offsets;
+};
+
+PolyglotBookBuilder::Job::Job(PolyglotBookBuilder* builder,
+			      const QByteArray& data)
+	: m_builder(builder),
+	  m_data(data)
+{
+}
+
+PolyglotBookBuilder::Job::Job(PolyglotBookBuilder* builder,
+			      const QString& fileName,
+			      const QVector<qint64>& offsets)
+	: m_builder(builder),
+	  m_fileName(fileName),
+	  m_offsets(offsets)
+{
+}
+
+bool PolyglotBookBuilder::Job::addGame(PgnStream& in,
+				       QVector<Record>& records)
+{
+	PgnGame game;
+	if (!game.read(in, m_builder->m_maxMoves, false))
+		return false;
+
+	gameRecords(game, m_builder->m_maxMoves, records);
+	return true;
+}
+
+void PolyglotBookBuilder::Job::run()
+{
+	// Every worker collects the records of its chunk locally, so
+	// the builder is only locked once per chunk
+	QVector<Record> records;
+	int gameCount = 0;
+
+	if (m_fileName.isEmpty())
+	{
+		PgnStream in(&m_data);
+		while (in.status() == PgnStream::Ok
+		&&     !m_builder->m_canceled.load())
+		{
+			if (addGame(in, records))
+				gameCount++;
+		}
+	}
+	else if (!m_builder->m_canceled.load())
+	{
+		QFile file(m_fileName);
+		if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			PgnStream in(&file);
+			for (qint64 pos : qAsConst(m_offsets))
+			{
+				if (m_builder->m_canceled.load())
+					break;
+				if (in.seek(pos) && addGame(in, records))
+					gameCount++;
+			}
+		}
+		else
+			qWarning("Could not open PGN file %s",
+				 qUtf8Printable(m_fileName));
+	}
+
+	m_builder->addRecords(records, gameCount);
+	m_builder->m_jobSlots.release();
+}
+
+
+/*
+ * Reads the records of a sorted run, either from memory or in
+ * blocks from a temporary file.
+ */
+class PolyglotBookBuilder::RunReader
+{
+	public:
+		explicit RunReader(const QVector<Record>& records);
+		explicit RunReader(QIODevice* device);
+
+		bool atEnd() const;
+		bool hasError() const;
+		const Record& current() const;
+		void next();
+
+	private:
+		void fill();
+
+		QIODevice* m_device;
+		QVector<Record> m_buffer;
+		const Record* m_data;
+		int m_pos;
+		int m_size;
+		bool m_error;
+};
+
+PolyglotBookBuilder::RunReader::RunReader(const QVector<Record>& records)
+	: m_device(nullptr),
+	  m_data(records.constData()),
+	  m_pos(0),
+	  m_size(records.size()),
+	  m_error(false)
+{
+}
+
+PolyglotBookBuilder::RunReader::RunReader(QIODevice* device)
+	: m_device(device),
+	  m_buffer(RunBufferSize),
+	  m_data(nullptr),
+	  m_pos(0),
+	  m_size(0),
+	  m_error(!device->seek(0))
+{
+	if (!m_error)
+		fill();
+}
+
+bool PolyglotBookBuilder::RunReader::atEnd() const
+{
+	return m_pos >= m_size;
+}
+
+bool PolyglotBookBuilder::RunReader::hasError() const
+{
+	return m_error;
+}
+
+const PolyglotBookBuilder::Record& PolyglotBookBuilder::RunReader::current() const
+{
+	Q_ASSERT(!atEnd());
+	return m_data[m_pos];
+}
+
+void PolyglotBookBuilder::RunReader::next()
+{
+	if (++m_pos >= m_size && m_device != nullptr)
+		fill();
+}
+
+void PolyglotBookBuilder::RunReader::fill()
+{
+	m_data = m_buffer.constData();
+	m_pos = 0;
+	m_size = 0;
+
+	const qint64 bytes = sizeof(Record) * m_buffer.size();
+	const qint64 n = m_device->read(reinterpret_cast<char*>(m_buffer.data()),
+					bytes);
+	if (n < 0 || n % sizeof(Record) != 0)
+	{
+		m_error = true;
+		return;
+	}
+	m_size = int(n / sizeof(Record));
+}
+
+
+/*
+ * Writes sorted records to a Polyglot book. Duplicate moves are
+ * summed, and the moves of each position are ordered by weight.
+ */
+class PolyglotBookBuilder::BookWriter
+{
+	public:
+		explicit BookWriter(QIODevice* device);
+
+		void add(const Record& record);
+		bool finish();
+
+	private:
+		static bool heavier(const Record& r1, const Record& r2);
+		void writeKey();
+		void flush();
+
+		QIODevice* m_device;
+		QVector<Record> m_moves;
+		QByteArray m_buffer;
+		bool m_ok;
+};
+
+PolyglotBookBuilder::BookWriter::BookWriter(QIODevice* device)
+	: m_device(device),
+	  m_ok(true)
+{
+	m_buffer.reserve(OutputBufferSize + EntrySize);
+}
+
+bool PolyglotBookBuilder::BookWriter::heavier(const Record& r1,
+					      const Record& r2)
+{
+	return r1.weight > r2.weight;
+}
+
+void PolyglotBookBuilder::BookWriter::add(const Record& record)
+{
+	if (!m_moves.isEmpty())
+	{
+		Record& last = m_moves.last();
+		if (last.key != record.key)
+			writeKey();
+		else if (last.move == record.move)
+		{
+			last.weight = qMin(MaxWeight, quint32(last.weight) + record.weight);
+			return;
+		}
+	}
+
+	m_moves.append(record);
+}
+
+void PolyglotBookBuilder::BookWriter::writeKey()
+{
+	std::stable_sort(m_moves.begin(), m_moves.end(), heavier);
+
+	for (const Record& record : qAsConst(m_moves))
+	{
+		uchar entry[EntrySize];
+		qToBigEndian<quint64>(record.key, entry);
+		qToBigEndian<quint16>(record.move, entry + 8);
+		qToBigEndian<quint16>(record.weight, entry + 10);
+		qToBigEndian<quint32>(0, entry + 12);
+		m_buffer.append(reinterpret_cast<const char*>(entry), EntrySize);
+	}
+	m_moves.clear();
+
+	if (m_buffer.size() >= OutputBufferSize)
+		flush();
+}
+
+void PolyglotBookBuilder::BookWriter::flush()
+{
+	if (m_ok && m_device->write(m_buffer) != m_buffer.size())
+	{
+		qWarning("Could not write opening book: %s",
+			 qUtf8Printable(m_device->errorString()));
+		m_ok = false;
+	}
+	m_buffer.resize(0);
+}
+
+bool PolyglotBookBuilder::BookWriter::finish()
+{
+	if (!m_moves.isEmpty())
+		writeKey();
+	flush();
+
+	return m_ok;
+}
+
+
+PolyglotBookBuilder::PolyglotBookBuilder(int maxMoves)
+	: m_maxMoves(maxMoves),
+	  m_maxRecords(MinRecords),
+	  m_failed(false),
+	  m_gameCount(0),
+	  m_canceled(0),
+	  m_jobSlotCount(0)
+{
+	Q_ASSERT(maxMoves > 0);
+
+	setThreadCount(QThread::idealThreadCount());
+	setMemoryLimit(DefaultMemoryLimit);
+}
+
+PolyglotBookBuilder::~PolyglotBookBuilder()
+{
+	waitForDone();
+	qDeleteAll(m_runs);
+}
+
+int PolyglotBookBuilder::maxMoves() const
+{
+	return m_maxMoves;
+}
+
+int PolyglotBookBuilder::threadCount() const
+{
+	return m_pool.maxThreadCount();
+}
+
+void PolyglotBookBuilder::setThreadCount(int count)
+{
+	count = qMax(1, count);
+	m_pool.setMaxThreadCount(count);
+
+	// Keep up to two chunks per thread waiting in the queue
+	const int slotCount = count * 2;
+	if (slotCount > m_jobSlotCount)
+		m_jobSlots.release(slotCount - m_jobSlotCount);
+	else
+		m_jobSlots.acquire(m_jobSlotCount - slotCount);
+	m_jobSlotCount = slotCount;
+}
+
+qint64 PolyglotBookBuilder::memoryLimit() const
+{
+	// The radix sort needs a second buffer of the same size
+	return qint64(m_maxRecords) * 2 * sizeof(Record);
+}
+
+void PolyglotBookBuilder::setMemoryLimit(qint64 bytes)
+{
+	const qint64 count = bytes / (2 * sizeof(Record));
+	m_maxRecords = int(qBound(qint64(MinRecords), count, qint64(INT_MAX / 2)));
+}
+
+int PolyglotBookBuilder::gameRecords(const PgnGame& game,
+				     int maxMoves,
+				     QVector<Record>& records)
+{
+	// The weights are the same as in OpeningBook::import()
+	const Chess::Side winner(game.result().winner());
+	const QVector<PgnGame::MoveData>& moves = game.moves();
+	int loserMod = -1;
+	quint16 weight = 1;
+	maxMoves = qMin(maxMoves, moves.size());
+	int ret = maxMoves;
+
+	if (!winner.isNull())
+	{
+		loserMod = int(game.startingSide() == winner);
+		weight = 2;
+		ret = (ret - loserMod) / 2 + loserMod;
+	}
+
+	for (int i = 0; i < maxMoves; i++)
+	{
+		// Skip the loser's moves
+		if ((i % 2) != loserMod)
+		{
+			const PgnGame::MoveData& md = moves.at(i);
+			Record record = { md.key, PolyglotBook::moveToBits(md.move), weight };
+			records.append(record);
+		}
+	}
+
+	return ret;
+}
+
+int PolyglotBookBuilder::addGame(const PgnGame& game)
+{
+	QVector<Record> records;
+	int ret = gameRecords(game, m_maxMoves, records);
+	addRecords(records, 1);
+
+	return ret;
+}
+
+void PolyglotBookBuilder::schedule(Job* job)
+{
+	// Block the producer while the workers are busy, so that only
+	// a few chunks are in memory at a time
+	m_jobSlots.acquire();
+	m_pool.start(job);
+}
+
+void PolyglotBookBuilder::addPgnData(const QByteArray& data)
+{
+	schedule(new Job(this, data));
+}
+
+void PolyglotBookBuilder::addPgnGames(const QString& fileName,
+				      const QVector<qint64>& offsets)
+{
+	schedule(new Job(this, fileName, offsets));
+}
+
+bool PolyglotBookBuilder::addPgnFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Could not open PGN file %s", qUtf8Printable(fileName));
+		return false;
+	}
+
+	QByteArray chunk;
+	while (!m_canceled.load() && !file.atEnd())
+	{
+		const QByteArray block(file.read(ChunkSize));
+		if (block.isEmpty())
+			break;
+		chunk += block;
+
+		// Schedule the whole games and keep the rest for the
+		// next chunk
+		const int end = gameBoundary(chunk);
+		if (end <= 0)
+			continue;
+		addPgnData(chunk.left(end));
+		chunk.remove(0, end);
+	}
+	if (!chunk.isEmpty() && !m_canceled.load())
+		addPgnData(chunk);
+
+	return true;
+}
+
+void PolyglotBookBuilder::cancel()
+{
+	m_canceled.store(1);
+}
+
+void PolyglotBookBuilder::waitForDone()
+{
+	m_pool.waitForDone();
+}
+
+int PolyglotBookBuilder::gameCount() const
+{
+	return m_gameCount.load();
+}
+
+void PolyglotBookBuilder::addRecords(const QVector<Record>& records,
+				     int gameCount)
+{
+	m_gameCount.fetchAndAddRelaxed(gameCount);
+
+	QMutexLocker locker(&m_mutex);
+	m_records += records;
+	if (m_records.size() < m_maxRecords)
+		return;
+
+	QVector<Record> run;
+	run.swap(m_records);
+	locker.unlock();
+
+	// Only one run is sorted and written at a time. The other
+	// workers can fill the next run meanwhile.
+	QMutexLocker runLocker(&m_runMutex);
+	if (!writeRun(run))
+		m_failed = true;
+}
+
+bool PolyglotBookBuilder::writeRun(QVector<Record>& records)
+{
+	sortRecords(records);
+
+	QTemporaryFile* file = new QTemporaryFile;
+	const qint64 bytes = sizeof(Record) * records.size();
+	if (!file->open()
+	||  file->write(reinterpret_cast<const char*>(records.constData()),
+			bytes) != bytes)
+	{
+		qWarning("Could not write temporary opening book file: %s",
+			 qUtf8Printable(file->errorString()));
+		delete file;
+		return false;
+	}
+
+	m_runs.append(file);
+	return true;
+}
+
+void PolyglotBookBuilder::sortRecords(QVector<Record>& records)
+{
+	const int n = records.size();
+	if (n < 2)
+		return;
+
+	// LSD radix sort by key and move, one byte per pass. The move
+	// bytes are the least significant ones.
+	QVector<Record> buffer(n);
+	Record* src = records.data();
+	Record* dst = buffer.data();
+
+	for (int pass = 0; pass < 10; pass++)
+	{
+		const int shift = pass < 2 ? pass * 8 : (pass - 2) * 8;
+		int count[256] = {};
+
+		for (int i = 0; i < n; i++)
+		{
+			const quint64 value = pass < 2 ? src[i].move : src[i].key;
+			count[(value >> shift) & 0xFF]++;
+		}
+
+		// Skip the pass if every record has the same byte
+		const quint64 first = pass < 2 ? src[0].move : src[0].key;
+		if (count[(first >> shift) & 0xFF] == n)
+			continue;
+
+		int offset = 0;
+		for (int d = 0; d < 256; d++)
+		{
+			const int c = count[d];
+			count[d] = offset;
+			offset += c;
+		}
+		for (int i = 0; i < n; i++)
+		{
+			const quint64 value = pass < 2 ? src[i].move : src[i].key;
+			dst[count[(value >> shift) & 0xFF]++] = src[i];
+		}
+		std::swap(src, dst);
+	}
+	if (src != records.constData())
+		records.swap(buffer);
+
+	// Sum the weights of duplicate moves
+	Record* data = records.data();
+	int last = 0;
+	for (int i = 1; i < n; i++)
+	{
+		if (data[i].key == data[last].key && data[i].move == data[last].move)
+			data[last].weight = qMin(MaxWeight, quint32(data[last].weight) + data[i].weight);
+		else
+			data[++last] = data[i];
+	}
+	records.resize(last + 1);
+}
+
+bool PolyglotBookBuilder::readerGreater(const RunReader* r1,
+					const RunReader* r2)
+{
+	const Record& a = r1->current();
+	const Record& b = r2->current();
+	if (a.key != b.key)
+		return a.key > b.key;
+	return a.move > b.move;
+}
+
+bool PolyglotBookBuilder::write(QIODevice* device)
+{
+	waitForDone();
+
+	QMutexLocker runLocker(&m_runMutex);
+	QVector<Record> records;
+	m_mutex.lock();
+	records.swap(m_records);
+	m_mutex.unlock();
+	sortRecords(records);
+
+	bool ok = !m_failed;
+	BookWriter writer(device);
+
+	if (m_runs.isEmpty())
+	{
+		for (const Record& record : qAsConst(records))
+			writer.add(record);
+	}
+	else
+	{
+		// K-way merge of the runs, with the records in memory as
+		// one more run
+		QVector<RunReader*> readers;
+		readers.append(new RunReader(records));
+		for (QTemporaryFile* file : qAsConst(m_runs))
+			readers.append(new RunReader(file));
+
+		QVector<RunReader*> heap;
+		for (RunReader* reader : qAsConst(readers))
+		{
+			if (!reader->atEnd())
+				heap.append(reader);
+		}
+		std::make_heap(heap.begin(), heap.end(), readerGreater);
+
+		while (!heap.isEmpty())
+		{
+			std::pop_heap(heap.begin(), heap.end(), readerGreater);
+			RunReader* reader = heap.last();
+			writer.add(reader->current());
+
+			reader->next();
+			if (!reader->atEnd())
+				std::push_heap(heap.begin(), heap.end(), readerGreater);
+			else
+				heap.removeLast();
+		}
+
+		for (RunReader* reader : qAsConst(readers))
+		{
+			if (reader->hasError())
+			{
+				qWarning("Could not read temporary opening book file");
+				ok = false;
+			}
+		}
+		qDeleteAll(readers);
+		qDeleteAll(m_runs);
+		m_runs.clear();
+	}
+
+	m_failed = false;
+	return writer.finish() && ok;
+}
@@ -0,0 +1,166 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POLYGLOTBOOKBUILDER_H
+#define POLYGLOTBOOKBUILDER_H
+
+#include <QVector>
+#include <QList>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QThreadPool>
+class QIODevice;
+class QTemporaryFile;
+class PgnGame;
+
+/*!
+ * \brief Builds Polyglot opening books from large PGN collections
+ *
+ * The games are parsed in chunks by a pool of worker threads. Every
+ * worker turns its games into (key, move, weight) records, using the
+ * same weights as OpeningBook::import(), and hands them over in one
+ * batch per chunk.
+ *
+ * When the collected records reach the memory limit they are radix
+ * sorted, the weights of duplicate moves are summed, and the result
+ * is written to a temporary file as a sorted run. write() merges the
+ * runs and the records still in memory into the final book, so the
+ * memory use doesn't depend on the size of the PGN collection.
+ *
+ * Unlike an in-memory PolyglotBook the summed weights saturate at
+ * the maximum Polyglot weight instead of wrapping around.
+ */
+class LIB_EXPORT PolyglotBookBuilder
+{
+	public:
+		/*!
+		 * Creates a new builder which imports at most \a maxMoves
+		 * halfmoves from each game.
+		 */
+		explicit PolyglotBookBuilder(int maxMoves);
+		/*! Waits for the workers and deletes the sorted runs. */
+		~PolyglotBookBuilder();
+
+		/*! Returns the maximum number of halfmoves per game. */
+		int maxMoves() const;
+
+		/*!
+		 * Returns the number of worker threads.
+		 * The default value is QThread::idealThreadCount().
+		 */
+		int threadCount() const;
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 *
+		 * This must be called before any games are added.
+		 */
+		void setThreadCount(int count);
+
+		/*!
+		 * Returns the approximate memory limit for the records
+		 * in bytes. The default value is 256 MB.
+		 */
+		qint64 memoryLimit() const;
+		/*! Sets the memory limit to \a bytes. */
+		void setMemoryLimit(qint64 bytes);
+
+		/*!
+		 * Imports \a game in the calling thread.
+		 *
+		 * Returns the number of imported moves.
+		 */
+		int addGame(const PgnGame& game);
+		/*!
+		 * Schedules the PGN games in \a data to be imported.
+		 *
+		 * \a data must only contain whole games.
+		 */
+		void addPgnData(const QByteArray& data);
+		/*!
+		 * Schedules the games that start at byte offsets \a offsets
+		 * of PGN file \a fileName to be imported.
+		 */
+		void addPgnGames(const QString& fileName,
+				 const QVector<qint64>& offsets);
+		/*!
+		 * Imports every game in PGN file \a fileName.
+		 *
+		 * The file is read in large chunks which are cut at game
+		 * boundaries and scheduled for import.
+		 * Returns false if the file can't be read.
+		 */
+		bool addPgnFile(const QString& fileName);
+
+		/*!
+		 * Stops the import. Scheduled chunks that haven't been
+		 * started yet are skipped.
+		 */
+		void cancel();
+		/*! Blocks until every scheduled chunk has been imported. */
+		void waitForDone();
+		/*! Returns the number of imported games. */
+		int gameCount() const;
+
+		/*!
+		 * Waits for the import to finish and writes the book to
+		 * \a device, sorted by key and by descending weight.
+		 * The builder is empty afterwards.
+		 *
+		 * Returns false if the device or a temporary file fails.
+		 */
+		bool write(QIODevice* device);
+
+	private:
+		Q_DISABLE_COPY(PolyglotBookBuilder)
+
+		struct Record
+		{
+			quint64 key;
+			quint16 move;
+			quint16 weight;
+		};
+		class Job;
+		class RunReader;
+		class BookWriter;
+
+		void schedule(Job* job);
+		void addRecords(const QVector<Record>& records, int gameCount);
+		bool writeRun(QVector<Record>& records);
+		static int gameRecords(const PgnGame& game,
+				       int maxMoves,
+				       QVector<Record>& records);
+		static void sortRecords(QVector<Record>& records);
+		static bool readerGreater(const RunReader* r1,
+					  const RunReader* r2);
+
+		int m_maxMoves;
+		int m_maxRecords;
+		bool m_failed;
+		QAtomicInt m_gameCount;
+		QAtomicInt m_canceled;
+		QVector<Record> m_records;
+		QList<QTemporaryFile*> m_runs;
+		QMutex m_mutex;
+		QMutex m_runMutex;
+		QSemaphore m_jobSlots;
+		int m_jobSlotCount;
+		QThreadPool m_pool;
+};
+
+#endif // POLYGLOTBOOKBUILDER_H
@@ -0,0 +1,192 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionindex.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QtEndian>
+#include "board/boardfactory.h"
+
+PositionIndex::PositionIndex()
+	: m_data(nullptr),
+	  m_sourceSize(0),
+	  m_sourceTime(0),
+	  m_gameCount(0),
+	  m_shards(nullptr),
+	  m_games(nullptr),
+	  m_records(nullptr)
+{
+}
+
+PositionIndex::~PositionIndex()
+{
+	close();
+}
+
+QString PositionIndex::indexFileName(const QString& pgnFileName)
+{
+	return pgnFileName + ".posindex";
+}
+
+quint64 PositionIndex::fenKey(const QString& fen, const QString& variant)
+{
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	if (board == nullptr)
+		return 0;
+
+	quint64 key = 0;
+	if (board->setFenString(fen))
+		key = board->key();
+	delete board;
+
+	return key;
+}
+
+bool PositionIndex::open(const QString& fileName)
+{
+	close();
+
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 size = m_file.size();
+	const qint64 tableSize = HeaderSize + (ShardCount + 1) * 8;
+	if (size < tableSize)
+	{
+		close();
+		return false;
+	}
+
+	const uchar* data = m_file.map(0, size);
+	if (data == nullptr
+	||  qFromLittleEndian<quint32>(data) != Magic
+	||  qFromLittleEndian<quint32>(data + 4) != Version
+	||  qFromLittleEndian<quint32>(data + 28) != ShardCount)
+	{
+		close();
+		return false;
+	}
+
+	m_data = data;
+	m_sourceSize = qFromLittleEndian<qint64>(data + 8);
+	m_sourceTime = qFromLittleEndian<qint64>(data + 16);
+	m_gameCount = int(qFromLittleEndian<quint32>(data + 24));
+	m_shards = data + HeaderSize;
+	m_games = m_shards + (ShardCount + 1) * 8;
+	m_records = m_games + qint64(m_gameCount) * 8;
+
+	// A truncated index would be read past the end of the map
+	const qint64 recordCount = positionCount();
+	if (m_gameCount < 0
+	||  recordCount < 0
+	||  m_records - data + recordCount * RecordSize != size)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void PositionIndex::close()
+{
+	if (m_data != nullptr)
+		m_file.unmap(const_cast<uchar*>(m_data));
+	m_file.close();
+
+	m_data = nullptr;
+	m_sourceSize = 0;
+	m_sourceTime = 0;
+	m_gameCount = 0;
+	m_shards = nullptr;
+	m_games = nullptr;
+	m_records = nullptr;
+}
+
+bool PositionIndex::isOpen() const
+{
+	return m_data != nullptr;
+}
+
+bool PositionIndex::isCurrent(const QString& pgnFileName) const
+{
+	if (!isOpen())
+		return false;
+
+	const QFileInfo info(pgnFileName);
+	return info.exists()
+	    && info.size() == m_sourceSize
+	    && info.lastModified().toMSecsSinceEpoch() == m_sourceTime;
+}
+
+int PositionIndex::gameCount() const
+{
+	return m_gameCount;
+}
+
+qint64 PositionIndex::positionCount() const
+{
+	if (m_shards == nullptr)
+		return 0;
+	return qFromLittleEndian<qint64>(m_shards + ShardCount * 8);
+}
+
+qint64 PositionIndex::gamePosition(int game) const
+{
+	Q_ASSERT(game >= 0 && game < m_gameCount);
+	return qFromLittleEndian<qint64>(m_games + qint64(game) * 8);
+}
+
+quint64 PositionIndex::recordKey(qint64 record) const
+{
+	return qFromLittleEndian<quint64>(m_records + record * RecordSize);
+}
+
+QVector<PositionIndex::Hit> PositionIndex::find(quint64 key) const
+{
+	QVector<Hit> hits;
+	if (!isOpen())
+		return hits;
+
+	const int shard = int(key >> 56);
+	qint64 first = qFromLittleEndian<qint64>(m_shards + shard * 8);
+	qint64 last = qFromLittleEndian<qint64>(m_shards + (shard + 1) * 8);
+
+	// Find the first record of the key
+	while (first < last)
+	{
+		const qint64 mid = first + (last - first) / 2;
+		if (recordKey(mid) < key)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	const qint64 end = positionCount();
+	for (qint64 i = first; i < end && recordKey(i) == key; i++)
+	{
+		const uchar* record = m_records + i * RecordSize;
+		Hit hit;
+		hit.game = qFromLittleEndian<quint32>(record + 8);
+		hit.ply = qFromLittleEndian<quint16>(record + 12);
+		hits.append(hit);
+	}
+
+	return hits;
+}
@@ -0,0 +1,124 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONINDEX_H
+#define POSITIONINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+
+/*!
+ * \brief A sorted on-disk index of the positions of a PGN collection
+ *
+ * The index maps the Zobrist key of every position reached in the
+ * games of a PGN file to the games and plies where it occurs. It is
+ * written by PositionIndexBuilder next to the PGN file, and queried
+ * through a memory map, so a lookup only touches a few pages of the
+ * file no matter how many games there are.
+ *
+ * The records are split into 256 shards by the most significant byte
+ * of the key. Every shard is sorted by key, game and ply, and the
+ * records of a key are found with a binary search inside its shard.
+ *
+ * The games are numbered in the order of the PGN file, the same way
+ * as the entries of a PgnGameScanner.
+ *
+ * \sa PositionIndexBuilder
+ */
+class LIB_EXPORT PositionIndex
+{
+	public:
+		/*! A position in a game. */
+		struct Hit
+		{
+			/*! The zero-based number of the game. */
+			quint32 game;
+			/*! The number of halfmoves played before the position. */
+			quint16 ply;
+		};
+
+		/*! Creates a new index that isn't open. */
+		PositionIndex();
+		/*! Closes the index. */
+		~PositionIndex();
+
+		/*! Returns the name of the index file of PGN file \a pgnFileName. */
+		static QString indexFileName(const QString& pgnFileName);
+		/*!
+		 * Returns the Zobrist key of \a fen in \a variant, or 0
+		 * if the FEN string isn't valid.
+		 */
+		static quint64 fenKey(const QString& fen,
+				      const QString& variant = "standard");
+
+		/*!
+		 * Opens index file \a fileName.
+		 *
+		 * Returns false if the file can't be mapped or isn't a
+		 * position index.
+		 */
+		bool open(const QString& fileName);
+		/*! Closes the index. */
+		void close();
+		/*! Returns true if the index is open. */
+		bool isOpen() const;
+		/*!
+		 * Returns true if the index was built from the current
+		 * contents of PGN file \a pgnFileName.
+		 */
+		bool isCurrent(const QString& pgnFileName) const;
+
+		/*! Returns the number of indexed games. */
+		int gameCount() const;
+		/*! Returns the number of indexed positions. */
+		qint64 positionCount() const;
+		/*! Returns the byte offset of \a game in the PGN file. */
+		qint64 gamePosition(int game) const;
+		/*!
+		 * Returns every occurrence of the position with Zobrist
+		 * key \a key, ordered by game and ply.
+		 */
+		QVector<Hit> find(quint64 key) const;
+
+	private:
+		Q_DISABLE_COPY(PositionIndex)
+
+		friend class PositionIndexBuilder;
+		enum
+		{
+			Magic = 0x43435049,
+			Version = 2,
+			ShardCount = 256,
+			RecordSize = 16,
+			HeaderSize = 32
+		};
+
+		quint64 recordKey(qint64 record) const;
+
+		QFile m_file;
+		const uchar* m_data;
+		qint64 m_sourceSize;
+		qint64 m_sourceTime;
+		int m_gameCount;
+		const uchar* m_shards;
+		const uchar* m_games;
+		const uchar* m_records;
+};
+
+#endif // POSITIONINDEX_H
@@ -0,0 +1,561 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionindexbuilder.h"
+#include <algorithm>
+#include <climits>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTemporaryFile>
+#include <QRunnable>
+#include <QThread>
+#include <QtEndian>
+#include <QtDebug>
+#include "positionindex.h"
+#include "pgngame.h"
+#include "pgnstream.h"
+#include "pgngamescanner.h"
+
+namespace {
+
+const qint64 DefaultMemoryLimit = 256 * 1024 * 1024;
+const qint64 MinRecords = 1024;
+const qint64 ChunkSize = 4 * 1024 * 1024;
+const int FlushRecords = 64 * 1024;
+const int OutputBufferSize = 64 * 1024;
+const int MaxPly = 0xFFFF;
+
+} // anonymous namespace
+
+
+class PositionIndexBuilder::ScanJob : public QRunnable
+{
+	public:
+		ScanJob(const PgnGameScanner& scanner,
+			Chunk* chunk,
+			bool guessState);
+
+		// Inherited from QRunnable
+		virtual void run();
+
+	private:
+		const PgnGameScanner& m_scanner;
+		Chunk* m_chunk;
+		bool m_guessState;
+};
+
+PositionIndexBuilder::ScanJob::ScanJob(const PgnGameScanner& scanner,
+				       Chunk* chunk,
+				       bool guessState)
+	: m_scanner(scanner),
+	  m_chunk(chunk),
+	  m_guessState(guessState)
+{
+}
+
+void PositionIndexBuilder::ScanJob::run()
+{
+	const PgnGameScanner::Chunk chunk(m_guessState
+		? m_scanner.scan(m_chunk->begin, m_chunk->end)
+		: m_scanner.scan(m_chunk->begin, m_chunk->end,
+				 m_chunk->startState));
+	m_chunk->startState = chunk.startState;
+	m_chunk->endState = chunk.endState;
+	m_chunk->games.clear();
+	m_chunk->games.reserve(chunk.entries.size());
+	for (const PgnGameEntry& entry : chunk.entries)
+		m_chunk->games.append(entry.pos());
+}
+
+
+class PositionIndexBuilder::ParseJob : public QRunnable
+{
+	public:
+		ParseJob(PositionIndexBuilder* builder,
+			 const char* data,
+			 const Chunk* chunk);
+
+		// Inherited from QRunnable
+		virtual void run();
+
+	private:
+		PositionIndexBuilder* m_builder;
+		const char* m_data;
+		const Chunk* m_chunk;
+};
+
+PositionIndexBuilder::ParseJob::ParseJob(PositionIndexBuilder* builder,
+					 const char* data,
+					 const Chunk* chunk)
+	: m_builder(builder),
+	  m_data(data),
+	  m_chunk(chunk)
+{
+}
+
+void PositionIndexBuilder::ParseJob::run()
+{
+	if (m_chunk->games.isEmpty())
+		return;
+
+	// The games of the chunk end where the next chunk's first
+	// game starts
+	const qint64 start = m_chunk->games.first();
+	const int size = int(qMin(m_chunk->dataEnd - start, qint64(INT_MAX)));
+	const QByteArray data(QByteArray::fromRawData(m_data + start, size));
+	PgnStream in(&data);
+
+	QVector<Record> records;
+	for (int i = 0; i < m_chunk->games.size(); i++)
+	{
+		if (m_builder->isCanceled())
+			return;
+
+		PgnGame game;
+		if (!in.seek(m_chunk->games.at(i) - start)
+		||  !game.read(in, INT_MAX - 1, false))
+			continue;
+
+		const quint32 gameId = quint32(m_chunk->firstGame + i);
+		const QVector<PgnGame::MoveData>& moves = game.moves();
+		const int plies = qMin(moves.size(), MaxPly);
+		for (int ply = 0; ply < plies; ply++)
+		{
+			Record record = { moves.at(ply).key, gameId, quint16(ply), 0 };
+			records.append(record);
+		}
+		// The final position's key is only known after a move
+		if (!moves.isEmpty() && moves.size() <= MaxPly)
+		{
+			Record record = { game.key(), gameId, quint16(moves.size()), 0 };
+			records.append(record);
+		}
+
+		if (records.size() >= FlushRecords)
+		{
+			m_builder->addRecords(records);
+			records.clear();
+		}
+	}
+
+	m_builder->addRecords(records);
+}
+
+
+class PositionIndexBuilder::ShardJob : public QRunnable
+{
+	public:
+		ShardJob(PositionIndexBuilder* builder,
+			 int shard,
+			 const QString& fileName,
+			 qint64 offset);
+
+		// Inherited from QRunnable
+		virtual void run();
+
+	private:
+		bool readRun();
+		bool writeRecords();
+
+		PositionIndexBuilder* m_builder;
+		QVector<Record> m_records;
+		QTemporaryFile* m_run;
+		QString m_fileName;
+		qint64 m_offset;
+};
+
+PositionIndexBuilder::ShardJob::ShardJob(PositionIndexBuilder* builder,
+					 int shard,
+					 const QString& fileName,
+					 qint64 offset)
+	: m_builder(builder),
+	  m_run(builder->m_runs.at(shard)),
+	  m_fileName(fileName),
+	  m_offset(offset)
+{
+	m_records.swap(builder->m_shards[shard]);
+}
+
+bool PositionIndexBuilder::ShardJob::readRun()
+{
+	if (m_run == nullptr)
+		return true;
+
+	const qint64 bytes = m_run->size();
+	const int oldSize = m_records.size();
+	m_records.resize(oldSize + int(bytes / sizeof(Record)));
+
+	return m_run->seek(0)
+	    && m_run->read(reinterpret_cast<char*>(m_records.data() + oldSize),
+			   bytes) == bytes;
+}
+
+bool PositionIndexBuilder::ShardJob::writeRecords()
+{
+	QFile file(m_fileName);
+	if (!file.open(QIODevice::ReadWrite) || !file.seek(m_offset))
+		return false;
+
+	QByteArray buffer;
+	buffer.reserve(OutputBufferSize + PositionIndex::RecordSize);
+	for (const Record& record : qAsConst(m_records))
+	{
+		uchar data[PositionIndex::RecordSize];
+		qToLittleEndian<quint64>(record.key, data);
+		qToLittleEndian<quint32>(record.game, data + 8);
+		qToLittleEndian<quint16>(record.ply, data + 12);
+		qToLittleEndian<quint16>(0, data + 14);
+		buffer.append(reinterpret_cast<const char*>(data),
+			      PositionIndex::RecordSize);
+
+		if (buffer.size() >= OutputBufferSize)
+		{
+			if (file.write(buffer) != buffer.size())
+				return false;
+			buffer.resize(0);
+		}
+	}
+
+	return file.write(buffer) == buffer.size();
+}
+
+void PositionIndexBuilder::ShardJob::run()
+{
+	if (m_builder->isCanceled())
+		return;
+	if (!readRun())
+	{
+		qWarning("Could not read temporary position index file");
+		m_builder->m_failed.store(1);
+		return;
+	}
+
+	std::sort(m_records.begin(), m_records.end(), recordLessThan);
+	if (m_builder->isCanceled())
+		return;
+	if (!writeRecords())
+	{
+		qWarning("Could not write position index %s",
+			 qUtf8Printable(m_fileName));
+		m_builder->m_failed.store(1);
+	}
+}
+
+
+PositionIndexBuilder::PositionIndexBuilder(const QString& pgnFileName)
+	: m_pgnFileName(pgnFileName),
+	  m_maxRecords(MinRecords),
+	  m_recordCount(0),
+	  m_gameCount(0),
+	  m_failed(0),
+	  m_canceled(0),
+	  m_shards(PositionIndex::ShardCount),
+	  m_runs(PositionIndex::ShardCount, nullptr)
+{
+	setThreadCount(QThread::idealThreadCount());
+	setMemoryLimit(DefaultMemoryLimit);
+}
+
+PositionIndexBuilder::~PositionIndexBuilder()
+{
+	m_pool.waitForDone();
+	qDeleteAll(m_runs);
+}
+
+QString PositionIndexBuilder::pgnFileName() const
+{
+	return m_pgnFileName;
+}
+
+int PositionIndexBuilder::threadCount() const
+{
+	return m_pool.maxThreadCount();
+}
+
+void PositionIndexBuilder::setThreadCount(int count)
+{
+	m_pool.setMaxThreadCount(qMax(1, count));
+}
+
+qint64 PositionIndexBuilder::memoryLimit() const
+{
+	return m_maxRecords * sizeof(Record);
+}
+
+void PositionIndexBuilder::setMemoryLimit(qint64 bytes)
+{
+	m_maxRecords = qMax(MinRecords, qint64(bytes / sizeof(Record)));
+}
+
+void PositionIndexBuilder::cancel()
+{
+	m_canceled.store(1);
+}
+
+void PositionIndexBuilder::setCancelCallback(const std::function<bool()>& callback)
+{
+	m_cancelCallback = callback;
+}
+
+bool PositionIndexBuilder::isCanceled()
+{
+	if (!m_canceled.load() && m_cancelCallback && m_cancelCallback())
+		m_canceled.store(1);
+	return m_canceled.load();
+}
+
+int PositionIndexBuilder::gameCount() const
+{
+	return m_gameCount;
+}
+
+bool PositionIndexBuilder::recordLessThan(const Record& r1, const Record& r2)
+{
+	if (r1.key != r2.key)
+		return r1.key < r2.key;
+	if (r1.game != r2.game)
+		return r1.game < r2.game;
+	return r1.ply < r2.ply;
+}
+
+void PositionIndexBuilder::addRecords(const QVector<Record>& records)
+{
+	QMutexLocker locker(&m_mutex);
+	for (const Record& record : records)
+		m_shards[int(record.key >> 56)].append(record);
+
+	m_recordCount += records.size();
+	if (m_recordCount >= m_maxRecords && !spill())
+		m_failed.store(1);
+}
+
+bool PositionIndexBuilder::spill()
+{
+	// Every shard has its own temporary file, so the shards can be
+	// sorted independently at the end
+	for (int i = 0; i < PositionIndex::ShardCount; i++)
+	{
+		QVector<Record>& records = m_shards[i];
+		if (records.isEmpty())
+			continue;
+
+		QTemporaryFile*& run = m_runs[i];
+		if (run == nullptr)
+		{
+			run = new QTemporaryFile;
+			if (!run->open())
+			{
+				qWarning("Could not create temporary position index file: %s",
+					 qUtf8Printable(run->errorString()));
+				return false;
+			}
+		}
+
+		const qint64 bytes = sizeof(Record) * records.size();
+		if (run->write(reinterpret_cast<const char*>(records.constData()),
+			       bytes) != bytes)
+		{
+			qWarning("Could not write temporary position index file: %s",
+				 qUtf8Printable(run->errorString()));
+			return false;
+		}
+		records.clear();
+	}
+
+	m_recordCount = 0;
+	return true;
+}
+
+bool PositionIndexBuilder::writeHeader(QTemporaryFile* file,
+				       const QVector<Chunk>& chunks,
+				       QVector<qint64>& shardOffsets)
+{
+	const QFileInfo info(m_pgnFileName);
+	QByteArray header(PositionIndex::HeaderSize, 0);
+	uchar* data = reinterpret_cast<uchar*>(header.data());
+	qToLittleEndian<quint32>(PositionIndex::Magic, data);
+	qToLittleEndian<quint32>(PositionIndex::Version, data + 4);
+	qToLittleEndian<qint64>(info.size(), data + 8);
+	qToLittleEndian<qint64>(info.lastModified().toMSecsSinceEpoch(), data + 16);
+	qToLittleEndian<quint32>(quint32(m_gameCount), data + 24);
+	qToLittleEndian<quint32>(PositionIndex::ShardCount, data + 28);
+
+	// The first record of every shard, and the total record count
+	QVector<qint64> firstRecords;
+	qint64 recordCount = 0;
+	for (int i = 0; i < PositionIndex::ShardCount; i++)
+	{
+		firstRecords.append(recordCount);
+		recordCount += m_shards.at(i).size();
+		if (m_runs.at(i) != nullptr)
+			recordCount += m_runs.at(i)->size() / sizeof(Record);
+	}
+	firstRecords.append(recordCount);
+
+	for (qint64 record : qAsConst(firstRecords))
+	{
+		uchar value[8];
+		qToLittleEndian<qint64>(record, value);
+		header.append(reinterpret_cast<const char*>(value), 8);
+	}
+	for (const Chunk& chunk : chunks)
+	{
+		for (qint64 pos : chunk.games)
+		{
+			uchar value[8];
+			qToLittleEndian<qint64>(pos, value);
+			header.append(reinterpret_cast<const char*>(value), 8);
+		}
+	}
+
+	shardOffsets.clear();
+	for (qint64 record : qAsConst(firstRecords))
+		shardOffsets.append(header.size() + record * PositionIndex::RecordSize);
+
+	// The shard jobs open the file by name, so it's closed here
+	if (!file->open()
+	||  file->write(header) != header.size()
+	||  !file->resize(shardOffsets.last()))
+	{
+		qWarning("Could not write position index %s: %s",
+			 qUtf8Printable(file->fileName()),
+			 qUtf8Printable(file->errorString()));
+		return false;
+	}
+	file->close();
+
+	return true;
+}
+
+bool PositionIndexBuilder::write(const QString& indexFileName)
+{
+	QFile file(m_pgnFileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Could not open PGN file %s", qUtf8Printable(m_pgnFileName));
+		return false;
+	}
+
+	const qint64 size = file.size();
+	const char* data = nullptr;
+	if (size > 0)
+	{
+		data = reinterpret_cast<const char*>(file.map(0, size));
+		if (data == nullptr)
+		{
+			qWarning("Could not map PGN file %s",
+				 qUtf8Printable(m_pgnFileName));
+			return false;
+		}
+	}
+
+	const PgnGameScanner scanner(data, size);
+	QVector<Chunk> chunks;
+	if (size > 0)
+	{
+		const QVector<qint64> starts(scanner.chunks(ChunkSize));
+		for (int i = 1; i < starts.size(); i++)
+		{
+			Chunk chunk = { starts.at(i - 1), starts.at(i), size, 0,
+					QVector<qint64>(), PgnGameScanner::State(),
+					PgnGameScanner::State() };
+			chunks.append(chunk);
+		}
+	}
+
+	// Find the games first, so that they can be numbered in file
+	// order before they are parsed
+	for (Chunk& chunk : chunks)
+		m_pool.start(new ScanJob(scanner, &chunk, true));
+	m_pool.waitForDone();
+
+	// A chunk whose state was guessed wrong, eg. one that starts
+	// inside a comment, is scanned again from the previous chunk
+	for (int i = 1; i < chunks.size(); i++)
+	{
+		Chunk& chunk = chunks[i];
+		if (chunk.startState == chunks.at(i - 1).endState)
+			continue;
+		chunk.startState = chunks.at(i - 1).endState;
+		ScanJob(scanner, &chunk, false).run();
+	}
+
+	qint64 dataEnd = size;
+	for (int i = chunks.size() - 1; i >= 0; i--)
+	{
+		chunks[i].dataEnd = dataEnd;
+		if (!chunks.at(i).games.isEmpty())
+			dataEnd = chunks.at(i).games.first();
+	}
+	m_gameCount = 0;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.firstGame = m_gameCount;
+		m_gameCount += chunk.games.size();
+	}
+
+	for (const Chunk& chunk : qAsConst(chunks))
+		m_pool.start(new ParseJob(this, data, &chunk));
+	m_pool.waitForDone();
+
+	if (data != nullptr)
+		file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+	file.close();
+
+	// The index is built next to the final file and only renamed
+	// when it's complete, so that a canceled or killed build can't
+	// leave behind a partial index with a valid header
+	QTemporaryFile indexFile(indexFileName + ".XXXXXX");
+	QVector<qint64> shardOffsets;
+	bool ok = !isCanceled()
+	       && !m_failed.load()
+	       && writeHeader(&indexFile, chunks, shardOffsets);
+	if (ok)
+	{
+		for (int i = 0; i < PositionIndex::ShardCount; i++)
+			m_pool.start(new ShardJob(this, i, indexFile.fileName(),
+						  shardOffsets.at(i)));
+		m_pool.waitForDone();
+		// A shard job that saw the cancel left its shard unwritten
+		ok = !isCanceled() && !m_failed.load();
+	}
+	if (ok)
+	{
+		const QString tempName(indexFile.fileName());
+		indexFile.setAutoRemove(false);
+		if (QFile::exists(indexFileName))
+			QFile::remove(indexFileName);
+		ok = QFile::rename(tempName, indexFileName);
+		if (!ok)
+		{
+			qWarning("Could not rename position index %s to %s",
+				 qUtf8Printable(tempName),
+				 qUtf8Printable(indexFileName));
+			QFile::remove(tempName);
+		}
+	}
+
+	qDeleteAll(m_runs);
+	m_runs.fill(nullptr);
+	m_shards = QVector<QVector<Record>>(PositionIndex::ShardCount);
+	m_recordCount = 0;
+	m_failed.store(0);
+
+	return ok;
+}
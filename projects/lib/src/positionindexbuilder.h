@@ -0,0 +1,148 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONINDEXBUILDER_H
+#define POSITIONINDEXBUILDER_H
+
+#include <functional>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include "pgngamescanner.h"
+class QTemporaryFile;
+
+/*!
+ * \brief Builds a PositionIndex from a PGN file
+ *
+ * The PGN file is memory-mapped and split into chunks. A pool of
+ * worker threads first finds the games of every chunk with a
+ * PgnGameScanner, so that the games can be numbered in file order,
+ * and then replays the games and records the Zobrist key of every
+ * position with its game and ply.
+ *
+ * The records are collected in one bucket per index shard. When
+ * they reach the memory limit the buckets are appended to temporary
+ * files. Finally every shard is sorted by a worker of its own and
+ * written to its place in the index file, so only one shard at a
+ * time per thread has to fit in memory.
+ *
+ * \sa PositionIndex
+ */
+class LIB_EXPORT PositionIndexBuilder
+{
+	public:
+		/*! Creates a new builder for PGN file \a pgnFileName. */
+		explicit PositionIndexBuilder(const QString& pgnFileName);
+		/*! Waits for the workers and deletes the temporary files. */
+		~PositionIndexBuilder();
+
+		/*! Returns the name of the PGN file. */
+		QString pgnFileName() const;
+
+		/*!
+		 * Returns the number of worker threads.
+		 * The default value is QThread::idealThreadCount().
+		 */
+		int threadCount() const;
+		/*! Sets the number of worker threads to \a count. */
+		void setThreadCount(int count);
+
+		/*!
+		 * Returns the approximate memory limit for the records
+		 * in bytes. The default value is 256 MB.
+		 */
+		qint64 memoryLimit() const;
+		/*! Sets the memory limit to \a bytes. */
+		void setMemoryLimit(qint64 bytes);
+
+		/*!
+		 * Stops the build. write() returns false and no index
+		 * is written.
+		 */
+		void cancel();
+		/*!
+		 * Sets \a callback to be polled by the build. If it
+		 * returns true the build is canceled like with cancel().
+		 *
+		 * The callback is called from the worker threads.
+		 */
+		void setCancelCallback(const std::function<bool()>& callback);
+		/*! Returns the number of indexed games. */
+		int gameCount() const;
+
+		/*!
+		 * Indexes the games of the PGN file and writes the index
+		 * to \a indexFileName.
+		 *
+		 * The index is built in a temporary file in the same
+		 * directory, which replaces \a indexFileName only after
+		 * the whole index is written.
+		 *
+		 * Returns false if the build was canceled or if a file
+		 * can't be read or written.
+		 */
+		bool write(const QString& indexFileName);
+
+	private:
+		Q_DISABLE_COPY(PositionIndexBuilder)
+
+		struct Record
+		{
+			quint64 key;
+			quint32 game;
+			quint16 ply;
+			quint16 reserved;
+		};
+		struct Chunk
+		{
+			qint64 begin;
+			qint64 end;
+			qint64 dataEnd;
+			int firstGame;
+			QVector<qint64> games;
+			PgnGameScanner::State startState;
+			PgnGameScanner::State endState;
+		};
+		class ScanJob;
+		class ParseJob;
+		class ShardJob;
+
+		bool isCanceled();
+		void addRecords(const QVector<Record>& records);
+		bool spill();
+		bool writeHeader(QTemporaryFile* file,
+				 const QVector<Chunk>& chunks,
+				 QVector<qint64>& shardOffsets);
+		static bool recordLessThan(const Record& r1, const Record& r2);
+
+		QString m_pgnFileName;
+		qint64 m_maxRecords;
+		qint64 m_recordCount;
+		int m_gameCount;
+		QAtomicInt m_failed;
+		QAtomicInt m_canceled;
+		std::function<bool()> m_cancelCallback;
+		QVector<QVector<Record>> m_shards;
+		QVector<QTemporaryFile*> m_runs;
+		QMutex m_mutex;
+		QThreadPool m_pool;
+};
+
+#endif // POSITIONINDEXBUILDER_H
@@ -47,7 +47,16 @@ HEADERS += $$PWD/chessengine.h \
     $$PWD/tournamentplayer.h \
     $$PWD/tournamentpair.h \
     $$PWD/worker.h \
-    $$PWD/graph_blossom.h
+    $$PWD/graph_blossom.h \
+    $$PWD/livefilewriter.h \
+    $$PWD/livejsonserializer.h \
+    $$PWD/polyglotbookbuilder.h \
+    $$PWD/pgngamescanner.h \
+    $$PWD/positionindex.h \
+    $$PWD/positionindexbuilder.h \
+    $$PWD/pgntagindex.h \
+    $$PWD/cpuallocator.h \
+    $$PWD/linequeue.h
 SOURCES += $$PWD/chessengine.cpp \
     $$PWD/chessgame.cpp \
     $$PWD/chessplayer.cpp \
@@ -92,10 +101,25 @@ SOURCES += $$PWD/chessengine.cpp \
     $$PWD/pyramidtournament.cpp \
     $$PWD/tournamentplayer.cpp \
     $$PWD/tournamentpair.cpp \
-    $$PWD/worker.cpp
+    $$PWD/worker.cpp \
+    $$PWD/livefilewriter.cpp \
+    $$PWD/livejsonserializer.cpp \
+    $$PWD/polyglotbookbuilder.cpp \
+    $$PWD/pgngamescanner.cpp \
+    $$PWD/positionindex.cpp \
+    $$PWD/positionindexbuilder.cpp \
+    $$PWD/pgntagindex.cpp \
+    $$PWD/cpuallocator.cpp \
+    $$PWD/linequeue.cpp
 win32 { 
     HEADERS += $$PWD/engineprocess_win.h \
 	$$PWD/pipereader_win.h
     SOURCES += $$PWD/engineprocess_win.cpp \
 	$$PWD/pipereader_win.cpp
 }
+linux {
+    HEADERS += $$PWD/engineprocess_linux.h \
+	$$PWD/pipereactor_linux.h
+    SOURCES += $$PWD/engineprocess_linux.cpp \
+	$$PWD/pipereactor_linux.cpp
+}
@@ -19,6 +19,11 @@
 #include "timecontrol.h"
 #include <QStringList>
 #include <QSettings>
+#ifdef Q_OS_UNIX
+  #include <time.h>
+#else
+  #include <QElapsedTimer>
+#endif
 
 namespace {
 
@@ -40,6 +45,18 @@ QString s_nodeString(int nodes)
 	return TimeControl::tr("%1 M").arg(nodes / 1000000);
 }
 
+#ifndef Q_OS_UNIX
+struct MonotonicClock
+{
+	MonotonicClock()
+	{
+		timer.start();
+	}
+
+	QElapsedTimer timer;
+};
+#endif
+
 } // anonymous namespace
 
 TimeControl::TimeControl()
@@ -47,14 +64,15 @@ TimeControl::TimeControl()
 	  m_timePerTc(0),
 	  m_timePerMove(0),
 	  m_increment(0),
-	  m_timeLeft(0),
+	  m_timeLeftUs(0),
 	  m_movesLeft(0),
 	  m_plyLimit(0),
 	  m_nodeLimit(0),
-	  m_lastMoveTime(0),
+	  m_lastMoveTimeUs(0),
 	  m_expiryMargin(0),
 	  m_expired(false),
-	  m_infinite(false)
+	  m_infinite(false),
+	  m_startNs(-1)
 {
 }
 
@@ -63,14 +81,15 @@ TimeControl::TimeControl(const QString& str)
 	  m_timePerTc(0),
 	  m_timePerMove(0),
 	  m_increment(0),
-	  m_timeLeft(0),
+	  m_timeLeftUs(0),
 	  m_movesLeft(0),
 	  m_plyLimit(0),
 	  m_nodeLimit(0),
-	  m_lastMoveTime(0),
+	  m_lastMoveTimeUs(0),
 	  m_expiryMargin(0),
 	  m_expired(false),
-	  m_infinite(false)
+	  m_infinite(false),
+	  m_startNs(-1)
 {
 	if (str == "inf")
 	{
@@ -198,15 +217,15 @@ QString TimeControl::toVerboseString() const
 void TimeControl::initialize()
 {
 	m_expired = false;
-	m_lastMoveTime = 0;
+	m_lastMoveTimeUs = 0;
 
 	if (m_timePerTc != 0)
 	{
-		m_timeLeft = m_timePerTc;
+		setTimeLeft(m_timePerTc);
 		m_movesLeft = m_movesPerTc;
 	}
 	else if (m_timePerMove != 0)
-		m_timeLeft = m_timePerMove;
+		setTimeLeft(m_timePerMove);
 }
 
 bool TimeControl::isInfinite() const
@@ -236,7 +255,12 @@ int TimeControl::timePerMove() const
 
 int TimeControl::timeLeft() const
 {
-	return m_timeLeft;
+	return int(m_timeLeftUs / 1000);
+}
+
+qint64 TimeControl::timeLeftUs() const
+{
+	return m_timeLeftUs;
 }
 
 int TimeControl::movesLeft() const
@@ -290,7 +314,7 @@ void TimeControl::setTimePerMove(int timePerMove)
 
 void TimeControl::setTimeLeft(int timeLeft)
 {
-	m_timeLeft = timeLeft;
+	m_timeLeftUs = qint64(timeLeft) * 1000;
 }
 
 void TimeControl::setMovesLeft(int movesLeft)
@@ -317,35 +341,49 @@ void TimeControl::setExpiryMargin(int expiryMargin)
 	m_expiryMargin = expiryMargin;
 }
 
-void TimeControl::startTimer()
+qint64 TimeControl::monotonicNs()
 {
-	m_time.start();
+#ifdef Q_OS_UNIX
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+	static const MonotonicClock clock;
+	return clock.timer.nsecsElapsed();
+#endif
 }
 
-void TimeControl::update(bool applyIncrement, int64_t overrideElapsedMs)
+void TimeControl::startTimer(qint64 startNs)
+{
+	m_startNs = startNs >= 0 ? startNs : monotonicNs();
+}
+
+void TimeControl::update(bool applyIncrement,
+			 int64_t overrideElapsedMs,
+			 qint64 endNs)
 {
-	/*
-	 * This will overflow after roughly 49 days however it's unlikely
-	 * we'll ever hit that limit.
-	 */
 	if (overrideElapsedMs >= 0)
-		m_lastMoveTime = overrideElapsedMs;
-	else if (m_time.isValid())
-		m_lastMoveTime = (int)m_time.elapsed();
+		m_lastMoveTimeUs = overrideElapsedMs * 1000;
+	else if (m_startNs >= 0)
+	{
+		if (endNs < 0)
+			endNs = monotonicNs();
+		m_lastMoveTimeUs = qMax(endNs - m_startNs, qint64(0)) / 1000;
+	}
 	else
-		m_lastMoveTime = 0;
+		m_lastMoveTimeUs = 0;
 
-	if (!m_infinite && m_lastMoveTime > m_timeLeft + m_expiryMargin)
+	if (!m_infinite
+	&&  m_lastMoveTimeUs > m_timeLeftUs + qint64(m_expiryMargin) * 1000)
 		m_expired = true;
 
 	if (m_timePerMove != 0)
 		setTimeLeft(m_timePerMove);
 	else
 	{
-	        int newTimeLeft = m_timeLeft - m_lastMoveTime;
+		m_timeLeftUs -= m_lastMoveTimeUs;
 		if (applyIncrement)
-			newTimeLeft += m_increment;
-		setTimeLeft(newTimeLeft);
+			m_timeLeftUs += qint64(m_increment) * 1000;
 		
 		if (m_movesPerTc > 0)
 		{
@@ -355,7 +393,7 @@ void TimeControl::update(bool applyIncrement, int64_t overrideElapsedMs)
 			if (m_movesLeft == 0)
 			{
 				setMovesLeft(m_movesPerTc);
-				setTimeLeft(m_timePerTc + m_timeLeft);
+				m_timeLeftUs += qint64(m_timePerTc) * 1000;
 			}
 		}
 	}
@@ -363,7 +401,12 @@ void TimeControl::update(bool applyIncrement, int64_t overrideElapsedMs)
 
 int TimeControl::lastMoveTime() const
 {
-	return m_lastMoveTime;
+	return int(m_lastMoveTimeUs / 1000);
+}
+
+qint64 TimeControl::lastMoveTimeUs() const
+{
+	return m_lastMoveTimeUs;
 }
 
 bool TimeControl::expired() const
@@ -373,9 +416,9 @@ bool TimeControl::expired() const
 
 int TimeControl::activeTimeLeft() const
 {
-	if (m_time.isValid())
-		return m_timeLeft - m_time.elapsed();
-	return m_timeLeft;
+	if (m_startNs >= 0)
+		return int((m_timeLeftUs - (monotonicNs() - m_startNs) / 1000) / 1000);
+	return timeLeft();
 }
 
 void TimeControl::readSettings(QSettings* settings)
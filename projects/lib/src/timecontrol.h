@@ -19,7 +19,6 @@
 #ifndef TIMECONTROL_H
 #define TIMECONTROL_H
 
-#include <QElapsedTimer>
 #include <QString>
 #include <QCoreApplication>
 class QSettings;
@@ -30,7 +29,9 @@ class QSettings;
  * TimeControl is used for telling the chess players how much time
  * they can spend thinking of their moves.
  *
- * \note All time handling is done in milliseconds.
+ * \note All time handling is done in milliseconds. Internally the
+ * clock runs in microseconds, so that the rounding errors of single
+ * moves don't add up over a game.
  */
 class LIB_EXPORT TimeControl
 {
@@ -114,6 +115,8 @@ class LIB_EXPORT TimeControl
 
 		/*! Returns the time left in the time control. */
 		int timeLeft() const;
+		/*! Returns the time left in the time control in microseconds. */
+		qint64 timeLeftUs() const;
 
 		/*!
 		 * Returns the number of full moves left in the time control,
@@ -171,8 +174,20 @@ class LIB_EXPORT TimeControl
 		void setExpiryMargin(int expiryMargin);
 
 		
-		/*! Start the timer. */
-		void startTimer();
+		/*!
+		 * Returns the current time of the monotonic clock in
+		 * nanoseconds.
+		 *
+		 * The timestamps given to startTimer() and update() must
+		 * come from this clock.
+		 */
+		static qint64 monotonicNs();
+
+		/*!
+		 * Start the timer at \a startNs, or now if \a startNs
+		 * is negative.
+		 */
+		void startTimer(qint64 startNs = -1);
 		
 		/*!
 		 * Update the time control with the elapsed time.
@@ -180,11 +195,19 @@ class LIB_EXPORT TimeControl
 		 * \a applyIncrement is true. This is the default.
 		 * Set this value to false if no increment is necessary for
 		 * the current move, e.g. for a book move.
+		 *
+		 * The move time is \a overrideElapsedMs if it isn't negative.
+		 * Otherwise the timer stops at \a endNs, or now if \a endNs
+		 * is negative.
 		 */
-		void update(bool applyIncrement = true, int64_t overrideElapsedMs = -1);
+		void update(bool applyIncrement = true,
+			    int64_t overrideElapsedMs = -1,
+			    qint64 endNs = -1);
 
 		/*! Returns the last elapsed move time. */
 		int lastMoveTime() const;
+		/*! Returns the last elapsed move time in microseconds. */
+		qint64 lastMoveTimeUs() const;
 
 		/*! Returns true if the allotted time has expired. */
 		bool expired() const;
@@ -209,15 +232,15 @@ class LIB_EXPORT TimeControl
 		int m_timePerTc;
 		int m_timePerMove;
 		int m_increment;
-		int m_timeLeft;
+		qint64 m_timeLeftUs;
 		int m_movesLeft;
 		int m_plyLimit;
 		int m_nodeLimit;
-		int m_lastMoveTime;
+		qint64 m_lastMoveTimeUs;
 		int m_expiryMargin;
 		bool m_expired;
 		bool m_infinite;
-		QElapsedTimer m_time;
+		qint64 m_startNs;
 };
 
 #endif // TIMECONTROL_H
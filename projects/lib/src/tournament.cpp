@@ -933,6 +933,39 @@ void Tournament::onGameStarted(ChessGame* game)
 	m_players[iBlack].setName(game->player(Chess::Side::Black)->name());
 
 	emit gameStarted(game, data->number, iWhite, iBlack);
+
+	prepareNextGame();
+}
+
+const PlayerBuilder* Tournament::builderByName(const QString& name) const
+{
+	for (const TournamentPlayer& player : m_players)
+	{
+		if (player.builder()->name() == name)
+			return player.builder();
+	}
+
+	return nullptr;
+}
+
+void Tournament::prepareNextGame()
+{
+	// Reloaded engines may have a different configuration
+	if (m_stopping || m_reloadEngines)
+		return;
+
+	// nextPair() can't be called ahead of time, so the prediction
+	// relies on the published schedule. Tournaments whose next
+	// pairing isn't known yet don't prepare anything.
+	const QList< QPair<QString, QString> > pairings(getPairings());
+	if (m_nextGameNumber >= pairings.size())
+		return;
+
+	const QPair<QString, QString>& pairing = pairings.at(m_nextGameNumber);
+	const PlayerBuilder* white = builderByName(pairing.first);
+	const PlayerBuilder* black = builderByName(pairing.second);
+	if (white != nullptr && black != nullptr)
+		m_gameManager->prepareGame(white, black);
 }
 
 void Tournament::onEngineUpdated(int engineIndex)
@@ -513,6 +513,9 @@ class LIB_EXPORT Tournament : public QObject
 			qreal eloDiff;
 		};
 
+		const PlayerBuilder* builderByName(const QString& name) const;
+		void prepareNextGame();
+
 		GameManager* m_gameManager;
 		EngineManager* m_engineManager;
 		ChessGame* m_lastGame;
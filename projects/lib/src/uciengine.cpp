@@ -19,6 +19,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 
 #include "board/board.h"
 #include "board/boardfactory.h"
@@ -84,6 +85,8 @@ QStringRef joinTokens(const QVarLengthArray<QStringRef>& tokens)
 
 UciEngine::UciEngine(QObject* parent)
 	: ChessEngine(parent),
+	  m_moveCount(0),
+	  m_baseMoveIndex(0),
 	  m_useDirectPv(false),
 	  m_sendOpponentsName(false),
 	  m_sendRatingAdv(false),
@@ -93,10 +96,16 @@ UciEngine::UciEngine(QObject* parent)
 	  m_ponderHits(0),
 	  m_ignoreThinking(false),
 	  m_rePing(false),
-	  m_cutesealMoveStartNs(0)
+	  m_cutesealMoveStartNs(0),
+	  m_thinkingTimer(new QTimer(this)),
+	  m_currentEvalPending(false)
 {
 	addVariant("standard");
 	setName("UciEngine");
+
+	m_thinkingTimer->setSingleShot(true);
+	connect(m_thinkingTimer, SIGNAL(timeout()),
+		this, SLOT(publishThinking()));
 }
 
 void UciEngine::startProtocol()
@@ -105,10 +114,31 @@ void UciEngine::startProtocol()
 	write("uci");
 }
 
+QString UciEngine::fenString() const
+{
+	if (board()->isRandomVariant())
+		return board()->fenString(Chess::Board::ShredderFen);
+	return board()->fenString(Chess::Board::XFen);
+}
+
 QString UciEngine::positionString()
 {
 	QString str("position");
 
+	// Positions before the last irreversible move can't repeat, so
+	// long games are sent from there instead of the starting position
+	const int deltaPlies = positionDeltaPlies();
+	if (deltaPlies > 0 && m_moveCount > deltaPlies && m_baseMoveIndex > 0)
+	{
+		str += QString(" fen ") + m_baseFen;
+		if (m_baseMoveIndex < m_moveStrings.size())
+		{
+			str += " moves";
+			str += m_moveStrings.midRef(m_baseMoveIndex);
+		}
+		return str;
+	}
+
 	if (board()->isRandomVariant() || m_startFen != board()->defaultFenString())
 		str += QString(" fen ") + m_startFen;
 	else
@@ -125,6 +155,27 @@ void UciEngine::sendPosition()
 	write(positionString());
 }
 
+void UciEngine::addMoveString(const QString& moveString)
+{
+	// The board is in the position before the move
+	if (board()->reversibleMoveCount() == 0)
+	{
+		m_baseFen = fenString();
+		m_baseMoveIndex = m_moveStrings.size();
+	}
+
+	m_moveStrings += " " + moveString;
+	m_moveCount++;
+}
+
+void UciEngine::removeLastMoveString()
+{
+	// The base position is the position before the removed move at
+	// the latest, so it's still part of the game
+	m_moveStrings.truncate(m_moveStrings.lastIndexOf(' '));
+	m_moveCount--;
+}
+
 void UciEngine::startGame()
 {
 	Q_ASSERT(supportsVariant(board()->variant()));
@@ -139,12 +190,13 @@ void UciEngine::startGame()
 	m_ponderHits = 0;
 	m_bmBuffer.clear();
 	m_moveStrings.clear();
+	m_moveCount = 0;
+	m_baseMoveIndex = 0;
 	m_useDirectPv = directPvList.contains(board()->variant());
+	clearPendingThinking();
 
-	if (board()->isRandomVariant())
-		m_startFen = board()->fenString(Chess::Board::ShredderFen);
-	else
-		m_startFen = board()->fenString(Chess::Board::XFen);
+	m_startFen = fenString();
+	m_baseFen = m_startFen;
 	setVariant(board()->variant());
 
 	write("ucinewgame");
@@ -173,6 +225,7 @@ void UciEngine::startGame()
 
 void UciEngine::endGame(const Chess::Result& result)
 {
+	publishThinking();
 	m_ignoreThinking = true;
 	if (stopThinking())
 		ping(false);
@@ -181,6 +234,9 @@ void UciEngine::endGame(const Chess::Result& result)
 
 void UciEngine::makeMove(const Chess::Move& move)
 {
+	// The pending PVs start from the current position
+	publishThinking();
+
 	if (!m_ponderMove.isNull())
 	{
 		m_movesPondered++;
@@ -197,7 +253,7 @@ void UciEngine::makeMove(const Chess::Move& move)
 			m_ponderMoveSan.clear();
 			if (m_ponderState != PonderHit)
 			{
-				m_moveStrings.truncate(m_moveStrings.lastIndexOf(' '));
+				removeLastMoveString();
 				if (isReady())
 				{
 					m_ignoreThinking = true;
@@ -217,7 +273,7 @@ void UciEngine::makeMove(const Chess::Move& move)
 	if (m_ponderState != PonderHit)
 	{
 		m_ponderState = NotPondering;
-		m_moveStrings += " " + board()->moveString(move, Chess::Board::LongAlgebraic);
+		addMoveString(board()->moveString(move, Chess::Board::LongAlgebraic));
 		if (m_ignoreThinking)
 			m_bmBuffer << positionString() << "isready";
 		else
@@ -227,6 +283,7 @@ void UciEngine::makeMove(const Chess::Move& move)
 
 void UciEngine::makeBookMove(const Chess::Move& move)
 {
+	publishThinking();
 	if (stopThinking())
 		ping(false);
 	clearPonderState();
@@ -236,10 +293,14 @@ void UciEngine::makeBookMove(const Chess::Move& move)
 
 void UciEngine::startThinking()
 {
+	// The evaluation was cleared by the clock
+	clearPendingThinking();
+
 	if (m_ponderState == PonderHit)
 	{
 		m_ponderState = NotPondering;
 		write("ponderhit");
+		startClockOnWrite();
 		return;
 	}
 
@@ -298,6 +359,7 @@ void UciEngine::startThinking()
 		command += QString(" nodes %1").arg(myTc->nodeLimit());
 
 	write(command);
+	startClockOnWrite();
 }
 
 void UciEngine::startPondering()
@@ -305,7 +367,7 @@ void UciEngine::startPondering()
 	if (!pondering() || m_ponderMove.isNull())
 		return;
 
-	m_moveStrings += " " + board()->moveString(m_ponderMove, Chess::Board::LongAlgebraic);
+	addMoveString(board()->moveString(m_ponderMove, Chess::Board::LongAlgebraic));
 	sendPosition();
 	ping();
 	startThinking();
@@ -313,6 +375,7 @@ void UciEngine::startPondering()
 
 void UciEngine::clearPonderState()
 {
+	publishThinking();
 	m_ponderState = NotPondering;
 	m_ponderMove = Chess::Move();
 	m_ponderMoveSan.clear();
@@ -421,7 +484,12 @@ void UciEngine::parseInfo(const QVarLengthArray<QStringRef>& tokens,
 		eval->setPvNumber(tokens[0].toString().toInt());
 		break;
 	case InfoPv:
-		eval->setPv(m_useDirectPv ?  directPv(tokens) : sanPv(tokens));
+		// Converting the PV to SAN is expensive, so it's done
+		// only when the evaluation is published
+		if (m_useDirectPv)
+			eval->setPv(directPv(tokens));
+		else
+			m_infoPv = joinTokens(tokens).toString();
 		break;
 	case InfoScore:
 		{
@@ -488,6 +556,7 @@ void UciEngine::parseInfo(const QStringRef& line)
 	QStringRef token(nextToken(line));
 	QVarLengthArray<QStringRef> tokens;
 	MoveEvaluation eval;
+	m_infoPv.clear();
 
 	// The "string" info is not supported and it can't be parsed
 	// like other info lines.
@@ -499,7 +568,7 @@ void UciEngine::parseInfo(const QStringRef& line)
 		token = parseUciTokens(token, types, 16, tokens, type);
 		parseInfo(tokens, type, &eval);
 	}
-	if (eval.isEmpty())
+	if (eval.isEmpty() && m_infoPv.isEmpty())
 		return;
 
 	if (!m_ponderMove.isNull())
@@ -512,13 +581,91 @@ void UciEngine::parseInfo(const QStringRef& line)
 	{
 		m_eval.merge(eval);
 		if (eval.depth() && eval.depth() != m_currentEval.depth())
+		{
+			// A pending PV belongs to the previous depth
+			if (m_infoPv.isEmpty())
+				updateEvalPv();
 			m_currentEval.clear();
+		}
 		m_currentEval.merge(eval);
+		if (!m_infoPv.isEmpty())
+			m_evalPv = m_infoPv;
+		m_currentEvalPending = true;
+	}
+	else
+	{
+		// Only the newest update of each PV is kept
+		m_pendingEvals[eval.pvNumber()].merge(eval);
+		if (!m_infoPv.isEmpty())
+			m_pendingPvs[eval.pvNumber()] = m_infoPv;
+	}
+
+	scheduleThinking();
+}
 
+void UciEngine::scheduleThinking()
+{
+	const int interval = thinkingInterval();
+	if (interval <= 0
+	||  !m_thinkingClock.isValid()
+	||  m_thinkingClock.elapsed() >= interval)
+	{
+		publishThinking();
+		return;
+	}
+
+	if (!m_thinkingTimer->isActive())
+		m_thinkingTimer->start(interval - int(m_thinkingClock.elapsed()));
+}
+
+void UciEngine::updateEvalPv()
+{
+	if (m_evalPv.isEmpty())
+		return;
+
+	const QString pv(sanPv(m_evalPv));
+	m_eval.setPv(pv);
+	m_currentEval.setPv(pv);
+	m_evalPv.clear();
+}
+
+void UciEngine::publishThinking()
+{
+	m_thinkingTimer->stop();
+	updateEvalPv();
+
+	if (m_currentEvalPending)
+	{
+		m_currentEvalPending = false;
+		m_thinkingClock.start();
 		emit thinking(m_currentEval);
 	}
-	else
+	if (m_pendingEvals.isEmpty())
+		return;
+
+	const QMap<int, MoveEvaluation> evals(m_pendingEvals);
+	const QMap<int, QString> pvs(m_pendingPvs);
+	m_pendingEvals.clear();
+	m_pendingPvs.clear();
+	m_thinkingClock.start();
+
+	QMap<int, MoveEvaluation>::const_iterator it;
+	for (it = evals.constBegin(); it != evals.constEnd(); ++it)
+	{
+		MoveEvaluation eval(it.value());
+		if (pvs.contains(it.key()))
+			eval.setPv(sanPv(pvs.value(it.key())));
 		emit thinking(eval);
+	}
+}
+
+void UciEngine::clearPendingThinking()
+{
+	m_thinkingTimer->stop();
+	m_currentEvalPending = false;
+	m_evalPv.clear();
+	m_pendingEvals.clear();
+	m_pendingPvs.clear();
 }
 
 EngineOption* UciEngine::parseOption(const QStringRef& line)
@@ -664,6 +811,12 @@ void UciEngine::parseLine(const QString& line)
 	}
 	else if (command == "bestmove")
 	{
+		// The move must not wait for the rest of the updates,
+		// only the primary PV is needed for its evaluation
+		m_pendingEvals.clear();
+		m_pendingPvs.clear();
+		publishThinking();
+
 		bool wasPondering = isPondering();
 		m_ponderState = NotPondering;
 		if (m_ignoreThinking)
@@ -686,7 +839,7 @@ void UciEngine::parseLine(const QString& line)
 				 qUtf8Printable(name()));
 			m_ponderMove = Chess::Move();
 			m_ponderMoveSan.clear();
-			m_moveStrings.truncate(m_moveStrings.lastIndexOf(' '));
+			removeLastMoveString();
 			pong();
 			return;
 		}
@@ -702,7 +855,7 @@ void UciEngine::parseLine(const QString& line)
 
 		QStringRef token(nextToken(command));
 		QString moveString(token.toString());
-		m_moveStrings += " " + moveString;
+		addMoveString(moveString);
 		Chess::Move move = board()->moveFromString(moveString);
 		if (move.isNull())
 		{
@@ -874,7 +1027,7 @@ QString UciEngine::directPv(const QVarLengthArray<QStringRef>& tokens)
 	return pv;
 }
 
-QString UciEngine::sanPv(const QVarLengthArray<QStringRef>& tokens)
+QString UciEngine::sanPv(const QString& pvString)
 {
 	Chess::Board* board = this->board();
 	QString pv;
@@ -886,7 +1039,8 @@ QString UciEngine::sanPv(const QVarLengthArray<QStringRef>& tokens)
 		movesMade++;
 	}
 
-	for (auto token : tokens)
+	const QVector<QStringRef> tokens(pvString.splitRef(' ', QString::SkipEmptyParts));
+	for (const QStringRef& token : tokens)
 	{
 		auto move = board->moveFromString(token.toString());
 		if (move.isNull())
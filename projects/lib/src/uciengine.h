@@ -20,6 +20,10 @@
 
 #include "chessengine.h"
 #include <QVarLengthArray>
+#include <QElapsedTimer>
+#include <QMap>
+
+class QTimer;
 
 
 /*!
@@ -56,6 +60,9 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		virtual bool isPondering() const;
 		virtual int getMaxNetLagMs() const { return isCuteseal() ? 600000 : 0; } // allow 600 secs on cuteseal
 
+	private slots:
+		void publishThinking();
+
 	private:
 		enum PonderState
 		{
@@ -76,15 +83,26 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		EngineOption* parseOption(const QStringRef& line);
 		void addVariantsFromOption(const EngineOption* option);
 		void setVariant(const QString& variant);
+		QString fenString() const;
 		QString positionString();
 		void sendPosition();
+		void addMoveString(const QString& moveString);
+		void removeLastMoveString();
 		void setPonderMove(const QString& moveString);
 		QString directPv(const QVarLengthArray<QStringRef>& tokens);
-		QString sanPv(const QVarLengthArray<QStringRef>& tokens);
+		QString sanPv(const QString& pvString);
+		void updateEvalPv();
+		void scheduleThinking();
+		void clearPendingThinking();
 		
 		QString m_variantOption;
 		QString m_startFen;
 		QString m_moveStrings;
+		int m_moveCount;
+		// Position after the last irreversible move, and the index
+		// of the moves played from it in m_moveStrings
+		QString m_baseFen;
+		int m_baseMoveIndex;
 		bool m_useDirectPv;
 		// Write buffer for messages that will be flushed to the engine
 		// after it sends a "bestmove"
@@ -100,6 +118,15 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		bool m_ignoreThinking;
 		bool m_rePing;
 		MoveEvaluation m_currentEval;
+		// Thinking updates that haven't been published yet. The PVs
+		// are kept in UCI notation until they're published.
+		QTimer* m_thinkingTimer;
+		QElapsedTimer m_thinkingClock;
+		bool m_currentEvalPending;
+		QString m_infoPv;
+		QString m_evalPv;
+		QMap<int, MoveEvaluation> m_pendingEvals;
+		QMap<int, QString> m_pendingPvs;
 		QStringList m_comboVariants;
 		uint64_t m_cutesealMoveStartNs;
 };
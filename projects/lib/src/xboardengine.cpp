@@ -354,6 +354,7 @@ void XboardEngine::startThinking()
 		write("go");
 	else
 		makeMove(m_nextMove);
+	startClockOnWrite();
 }
 
 void XboardEngine::onTimeout()
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_bitboard
+SOURCES += tst_bitboard.cpp
@@ -0,0 +1,330 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include <board/westernboard.h>
+#include <board/boardfactory.h>
+
+
+class tst_Bitboard: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void backend_data() const;
+		void backend();
+
+		void perft_data() const;
+		void perft();
+
+		void legality_data() const;
+		void legality();
+		void berolinaEnpassant();
+
+	private:
+		bool compareTree(Chess::WesternBoard* board,
+				 int depth,
+				 quint64* nodeCount);
+		bool compareLegality(Chess::WesternBoard* board, int depth);
+
+		QString m_failure;
+};
+
+
+static QVector<quint32> moveKeys(const QVector<Chess::Move>& moves)
+{
+	QVector<quint32> keys;
+	keys.reserve(moves.size());
+	for (const Chess::Move& move : moves)
+	{
+		keys << ((quint32(move.sourceSquare()) << 16)
+		      |  (quint32(move.targetSquare()) << 8)
+		      |  quint32(move.promotion()));
+	}
+	std::sort(keys.begin(), keys.end());
+
+	return keys;
+}
+
+bool tst_Bitboard::compareTree(Chess::WesternBoard* board,
+			       int depth,
+			       quint64* nodeCount)
+{
+	const QVector<Chess::Move> moves(board->legalMoves());
+	const QString result(board->result().toShortString());
+
+	board->setBitboardsEnabled(false);
+	board->setLegalityShortcutEnabled(false);
+	const QVector<Chess::Move> mailboxMoves(board->legalMoves());
+	const QString mailboxResult(board->result().toShortString());
+	board->setLegalityShortcutEnabled(true);
+	board->setBitboardsEnabled(true);
+
+	if (moveKeys(moves) != moveKeys(mailboxMoves)
+	||  result != mailboxResult)
+	{
+		m_failure = QString("%1: %2 moves, mailbox: %3 moves")
+			    .arg(board->fenString())
+			    .arg(moves.size())
+			    .arg(mailboxMoves.size());
+		return false;
+	}
+
+	if (depth <= 1)
+	{
+		*nodeCount += moves.size();
+		return true;
+	}
+
+	for (const Chess::Move& move : moves)
+	{
+		board->makeMove(move);
+		bool ok = compareTree(board, depth - 1, nodeCount);
+		board->undoMove();
+		if (!ok)
+			return false;
+	}
+
+	return true;
+}
+
+bool tst_Bitboard::compareLegality(Chess::WesternBoard* board, int depth)
+{
+	const QVector<Chess::Move> moves(board->legalMoves());
+
+	board->setLegalityShortcutEnabled(false);
+	const QVector<Chess::Move> madeMoves(board->legalMoves());
+	board->setLegalityShortcutEnabled(true);
+
+	if (moveKeys(moves) != moveKeys(madeMoves))
+	{
+		m_failure = QString("%1: %2 moves, make/undo: %3 moves")
+			    .arg(board->fenString())
+			    .arg(moves.size())
+			    .arg(madeMoves.size());
+		return false;
+	}
+
+	if (depth <= 1)
+		return true;
+
+	for (const Chess::Move& move : moves)
+	{
+		board->makeMove(move);
+		bool ok = compareLegality(board, depth - 1);
+		board->undoMove();
+		if (!ok)
+			return false;
+	}
+
+	return true;
+}
+
+
+void tst_Bitboard::backend_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<bool>("bitboards");
+
+	QTest::newRow("standard") << "standard" << true;
+	QTest::newRow("fischerandom") << "fischerandom" << true;
+	QTest::newRow("kingofthehill") << "kingofthehill" << true;
+	QTest::newRow("3check") << "3check" << true;
+	QTest::newRow("antichess") << "antichess" << false;
+	QTest::newRow("andernach") << "andernach" << false;
+	QTest::newRow("berolina") << "berolina" << false;
+	QTest::newRow("extinction") << "extinction" << false;
+	QTest::newRow("horde") << "horde" << false;
+	QTest::newRow("atomic") << "atomic" << false;
+	QTest::newRow("capablanca") << "capablanca" << false;
+}
+
+void tst_Bitboard::backend()
+{
+	QFETCH(QString, variant);
+	QFETCH(bool, bitboards);
+
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	QVERIFY(board != nullptr);
+	QVERIFY(board->setFenString(board->defaultFenString()));
+
+	auto westernBoard = dynamic_cast<Chess::WesternBoard*>(board);
+	QVERIFY(westernBoard != nullptr);
+	QCOMPARE(westernBoard->usesBitboards(), bitboards);
+
+	westernBoard->setBitboardsEnabled(false);
+	QVERIFY(!westernBoard->usesBitboards());
+
+	delete board;
+}
+
+void tst_Bitboard::perft_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<int>("depth");
+	QTest::addColumn<quint64>("nodecount");
+
+	QString variant = "standard";
+
+	QTest::newRow("startpos")
+		<< variant
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< 3
+		<< Q_UINT64_C(8902);
+	QTest::newRow("pos2")
+		<< variant
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"
+		<< 3
+		<< Q_UINT64_C(97862);
+	QTest::newRow("pos3")
+		<< variant
+		<< "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -"
+		<< 4
+		<< Q_UINT64_C(43238);
+	QTest::newRow("pos4")
+		<< variant
+		<< "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+		<< 3
+		<< Q_UINT64_C(9467);
+	QTest::newRow("pos5")
+		<< variant
+		<< "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+		<< 3
+		<< Q_UINT64_C(62379);
+	QTest::newRow("pos6")
+		<< variant
+		<< "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+		<< 3
+		<< Q_UINT64_C(89890);
+	QTest::newRow("en passant pin")
+		<< variant
+		<< "8/8/8/KPp4r/8/8/8/6k1 w - c6 0 2"
+		<< 1
+		<< Q_UINT64_C(4);
+
+	variant = "fischerandom";
+	QTest::newRow("frc1")
+		<< variant
+		<< "1rk3r1/8/8/8/8/8/8/1RK1R3 w EBgb -"
+		<< 2
+		<< Q_UINT64_C(464);
+	QTest::newRow("frc3")
+		<< variant
+		<< "2rkr3/5PP1/8/5Q2/5q2/8/5pp1/2RKR3 w KQkq - 0 1"
+		<< 3
+		<< Q_UINT64_C(71005);
+	QTest::newRow("frc4")
+		<< variant
+		<< "2Rnb1kr/5ppp/8/q3p3/p3P3/4P3/6PP/1Q3BKR b Hh - 0 15"
+		<< 3
+		<< Q_UINT64_C(24750);
+}
+
+void tst_Bitboard::perft()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(int, depth);
+	QFETCH(quint64, nodecount);
+
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	QVERIFY(board != nullptr);
+	QVERIFY(board->setFenString(fen));
+
+	auto westernBoard = dynamic_cast<Chess::WesternBoard*>(board);
+	QVERIFY(westernBoard != nullptr);
+	QVERIFY(westernBoard->usesBitboards());
+
+	// Every node of the tree must have the same legal moves
+	// and result with both move generators
+	quint64 nodes = 0;
+	bool ok = compareTree(westernBoard, depth, &nodes);
+	delete board;
+
+	QVERIFY2(ok, qPrintable(m_failure));
+	QCOMPARE(nodes, nodecount);
+}
+
+void tst_Bitboard::legality_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<int>("depth");
+
+	// An empty FEN string stands for the default position
+	QTest::newRow("standard") << "standard" << "" << 3;
+	QTest::newRow("standard pos2")
+		<< "standard"
+		<< "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"
+		<< 2;
+	QTest::newRow("standard pos3")
+		<< "standard" << "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -" << 4;
+	QTest::newRow("standard pos4")
+		<< "standard"
+		<< "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+		<< 2;
+	QTest::newRow("en passant pin")
+		<< "standard" << "8/8/8/KPp4r/8/8/8/6k1 w - c6 0 2" << 2;
+	QTest::newRow("frc1")
+		<< "fischerandom" << "1rk3r1/8/8/8/8/8/8/1RK1R3 w EBgb -" << 2;
+	QTest::newRow("frc4")
+		<< "fischerandom"
+		<< "2Rnb1kr/5ppp/8/q3p3/p3P3/4P3/6PP/1Q3BKR b Hh - 0 15"
+		<< 2;
+	QTest::newRow("capablanca") << "capablanca" << "" << 2;
+	QTest::newRow("gothic") << "gothic" << "" << 2;
+	QTest::newRow("grand") << "grand" << "" << 2;
+	QTest::newRow("berolina") << "berolina" << "" << 3;
+	QTest::newRow("berolina en passant")
+		<< "berolina" << "4k3/8/8/1pPP4/8/8/8/4K3 w - c6b5 0 1" << 2;
+}
+
+void tst_Bitboard::legality()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(int, depth);
+
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	QVERIFY(board != nullptr);
+	QVERIFY(board->setFenString(fen.isEmpty() ? board->defaultFenString() : fen));
+
+	auto westernBoard = dynamic_cast<Chess::WesternBoard*>(board);
+	QVERIFY(westernBoard != nullptr);
+	westernBoard->setBitboardsEnabled(false);
+
+	// Every node of the tree must have the same legal moves whether
+	// or not the moves are made to check their legality
+	bool ok = compareLegality(westernBoard, depth);
+	delete board;
+
+	QVERIFY2(ok, qPrintable(m_failure));
+}
+
+void tst_Bitboard::berolinaEnpassant()
+{
+	Chess::Board* board = Chess::BoardFactory::create("berolina");
+	QVERIFY(board != nullptr);
+	QVERIFY(board->setFenString("4k3/8/8/1pPP4/8/8/8/4K3 w - c6b5 0 1"));
+	const Chess::Square epVictim(1, 4);
+
+	// A diagonal step to the en-passant square isn't a capture
+	Chess::Move move(board->moveFromString("d5c6"));
+	QVERIFY(!move.isNull());
+	QVERIFY(board->isLegalMove(move));
+	board->makeMove(move);
+	QCOMPARE(board->pieceAt(epVictim), Chess::Piece(Chess::Side::Black, Chess::WesternBoard::Pawn));
+	board->undoMove();
+
+	// A straight step to it is
+	move = board->moveFromString("c5c6");
+	QVERIFY(!move.isNull());
+	board->makeMove(move);
+	QCOMPARE(board->pieceAt(epVictim), Chess::Piece());
+	board->undoMove();
+	QCOMPARE(board->pieceAt(epVictim), Chess::Piece(Chess::Side::Black, Chess::WesternBoard::Pawn));
+
+	delete board;
+}
+
+QTEST_MAIN(tst_Bitboard)
+#include "tst_bitboard.moc"
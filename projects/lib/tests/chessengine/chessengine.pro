@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_chessengine
+SOURCES += tst_chessengine.cpp
@@ -0,0 +1,166 @@
+#include <QtTest/QtTest>
+#include <chessengine.h>
+
+namespace {
+
+// A sequential device whose input is fed by the test
+class FeedDevice : public QIODevice
+{
+	public:
+		FeedDevice()
+		{
+			open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+		}
+
+		void feed(const QByteArray& data)
+		{
+			m_data.append(data);
+			emit readyRead();
+		}
+
+		virtual bool isSequential() const
+		{
+			return true;
+		}
+
+		virtual qint64 bytesAvailable() const
+		{
+			return m_data.size() + QIODevice::bytesAvailable();
+		}
+
+	protected:
+		virtual qint64 readData(char* data, qint64 maxSize)
+		{
+			const int n = int(qMin(maxSize, qint64(m_data.size())));
+			memcpy(data, m_data.constData(), size_t(n));
+			m_data.remove(0, n);
+			return n;
+		}
+
+		virtual qint64 writeData(const char* data, qint64 maxSize)
+		{
+			Q_UNUSED(data);
+			return maxSize;
+		}
+
+	private:
+		QByteArray m_data;
+};
+
+// An engine that records the lines it parses. Parsing the line
+// "feed" feeds more input, which is read before the line returns.
+class LineEngine : public ChessEngine
+{
+	public:
+		LineEngine()
+			: m_device(new FeedDevice)
+		{
+			setDevice(m_device);
+		}
+
+		void feed(const QByteArray& data)
+		{
+			m_device->feed(data);
+		}
+
+		virtual QString protocol() const
+		{
+			return "test";
+		}
+
+		QStringList lines;
+		QByteArray nestedInput;
+
+	protected:
+		virtual void startGame() {}
+		virtual void startThinking() {}
+		virtual void startProtocol() {}
+		virtual void makeMove(const Chess::Move& move)
+		{
+			Q_UNUSED(move);
+		}
+		virtual bool sendPing()
+		{
+			return false;
+		}
+		virtual void sendStop() {}
+		virtual void sendQuit() {}
+		virtual void sendOption(const QString& name, const QVariant& value)
+		{
+			Q_UNUSED(name);
+			Q_UNUSED(value);
+		}
+
+		virtual void parseLine(const QString& line)
+		{
+			lines << line;
+			if (line == "feed")
+				feed(nestedInput);
+		}
+
+	private:
+		FeedDevice* m_device;
+};
+
+} // anonymous namespace
+
+class tst_ChessEngine: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void lines_data() const;
+		void lines();
+		void reentrantInput();
+};
+
+void tst_ChessEngine::lines_data() const
+{
+	QTest::addColumn<QList<QByteArray>>("input");
+	QTest::addColumn<QStringList>("lines");
+
+	QTest::newRow("one read")
+		<< (QList<QByteArray>() << "uciok\nreadyok\n")
+		<< (QStringList() << "uciok" << "readyok");
+	QTest::newRow("crlf")
+		<< (QList<QByteArray>() << "id name x\r\n\r\nuciok\r\n")
+		<< (QStringList() << "id name x" << "uciok");
+	QTest::newRow("partial line")
+		<< (QList<QByteArray>() << "bestmo" << "ve e2e4" << "\nreadyok\nin")
+		<< (QStringList() << "bestmove e2e4" << "readyok");
+	QTest::newRow("split crlf")
+		<< (QList<QByteArray>() << "readyok\r" << "\nuciok\r" << "\n")
+		<< (QStringList() << "readyok" << "uciok");
+	QTest::newRow("utf-8")
+		<< (QList<QByteArray>() << "id author J\xc3" << "\xa4rvi\n")
+		<< (QStringList() << QString::fromUtf8("id author J\xc3\xa4rvi"));
+}
+
+void tst_ChessEngine::lines()
+{
+	QFETCH(QList<QByteArray>, input);
+	QFETCH(QStringList, lines);
+
+	LineEngine engine;
+	for (const QByteArray& data : qAsConst(input))
+		engine.feed(data);
+
+	QCOMPARE(engine.lines, lines);
+}
+
+void tst_ChessEngine::reentrantInput()
+{
+	// The input fed while "feed" is parsed is read by a nested
+	// call. The lines are still parsed once each and in order.
+	LineEngine engine;
+	engine.nestedInput = "second\nthi";
+	engine.feed("first\nfeed\n");
+	QCOMPARE(engine.lines, QStringList() << "first" << "feed" << "second");
+
+	engine.feed("rd\n");
+	QCOMPARE(engine.lines, QStringList()
+		 << "first" << "feed" << "second" << "third");
+}
+
+QTEST_MAIN(tst_ChessEngine)
+#include "tst_chessengine.moc"
@@ -0,0 +1,139 @@
+#include <QtTest/QtTest>
+#include <cpuallocator.h>
+
+class tst_CpuAllocator: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void smt();
+		void numa();
+		void noNuma();
+		void toggleSmt();
+		void lists_data() const;
+		void lists();
+		void invalidLists();
+
+	private:
+		static QList<CpuAllocator::Cpu> topology();
+		static QList<int> cpus(const QString& str);
+};
+
+QList<CpuAllocator::Cpu> tst_CpuAllocator::topology()
+{
+	// Two NUMA nodes with two cores each, and two SMT siblings
+	// per core. The siblings of CPU 0 and 4 are CPU 2 and 6.
+	QList<CpuAllocator::Cpu> list;
+	for (int id = 0; id < 8; id++)
+	{
+		const int node = id / 4;
+		CpuAllocator::Cpu cpu = { id, node * 2 + id % 2, node };
+		list << cpu;
+	}
+
+	return list;
+}
+
+QList<int> tst_CpuAllocator::cpus(const QString& str)
+{
+	return CpuAllocator::parseList(str);
+}
+
+void tst_CpuAllocator::smt()
+{
+	CpuAllocator allocator(topology());
+	QCOMPARE(allocator.cpuCount(), 8);
+	QCOMPARE(allocator.freeCpuCount(), 8);
+
+	// Whole cores are allocated
+	QCOMPARE(allocator.allocate(1), cpus("0,2"));
+	QCOMPARE(allocator.allocate(1), cpus("1,3"));
+	QCOMPARE(allocator.allocate(2), cpus("4-7"));
+	QCOMPARE(allocator.freeCpuCount(), 0);
+	QVERIFY(allocator.allocate(1).isEmpty());
+
+	allocator.release(cpus("1,3"));
+	QCOMPARE(allocator.freeCpuCount(), 2);
+	QCOMPARE(allocator.allocate(1), cpus("1,3"));
+
+	QVERIFY(allocator.allocate(0).isEmpty());
+	QVERIFY(CpuAllocator().allocate(1).isEmpty());
+}
+
+void tst_CpuAllocator::numa()
+{
+	CpuAllocator allocator(topology());
+	allocator.setRespectSmt(false);
+
+	QCOMPARE(allocator.allocate(3), cpus("0-2"));
+	// The first node doesn't have room anymore
+	QCOMPARE(allocator.allocate(2), cpus("4,5"));
+	// The fullest node that has room is used
+	QCOMPARE(allocator.allocate(1), cpus("3"));
+	allocator.release(cpus("3"));
+	// No node has room, so the CPUs come from both
+	QCOMPARE(allocator.allocate(3), cpus("3,6,7"));
+}
+
+void tst_CpuAllocator::noNuma()
+{
+	CpuAllocator allocator(topology());
+	allocator.setRespectSmt(false);
+	allocator.setRespectNuma(false);
+
+	QCOMPARE(allocator.allocate(3), cpus("0-2"));
+	QCOMPARE(allocator.allocate(2), cpus("3,4"));
+	QCOMPARE(allocator.allocate(4).size(), 0);
+	QCOMPARE(allocator.allocate(3), cpus("5-7"));
+}
+
+void tst_CpuAllocator::toggleSmt()
+{
+	CpuAllocator allocator(topology());
+	allocator.setRespectSmt(false);
+	QCOMPARE(allocator.allocate(1), cpus("0"));
+
+	// The allocated CPU keeps its whole core busy
+	allocator.setRespectSmt(true);
+	QCOMPARE(allocator.freeCpuCount(), 6);
+	QCOMPARE(allocator.allocate(1), cpus("1,3"));
+
+	allocator.release(cpus("0"));
+	QCOMPARE(allocator.allocate(1), cpus("0,2"));
+}
+
+void tst_CpuAllocator::lists_data() const
+{
+	QTest::addColumn<QString>("str");
+	QTest::addColumn<QString>("normalized");
+	QTest::addColumn<int>("count");
+
+	QTest::newRow("empty") << "" << "" << 0;
+	QTest::newRow("single") << "5" << "5" << 1;
+	QTest::newRow("range") << "0-3" << "0-3" << 4;
+	QTest::newRow("mixed") << "0-3,8,10-11" << "0-3,8,10-11" << 7;
+	QTest::newRow("adjacent") << "0,1,2,4" << "0-2,4" << 4;
+	QTest::newRow("whitespace") << "0 - 1,\n3\n" << "0-1,3" << 3;
+}
+
+void tst_CpuAllocator::lists()
+{
+	QFETCH(QString, str);
+	QFETCH(QString, normalized);
+	QFETCH(int, count);
+
+	const QList<int> list(CpuAllocator::parseList(str));
+	QCOMPARE(list.size(), count);
+	QCOMPARE(CpuAllocator::toString(list), normalized);
+}
+
+void tst_CpuAllocator::invalidLists()
+{
+	QVERIFY(CpuAllocator::parseList("3-1").isEmpty());
+	QVERIFY(CpuAllocator::parseList("a").isEmpty());
+	QVERIFY(CpuAllocator::parseList("0,-1").isEmpty());
+	QVERIFY(CpuAllocator::parseList("1-").isEmpty());
+}
+
+QTEST_MAIN(tst_CpuAllocator)
+#include "tst_cpuallocator.moc"
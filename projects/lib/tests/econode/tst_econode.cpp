@@ -0,0 +1,88 @@
+#include <QtTest/QtTest>
+#include <econode.h>
+#include <pgngame.h>
+#include <board/board.h>
+
+class tst_EcoNode: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void classify();
+		void maxPlies();
+		void unknownKey();
+
+	private:
+		static bool addMoves(PgnGame& game, const QStringList& moves);
+};
+
+bool tst_EcoNode::addMoves(PgnGame& game, const QStringList& moves)
+{
+	Chess::Board* board = game.createBoard();
+	if (board == nullptr)
+		return false;
+	for (const PgnGame::MoveData& md : game.moves())
+		board->makeMove(board->moveFromGenericMove(md.move));
+
+	bool ok = true;
+	for (const QString& moveString : moves)
+	{
+		const Chess::Move move(board->moveFromString(moveString));
+		if (move.isNull())
+		{
+			ok = false;
+			break;
+		}
+
+		PgnGame::MoveData md;
+		md.key = board->key();
+		md.move = board->genericMove(move);
+		md.moveString = moveString;
+		board->makeMove(move);
+		game.addMove(md, board->key());
+	}
+
+	delete board;
+	return ok;
+}
+
+void tst_EcoNode::classify()
+{
+	PgnGame game;
+	QVERIFY(addMoves(game, {"e4", "c5"}));
+	QCOMPARE(game.tagValue("Opening"), QString("Sicilian defence"));
+	QVERIFY(game.tagValue("ECO").startsWith("B"));
+
+	// Leaving the book keeps the last classification
+	const QString eco(game.tagValue("ECO"));
+	QVERIFY(addMoves(game, {"a3", "h6"}));
+	QCOMPARE(game.tagValue("ECO"), eco);
+
+	// A cleared game is classified again
+	game.clear();
+	QVERIFY(addMoves(game, {"e4", "c5"}));
+	QCOMPARE(game.tagValue("ECO"), eco);
+}
+
+void tst_EcoNode::maxPlies()
+{
+	QVERIFY(EcoNode::maxPlies() > 0);
+
+	// Moves after the longest opening line don't change the tags
+	PgnGame game;
+	const QStringList shuffle {"Nf3", "Nf6", "Ng1", "Ng8"};
+	while (game.moves().size() <= EcoNode::maxPlies())
+		QVERIFY(addMoves(game, shuffle));
+	game.setTag("ECO", "X00");
+	QVERIFY(addMoves(game, {"e4", "c5"}));
+	QCOMPARE(game.tagValue("ECO"), QString("X00"));
+}
+
+void tst_EcoNode::unknownKey()
+{
+	QVERIFY(EcoNode::find(0) == nullptr);
+	QVERIFY(EcoNode::find(Q_UINT64_C(0x0123456789abcdef)) == nullptr);
+}
+
+QTEST_MAIN(tst_EcoNode)
+#include "tst_econode.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_linequeue
+SOURCES += tst_linequeue.cpp
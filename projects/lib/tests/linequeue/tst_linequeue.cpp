@@ -0,0 +1,121 @@
+#include <QtTest/QtTest>
+#include <linequeue.h>
+
+class tst_LineQueue: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void capacity();
+		void fifo();
+		void wrapAround();
+		void threads();
+};
+
+class LineProducer : public QThread
+{
+	public:
+		LineProducer(LineQueue* queue, int count)
+			: m_queue(queue),
+			  m_count(count)
+		{
+		}
+
+	protected:
+		virtual void run()
+		{
+			for (int i = 0; i < m_count; i++)
+			{
+				const QByteArray line(QByteArray::number(i) + "\n");
+				while (!m_queue->push(line, i))
+					yieldCurrentThread();
+			}
+		}
+
+	private:
+		LineQueue* m_queue;
+		int m_count;
+};
+
+void tst_LineQueue::capacity()
+{
+	QCOMPARE(LineQueue(1).capacity(), 1);
+	QCOMPARE(LineQueue(4).capacity(), 4);
+	QCOMPARE(LineQueue(5).capacity(), 8);
+	QCOMPARE(LineQueue(0).capacity(), 1);
+
+	LineQueue queue(2);
+	QVERIFY(queue.isEmpty());
+	QVERIFY(!queue.isFull());
+	QVERIFY(queue.push("a\n", 1));
+	QVERIFY(queue.push("b\n", 2));
+	QVERIFY(queue.isFull());
+	QVERIFY(!queue.push("c\n", 3));
+}
+
+void tst_LineQueue::fifo()
+{
+	LineQueue queue(4);
+	QByteArray line;
+	qint64 ns = 0;
+	QVERIFY(!queue.pop(&line, &ns));
+
+	queue.push("info depth 1\n", 10);
+	queue.push("bestmove e2e4\n", 20);
+	QVERIFY(queue.pop(&line, &ns));
+	QCOMPARE(line, QByteArray("info depth 1\n"));
+	QCOMPARE(ns, qint64(10));
+	QVERIFY(queue.pop(&line, &ns));
+	QCOMPARE(line, QByteArray("bestmove e2e4\n"));
+	QCOMPARE(ns, qint64(20));
+	QVERIFY(queue.isEmpty());
+}
+
+void tst_LineQueue::wrapAround()
+{
+	LineQueue queue(4);
+	QByteArray line;
+	qint64 ns = 0;
+
+	for (int i = 0; i < 100; i++)
+	{
+		QVERIFY(queue.push(QByteArray::number(i), i));
+		QVERIFY(queue.push(QByteArray::number(i + 1000), i + 1000));
+		QVERIFY(queue.pop(&line, &ns));
+		QCOMPARE(line, QByteArray::number(i));
+		QVERIFY(queue.pop(&line, &ns));
+		QCOMPARE(ns, qint64(i + 1000));
+	}
+	QVERIFY(queue.isEmpty());
+}
+
+void tst_LineQueue::threads()
+{
+	const int count = 100000;
+	LineQueue queue(16);
+	LineProducer producer(&queue, count);
+	producer.start();
+
+	QByteArray line;
+	qint64 ns = 0;
+	int i = 0;
+	while (i < count)
+	{
+		if (!queue.pop(&line, &ns))
+		{
+			QThread::yieldCurrentThread();
+			continue;
+		}
+
+		// Any lost or reordered line fails the test
+		QCOMPARE(ns, qint64(i));
+		QCOMPARE(line, QByteArray::number(i) + "\n");
+		i++;
+	}
+
+	QVERIFY(producer.wait(10000));
+	QVERIFY(queue.isEmpty());
+}
+
+QTEST_MAIN(tst_LineQueue)
+#include "tst_linequeue.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_livefilewriter
+SOURCES += tst_livefilewriter.cpp
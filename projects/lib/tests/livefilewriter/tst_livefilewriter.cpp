@@ -0,0 +1,109 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <livefilewriter.h>
+#include <pgngame.h>
+
+class tst_LiveFileWriter: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void coalesce();
+		void pgn();
+		void capacity();
+
+	private:
+		static QString readFile(const QString& fileName);
+};
+
+QString tst_LiveFileWriter::readFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return QString();
+	return QString::fromUtf8(file.readAll());
+}
+
+void tst_LiveFileWriter::coalesce()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(dir.path() + "/live.json");
+
+	LiveFileWriter writer;
+	writer.setFlushInterval(10000);
+	for (int i = 0; i < 100; i++)
+		writer.writeText(fileName, QString("[%1]").arg(i));
+
+	// Only the last update is written, and flush() doesn't wait
+	// for the flush interval
+	QElapsedTimer timer;
+	timer.start();
+	writer.flush();
+	QVERIFY(timer.elapsed() < 5000);
+
+	QCOMPARE(readFile(fileName), QString("[99]"));
+	QVERIFY(!QFile::exists(dir.path() + "/live_temp.json"));
+
+	writer.writeText(fileName, "[100]");
+	writer.stop();
+	QCOMPARE(readFile(fileName), QString("[100]"));
+}
+
+void tst_LiveFileWriter::pgn()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(dir.path() + "/live.pgn");
+
+	PgnGame game;
+	game.setEvent("Live");
+	game.setSite("Here");
+	game.setRound(1);
+	game.setPlayerName(Chess::Side::White, "white");
+	game.setPlayerName(Chess::Side::Black, "black");
+	game.setResult(Chess::Result());
+
+	QString expected;
+	QTextStream out(&expected);
+	PgnGame copy(game);
+	copy.write(out, PgnGame::Minimal);
+
+	LiveFileWriter writer;
+	writer.setFlushInterval(0);
+	writer.writePgn(fileName, game, PgnGame::Minimal);
+	writer.flush();
+	QCOMPARE(readFile(fileName), expected);
+
+	// Every snapshot replaces the file instead of appending to it
+	writer.writePgn(fileName, game, PgnGame::Minimal);
+	writer.flush();
+	QCOMPARE(readFile(fileName), expected);
+}
+
+void tst_LiveFileWriter::capacity()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+
+	LiveFileWriter writer;
+	writer.setFlushInterval(10);
+	writer.setCapacity(2);
+	QCOMPARE(writer.capacity(), 2);
+
+	for (int i = 0; i < 10; i++)
+	{
+		const QString fileName(QString("%1/live%2.txt").arg(dir.path()).arg(i));
+		writer.writeText(fileName, QString::number(i));
+	}
+	writer.flush();
+
+	for (int i = 0; i < 10; i++)
+	{
+		const QString fileName(QString("%1/live%2.txt").arg(dir.path()).arg(i));
+		QCOMPARE(readFile(fileName), QString::number(i));
+	}
+}
+
+QTEST_MAIN(tst_LiveFileWriter)
+#include "tst_livefilewriter.moc"
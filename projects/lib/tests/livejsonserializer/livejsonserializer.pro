@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_livejsonserializer
+SOURCES += tst_livejsonserializer.cpp
@@ -0,0 +1,182 @@
+#include <QtTest/QtTest>
+#include <livejsonserializer.h>
+#include <pgngame.h>
+#include <jsonparser.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+class tst_LiveJsonSerializer: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void incremental();
+		void pv();
+		void lastComment();
+		void newGame();
+
+	private:
+		static void addMoves(PgnGame& game,
+				     const QStringList& moves,
+				     const QStringList& comments);
+		static QVariantMap parse(const QString& json);
+};
+
+void tst_LiveJsonSerializer::addMoves(PgnGame& game,
+				      const QStringList& moves,
+				      const QStringList& comments)
+{
+	Chess::Board* board = game.createBoard();
+	QVERIFY(board != nullptr);
+	for (const PgnGame::MoveData& md : game.moves())
+		board->makeMove(board->moveFromGenericMove(md.move));
+
+	for (int i = 0; i < moves.size(); i++)
+	{
+		const Chess::Move move(board->moveFromString(moves.at(i)));
+		QVERIFY(!move.isNull());
+
+		PgnGame::MoveData md;
+		md.key = board->key();
+		md.move = board->genericMove(move);
+		md.moveString = moves.at(i);
+		md.comment = comments.value(i);
+		board->makeMove(move);
+		game.addMove(md, board->key(), false);
+	}
+
+	delete board;
+}
+
+QVariantMap tst_LiveJsonSerializer::parse(const QString& json)
+{
+	QString str(json);
+	QTextStream stream(&str, QIODevice::ReadOnly);
+	JsonParser parser(stream);
+	return parser.parse().toMap();
+}
+
+void tst_LiveJsonSerializer::incremental()
+{
+	const QStringList moves {"e4", "c5", "Nf3", "d6", "d4", "cxd4"};
+	const QStringList comments {
+		"book", "book",
+		"d=20, sd=30, pv=Nf3 d6 d4, mb=+0+0+0+0+0, R50=49",
+		"d=21, pv=d6 d4 cxd4, Rd=-11",
+		"d=22, pv=d4 cxd4 Nxd4",
+		"d=23, pv=cxd4 Nxd4, Rr=-1000"
+	};
+
+	PgnGame game;
+	game.setTag("White", "Engine A");
+	game.setTag("Black", "Engine B");
+
+	LiveJsonSerializer live;
+	QString json;
+	for (int i = 0; i < moves.size(); i++)
+	{
+		addMoves(game, moves.mid(i, 1), comments.mid(i, 1));
+		json = live.serialize(game);
+		QVERIFY(!json.isEmpty());
+	}
+
+	// The cached records must match a serialization from scratch
+	LiveJsonSerializer fresh;
+	QCOMPARE(json, fresh.serialize(game));
+
+	const QVariantMap map(parse(json));
+	QCOMPARE(map["Headers"].toMap()["White"].toString(), QString("Engine A"));
+
+	const QVariantList moveList(map["Moves"].toList());
+	QCOMPARE(moveList.size(), moves.size());
+
+	const QVariantMap first(moveList.at(0).toMap());
+	QCOMPARE(first["m"].toString(), QString("e4"));
+	QCOMPARE(first["from"].toString(), QString("e2"));
+	QCOMPARE(first["to"].toString(), QString("e4"));
+	QCOMPARE(first["book"].toBool(), true);
+
+	const QVariantMap third(moveList.at(2).toMap());
+	QCOMPARE(third["book"].toBool(), false);
+	QCOMPARE(third["d"].toString(), QString("20"));
+	QCOMPARE(third["material"].toMap()["q"].toInt(), 0);
+	QCOMPARE(third["adjudication"].toMap()["FiftyMoves"].toInt(), 49);
+	QCOMPARE(moveList.at(3).toMap()["adjudication"].toMap()["Draw"].toInt(), -11);
+	QCOMPARE(moveList.at(5).toMap()["adjudication"].toMap()["ResignOrWin"].toInt(), -1000);
+}
+
+void tst_LiveJsonSerializer::pv()
+{
+	PgnGame game;
+	addMoves(game, {"e4", "e5"}, {"pv=e4 e5 Nf3", "pv=e5 Nf3 xx Nc6"});
+
+	LiveJsonSerializer live;
+	const QVariantList moveList(parse(live.serialize(game))["Moves"].toList());
+	QCOMPARE(moveList.size(), 2);
+
+	Chess::Board* board = game.createBoard();
+	QVERIFY(board != nullptr);
+
+	const QVariantMap pv(moveList.at(0).toMap()["pv"].toMap());
+	QCOMPARE(pv["San"].toString(), QString("e4 e5 Nf3"));
+	const QVariantList pvMoves(pv["Moves"].toList());
+	QCOMPARE(pvMoves.size(), 3);
+	for (int i = 0; i < pvMoves.size(); i++)
+	{
+		const QVariantMap pvMove(pvMoves.at(i).toMap());
+		board->makeMove(board->moveFromString(pvMove["m"].toString()));
+		QCOMPARE(pvMove["fen"].toString(), board->fenString());
+	}
+	QCOMPARE(pvMoves.at(2).toMap()["from"].toString(), QString("g1"));
+	QCOMPARE(pvMoves.at(2).toMap()["to"].toString(), QString("f3"));
+
+	// The PV stops at the first illegal move
+	const QVariantMap pv2(moveList.at(1).toMap()["pv"].toMap());
+	QCOMPARE(pv2["Moves"].toList().size(), 2);
+
+	// The move's own FEN isn't affected by the PV
+	board->undoMove();
+	QCOMPARE(moveList.at(1).toMap()["fen"].toString(), board->fenString());
+	delete board;
+}
+
+void tst_LiveJsonSerializer::lastComment()
+{
+	PgnGame game;
+	addMoves(game, {"d4", "d5"}, {"d=10", "d=11"});
+
+	LiveJsonSerializer live;
+	live.serialize(game);
+
+	game.setResultDescription("White resigns");
+	const QString json(live.serialize(game));
+
+	LiveJsonSerializer fresh;
+	QCOMPARE(json, fresh.serialize(game));
+
+	const QVariantList moveList(parse(json)["Moves"].toList());
+	QCOMPARE(moveList.last().toMap()["rem"].toString(), QString("White resigns"));
+}
+
+void tst_LiveJsonSerializer::newGame()
+{
+	PgnGame game1;
+	addMoves(game1, {"e4", "e5", "Nf3"}, {});
+	PgnGame game2;
+	addMoves(game2, {"d4", "d5"}, {});
+
+	LiveJsonSerializer live;
+	live.serialize(game1);
+
+	// A game that doesn't continue the cached moves starts over
+	LiveJsonSerializer fresh;
+	QCOMPARE(live.serialize(game2), fresh.serialize(game2));
+
+	PgnGame empty;
+	const QVariantMap map(parse(live.serialize(empty)));
+	QVERIFY(map.contains("Moves"));
+	QVERIFY(map["Moves"].toList().isEmpty());
+}
+
+QTEST_MAIN(tst_LiveJsonSerializer)
+#include "tst_livejsonserializer.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_openingsuite
+SOURCES += tst_openingsuite.cpp
@@ -0,0 +1,180 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <openingsuite.h>
+
+class tst_OpeningSuite: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void pgnResume();
+		void pgnComments();
+		void epdResume();
+		void randomOrder();
+		void staleIndex();
+
+	private:
+		static QString writeFile(const QTemporaryDir& dir,
+					 const QString& name,
+					 const QByteArray& data);
+		static QByteArray pgnData(int count);
+		static QString event(const PgnGame& game);
+};
+
+QString tst_OpeningSuite::writeFile(const QTemporaryDir& dir,
+				    const QString& name,
+				    const QByteArray& data)
+{
+	const QString fileName(dir.filePath(name));
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		return QString();
+	file.write(data);
+	return fileName;
+}
+
+QByteArray tst_OpeningSuite::pgnData(int count)
+{
+	QByteArray data;
+	for (int i = 0; i < count; i++)
+	{
+		data += QString("[Event \"Game %1\"]\n"
+				"[Result \"*\"]\n"
+				"\n"
+				"{ [%2] } 1. e4 e5 *\n"
+				"\n").arg(i).arg(i).toLatin1();
+	}
+	return data;
+}
+
+QString tst_OpeningSuite::event(const PgnGame& game)
+{
+	return game.tagValue("Event");
+}
+
+void tst_OpeningSuite::pgnResume()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(writeFile(dir, "suite.pgn", pgnData(5)));
+	const QString indexName(OpeningSuite::indexFileName(fileName));
+
+	OpeningSuite suite(fileName, OpeningSuite::PgnFormat,
+			   OpeningSuite::SequentialOrder, 2);
+	QVERIFY(suite.initialize());
+	QVERIFY(QFile::exists(indexName));
+	QCOMPARE(event(suite.nextGame(10)), QString("Game 2"));
+	QCOMPARE(event(suite.nextGame(10)), QString("Game 3"));
+
+	// The second suite uses the existing index
+	const QDateTime indexTime(QFileInfo(indexName).lastModified());
+	OpeningSuite suite2(fileName, OpeningSuite::PgnFormat,
+			    OpeningSuite::SequentialOrder, 4);
+	QVERIFY(suite2.initialize());
+	QCOMPARE(QFileInfo(indexName).lastModified(), indexTime);
+	QCOMPARE(event(suite2.nextGame(10)), QString("Game 4"));
+	QCOMPARE(event(suite2.nextGame(10)), QString("Game 0"));
+
+	// The start index wraps around
+	OpeningSuite suite3(fileName, OpeningSuite::PgnFormat,
+			    OpeningSuite::SequentialOrder, 6);
+	QVERIFY(suite3.initialize());
+	QCOMPARE(event(suite3.nextGame(10)), QString("Game 1"));
+
+	// No index is needed without a start index
+	QFile::remove(indexName);
+	OpeningSuite suite4(fileName, OpeningSuite::PgnFormat);
+	QVERIFY(suite4.initialize());
+	QVERIFY(!QFile::exists(indexName));
+	QCOMPARE(event(suite4.nextGame(10)), QString("Game 0"));
+}
+
+void tst_OpeningSuite::pgnComments()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QByteArray data(
+		"[Event \"Game 0\"]\n"
+		"[Result \"*\"]\n"
+		"\n"
+		"1. e4 {a comment that\n"
+		"[Event \"Not a game\"]\n"
+		"spans lines} e5 ; a { line comment\n"
+		"2. Nf3 *\n"
+		"\n"
+		"[Event \"Game 1\"]\n"
+		"[Result \"*\"]\n"
+		"\n"
+		"1. d4 *\n");
+	const QString fileName(writeFile(dir, "suite.pgn", data));
+
+	// Lines inside comments don't start games
+	OpeningSuite suite(fileName, OpeningSuite::PgnFormat,
+			   OpeningSuite::SequentialOrder, 1);
+	QVERIFY(suite.initialize());
+	QCOMPARE(event(suite.nextGame(10)), QString("Game 1"));
+
+	OpeningSuite suite2(fileName, OpeningSuite::PgnFormat,
+			    OpeningSuite::SequentialOrder, 2);
+	QVERIFY(suite2.initialize());
+	QCOMPARE(event(suite2.nextGame(10)), QString("Game 0"));
+}
+
+void tst_OpeningSuite::epdResume()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QByteArray data(
+		"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq -\n"
+		"\n"
+		"rnbqkbnr/pppppppp/8/8/3P4/8/PPP1PPPP/RNBQKBNR b KQkq -\n"
+		"  rnbqkbnr/pppppppp/8/8/2P5/8/PP1PPPPP/RNBQKBNR b KQkq -\n");
+	const QString fileName(writeFile(dir, "suite.epd", data));
+
+	OpeningSuite suite(fileName, OpeningSuite::EpdFormat,
+			   OpeningSuite::SequentialOrder, 1);
+	QVERIFY(suite.initialize());
+	QCOMPARE(suite.nextGame(10).startingFenString(),
+		 QString("rnbqkbnr/pppppppp/8/8/3P4/8/PPP1PPPP/RNBQKBNR b KQkq -"));
+	QCOMPARE(suite.nextGame(10).startingFenString(),
+		 QString("rnbqkbnr/pppppppp/8/8/2P5/8/PP1PPPPP/RNBQKBNR b KQkq -"));
+}
+
+void tst_OpeningSuite::randomOrder()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const int count = 20;
+	const QString fileName(writeFile(dir, "suite.pgn", pgnData(count)));
+
+	OpeningSuite suite(fileName, OpeningSuite::PgnFormat,
+			   OpeningSuite::RandomOrder);
+	QVERIFY(suite.initialize());
+
+	QSet<QString> events;
+	for (int i = 0; i < count; i++)
+		events.insert(event(suite.nextGame(10)));
+	QCOMPARE(events.size(), count);
+}
+
+void tst_OpeningSuite::staleIndex()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(writeFile(dir, "suite.pgn", pgnData(3)));
+
+	OpeningSuite suite(fileName, OpeningSuite::PgnFormat,
+			   OpeningSuite::SequentialOrder, 2);
+	QVERIFY(suite.initialize());
+	QCOMPARE(event(suite.nextGame(10)), QString("Game 2"));
+
+	// A changed suite is indexed again
+	writeFile(dir, "suite.pgn", pgnData(3).mid(30));
+	OpeningSuite suite2(fileName, OpeningSuite::PgnFormat,
+			    OpeningSuite::SequentialOrder, 1);
+	QVERIFY(suite2.initialize());
+	QCOMPARE(event(suite2.nextGame(10)), QString("Game 2"));
+}
+
+QTEST_MAIN(tst_OpeningSuite)
+#include "tst_openingsuite.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgngameentry
+SOURCES += tst_pgngameentry.cpp
@@ -0,0 +1,99 @@
+#include <QtTest/QtTest>
+#include <pgngameentry.h>
+#include <pgnstream.h>
+
+class tst_PgnGameEntry: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void table();
+		void emptyTable();
+		void invalidTable();
+
+	private:
+		static QVector<PgnGameEntry> entries();
+};
+
+QVector<PgnGameEntry> tst_PgnGameEntry::entries()
+{
+	const QByteArray data(
+		"[Event \"First\"]\n"
+		"[Site \"Somewhere\"]\n"
+		"[White \"Engine A\"]\n"
+		"[Black \"Engine B\"]\n"
+		"[Result \"1-0\"]\n"
+		"\n"
+		"1. e4 e5 1-0\n"
+		"\n"
+		"[Event \"Second\"]\n"
+		"[Round \"2\"]\n"
+		"[Result \"1/2-1/2\"]\n"
+		"[Variant \"atomic\"]\n"
+		"\n"
+		"1. d4 d5 1/2-1/2\n");
+
+	PgnStream in(&data);
+	QVector<PgnGameEntry> entries;
+	PgnGameEntry entry;
+	while (entry.read(in))
+		entries << entry;
+
+	return entries;
+}
+
+void tst_PgnGameEntry::table()
+{
+	const QVector<PgnGameEntry> expected(entries());
+	QCOMPARE(expected.size(), 2);
+
+	QVector<PgnGameEntry> actual;
+	QByteArray table(PgnGameEntry::writeTable(expected));
+	QVERIFY(PgnGameEntry::readTable(table, expected.size(), actual));
+
+	// The entries must not refer to the table
+	table.fill('\0');
+
+	QCOMPARE(actual.size(), expected.size());
+	for (int i = 0; i < expected.size(); i++)
+	{
+		QCOMPARE(actual.at(i).pos(), expected.at(i).pos());
+		QCOMPARE(actual.at(i).lineNumber(), expected.at(i).lineNumber());
+		for (int tag = 0; tag <= PgnGameEntry::VariantTag; tag++)
+		{
+			const PgnGameEntry::TagType type = PgnGameEntry::TagType(tag);
+			QCOMPARE(actual.at(i).tagValue(type),
+				 expected.at(i).tagValue(type));
+		}
+	}
+	QCOMPARE(actual.at(1).tagValue(PgnGameEntry::VariantTag),
+		 QString("atomic"));
+}
+
+void tst_PgnGameEntry::emptyTable()
+{
+	QVector<PgnGameEntry> entries(1);
+	const QByteArray table(PgnGameEntry::writeTable(QVector<PgnGameEntry>()));
+	QVERIFY(table.isEmpty());
+	QVERIFY(PgnGameEntry::readTable(table, 0, entries));
+	QVERIFY(entries.isEmpty());
+}
+
+void tst_PgnGameEntry::invalidTable()
+{
+	const QVector<PgnGameEntry> expected(entries());
+	const QByteArray table(PgnGameEntry::writeTable(expected));
+	QVector<PgnGameEntry> actual;
+
+	// Too many records
+	QVERIFY(!PgnGameEntry::readTable(table, 100, actual));
+	QVERIFY(!PgnGameEntry::readTable(table, -1, actual));
+
+	// The tags of the last entry are outside the pool
+	QVERIFY(!PgnGameEntry::readTable(table.left(table.size() - 1),
+					 expected.size(), actual));
+	QVERIFY(actual.isEmpty());
+}
+
+QTEST_MAIN(tst_PgnGameEntry)
+#include "tst_pgngameentry.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgngamescanner
+SOURCES += tst_pgngamescanner.cpp
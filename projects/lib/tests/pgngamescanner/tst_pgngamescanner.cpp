@@ -0,0 +1,163 @@
+#include <QtTest/QtTest>
+#include <pgngamescanner.h>
+#include <pgngameentry.h>
+#include <pgnstream.h>
+
+class tst_PgnGameScanner: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void entries_data() const;
+		void entries();
+		void sharedTags();
+
+	private:
+		static QByteArray pgnData();
+		static QByteArray commentData();
+		static QVector<PgnGameEntry> streamEntries(const QByteArray& data);
+};
+
+QByteArray tst_PgnGameScanner::pgnData()
+{
+	return QByteArray(
+		"[Event \"First\"]\n"
+		"[Site \"Somewhere\"]\n"
+		"[White \"Engine A\"]\n"
+		"[Black \"Engine B\"]\n"
+		"[Result \"1-0\"]\n"
+		"\n"
+		"1. e4 e5 2. Nf3 {a comment} Nc6 1-0\n"
+		"\n"
+		"[Event \"Second\"]\r\n"
+		"[Round \"2\"]\r\n"
+		"[White \"Engine B\"]\r\n"
+		"[Black \"Engine A\"]\r\n"
+		"[Result \"1/2-1/2\"]\r\n"
+		"[Variant \"atomic\"]\r\n"
+		"\r\n"
+		"1. d4 d5\r\n"
+		"2. c4 1/2-1/2\r\n"
+		"\r\n"
+		"  [Event \"Third\"]\n"
+		"[Date \"2018.01.01\"]\n"
+		"[Result \"*\"]\n"
+		"1. c4 *\n");
+}
+
+QByteArray tst_PgnGameScanner::commentData()
+{
+	// Lines inside comments and braces in tag values or line
+	// comments don't start games
+	return QByteArray(
+		"[Event \"First {\"]\n"
+		"[Result \"1-0\"]\n"
+		"\n"
+		"1. e4 {a comment that\n"
+		"[Event \"Not a game\"]\n"
+		"spans lines} e5 ; a { line comment\n"
+		"2. Nf3 {\n"
+		"\n"
+		"  [%clk 0:01:00]\n"
+		"} Nc6 1-0\n"
+		"\n"
+		"[Event \"Second\"]\n"
+		"[Result \"*\"]\n"
+		"\n"
+		"1. d4 {[%eval 0.2]} *\n");
+}
+
+QVector<PgnGameEntry> tst_PgnGameScanner::streamEntries(const QByteArray& data)
+{
+	PgnStream in(&data);
+	QVector<PgnGameEntry> entries;
+	PgnGameEntry entry;
+	while (entry.read(in))
+		entries << entry;
+
+	return entries;
+}
+
+void tst_PgnGameScanner::entries_data() const
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<int>("gameCount");
+	QTest::addColumn<int>("chunkSize");
+
+	QTest::newRow("single") << pgnData() << 3 << 1024 * 1024;
+	QTest::newRow("lines") << pgnData() << 3 << 1;
+	QTest::newRow("small") << pgnData() << 3 << 40;
+	QTest::newRow("comments single") << commentData() << 2 << 1024 * 1024;
+	QTest::newRow("comments lines") << commentData() << 2 << 1;
+	QTest::newRow("comments small") << commentData() << 2 << 20;
+}
+
+void tst_PgnGameScanner::entries()
+{
+	QFETCH(QByteArray, data);
+	QFETCH(int, gameCount);
+	QFETCH(int, chunkSize);
+
+	const QVector<PgnGameEntry> expected(streamEntries(data));
+	QCOMPARE(expected.size(), gameCount);
+
+	PgnGameScanner scanner(data.constData(), data.size());
+	const QVector<qint64> chunks(scanner.chunks(chunkSize));
+	QCOMPARE(chunks.first(), qint64(0));
+	QCOMPARE(chunks.last(), qint64(data.size()));
+
+	QVector<PgnGameEntry> entries;
+	qint64 lineCount = 0;
+	PgnGameScanner::State state = { false, false };
+	for (int i = 1; i < chunks.size(); i++)
+	{
+		PgnGameScanner::Chunk chunk(scanner.scan(chunks.at(i - 1),
+							 chunks.at(i)));
+		if (chunk.startState != state)
+			chunk = scanner.scan(chunks.at(i - 1), chunks.at(i), state);
+		state = chunk.endState;
+		PgnGameScanner::addLines(chunk.entries, lineCount);
+		lineCount += chunk.lineCount;
+		entries += chunk.entries;
+	}
+	QCOMPARE(lineCount, qint64(data.count('\n')));
+
+	QCOMPARE(entries.size(), expected.size());
+	for (int i = 0; i < entries.size(); i++)
+	{
+		QCOMPARE(entries.at(i).pos(), expected.at(i).pos());
+		QCOMPARE(entries.at(i).lineNumber(), expected.at(i).lineNumber());
+		for (int type = PgnGameEntry::EventTag;
+		     type <= PgnGameEntry::VariantTag; type++)
+		{
+			const PgnGameEntry::TagType tagType = PgnGameEntry::TagType(type);
+			QCOMPARE(entries.at(i).tagValue(tagType),
+				 expected.at(i).tagValue(tagType));
+		}
+	}
+}
+
+void tst_PgnGameScanner::sharedTags()
+{
+	const QByteArray data(pgnData());
+	PgnGameScanner scanner(data.constData(), data.size());
+	const QVector<PgnGameEntry> entries(scanner.scan(0, data.size()).entries);
+	QCOMPARE(entries.size(), 3);
+	QCOMPARE(entries.at(1).tagValue(PgnGameEntry::VariantTag), QString("atomic"));
+
+	// An entry written to a data stream only contains its own tags
+	QByteArray state;
+	QDataStream out(&state, QIODevice::WriteOnly);
+	out << entries.at(1);
+
+	QDataStream in(state);
+	PgnGameEntry entry;
+	in >> entry;
+	QCOMPARE(entry.pos(), entries.at(1).pos());
+	QCOMPARE(entry.tagValue(PgnGameEntry::EventTag), QString("Second"));
+	QCOMPARE(entry.tagValue(PgnGameEntry::RoundTag), QString("2"));
+	QVERIFY(in.atEnd());
+}
+
+QTEST_MAIN(tst_PgnGameScanner)
+#include "tst_pgngamescanner.moc"
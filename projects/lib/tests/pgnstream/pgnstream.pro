@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgnstream
+SOURCES += tst_pgnstream.cpp
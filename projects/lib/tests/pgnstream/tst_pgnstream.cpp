@@ -0,0 +1,144 @@
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <pgnstream.h>
+#include <pgngame.h>
+#include <pgngameentry.h>
+
+class tst_PgnStream: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void tokens();
+		void textMode();
+		void largeDevice();
+		void seek();
+
+	private:
+		static QByteArray pgnData(int index);
+};
+
+QByteArray tst_PgnStream::pgnData(int index)
+{
+	return QString("[Event \"Game %1\"]\n"
+		       "[Result \"1-0\"]\n"
+		       "\n"
+		       "1. e4 {first\n"
+		       "comment} e5 (1... c5 {[%eval 0.3]}) 2. Nf3 $1 ; line comment [x]\n"
+		       "Nc6 % escaped [y]\n"
+		       "3. Bb5 1-0\n"
+		       "\n").arg(index).toLatin1();
+}
+
+void tst_PgnStream::tokens()
+{
+	const QByteArray data(pgnData(0));
+	PgnStream in(&data);
+	QVERIFY(in.nextGame());
+
+	QCOMPARE(in.readNext(), PgnStream::PgnTag);
+	QCOMPARE(in.tagName(), QByteArray("Event"));
+	QCOMPARE(in.tagValue(), QByteArray("Game 0"));
+	QCOMPARE(in.readNext(), PgnStream::PgnTag);
+	QCOMPARE(in.readNext(), PgnStream::PgnMoveNumber);
+	QCOMPARE(in.tokenString(), QByteArray("1"));
+	QCOMPARE(in.readNext(), PgnStream::PgnMove);
+	QCOMPARE(in.tokenString(), QByteArray("e4"));
+	QCOMPARE(in.readNext(), PgnStream::PgnComment);
+	QCOMPARE(in.tokenString(), QByteArray("first\ncomment"));
+	QCOMPARE(in.readNext(), PgnStream::PgnMove);
+	QCOMPARE(in.readNext(), PgnStream::PgnComment);
+	QCOMPARE(in.tokenString(), QByteArray("1... c5 {[%eval 0.3]}"));
+	QCOMPARE(in.readNext(), PgnStream::PgnMoveNumber);
+	QCOMPARE(in.readNext(), PgnStream::PgnMove);
+	QCOMPARE(in.tokenString(), QByteArray("Nf3"));
+	QCOMPARE(in.readNext(), PgnStream::PgnNag);
+	QCOMPARE(in.tokenString(), QByteArray("1"));
+	QCOMPARE(in.readNext(), PgnStream::PgnLineComment);
+	QCOMPARE(in.tokenString(), QByteArray(" line comment [x]"));
+	QCOMPARE(in.readNext(), PgnStream::PgnMove);
+	QCOMPARE(in.tokenString(), QByteArray("Nc6"));
+	QCOMPARE(in.readNext(), PgnStream::PgnMoveNumber);
+	QCOMPARE(in.lineNumber(), qint64(7));
+	QCOMPARE(in.readNext(), PgnStream::PgnMove);
+	QCOMPARE(in.readNext(), PgnStream::PgnResult);
+	QCOMPARE(in.tokenString(), QByteArray("1-0"));
+	QVERIFY(!in.nextGame());
+}
+
+void tst_PgnStream::textMode()
+{
+	QByteArray data(pgnData(0));
+	data.replace("\n", "\r\n");
+	QBuffer buffer(&data);
+	QVERIFY(buffer.open(QIODevice::ReadOnly | QIODevice::Text));
+
+	PgnStream in(&buffer);
+	PgnGame game;
+	QVERIFY(game.read(in));
+	QCOMPARE(game.tagValue("Event"), QString("Game 0"));
+	QCOMPARE(game.moves().size(), 5);
+	QCOMPARE(game.moves().at(0).comment, QString("first\ncomment"));
+	QVERIFY(buffer.isTextModeEnabled());
+}
+
+void tst_PgnStream::largeDevice()
+{
+	// Enough games to cross several buffer boundaries
+	const int count = 2000;
+	QByteArray data;
+	QVector<qint64> positions;
+	for (int i = 0; i < count; i++)
+	{
+		positions.append(data.size());
+		data += pgnData(i);
+	}
+
+	QBuffer buffer(&data);
+	QVERIFY(buffer.open(QIODevice::ReadOnly));
+	PgnStream in(&buffer);
+	PgnGameEntry entry;
+	for (int i = 0; i < count; i++)
+	{
+		QVERIFY(entry.read(in));
+		QCOMPARE(entry.pos(), positions.at(i));
+		QCOMPARE(entry.lineNumber(), qint64(i * 8 + 1));
+		QCOMPARE(entry.tagValue(PgnGameEntry::EventTag),
+			 QString("Game %1").arg(i));
+	}
+	QVERIFY(!entry.read(in));
+	QCOMPARE(in.status(), PgnStream::ReadPastEnd);
+}
+
+void tst_PgnStream::seek()
+{
+	QByteArray data;
+	for (int i = 0; i < 1000; i++)
+		data += pgnData(i);
+	const qint64 pos = data.indexOf("[Event \"Game 900\"]");
+	const qint64 pos2 = data.indexOf("[Event \"Game 901\"]");
+
+	QBuffer buffer(&data);
+	QVERIFY(buffer.open(QIODevice::ReadOnly));
+	PgnStream in(&buffer);
+	PgnGame game;
+
+	QVERIFY(in.seek(pos, 7201));
+	QVERIFY(game.read(in));
+	QCOMPARE(game.tagValue("Event"), QString("Game 900"));
+
+	// Seek both inside and outside of the buffer
+	QVERIFY(in.seek(pos2, 7209));
+	QVERIFY(game.read(in));
+	QCOMPARE(game.tagValue("Event"), QString("Game 901"));
+	QVERIFY(in.seek(pos, 7201));
+	QVERIFY(game.read(in));
+	QCOMPARE(game.tagValue("Event"), QString("Game 900"));
+	QVERIFY(in.seek(0));
+	QVERIFY(game.read(in));
+	QCOMPARE(game.tagValue("Event"), QString("Game 0"));
+	QCOMPARE(in.lineNumber(), qint64(8));
+}
+
+QTEST_MAIN(tst_PgnStream)
+#include "tst_pgnstream.moc"
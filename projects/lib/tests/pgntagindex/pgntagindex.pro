@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pgntagindex
+SOURCES += tst_pgntagindex.cpp
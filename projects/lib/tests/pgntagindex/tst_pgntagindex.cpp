@@ -0,0 +1,209 @@
+#include <QtTest/QtTest>
+#include <pgntagindex.h>
+#include <pgngamefilter.h>
+#include <pgngameentry.h>
+#include <pgnstream.h>
+
+class tst_PgnTagIndex: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void cleanupTestCase();
+		void dictionaries();
+		void fixedString_data() const;
+		void fixedString();
+		void advanced_data() const;
+		void advanced();
+
+	private:
+		void compare(const PgnGameFilter& filter);
+
+		QByteArray m_data;
+		QList<PgnGameEntry*> m_entries;
+		PgnTagIndex m_index;
+};
+
+void tst_PgnTagIndex::initTestCase()
+{
+	m_data =
+		"[Event \"Candidates\"]\n[Site \"Berlin\"]\n[Date \"2018.03.10\"]\n"
+		"[Round \"1\"]\n[White \"Caruana, Fabiano\"]\n[Black \"Aronian, Levon\"]\n"
+		"[Result \"1-0\"]\n\n1. e4 1-0\n\n"
+		"[Event \"Candidates\"]\n[Site \"Berlin\"]\n[Date \"2018.03.11\"]\n"
+		"[Round \"2\"]\n[White \"Aronian, Levon\"]\n[Black \"Caruana, Fabiano\"]\n"
+		"[Result \"1/2-1/2\"]\n\n1. d4 1/2-1/2\n\n"
+		"[Event \"Candidates\"]\n[Site \"Berlin\"]\n[Date \"2018.03.12\"]\n"
+		"[Round \"3\"]\n[White \"Kramnik, Vladimir\"]\n[Black \"Caruana, Fabiano\"]\n"
+		"[Result \"0-1\"]\n\n1. c4 0-1\n\n"
+		"[Event \"London Classic\"]\n[Site \"London\"]\n[Date \"2018.??.??\"]\n"
+		"[Round \"?\"]\n[White \"Kramnik, Vladimir\"]\n[Black \"Aronian, Levon\"]\n"
+		"[Result \"*\"]\n\n1. Nf3 *\n\n"
+		"[Event \"Blitz\"]\n[Site \"London\"]\n[Date \"2017.13.01\"]\n"
+		"[Round \"12\"]\n[White \"Aronian, Levon\"]\n[Black \"Kramnik, Vladimir\"]\n"
+		"[Result \"0-1\"]\n\n1. g3 0-1\n\n"
+		"[Event \"Blitz\"]\n[White \"Carlsen, Magnus\"]\n\n1. b3 *\n\n";
+
+	PgnStream in(&m_data);
+	PgnGameEntry entry;
+	while (entry.read(in))
+		m_entries.append(new PgnGameEntry(entry));
+
+	QList<const PgnGameEntry*> entries;
+	for (const PgnGameEntry* e : qAsConst(m_entries))
+		entries.append(e);
+	m_index.build(entries);
+}
+
+void tst_PgnTagIndex::cleanupTestCase()
+{
+	qDeleteAll(m_entries);
+}
+
+void tst_PgnTagIndex::compare(const PgnGameFilter& filter)
+{
+	const PgnTagIndex::Query query(m_index, filter);
+	for (int i = 0; i < m_entries.size(); i++)
+		QCOMPARE(query.match(i), m_entries.at(i)->match(filter));
+}
+
+void tst_PgnTagIndex::dictionaries()
+{
+	QCOMPARE(m_index.size(), 6);
+	QCOMPARE(m_index.valueCount(PgnGameEntry::EventTag), 3);
+	QCOMPARE(m_index.valueCount(PgnGameEntry::SiteTag), 3);
+
+	// The players of both colors share one dictionary
+	QCOMPARE(m_index.valueCount(PgnGameEntry::WhiteTag), 5);
+	QCOMPARE(m_index.valueCount(PgnGameEntry::BlackTag), 5);
+	QCOMPARE(m_index.valueId(0, PgnGameEntry::WhiteTag),
+		 m_index.valueId(1, PgnGameEntry::BlackTag));
+	QCOMPARE(m_index.valueId(0, PgnGameEntry::EventTag),
+		 m_index.valueId(2, PgnGameEntry::EventTag));
+
+	PgnTagIndex index;
+	index.build(QList<const PgnGameEntry*>());
+	QCOMPARE(index.size(), 0);
+	QCOMPARE(index.valueCount(PgnGameEntry::EventTag), 0);
+}
+
+void tst_PgnTagIndex::fixedString_data() const
+{
+	QTest::addColumn<QString>("pattern");
+
+	QTest::newRow("empty") << "";
+	QTest::newRow("event") << "candidates";
+	QTest::newRow("site") << "LONDON";
+	QTest::newRow("player") << "kramnik";
+	QTest::newRow("date") << "2018.03";
+	QTest::newRow("round") << "12";
+	QTest::newRow("result") << "1/2";
+	QTest::newRow("no match") << "Tal";
+}
+
+void tst_PgnTagIndex::fixedString()
+{
+	QFETCH(QString, pattern);
+	compare(PgnGameFilter(pattern));
+}
+
+void tst_PgnTagIndex::advanced_data() const
+{
+	QTest::addColumn<QString>("event");
+	QTest::addColumn<QString>("player");
+	QTest::addColumn<QString>("opponent");
+	QTest::addColumn<int>("side");
+	QTest::addColumn<QDate>("minDate");
+	QTest::addColumn<QDate>("maxDate");
+	QTest::addColumn<int>("minRound");
+	QTest::addColumn<int>("maxRound");
+	QTest::addColumn<int>("result");
+	QTest::addColumn<bool>("inverted");
+
+	const int noSide = Chess::Side::NoSide;
+	const int white = Chess::Side::White;
+	const int black = Chess::Side::Black;
+
+	QTest::newRow("empty")
+		<< "" << "" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("event")
+		<< "cand" << "" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("player")
+		<< "" << "caruana" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("white player")
+		<< "" << "Aronian" << "" << white << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("black player")
+		<< "" << "Aronian" << "" << black << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("opponent")
+		<< "" << "Kramnik" << "Aronian" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("opponent only")
+		<< "" << "" << "Caruana" << white << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("dates")
+		<< "" << "" << "" << noSide << QDate(2018, 3, 11) << QDate(2018, 3, 12)
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("max date")
+		<< "" << "" << "" << noSide << QDate() << QDate(2018, 3, 10)
+		<< 0 << 0 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("rounds")
+		<< "" << "" << "" << noSide << QDate() << QDate()
+		<< 2 << 12 << int(PgnGameFilter::AnyResult) << false;
+	QTest::newRow("first player wins")
+		<< "" << "Caruana" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::FirstPlayerWins) << false;
+	QTest::newRow("first player loses")
+		<< "" << "Aronian" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::FirstPlayerLoses) << false;
+	QTest::newRow("black wins")
+		<< "" << "" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::BlackWins) << false;
+	QTest::newRow("not a draw")
+		<< "" << "" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::Draw) << true;
+	QTest::newRow("unfinished")
+		<< "" << "" << "" << noSide << QDate() << QDate()
+		<< 0 << 0 << int(PgnGameFilter::Unfinished) << false;
+	QTest::newRow("combined")
+		<< "Candidates" << "Caruana" << "Kramnik" << black
+		<< QDate(2018, 1, 1) << QDate()
+		<< 1 << 0 << int(PgnGameFilter::FirstPlayerWins) << false;
+}
+
+void tst_PgnTagIndex::advanced()
+{
+	QFETCH(QString, event);
+	QFETCH(QString, player);
+	QFETCH(QString, opponent);
+	QFETCH(int, side);
+	QFETCH(QDate, minDate);
+	QFETCH(QDate, maxDate);
+	QFETCH(int, minRound);
+	QFETCH(int, maxRound);
+	QFETCH(int, result);
+	QFETCH(bool, inverted);
+
+	PgnGameFilter filter;
+	filter.setEvent(event);
+	filter.setPlayer(player, Chess::Side::Type(side));
+	filter.setOpponent(opponent);
+	if (minDate.isValid())
+		filter.setMinDate(minDate);
+	if (maxDate.isValid())
+		filter.setMaxDate(maxDate);
+	filter.setMinRound(minRound);
+	filter.setMaxRound(maxRound);
+	filter.setResult(PgnGameFilter::Result(result));
+	filter.setResultInverted(inverted);
+
+	compare(filter);
+}
+
+QTEST_MAIN(tst_PgnTagIndex)
+#include "tst_pgntagindex.moc"
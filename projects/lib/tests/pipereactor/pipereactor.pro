@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_pipereactor
+SOURCES += tst_pipereactor.cpp
@@ -0,0 +1,232 @@
+#include <QtTest/QtTest>
+#include <unistd.h>
+#include <pipereactor_linux.h>
+#include <engineprocess_linux.h>
+#include <timecontrol.h>
+
+class tst_PipeReactor: public QObject
+{
+	Q_OBJECT
+
+	public:
+		tst_PipeReactor();
+
+	public slots:
+		void onLinesQueued();
+
+	private slots:
+		void init();
+		void cleanup();
+
+		void lines();
+		void partialLines();
+		void backlog();
+		void finished();
+		void processExitAfterEof();
+		void queuedReads();
+		void blockedInput();
+
+	private:
+		void write(const QByteArray& data);
+		bool waitForLines(int count, int timeout = 5000);
+
+		int m_read;
+		int m_write;
+		PipeReactor::Channel* m_channel;
+		QList<QByteArray> m_lines;
+		QList<qint64> m_timestamps;
+		bool m_finished;
+};
+
+tst_PipeReactor::tst_PipeReactor()
+	: m_read(-1),
+	  m_write(-1),
+	  m_channel(nullptr),
+	  m_finished(false)
+{
+}
+
+void tst_PipeReactor::init()
+{
+	int fds[2];
+	QVERIFY(pipe(fds) == 0);
+	m_read = fds[0];
+	m_write = fds[1];
+
+	m_lines.clear();
+	m_timestamps.clear();
+	m_finished = false;
+	m_channel = new PipeReactor::Channel(m_read, this, "onLinesQueued");
+	QVERIFY(PipeReactor::instance()->add(m_channel));
+}
+
+void tst_PipeReactor::cleanup()
+{
+	PipeReactor::instance()->remove(m_channel);
+	delete m_channel;
+	m_channel = nullptr;
+
+	if (m_write != -1)
+		close(m_write);
+	close(m_read);
+	m_write = -1;
+}
+
+void tst_PipeReactor::onLinesQueued()
+{
+	m_channel->acknowledge();
+	const bool finished = m_channel->isFinished();
+
+	QByteArray line;
+	qint64 ns;
+	while (m_channel->takeLine(&line, &ns))
+	{
+		m_lines << line;
+		m_timestamps << ns;
+	}
+	PipeReactor::instance()->resume(m_channel);
+
+	if (finished)
+		m_finished = true;
+}
+
+void tst_PipeReactor::write(const QByteArray& data)
+{
+	QCOMPARE(::write(m_write, data.constData(), size_t(data.size())),
+		 ssize_t(data.size()));
+}
+
+bool tst_PipeReactor::waitForLines(int count, int timeout)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (m_lines.size() < count && timer.elapsed() < timeout)
+		QTest::qWait(10);
+
+	return m_lines.size() >= count;
+}
+
+void tst_PipeReactor::lines()
+{
+	const qint64 start = TimeControl::monotonicNs();
+	write("uciok\nreadyok\n");
+	QVERIFY(waitForLines(2));
+
+	QCOMPARE(m_lines.at(0), QByteArray("uciok\n"));
+	QCOMPARE(m_lines.at(1), QByteArray("readyok\n"));
+	QVERIFY(m_timestamps.at(0) >= start);
+	QVERIFY(m_timestamps.at(0) <= TimeControl::monotonicNs());
+}
+
+void tst_PipeReactor::partialLines()
+{
+	write("bestmove ");
+	QTest::qWait(50);
+	QVERIFY(m_lines.isEmpty());
+
+	// The line gets the time of its end
+	const qint64 start = TimeControl::monotonicNs();
+	write("e2e4\r\ninfo");
+	QVERIFY(waitForLines(1));
+	QCOMPARE(m_lines.size(), 1);
+	QCOMPARE(m_lines.at(0), QByteArray("bestmove e2e4\r\n"));
+	QVERIFY(m_timestamps.at(0) >= start);
+}
+
+void tst_PipeReactor::backlog()
+{
+	// More lines than the queue holds, and the receiver only
+	// takes them when the event loop runs
+	const int count = 3000;
+	QByteArray data;
+	for (int i = 0; i < count; i++)
+		data += "info nodes " + QByteArray::number(i) + "\n";
+	write(data);
+
+	QVERIFY(waitForLines(count));
+	QCOMPARE(m_lines.size(), count);
+	for (int i = 0; i < count; i++)
+		QCOMPARE(m_lines.at(i), "info nodes " + QByteArray::number(i) + "\n");
+}
+
+void tst_PipeReactor::finished()
+{
+	write("quit\nno newline");
+	close(m_write);
+	m_write = -1;
+
+	QVERIFY(waitForLines(2));
+	QTRY_VERIFY(m_finished);
+	QCOMPARE(m_lines.size(), 2);
+	QCOMPARE(m_lines.at(1), QByteArray("no newline"));
+}
+
+void tst_PipeReactor::processExitAfterEof()
+{
+	// The process closes its output well before it exits, so it
+	// can't be reaped when the end of the output is read. The
+	// process id is cleared when finished() is emitted.
+	EngineProcess process;
+	process.start("/bin/sh", QStringList() << "-c" << "exec >&-; sleep 0.2; exit 3");
+	QVERIFY(process.waitForStarted());
+	QVERIFY(process.processId() != 0);
+
+	QTRY_COMPARE(process.processId(), qint64(0));
+	QCOMPARE(process.exitCode(), 3);
+	QCOMPARE(process.exitStatus(), EngineProcess::NormalExit);
+}
+
+void tst_PipeReactor::queuedReads()
+{
+	// Both lines are queued before the event loop runs, so they're
+	// delivered together. Each keeps the time it was read.
+	EngineProcess process;
+	process.start("/bin/sh", QStringList() << "-c"
+		      << "echo first; sleep 0.2; echo second; sleep 5");
+	QVERIFY(process.waitForStarted());
+	QThread::msleep(500);
+
+	QTRY_COMPARE(process.bytesAvailable(), qint64(13));
+	const qint64 first = process.readTimestampNs(0);
+	const qint64 second = process.readTimestampNs(6);
+	QVERIFY(first > 0);
+	QVERIFY(second - first >= 150 * 1000000LL);
+
+	// The times of the lines just read are still known
+	QCOMPARE(process.read(13), QByteArray("first\nsecond\n"));
+	QCOMPARE(process.readTimestampNs(5), first);
+	QCOMPARE(process.readTimestampNs(12), second);
+	QCOMPARE(process.readTimestampNs(13), qint64(-1));
+
+	process.kill();
+	QVERIFY(process.waitForFinished());
+}
+
+void tst_PipeReactor::blockedInput()
+{
+	// The process doesn't read its input at first, so most of the
+	// data doesn't fit in the pipe. The write mustn't block.
+	EngineProcess process;
+	process.start("/bin/sh", QStringList() << "-c"
+		      << "sleep 0.3; head -c 4194304 | wc -c; sleep 5");
+	QVERIFY(process.waitForStarted());
+
+	const QByteArray data(4 * 1024 * 1024, 'x');
+	QElapsedTimer timer;
+	timer.start();
+	QCOMPARE(process.write(data), qint64(data.size()));
+	QVERIFY(timer.elapsed() < 200);
+	QVERIFY(process.bytesToWrite() > 0);
+
+	// The rest is written from the event loop once the process
+	// reads its input
+	QTRY_COMPARE(process.bytesToWrite(), qint64(0));
+	QTRY_VERIFY(process.canReadLine());
+	QCOMPARE(process.readLine().trimmed(), QByteArray("4194304"));
+
+	process.kill();
+	QVERIFY(process.waitForFinished());
+}
+
+QTEST_MAIN(tst_PipeReactor)
+#include "tst_pipereactor.moc"
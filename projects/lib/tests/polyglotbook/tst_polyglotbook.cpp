@@ -10,10 +10,13 @@ class tst_PolyglotBook: public QObject
 	private slots:
 		void initialValues();
 		void startPos();
+		void diskEntries();
 
 	private:
 		QMap<QString,quint16> entries(const OpeningBook* book,
 					      Chess::Board* board) const;
+		static QMap<quint32,int> weights(const OpeningBook* book,
+						 quint64 key);
 };
 
 void tst_PolyglotBook::initialValues()
@@ -40,6 +43,25 @@ QMap<QString,quint16> tst_PolyglotBook::entries(const OpeningBook* book,
 	return ret;
 }
 
+QMap<quint32,int> tst_PolyglotBook::weights(const OpeningBook* book,
+					     quint64 key)
+{
+	QMap<quint32,int> ret;
+
+	for (auto entry: book->entries(key))
+	{
+		const auto& move = entry.move;
+		quint32 id = (move.sourceSquare().file() << 16)
+			   | (move.sourceSquare().rank() << 12)
+			   | (move.targetSquare().file() << 8)
+			   | (move.targetSquare().rank() << 4)
+			   | move.promotion();
+		ret[id] += entry.weight;
+	}
+
+	return ret;
+}
+
 void tst_PolyglotBook::startPos()
 {
 	QMap<QString,quint16> expect;
@@ -74,5 +96,41 @@ void tst_PolyglotBook::startPos()
 	QCOMPARE(entries, expect);
 }
 
+void tst_PolyglotBook::diskEntries()
+{
+	auto ramBook = PolyglotBook(OpeningBook::Ram);
+	QVERIFY(ramBook.read("book_small.bin"));
+	auto diskBook = PolyglotBook(OpeningBook::Disk);
+	QVERIFY(diskBook.read("book_small.bin"));
+	// Shares the mapping of the first book
+	auto diskBook2 = PolyglotBook(OpeningBook::Disk);
+	QVERIFY(diskBook2.read("book_small.bin"));
+
+	QFile file("book_small.bin");
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QDataStream in(&file);
+
+	// Every key in the book, and the keys next to them
+	QList<quint64> keys;
+	while (!in.atEnd())
+	{
+		quint64 key;
+		quint16 move;
+		quint16 weight;
+		quint32 learn;
+		in >> key >> move >> weight >> learn;
+		keys << key << key - 1 << key + 1;
+	}
+	keys << 0 << Q_UINT64_C(0xFFFFFFFFFFFFFFFF);
+	QVERIFY(keys.size() > 2);
+
+	for (quint64 key : qAsConst(keys))
+	{
+		const auto expect = weights(&ramBook, key);
+		QCOMPARE(weights(&diskBook, key), expect);
+		QCOMPARE(weights(&diskBook2, key), expect);
+	}
+}
+
 QTEST_MAIN(tst_PolyglotBook)
 #include "tst_polyglotbook.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_polyglotbookbuilder
+SOURCES += tst_polyglotbookbuilder.cpp
@@ -0,0 +1,198 @@
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include <polyglotbookbuilder.h>
+#include <polyglotbook.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+
+class tst_PolyglotBookBuilder: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void import();
+		void order();
+		void runs();
+		void pgnFile();
+
+	private:
+		static QByteArray pgnData();
+		static bool build(PolyglotBookBuilder& builder, QByteArray* book);
+		static QMap<quint32,int> weights(const QByteArray& book,
+						 quint64 key);
+};
+
+QByteArray tst_PolyglotBookBuilder::pgnData()
+{
+	return QByteArray(
+		"[Event \"Test\"]\n"
+		"[Result \"1-0\"]\n"
+		"\n"
+		"1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 1-0\n"
+		"\n"
+		"[Event \"Test\"]\n"
+		"[Result \"0-1\"]\n"
+		"\n"
+		"1. e4 c5 2. Nf3 d6 3. d4 cxd4 {comment} 4. Nxd4 Nf6 0-1\n"
+		"\n"
+		"[Event \"Test\"]\n"
+		"[Result \"1/2-1/2\"]\n"
+		"\n"
+		"1. d4 d5 2. c4 e6 3. Nc3 Nf6 1/2-1/2\n"
+		"\n"
+		"[Event \"Test\"]\n"
+		"[Result \"1/2-1/2\"]\n"
+		"\n"
+		"1. e4 e5 2. Nf3 Nc6 1/2-1/2\n"
+		"\n");
+}
+
+bool tst_PolyglotBookBuilder::build(PolyglotBookBuilder& builder,
+				    QByteArray* book)
+{
+	QBuffer buffer(book);
+	return buffer.open(QIODevice::WriteOnly) && builder.write(&buffer);
+}
+
+QMap<quint32,int> tst_PolyglotBookBuilder::weights(const QByteArray& book,
+						   quint64 key)
+{
+	PolyglotBook polyglotBook(OpeningBook::Ram);
+	QDataStream in(book);
+	in >> &polyglotBook;
+
+	QMap<quint32,int> ret;
+	for (auto entry: polyglotBook.entries(key))
+	{
+		const auto& move = entry.move;
+		quint32 id = (move.sourceSquare().file() << 16)
+			   | (move.sourceSquare().rank() << 12)
+			   | (move.targetSquare().file() << 8)
+			   | (move.targetSquare().rank() << 4)
+			   | move.promotion();
+		ret[id] += entry.weight;
+	}
+
+	return ret;
+}
+
+void tst_PolyglotBookBuilder::import()
+{
+	const QByteArray data(pgnData());
+	const int plies = 6;
+
+	PolyglotBookBuilder builder(plies);
+	builder.addPgnData(data);
+	QByteArray book;
+	QVERIFY(build(builder, &book));
+	QCOMPARE(builder.gameCount(), 4);
+	QVERIFY(!book.isEmpty());
+	QCOMPARE(book.size() % 16, 0);
+
+	// The book must match an in-memory book of the same games
+	PolyglotBook reference(OpeningBook::Ram);
+	PgnStream refIn(&data);
+	reference.import(refIn, plies);
+	QByteArray refBook;
+	QDataStream refOut(&refBook, QIODevice::WriteOnly);
+	refOut << &reference;
+
+	PgnStream in(&data);
+	PgnGame game;
+	int positions = 0;
+	while (game.read(in))
+	{
+		for (const PgnGame::MoveData& md : game.moves())
+		{
+			QCOMPARE(weights(book, md.key), weights(refBook, md.key));
+			positions++;
+		}
+	}
+	QVERIFY(positions > 0);
+}
+
+void tst_PolyglotBookBuilder::order()
+{
+	PolyglotBookBuilder builder(8);
+	builder.addPgnData(pgnData());
+	QByteArray book;
+	QVERIFY(build(builder, &book));
+
+	const uchar* data = reinterpret_cast<const uchar*>(book.constData());
+	for (int i = 16; i < book.size(); i += 16)
+	{
+		quint64 prevKey = qFromBigEndian<quint64>(data + i - 16);
+		quint64 key = qFromBigEndian<quint64>(data + i);
+		QVERIFY(prevKey <= key);
+		if (prevKey == key)
+		{
+			quint16 prevWeight = qFromBigEndian<quint16>(data + i - 6);
+			quint16 weight = qFromBigEndian<quint16>(data + i + 10);
+			QVERIFY(prevWeight >= weight);
+		}
+	}
+}
+
+void tst_PolyglotBookBuilder::runs()
+{
+	const QByteArray data(pgnData());
+	const int copies = 500;
+
+	PolyglotBookBuilder memoryBuilder(10);
+	for (int i = 0; i < copies; i++)
+		memoryBuilder.addPgnData(data);
+
+	// The smallest memory limit forces several sorted runs
+	PolyglotBookBuilder runBuilder(10);
+	runBuilder.setThreadCount(4);
+	runBuilder.setMemoryLimit(0);
+	for (int i = 0; i < copies; i++)
+		runBuilder.addPgnData(data);
+
+	QByteArray book;
+	QVERIFY(build(runBuilder, &book));
+	QCOMPARE(runBuilder.gameCount(), copies * 4);
+	QByteArray memoryBook;
+	QVERIFY(build(memoryBuilder, &memoryBook));
+	QCOMPARE(book, memoryBook);
+
+	// 1. e4 was played by the winner of one game and in one draw,
+	// and 1. d4 in one draw
+	PgnStream in(&data);
+	PgnGame game;
+	QVERIFY(game.read(in));
+	const QMap<quint32,int> startWeights(weights(book, game.moves().at(0).key));
+	QCOMPARE(startWeights.size(), 2);
+	QCOMPARE(startWeights.values(), QList<int>() << copies << copies * 3);
+}
+
+void tst_PolyglotBookBuilder::pgnFile()
+{
+	const QByteArray data(pgnData());
+	QTemporaryFile file;
+	QVERIFY(file.open());
+	for (int i = 0; i < 100; i++)
+		file.write(data);
+	file.close();
+
+	PolyglotBookBuilder fileBuilder(10);
+	QVERIFY(fileBuilder.addPgnFile(file.fileName()));
+	QByteArray book;
+	QVERIFY(build(fileBuilder, &book));
+	QCOMPARE(fileBuilder.gameCount(), 400);
+
+	PolyglotBookBuilder dataBuilder(10);
+	for (int i = 0; i < 100; i++)
+		dataBuilder.addPgnData(data);
+	QByteArray dataBook;
+	QVERIFY(build(dataBuilder, &dataBook));
+	QCOMPARE(book, dataBook);
+
+	PolyglotBookBuilder missing(10);
+	QVERIFY(!missing.addPgnFile("no-such-file.pgn"));
+}
+
+QTEST_MAIN(tst_PolyglotBookBuilder)
+#include "tst_polyglotbookbuilder.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_positionindex
+SOURCES += tst_positionindex.cpp
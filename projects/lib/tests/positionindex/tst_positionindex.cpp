@@ -0,0 +1,275 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <positionindex.h>
+#include <positionindexbuilder.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+
+class tst_PositionIndex: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void find();
+		void fen();
+		void runs();
+		void staleIndex();
+		void canceledBuild();
+		void invalidFile();
+
+	private:
+		static QByteArray pgnData();
+		static QString writeFile(const QTemporaryDir& dir,
+					 const QString& name,
+					 const QByteArray& data);
+		static bool build(const QString& pgnFileName,
+				  qint64 memoryLimit = 256 * 1024 * 1024);
+};
+
+QByteArray tst_PositionIndex::pgnData()
+{
+	return QByteArray(
+		"[Event \"Test\"]\n"
+		"[Result \"1-0\"]\n"
+		"\n"
+		"1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 1-0\n"
+		"\n"
+		"[Event \"Test\"]\n"
+		"[Result \"0-1\"]\n"
+		"\n"
+		"1. Nf3 Nc6 2. e4 e5 3. d4 exd4 {comment} 4. Nxd4 Nf6 0-1\n"
+		"\n"
+		"[Event \"Test\"]\n"
+		"[Result \"1/2-1/2\"]\n"
+		"\n"
+		"1. d4 d5 2. c4 e6 3. Nc3 Nf6 1/2-1/2\n"
+		"\n");
+}
+
+QString tst_PositionIndex::writeFile(const QTemporaryDir& dir,
+				     const QString& name,
+				     const QByteArray& data)
+{
+	const QString fileName(dir.filePath(name));
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		return QString();
+	file.write(data);
+	return fileName;
+}
+
+bool tst_PositionIndex::build(const QString& pgnFileName, qint64 memoryLimit)
+{
+	PositionIndexBuilder builder(pgnFileName);
+	builder.setThreadCount(4);
+	builder.setMemoryLimit(memoryLimit);
+	return builder.write(PositionIndex::indexFileName(pgnFileName));
+}
+
+void tst_PositionIndex::find()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QByteArray data(pgnData());
+	const QString fileName(writeFile(dir, "games.pgn", data));
+	QVERIFY(build(fileName));
+
+	PositionIndex index;
+	QVERIFY(index.open(PositionIndex::indexFileName(fileName)));
+	QVERIFY(index.isCurrent(fileName));
+	QCOMPARE(index.gameCount(), 3);
+
+	// Every position of every game must be found
+	PgnStream in(&data);
+	PgnGame game;
+	int gameId = 0;
+	qint64 positions = 0;
+	while (game.read(in))
+	{
+		const QVector<PgnGame::MoveData>& moves = game.moves();
+		for (int ply = 0; ply <= moves.size(); ply++)
+		{
+			const quint64 key = ply < moves.size() ? moves.at(ply).key
+							       : game.key();
+			bool found = false;
+			for (const PositionIndex::Hit& hit : index.find(key))
+			{
+				if (int(hit.game) == gameId && hit.ply == ply)
+					found = true;
+			}
+			QVERIFY(found);
+			positions++;
+		}
+		gameId++;
+	}
+	QCOMPARE(index.positionCount(), positions);
+
+	// The games reach the position after 1. e4 e5 2. Nf3 Nc6 by
+	// different move orders
+	in.seek(0);
+	QVERIFY(game.read(in));
+	const QVector<PositionIndex::Hit> hits(index.find(game.moves().at(4).key));
+	QCOMPARE(hits.size(), 2);
+	QCOMPARE(hits.at(0).game, 0u);
+	QCOMPARE(hits.at(0).ply, quint16(4));
+	QCOMPARE(hits.at(1).game, 1u);
+	QCOMPARE(hits.at(1).ply, quint16(4));
+
+	// The game positions point to the tags of the games
+	QCOMPARE(index.gamePosition(0), qint64(0));
+	QCOMPARE(index.gamePosition(1), qint64(data.indexOf("[Event", 1)));
+
+	QVERIFY(index.find(0x123456789abcdefULL).isEmpty());
+}
+
+void tst_PositionIndex::fen()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(writeFile(dir, "games.pgn", pgnData()));
+	QVERIFY(build(fileName));
+
+	PositionIndex index;
+	QVERIFY(index.open(PositionIndex::indexFileName(fileName)));
+
+	// Every game starts from the standard position
+	const quint64 key = PositionIndex::fenKey(
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	QVERIFY(key != 0);
+	const QVector<PositionIndex::Hit> hits(index.find(key));
+	QCOMPARE(hits.size(), 3);
+	for (int i = 0; i < hits.size(); i++)
+	{
+		QCOMPARE(int(hits.at(i).game), i);
+		QCOMPARE(hits.at(i).ply, quint16(0));
+	}
+
+	QCOMPARE(PositionIndex::fenKey("not a fen"), quint64(0));
+	QCOMPARE(PositionIndex::fenKey(
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"no-such-variant"), quint64(0));
+}
+
+void tst_PositionIndex::runs()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QByteArray data(pgnData());
+	const int copies = 500;
+	QByteArray collection;
+	for (int i = 0; i < copies; i++)
+		collection += data;
+
+	// The smallest memory limit writes the shards to temporary
+	// files several times
+	const QString memoryName(writeFile(dir, "memory.pgn", collection));
+	const QString runName(writeFile(dir, "runs.pgn", collection));
+	QVERIFY(build(memoryName));
+	QVERIFY(build(runName, 0));
+
+	QFile memoryFile(PositionIndex::indexFileName(memoryName));
+	QFile runFile(PositionIndex::indexFileName(runName));
+	QVERIFY(memoryFile.open(QIODevice::ReadOnly));
+	QVERIFY(runFile.open(QIODevice::ReadOnly));
+	// Skip the size and time of the PGN files
+	const int sourceEnd = 24;
+	QCOMPARE(runFile.readAll().mid(sourceEnd),
+		 memoryFile.readAll().mid(sourceEnd));
+
+	PositionIndex index;
+	QVERIFY(index.open(runFile.fileName()));
+	QCOMPARE(index.gameCount(), copies * 3);
+
+	PgnStream in(&data);
+	PgnGame game;
+	QVERIFY(game.read(in));
+	const QVector<PositionIndex::Hit> hits(index.find(game.key()));
+	QCOMPARE(hits.size(), copies);
+	for (int i = 0; i < copies; i++)
+		QCOMPARE(int(hits.at(i).game), i * 3);
+}
+
+void tst_PositionIndex::staleIndex()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(writeFile(dir, "games.pgn", pgnData()));
+	QVERIFY(build(fileName));
+
+	writeFile(dir, "games.pgn", pgnData() + pgnData());
+	PositionIndex index;
+	QVERIFY(index.open(PositionIndex::indexFileName(fileName)));
+	QVERIFY(!index.isCurrent(fileName));
+	index.close();
+
+	QVERIFY(build(fileName));
+	QVERIFY(index.open(PositionIndex::indexFileName(fileName)));
+	QVERIFY(index.isCurrent(fileName));
+	QCOMPARE(index.gameCount(), 6);
+}
+
+void tst_PositionIndex::canceledBuild()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(writeFile(dir, "games.pgn", pgnData()));
+	const QString indexName(PositionIndex::indexFileName(fileName));
+	QVERIFY(build(fileName));
+
+	// A canceled build keeps the old index
+	PositionIndexBuilder builder(fileName);
+	builder.cancel();
+	QVERIFY(!builder.write(indexName));
+
+	PositionIndex index;
+	QVERIFY(index.open(indexName));
+	QVERIFY(index.isCurrent(fileName));
+	QCOMPARE(index.gameCount(), 3);
+	index.close();
+
+	// A cancel that arrives after the shards are written still
+	// discards the new index. The first build counts the polls.
+	writeFile(dir, "games.pgn", pgnData() + pgnData());
+	const QString countName(dir.path() + "/count.posindex");
+	int polls = 0;
+	PositionIndexBuilder counter(fileName);
+	counter.setThreadCount(1);
+	counter.setCancelCallback([&polls]() { polls++; return false; });
+	QVERIFY(counter.write(countName));
+	QVERIFY(polls > 0);
+	QVERIFY(QFile::remove(countName));
+
+	int remaining = polls;
+	PositionIndexBuilder lateBuilder(fileName);
+	lateBuilder.setThreadCount(1);
+	lateBuilder.setCancelCallback([&remaining]() { return --remaining <= 0; });
+	QVERIFY(!lateBuilder.write(indexName));
+	QVERIFY(index.open(indexName));
+	QVERIFY(!index.isCurrent(fileName));
+	QCOMPARE(index.gameCount(), 3);
+	index.close();
+
+	// The temporary index file is renamed or removed
+	QVERIFY(build(fileName));
+	QCOMPARE(QDir(dir.path()).entryList(QDir::Files).size(), 2);
+}
+
+void tst_PositionIndex::invalidFile()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName(writeFile(dir, "games.pgn", pgnData()));
+
+	PositionIndex index;
+	QVERIFY(!index.open(fileName));
+	QVERIFY(!index.isOpen());
+	QVERIFY(index.find(0).isEmpty());
+	QVERIFY(!index.open(dir.filePath("no-such-file")));
+
+	PositionIndexBuilder builder(dir.filePath("no-such-file.pgn"));
+	QVERIFY(!builder.write(dir.filePath("no-such-file.pgn.posindex")));
+	QVERIFY(!QFile::exists(dir.filePath("no-such-file.pgn.posindex")));
+}
+
+QTEST_MAIN(tst_PositionIndex)
+#include "tst_positionindex.moc"
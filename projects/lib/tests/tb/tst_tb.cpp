@@ -14,6 +14,9 @@ class tst_Tb: public QObject
 		
 		void positions_data() const;
 		void positions();
+		void wdlPositions_data() const;
+		void wdlPositions();
+		void cache();
 		
 		void cleanupTestCase();
 		
@@ -112,5 +115,44 @@ void tst_Tb::positions()
 	QCOMPARE(int(tbDtz), dtz);
 }
 
+void tst_Tb::wdlPositions_data() const
+{
+	positions_data();
+}
+
+void tst_Tb::wdlPositions()
+{
+	QFETCH(QString, fen);
+	QFETCH(QString, result);
+
+	// Without a DTZ the WDL tables are tried first
+	QVERIFY(m_board.setFenString(fen));
+	QCOMPARE(m_board.tablebaseResult().toShortString(), result);
+}
+
+void tst_Tb::cache()
+{
+	QVERIFY(m_board.setFenString("8/2k5/8/6N1/5K2/1r6/8/8 w - - 0 1"));
+	SyzygyTablebase::setCacheSize(1024);
+
+	const auto before = SyzygyTablebase::statistics();
+	QCOMPARE(m_board.tablebaseResult().toShortString(), QString("1/2-1/2"));
+	const auto probed = SyzygyTablebase::statistics();
+	QCOMPARE(probed.lookups, before.lookups + 1);
+	QCOMPARE(probed.wdlProbes, before.wdlProbes + 1);
+	QCOMPARE(probed.cacheHits, before.cacheHits);
+
+	QCOMPARE(m_board.tablebaseResult().toShortString(), QString("1/2-1/2"));
+	const auto cached = SyzygyTablebase::statistics();
+	QCOMPARE(cached.wdlProbes, probed.wdlProbes);
+	QCOMPARE(cached.cacheHits, probed.cacheHits + 1);
+
+	// A disabled cache probes every time
+	SyzygyTablebase::setCacheSize(0);
+	m_board.tablebaseResult();
+	QCOMPARE(SyzygyTablebase::statistics().wdlProbes, cached.wdlProbes + 1);
+	SyzygyTablebase::setCacheSize(65536);
+}
+
 QTEST_MAIN(tst_Tb)
 #include "tst_tb.moc"
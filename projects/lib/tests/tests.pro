@@ -1,5 +1,8 @@
 TEMPLATE = subdirs
-SUBDIRS = chessboard tb sprt mersenne tournamentplayer tournamentpair polyglotbook graph_blossom
+SUBDIRS = chessboard bitboard tb sprt mersenne tournamentplayer tournamentpair polyglotbook graph_blossom livefilewriter livejsonserializer polyglotbookbuilder openingsuite econode pgngamescanner pgnstream positionindex pgntagindex pgngameentry cpuallocator timecontrol linequeue chessengine
 win32 {
     SUBDIRS += pipereader
 }
+linux {
+    SUBDIRS += pipereactor
+}
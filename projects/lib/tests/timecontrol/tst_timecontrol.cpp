@@ -0,0 +1,111 @@
+#include <QtTest/QtTest>
+#include <timecontrol.h>
+
+class tst_TimeControl: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void microseconds();
+		void expiry();
+		void overrideTime();
+		void movesPerTc();
+		void monotonicClock();
+};
+
+void tst_TimeControl::microseconds()
+{
+	TimeControl tc("10+0.1");
+	tc.initialize();
+	QCOMPARE(tc.timeLeft(), 10000);
+	QCOMPARE(tc.timeLeftUs(), qint64(10000000));
+
+	// Fractions of a millisecond aren't lost between moves
+	for (int i = 0; i < 4; i++)
+	{
+		tc.startTimer(1000000);
+		tc.update(true, -1, 1000000 + 1500000);
+		QCOMPARE(tc.lastMoveTime(), 1);
+		QCOMPARE(tc.lastMoveTimeUs(), qint64(1500));
+	}
+	QCOMPARE(tc.timeLeftUs(), qint64(10000000 - 4 * 1500 + 4 * 100000));
+	QCOMPARE(tc.timeLeft(), 10394);
+
+	// No increment for book moves
+	tc.startTimer(0);
+	tc.update(false, -1, 2000000);
+	QCOMPARE(tc.timeLeft(), 10392);
+	QVERIFY(!tc.expired());
+}
+
+void tst_TimeControl::expiry()
+{
+	TimeControl tc("1");
+	tc.setExpiryMargin(5);
+	tc.initialize();
+
+	// Within the margin
+	tc.startTimer(0);
+	tc.update(false, -1, 1004999000);
+	QVERIFY(!tc.expired());
+	QCOMPARE(tc.timeLeftUs(), qint64(-4999));
+
+	tc.initialize();
+	tc.startTimer(0);
+	tc.update(false, -1, 1005001000);
+	QVERIFY(tc.expired());
+
+	// A timestamp before the start counts as no time at all
+	tc.initialize();
+	tc.startTimer(1000);
+	tc.update(false, -1, 0);
+	QCOMPARE(tc.lastMoveTimeUs(), qint64(0));
+	QCOMPARE(tc.timeLeft(), 1000);
+}
+
+void tst_TimeControl::overrideTime()
+{
+	TimeControl tc("60");
+	tc.initialize();
+	tc.startTimer(0);
+	tc.update(true, 250, 5000000000LL);
+	QCOMPARE(tc.lastMoveTime(), 250);
+	QCOMPARE(tc.timeLeft(), 59750);
+}
+
+void tst_TimeControl::movesPerTc()
+{
+	TimeControl tc("2/1");
+	tc.initialize();
+	QCOMPARE(tc.movesLeft(), 2);
+
+	tc.startTimer(0);
+	tc.update(true, -1, 400500000);
+	QCOMPARE(tc.movesLeft(), 1);
+	tc.startTimer(0);
+	tc.update(true, -1, 400500000);
+
+	// The time of the next time control is added
+	QCOMPARE(tc.movesLeft(), 2);
+	QCOMPARE(tc.timeLeftUs(), qint64(1000000 - 801000 + 1000000));
+}
+
+void tst_TimeControl::monotonicClock()
+{
+	const qint64 t1 = TimeControl::monotonicNs();
+	QTest::qSleep(2);
+	const qint64 t2 = TimeControl::monotonicNs();
+	QVERIFY(t1 >= 0);
+	QVERIFY(t2 - t1 >= 1000000);
+
+	TimeControl tc("10");
+	tc.initialize();
+	tc.startTimer();
+	QTest::qSleep(2);
+	tc.update();
+	QVERIFY(tc.lastMoveTimeUs() >= 1000);
+	QVERIFY(tc.activeTimeLeft() <= tc.timeLeft());
+}
+
+QTEST_MAIN(tst_TimeControl)
+#include "tst_timecontrol.moc"